@@ -0,0 +1,129 @@
+/**
+ * NeuroChef - Arena Allocator Implementation
+ * 
+ * This file implements the chunked bump allocator used for RecipeDB data.
+ */
+
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT 16
+#define ARENA_MAX_CHUNK_SIZE (16 * 1024 * 1024)
+
+struct ArenaChunk {
+    ArenaChunk* next;
+    size_t capacity;
+    size_t used;
+    /* Pads the header so chunk data starts aligned */
+    union {
+        long double ld;
+        void* p;
+        long long ll;
+    } data[];
+};
+
+static size_t align_up(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+static ArenaChunk* add_chunk(Arena* arena, size_t min_size) {
+    size_t capacity = arena->next_chunk_size;
+    if (capacity < min_size) capacity = min_size;
+
+    ArenaChunk* chunk = (ArenaChunk*)malloc(sizeof(ArenaChunk) + capacity);
+    if (!chunk) return NULL;
+
+    chunk->next = arena->head;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    arena->head = chunk;
+
+    arena->chunk_count++;
+    arena->bytes_reserved += capacity;
+    if (arena->next_chunk_size < ARENA_MAX_CHUNK_SIZE) {
+        arena->next_chunk_size *= 2;
+    }
+    return chunk;
+}
+
+void arena_init(Arena* arena, size_t initial_chunk_size) {
+    arena->head = NULL;
+    arena->next_chunk_size = initial_chunk_size > 0 ? align_up(initial_chunk_size) : 4096;
+    arena->chunk_count = 0;
+    arena->bytes_reserved = 0;
+    arena->bytes_used = 0;
+    arena->allocation_count = 0;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    size = align_up(size > 0 ? size : 1);
+
+    ArenaChunk* chunk = arena->head;
+    if (!chunk || chunk->capacity - chunk->used < size) {
+        chunk = add_chunk(arena, size);
+        if (!chunk) return NULL;
+    }
+
+    void* ptr = (char*)chunk->data + chunk->used;
+    chunk->used += size;
+    arena->bytes_used += size;
+    arena->allocation_count++;
+    return ptr;
+}
+
+void* arena_copy(Arena* arena, const void* data, size_t size) {
+    void* copy = arena_alloc(arena, size);
+    if (copy && size > 0) {
+        memcpy(copy, data, size);
+    }
+    return copy;
+}
+
+void arena_adopt(Arena* arena, Arena* other) {
+    if (!other->head) return;
+
+    /* Keep this arena's current chunk in front, where allocation happens */
+    ArenaChunk* tail = other->head;
+    while (tail->next) {
+        tail = tail->next;
+    }
+    if (arena->head) {
+        tail->next = arena->head->next;
+        arena->head->next = other->head;
+    } else {
+        arena->head = other->head;
+    }
+
+    arena->chunk_count += other->chunk_count;
+    arena->bytes_reserved += other->bytes_reserved;
+    arena->bytes_used += other->bytes_used;
+    arena->allocation_count += other->allocation_count;
+
+    other->head = NULL;
+    other->chunk_count = 0;
+    other->bytes_reserved = 0;
+    other->bytes_used = 0;
+    other->allocation_count = 0;
+}
+
+void arena_free(Arena* arena) {
+    ArenaChunk* chunk = arena->head;
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->head = NULL;
+    arena->chunk_count = 0;
+    arena->bytes_reserved = 0;
+    arena->bytes_used = 0;
+    arena->allocation_count = 0;
+}
+
+void arena_get_stats(const Arena* arena, ArenaStats* stats) {
+    stats->chunk_count = arena->chunk_count;
+    stats->bytes_reserved = arena->bytes_reserved;
+    stats->bytes_used = arena->bytes_used;
+    stats->allocation_count = arena->allocation_count;
+}
@@ -0,0 +1,83 @@
+/**
+ * NeuroChef - Arena Allocator
+ * 
+ * This header declares a bump allocator for data that lives exactly as long
+ * as a RecipeDB. Allocations are carved out of a few large chunks and are
+ * released all at once.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct ArenaChunk ArenaChunk;
+
+typedef struct {
+    ArenaChunk* head;
+    size_t next_chunk_size;
+    size_t chunk_count;
+    size_t bytes_reserved;
+    size_t bytes_used;
+    size_t allocation_count;
+} Arena;
+
+typedef struct {
+    size_t chunk_count;
+    size_t bytes_reserved;
+    size_t bytes_used;
+    size_t allocation_count;
+} ArenaStats;
+
+/**
+ * Initialize an empty arena
+ * 
+ * @param arena The arena to initialize
+ * @param initial_chunk_size Size of the first chunk; later chunks grow geometrically
+ */
+void arena_init(Arena* arena, size_t initial_chunk_size);
+
+/**
+ * Allocate memory from the arena
+ * 
+ * @param arena The arena
+ * @param size Number of bytes to allocate
+ * @return Pointer aligned for any object type, or NULL if out of memory
+ */
+void* arena_alloc(Arena* arena, size_t size);
+
+/**
+ * Copy a buffer into the arena
+ * 
+ * @param arena The arena
+ * @param data The bytes to copy
+ * @param size Number of bytes to copy
+ * @return The copy, or NULL if out of memory
+ */
+void* arena_copy(Arena* arena, const void* data, size_t size);
+
+/**
+ * Move every chunk of another arena into this one, so its allocations
+ * live as long as this arena does
+ * 
+ * @param arena The arena that takes the chunks
+ * @param other The arena to empty; it is left initialized and empty
+ */
+void arena_adopt(Arena* arena, Arena* other);
+
+/**
+ * Release every chunk owned by the arena
+ * 
+ * @param arena The arena to free
+ */
+void arena_free(Arena* arena);
+
+/**
+ * Get usage statistics for an arena
+ * 
+ * @param arena The arena
+ * @param stats Receives the statistics
+ */
+void arena_get_stats(const Arena* arena, ArenaStats* stats);
+
+#endif /* ARENA_H */
@@ -0,0 +1,148 @@
+/**
+ * NeuroChef - Recipe Loader Benchmark
+ * 
+ * Times init_recipe_db over a catalog file, and optionally compiles a
+ * snapshot of it and times loading that. Generate a large catalog with
+ * bench/generate_catalog.py, e.g. a 100k-meal file:
+ *
+ *     python bench/generate_catalog.py 100000 meals_100k.json
+ *     ./bench_load meals_100k.json 5 meals_100k.ncdb
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include "../json_scan.h"
+#include "../recipe_utils.h"
+#include "../snapshot.h"
+#include "../thread_pool.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/* Best time of init_recipe_db over some runs, or a negative time on failure */
+static double best_load_ms(const char* path, int iterations) {
+    double best = -1.0;
+    for (int i = 0; i < iterations; i++) {
+        double start = now_ms();
+        RecipeDB* db = init_recipe_db(path);
+        double elapsed = now_ms() - start;
+        bool loaded = db && !db->error_message;
+        free_recipe_db(db);
+        if (!loaded) return -1.0;
+        if (best < 0.0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <meal_data.json> [iterations] [snapshot]\n", argv[0]);
+        return 1;
+    }
+
+    const char* path = argv[1];
+    int iterations = argc > 2 ? atoi(argv[2]) : 3;
+    if (iterations < 1) iterations = 1;
+    const char* snapshot_path = argc > 3 ? argv[3] : NULL;
+
+    int thread_count = thread_pool_default_size();
+    if (thread_count > 1) {
+        set_recipe_loader_threads(1);
+        double sequential = best_load_ms(path, iterations);
+        if (sequential < 0.0) {
+            fprintf(stderr, "Load failed\n");
+            return 1;
+        }
+        printf("init_recipe_db on 1 thread: best %.2f ms over %d runs\n", sequential, iterations);
+        set_recipe_loader_threads(0);
+    }
+
+    JsonScanKernel kernel = json_scan_best_kernel();
+    if (kernel != JSON_SCAN_SCALAR) {
+        json_scan_set_kernel(JSON_SCAN_SCALAR);
+        double scalar = best_load_ms(path, iterations);
+        if (scalar < 0.0) {
+            fprintf(stderr, "Load failed\n");
+            return 1;
+        }
+        printf("init_recipe_db with scalar scanning: best %.2f ms over %d runs\n", scalar, iterations);
+        json_scan_set_kernel(kernel);
+    }
+
+    double best = 0.0;
+    double total = 0.0;
+    int recipe_count = 0;
+    ArenaStats arena_stats;
+
+    for (int i = 0; i < iterations; i++) {
+        double start = now_ms();
+        RecipeDB* db = init_recipe_db(path);
+        double elapsed = now_ms() - start;
+
+        if (!db || db->error_message) {
+            fprintf(stderr, "Load failed: %s\n", db ? db->error_message : "out of memory");
+            free_recipe_db(db);
+            return 1;
+        }
+
+        recipe_count = db->recipe_count;
+        get_recipe_db_arena_stats(db, &arena_stats);
+        if (i == 0 && snapshot_path) {
+            const char* error = write_recipe_snapshot(db, path, snapshot_path);
+            if (error) {
+                fprintf(stderr, "Snapshot failed: %s\n", error);
+                free_recipe_db(db);
+                return 1;
+            }
+        }
+        free_recipe_db(db);
+
+        total += elapsed;
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+
+    printf("init_recipe_db on %d thread%s with %s scanning: %d recipes, best %.2f ms, mean %.2f ms over %d runs\n",
+           thread_count, thread_count == 1 ? "" : "s", json_scan_kernel_name(kernel), recipe_count, best,
+           total / iterations, iterations);
+
+    if (snapshot_path) {
+        double snapshot_best = 0.0;
+        double snapshot_total = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            SnapshotStatus status;
+            double start = now_ms();
+            RecipeDB* db = load_recipe_snapshot(snapshot_path, path, &status);
+            double elapsed = now_ms() - start;
+
+            if (!db) {
+                fprintf(stderr, "Snapshot load failed: %s\n", snapshot_status_name(status));
+                return 1;
+            }
+            free_recipe_db(db);
+
+            snapshot_total += elapsed;
+            if (i == 0 || elapsed < snapshot_best) snapshot_best = elapsed;
+        }
+        printf("load_recipe_snapshot: best %.2f ms, mean %.2f ms over %d runs\n",
+               snapshot_best, snapshot_total / iterations, iterations);
+    }
+
+    printf("arena: %zu chunks, %zu KB reserved, %zu KB used, %zu allocations\n",
+           arena_stats.chunk_count, arena_stats.bytes_reserved / 1024,
+           arena_stats.bytes_used / 1024, arena_stats.allocation_count);
+
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        printf("peak resident memory: %ld KB\n", usage.ru_maxrss);
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,351 @@
+/**
+ * NeuroChef - Microbenchmarks
+ *
+ * Times the C recipe engine one operation at a time over a catalog file and
+ * reports, for each benchmark, the mean time per operation, heap
+ * allocations per operation and the 50th, 90th and 99th percentile
+ * latencies. Build and run the whole suite over generated catalogs with
+ * `cmake --build build --target bench`, or run one catalog directly:
+ *
+ *     ./bench_micro meals_10000.json
+ *
+ * Query classification and recipe name extraction both happen in
+ * parse_query, and each generate_*_response runs under render_parsed_query
+ * for its query type, so those are the entry points benchmarked here.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../recipe_filter.h"
+#include "../recipe_utils.h"
+#include "../string_builder.h"
+
+/* Each benchmark runs for about this long */
+#define BENCH_TIME_BUDGET_NS 500000000LL
+#define BENCH_MIN_OPS 3
+#define BENCH_MAX_OPS 200000
+/* Distinct queries each benchmark cycles through */
+#define BENCH_QUERY_COUNT 1024
+#define BENCH_QUERY_SIZE 256
+
+/* Count heap allocations by wrapping glibc's allocator; elsewhere, and under
+   sanitizers that replace it, allocations are not counted */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define BENCH_COUNT_ALLOCATIONS 1
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* pointer, size_t size);
+
+static size_t allocation_count = 0;
+
+void* malloc(size_t size) {
+    allocation_count++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    allocation_count++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+    allocation_count++;
+    return __libc_realloc(pointer, size);
+}
+#else
+#define BENCH_COUNT_ALLOCATIONS 0
+static size_t allocation_count = 0;
+#endif
+
+typedef struct {
+    const char* catalog_path;
+    RecipeDB* db;
+    /* Queries or names the current benchmark cycles through */
+    char (*inputs)[BENCH_QUERY_SIZE];
+    ParsedQuery* parsed;
+    StringBuilder out;
+} Bench;
+
+/* Runs operation number i; returns false if it failed */
+typedef bool (*BenchOp)(Bench* bench, size_t i);
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int compare_samples(const void* a, const void* b) {
+    long long x = *(const long long*)a;
+    long long y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+static long long percentile(const long long* sorted, size_t count, double fraction) {
+    size_t index = (size_t)(fraction * (double)count);
+    return sorted[index < count ? index : count - 1];
+}
+
+/* Cost of reading the clock, subtracted from every sample */
+static long long timer_overhead_ns(void) {
+    long long samples[1001];
+    for (int i = 0; i < 1001; i++) {
+        long long start = now_ns();
+        samples[i] = now_ns() - start;
+    }
+    qsort(samples, 1001, sizeof(long long), compare_samples);
+    return samples[500];
+}
+
+static void print_header(void) {
+    printf("%-34s %8s %12s %11s %10s %10s %10s\n",
+           "benchmark", "ops", "ns/op", "allocs/op", "p50 ns", "p90 ns", "p99 ns");
+}
+
+/* Time one operation at a time until the budget runs out */
+static bool run_bench(Bench* bench, const char* name, BenchOp op, long long timer_overhead) {
+    long long* samples = (long long*)malloc(BENCH_MAX_OPS * sizeof(long long));
+    if (!samples) return false;
+
+    /* Warm up caches and any lazily built state */
+    if (!op(bench, 0)) {
+        printf("%-34s failed\n", name);
+        free(samples);
+        return false;
+    }
+
+    size_t ops = 0;
+    long long total = 0;
+    size_t allocations_before = allocation_count;
+    long long started = now_ns();
+    while (ops < BENCH_MAX_OPS &&
+           (ops < BENCH_MIN_OPS || now_ns() - started < BENCH_TIME_BUDGET_NS)) {
+        long long start = now_ns();
+        op(bench, ops);
+        long long elapsed = now_ns() - start - timer_overhead;
+        samples[ops++] = elapsed > 0 ? elapsed : 0;
+        total += elapsed > 0 ? elapsed : 0;
+    }
+    size_t allocations = allocation_count - allocations_before;
+
+    qsort(samples, ops, sizeof(long long), compare_samples);
+    char allocations_text[32];
+    if (BENCH_COUNT_ALLOCATIONS) {
+        snprintf(allocations_text, sizeof(allocations_text), "%.1f", (double)allocations / (double)ops);
+    } else {
+        snprintf(allocations_text, sizeof(allocations_text), "n/a");
+    }
+    printf("%-34s %8zu %12.0f %11s %10lld %10lld %10lld\n", name, ops, (double)total / (double)ops,
+           allocations_text, percentile(samples, ops, 0.50), percentile(samples, ops, 0.90),
+           percentile(samples, ops, 0.99));
+    fflush(stdout);
+    free(samples);
+    return true;
+}
+
+/* ===== Operations ===== */
+
+static bool op_init_recipe_db(Bench* bench, size_t i) {
+    (void)i;
+    RecipeDB* db = init_recipe_db(bench->catalog_path);
+    bool loaded = db && !db->error_message;
+    free_recipe_db(db);
+    return loaded;
+}
+
+static bool op_find_recipe_by_name(Bench* bench, size_t i) {
+    return find_recipe_by_name(bench->db, bench->inputs[i % BENCH_QUERY_COUNT]) != NULL;
+}
+
+static bool op_parse_query(Bench* bench, size_t i) {
+    ParsedQuery query;
+    if (!parse_query(bench->inputs[i % BENCH_QUERY_COUNT], &query)) return false;
+    bool is_recipe = parsed_query_is_recipe(&query);
+    free_parsed_query(&query);
+    return is_recipe;
+}
+
+static bool op_render_parsed_query(Bench* bench, size_t i) {
+    sb_reset(&bench->out);
+    QueryResult result = render_parsed_query(bench->db, &bench->parsed[i % BENCH_QUERY_COUNT], &bench->out);
+    return result.success;
+}
+
+static bool op_process_recipe_query(Bench* bench, size_t i) {
+    QueryResult result = process_recipe_query(bench->db, bench->inputs[i % BENCH_QUERY_COUNT]);
+    bool success = result.success;
+    free_query_result(&result);
+    return success;
+}
+
+static bool op_answer_filter_query(Bench* bench, size_t i) {
+    ParsedQuery query;
+    if (!parse_query(bench->inputs[i % BENCH_QUERY_COUNT], &query)) return false;
+
+    RecipeFilter filter;
+    bool answered = parse_recipe_filter(bench->db, &query, &filter);
+    if (answered) {
+        sb_reset(&bench->out);
+        answered = answer_filter_query(bench->db, &filter, &bench->out);
+    }
+    free_parsed_query(&query);
+    return answered;
+}
+
+/* ===== Inputs ===== */
+
+/* Spread the inputs over the whole catalog */
+static const Recipe* input_recipe(const RecipeDB* db, int i) {
+    return &db->recipes[((size_t)i * 7919u) % (size_t)db->recipe_count];
+}
+
+static void make_names(Bench* bench, bool with_typo) {
+    for (int i = 0; i < BENCH_QUERY_COUNT; i++) {
+        StringView name = input_recipe(bench->db, i)->name;
+        int length = name.length < BENCH_QUERY_SIZE - 1 ? (int)name.length : BENCH_QUERY_SIZE - 1;
+        snprintf(bench->inputs[i], BENCH_QUERY_SIZE, "%.*s", length, name.data);
+        /* Drop a letter from the middle: one edit away */
+        if (with_typo && length > 4) {
+            memmove(&bench->inputs[i][length / 2], &bench->inputs[i][length / 2 + 1], (size_t)(length - length / 2));
+        }
+    }
+}
+
+static void make_queries(Bench* bench, const char* format) {
+    for (int i = 0; i < BENCH_QUERY_COUNT; i++) {
+        StringView name = input_recipe(bench->db, i)->name;
+        int length = name.length < BENCH_QUERY_SIZE / 2 ? (int)name.length : BENCH_QUERY_SIZE / 2;
+        snprintf(bench->inputs[i], BENCH_QUERY_SIZE, format, length, name.data);
+    }
+}
+
+/* Mixed query types, as a user would ask them */
+static void make_mixed_queries(Bench* bench) {
+    static const char* formats[] = {
+        "What is in %.*s?", "How do I make %.*s?", "What's the texture of %.*s?",
+        "How long does it take to make %.*s?", "Tell me about %.*s"
+    };
+    for (int i = 0; i < BENCH_QUERY_COUNT; i++) {
+        StringView name = input_recipe(bench->db, i)->name;
+        int length = name.length < BENCH_QUERY_SIZE / 2 ? (int)name.length : BENCH_QUERY_SIZE / 2;
+        snprintf(bench->inputs[i], BENCH_QUERY_SIZE, formats[i % 5], length, name.data);
+    }
+}
+
+/* Compound constraints, from selective to broad */
+static void make_filter_queries(Bench* bench) {
+    static const char* formats[] = {
+        "warm, soft dinner under %d minutes total",
+        "breakfast or lunch under %d minutes prep",
+        "meals without creamy or fluffy under %d minutes",
+        "sweet cold snacks with cook time over %d minutes",
+        "meals with prep time between 5 and %d minutes page 2"
+    };
+    for (int i = 0; i < BENCH_QUERY_COUNT; i++) {
+        snprintf(bench->inputs[i], BENCH_QUERY_SIZE, formats[i % 5], 10 + (i / 5) % 50);
+    }
+}
+
+static bool parse_inputs(Bench* bench) {
+    for (int i = 0; i < BENCH_QUERY_COUNT; i++) {
+        if (!parse_query(bench->inputs[i], &bench->parsed[i])) {
+            for (int j = 0; j < i; j++) free_parsed_query(&bench->parsed[j]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void free_parsed_inputs(Bench* bench) {
+    for (int i = 0; i < BENCH_QUERY_COUNT; i++) {
+        free_parsed_query(&bench->parsed[i]);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <meal_data.json>...\n", argv[0]);
+        return 1;
+    }
+
+    static const struct {
+        const char* name;
+        const char* format;
+    } renders[] = {
+        { "render_parsed_query/ingredients", "What is in %.*s?" },
+        { "render_parsed_query/preparation", "How do I make %.*s?" },
+        { "render_parsed_query/sensory", "What's the texture of %.*s?" },
+        { "render_parsed_query/time", "How long does it take to make %.*s?" },
+        { "render_parsed_query/general", "Tell me about %.*s" }
+    };
+
+    Bench bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.inputs = (char (*)[BENCH_QUERY_SIZE])calloc(BENCH_QUERY_COUNT, BENCH_QUERY_SIZE);
+    bench.parsed = (ParsedQuery*)calloc(BENCH_QUERY_COUNT, sizeof(ParsedQuery));
+    if (!bench.inputs || !bench.parsed) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    sb_init(&bench.out);
+
+    long long timer_overhead = timer_overhead_ns();
+    if (!BENCH_COUNT_ALLOCATIONS) {
+        printf("(allocation counting needs glibc without sanitizers)\n");
+    }
+
+    int exit_code = 0;
+    for (int c = 1; c < argc; c++) {
+        bench.catalog_path = argv[c];
+        bench.db = init_recipe_db(bench.catalog_path);
+        if (!bench.db || bench.db->error_message || bench.db->recipe_count == 0) {
+            fprintf(stderr, "Failed to load %s: %s\n", bench.catalog_path,
+                    bench.db && bench.db->error_message ? bench.db->error_message : "no recipes");
+            free_recipe_db(bench.db);
+            exit_code = 1;
+            continue;
+        }
+        bench.db->verbose = false;
+
+        printf("\n%s: %d recipes\n", bench.catalog_path, bench.db->recipe_count);
+        print_header();
+
+        bool ok = run_bench(&bench, "init_recipe_db", op_init_recipe_db, timer_overhead);
+
+        make_names(&bench, false);
+        ok = run_bench(&bench, "find_recipe_by_name/exact", op_find_recipe_by_name, timer_overhead) && ok;
+        make_names(&bench, true);
+        ok = run_bench(&bench, "find_recipe_by_name/typo", op_find_recipe_by_name, timer_overhead) && ok;
+
+        make_mixed_queries(&bench);
+        ok = run_bench(&bench, "parse_query", op_parse_query, timer_overhead) && ok;
+
+        for (size_t r = 0; r < sizeof(renders) / sizeof(renders[0]); r++) {
+            make_queries(&bench, renders[r].format);
+            if (!parse_inputs(&bench)) {
+                ok = false;
+                continue;
+            }
+            ok = run_bench(&bench, renders[r].name, op_render_parsed_query, timer_overhead) && ok;
+            free_parsed_inputs(&bench);
+        }
+
+        make_mixed_queries(&bench);
+        ok = run_bench(&bench, "process_recipe_query", op_process_recipe_query, timer_overhead) && ok;
+
+        make_filter_queries(&bench);
+        ok = run_bench(&bench, "answer_filter_query", op_answer_filter_query, timer_overhead) && ok;
+
+        if (!ok) exit_code = 1;
+        free_recipe_db(bench.db);
+        bench.db = NULL;
+    }
+
+    sb_free(&bench.out);
+    free(bench.inputs);
+    free(bench.parsed);
+    return exit_code;
+}
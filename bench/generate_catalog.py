@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""
+NeuroChef Synthetic Catalog Generator
+
+Writes a schema-valid meal_data.json style catalog with an arbitrary number
+of meals so the C loader and query paths can be benchmarked at scale.
+"""
+
+import argparse
+import json
+import os
+import random
+import sys
+import textwrap
+
+ADJECTIVES = ["Creamy", "Soft", "Mild", "Smooth", "Warm", "Chilled", "Fluffy",
+              "Golden", "Simple", "Gentle", "Silky", "Cozy", "Fresh", "Sweet"]
+DISHES = ["Smoothie", "Mashed Potatoes", "Chicken Salad", "Pasta", "Sweet Potato",
+          "Oatmeal", "Rice Bowl", "Soup", "Pudding", "Scrambled Eggs", "Risotto",
+          "Polenta", "Yogurt Parfait", "Noodles", "Congee", "Frittata"]
+MEALS_MARKER = "__generated_meals__"
+MEAL_TYPES = ["breakfast", "lunch", "dinner", "snack", "side", "comfort"]
+TEXTURES = ["smooth", "soft", "creamy", "liquid", "fluffy", "slippery", "variable", "uniform"]
+TEMPERATURES = ["cold", "warm", "room temperature", "hot"]
+TASTES = ["sweet", "savory", "mild", "tangy", "herby", "earthy", "mildly nutty"]
+SMELLS = ["fruity", "earthy", "herbal", "mildly aromatic", "sweet", "neutral"]
+INGREDIENTS = ["Potatoes", "Milk/Cream", "Butter/Oil", "Garlic", "Salt", "Pepper",
+               "Frozen berries", "Yogurt", "Cooked chicken", "Pasta", "Pesto",
+               "Sweet potato", "Rice", "Broth", "Eggs", "Oats", "Honey", "Cheese"]
+OPTIONS = ["dairy", "non-dairy", "olive oil", "fresh", "powdered", "optional"]
+STEPS = ["Gather all ingredients and tools.", "Combine ingredients in a bowl.",
+         "Heat gently over medium heat.", "Stir until evenly combined.",
+         "Season with salt and pepper to taste.", "Blend until smooth.",
+         "Let cool slightly before serving.", "Serve warm and enjoy."]
+
+
+def pick(rng, pool, low, high):
+    return rng.sample(pool, rng.randint(low, high))
+
+
+def make_meal(rng, index):
+    """Build one meal object matching the meal_data.json schema."""
+    ingredients = []
+    for name in pick(rng, INGREDIENTS, 2, 7):
+        ingredient = {"name": name}
+        if rng.random() < 0.6:
+            ingredient["options"] = pick(rng, OPTIONS, 1, 3)
+        if rng.random() < 0.5:
+            ingredient["notes"] = "Adjust amount to preference"
+        ingredients.append(ingredient)
+
+    return {
+        "id": f"meal_{index:07d}",
+        "name": f"{rng.choice(ADJECTIVES)} {rng.choice(DISHES)} {index}",
+        "meal_type": pick(rng, MEAL_TYPES, 1, 2),
+        "sensory_profile": {
+            "texture": pick(rng, TEXTURES, 1, 3),
+            "temperature": pick(rng, TEMPERATURES, 1, 1),
+            "taste": pick(rng, TASTES, 1, 3),
+            "smell": pick(rng, SMELLS, 1, 2),
+        },
+        "prep_time": {"duration": rng.choice([2, 5, 10, 15, 20, 30]), "unit": "minutes"},
+        "cook_time": {"duration": rng.choice([0, 5, 10, 20, 45, 60]), "unit": "minutes"},
+        "description": "A generated meal used for benchmarking the recipe loader.",
+        "ingredients": ingredients,
+        "preparation_steps": pick(rng, STEPS, 2, 6),
+        "executive_function_support": {
+            "difficulty_planning": rng.random() < 0.5,
+            "difficulty_initiating": rng.random() < 0.5,
+            "difficulty_monitoring": rng.random() < 0.5,
+        },
+        "notes": "Generated for benchmarking.",
+    }
+
+
+def generate(meal_count, seed, template_path):
+    """Return a catalog dict with meal_count generated meals."""
+    rng = random.Random(seed)
+    with open(template_path, 'r') as file:
+        catalog = json.load(file)
+    catalog["meals"] = [make_meal(rng, i) for i in range(meal_count)]
+    return catalog
+
+
+def write_catalog(file, meal_count, seed, template_path):
+    """Write the same catalog as generate(), one meal at a time, so even
+    million-meal catalogs never have to fit in memory."""
+    rng = random.Random(seed)
+    with open(template_path, 'r') as template:
+        catalog = json.load(template)
+    catalog["meals"] = MEALS_MARKER
+    head, tail = json.dumps(catalog, indent=4, ensure_ascii=False).split(json.dumps(MEALS_MARKER), 1)
+
+    file.write(head + "[")
+    for i in range(meal_count):
+        meal = json.dumps(make_meal(rng, i), indent=4, ensure_ascii=False)
+        file.write(("," if i else "") + "\n" + textwrap.indent(meal, " " * 8))
+    file.write(("\n    ]" if meal_count else "]") + tail)
+
+
+def main():
+    repo_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("meals", type=int, help="number of meals to generate")
+    parser.add_argument("output", help="output path, or - for stdout")
+    parser.add_argument("--seed", type=int, default=42)
+    parser.add_argument("--template", default=os.path.join(repo_dir, "meal_data.json"),
+                        help="catalog whose non-meal sections are copied")
+    args = parser.parse_args()
+
+    if args.output == "-":
+        write_catalog(sys.stdout, args.meals, args.seed, args.template)
+    else:
+        directory = os.path.dirname(os.path.abspath(args.output))
+        os.makedirs(directory, exist_ok=True)
+        with open(args.output, 'w', encoding='utf-8') as file:
+            write_catalog(file, args.meals, args.seed, args.template)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
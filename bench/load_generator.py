@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""
+NeuroChef Server Load Generator
+
+Opens many concurrent connections to a `neurochef --serve` instance, sends
+recipe queries over the line protocol or HTTP/1.1 keep-alive, and reports
+throughput and latency percentiles.
+"""
+
+import argparse
+import json
+import os
+import random
+import socket
+import sys
+import threading
+import time
+import urllib.parse
+
+TEMPLATES = ["What is in {}?", "How do I make {}?", "What's the texture of {}?",
+             "How long does it take to make {}?", "Tell me about {}"]
+GUIDANCE = ["I need meals with smooth texture", "What are some quick meals?",
+            "I have difficulty planning meals"]
+
+
+def load_queries(catalog_path, count, seed):
+    """Build a reproducible mix of recipe and guidance queries."""
+    with open(catalog_path, 'r', encoding='utf-8') as file:
+        names = [meal["name"] for meal in json.load(file)["meals"]]
+    rng = random.Random(seed)
+    queries = []
+    for _ in range(count):
+        if rng.random() < 0.1:
+            queries.append(rng.choice(GUIDANCE))
+        else:
+            queries.append(rng.choice(TEMPLATES).format(rng.choice(names)))
+    return queries
+
+
+def connect(address):
+    if "/" in address:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        sock.connect(address[5:] if address.startswith("unix:") else address)
+    else:
+        host, _, port = address.rpartition(":")
+        sock = socket.create_connection((host or "127.0.0.1", int(port)))
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    return sock
+
+
+class LineClient:
+    def __init__(self, sock):
+        self.file = sock.makefile('rwb')
+
+    def ask(self, query):
+        self.file.write(query.encode('utf-8') + b"\n")
+        self.file.flush()
+        return json.loads(self.file.readline())
+
+
+class HttpClient:
+    def __init__(self, sock):
+        self.file = sock.makefile('rwb')
+
+    def ask(self, query):
+        target = "/query?q=" + urllib.parse.quote_plus(query)
+        self.file.write(f"GET {target} HTTP/1.1\r\nHost: neurochef\r\n\r\n".encode('ascii'))
+        self.file.flush()
+        status = self.file.readline()
+        if b" 200 " not in status:
+            raise RuntimeError(status.decode('ascii', 'replace').strip())
+        length = 0
+        while True:
+            line = self.file.readline().strip()
+            if not line:
+                break
+            name, _, value = line.partition(b":")
+            if name.lower() == b"content-length":
+                length = int(value)
+        return json.loads(self.file.read(length))
+
+
+def run_connection(address, http, queries, latencies, errors):
+    try:
+        sock = connect(address)
+        client = HttpClient(sock) if http else LineClient(sock)
+        for query in queries:
+            start = time.perf_counter_ns()
+            answer = client.ask(query)
+            latencies.append(time.perf_counter_ns() - start)
+            if answer.get("query") != query:
+                errors.append(f"answer for {answer.get('query')!r}, expected {query!r}")
+        sock.close()
+    except (OSError, RuntimeError, ValueError) as error:
+        errors.append(str(error))
+
+
+def percentile(values, fraction):
+    return values[min(len(values) - 1, int(fraction * len(values)))]
+
+
+def main():
+    repo_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("address", help="Unix socket path or [host:]port the server listens on")
+    parser.add_argument("--connections", type=int, default=32)
+    parser.add_argument("--requests", type=int, default=1000, help="requests per connection")
+    parser.add_argument("--http", action="store_true", help="use HTTP/1.1 instead of lines")
+    parser.add_argument("--catalog", default=os.path.join(repo_dir, "meal_data.json"),
+                        help="catalog the recipe names are taken from")
+    parser.add_argument("--seed", type=int, default=42)
+    args = parser.parse_args()
+
+    latencies = []
+    errors = []
+    threads = []
+    for i in range(args.connections):
+        queries = load_queries(args.catalog, args.requests, args.seed + i)
+        threads.append(threading.Thread(target=run_connection,
+                                        args=(args.address, args.http, queries, latencies, errors)))
+
+    start = time.perf_counter()
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    elapsed = time.perf_counter() - start
+
+    latencies.sort()
+    print(f"{len(latencies)} requests over {args.connections} connections in {elapsed:.2f} s "
+          f"({len(latencies) / elapsed:.0f} req/s)")
+    if latencies:
+        print("latency us: p50 %.0f  p90 %.0f  p99 %.0f  max %.0f" % (
+            percentile(latencies, 0.50) / 1000, percentile(latencies, 0.90) / 1000,
+            percentile(latencies, 0.99) / 1000, latencies[-1] / 1000))
+    for error in errors[:10]:
+        print("error:", error, file=sys.stderr)
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,657 @@
+/**
+ * NeuroChef - Compressed Bitmaps Implementation
+ * 
+ * This file implements array and bitset containers and their intersections,
+ * unions and differences. Bitset operations use SSE2 where the compiler
+ * targets it. Results are stored as arrays up to BITMAP_ARRAY_MAX values
+ * and as bitsets above, whatever their inputs were.
+ */
+
+#include "bitmap.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static int popcount64(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static int ctz64(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static void container_free(BitmapContainer* container) {
+    if (container->type == BITMAP_CONTAINER_ARRAY) {
+        free(container->data.values);
+    } else {
+        free(container->data.words);
+    }
+    container->data.values = NULL;
+}
+
+static bool array_to_bitset(BitmapContainer* container) {
+    uint64_t* words = (uint64_t*)calloc(BITMAP_BITSET_WORDS, sizeof(uint64_t));
+    if (!words) return false;
+
+    for (int i = 0; i < container->cardinality; i++) {
+        uint16_t low = container->data.values[i];
+        words[low >> 6] |= 1ULL << (low & 63);
+    }
+
+    free(container->data.values);
+    container->data.words = words;
+    container->type = BITMAP_CONTAINER_BITSET;
+    container->capacity = 0;
+    return true;
+}
+
+static bool bitset_to_array(BitmapContainer* container) {
+    uint16_t* values = (uint16_t*)malloc((container->cardinality > 0 ? container->cardinality : 1) * sizeof(uint16_t));
+    if (!values) return false;
+
+    int count = 0;
+    for (int w = 0; w < BITMAP_BITSET_WORDS; w++) {
+        uint64_t word = container->data.words[w];
+        while (word) {
+            int bit = ctz64(word);
+            values[count++] = (uint16_t)(w * 64 + bit);
+            word &= word - 1;
+        }
+    }
+
+    free(container->data.words);
+    container->data.values = values;
+    container->type = BITMAP_CONTAINER_ARRAY;
+    container->capacity = container->cardinality;
+    return true;
+}
+
+static bool container_append(BitmapContainer* container, uint16_t low) {
+    if (container->type == BITMAP_CONTAINER_BITSET) {
+        uint64_t bit = 1ULL << (low & 63);
+        if (!(container->data.words[low >> 6] & bit)) {
+            container->data.words[low >> 6] |= bit;
+            container->cardinality++;
+        }
+        return true;
+    }
+
+    int count = container->cardinality;
+    if (count > 0) {
+        uint16_t last = container->data.values[count - 1];
+        if (low == last) return true;
+        if (low < last) return false;
+    }
+
+    if (count == BITMAP_ARRAY_MAX) {
+        if (!array_to_bitset(container)) return false;
+        return container_append(container, low);
+    }
+
+    if (count == container->capacity) {
+        int new_capacity = container->capacity == 0 ? 4 : container->capacity * 2;
+        if (new_capacity > BITMAP_ARRAY_MAX) new_capacity = BITMAP_ARRAY_MAX;
+        uint16_t* values = (uint16_t*)realloc(container->data.values, new_capacity * sizeof(uint16_t));
+        if (!values) return false;
+        container->data.values = values;
+        container->capacity = new_capacity;
+    }
+
+    container->data.values[container->cardinality++] = low;
+    return true;
+}
+
+static bool array_contains(const uint16_t* values, int count, uint16_t low) {
+    int lo = 0;
+    int hi = count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) >> 1;
+        if (values[mid] == low) return true;
+        if (values[mid] < low) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return false;
+}
+
+static bool container_contains(const BitmapContainer* container, uint16_t low) {
+    if (container->type == BITMAP_CONTAINER_BITSET) {
+        return (container->data.words[low >> 6] >> (low & 63)) & 1;
+    }
+    return array_contains(container->data.values, container->cardinality, low);
+}
+
+static int and_array_array(uint16_t* out, const BitmapContainer* a, const BitmapContainer* b) {
+    int i = 0, j = 0, count = 0;
+    while (i < a->cardinality && j < b->cardinality) {
+        uint16_t va = a->data.values[i];
+        uint16_t vb = b->data.values[j];
+        if (va < vb) {
+            i++;
+        } else if (va > vb) {
+            j++;
+        } else {
+            if (out) out[count] = va;
+            count++;
+            i++;
+            j++;
+        }
+    }
+    return count;
+}
+
+static int and_array_bitset(uint16_t* out, const BitmapContainer* array, const BitmapContainer* bitset) {
+    int count = 0;
+    for (int i = 0; i < array->cardinality; i++) {
+        uint16_t low = array->data.values[i];
+        if ((bitset->data.words[low >> 6] >> (low & 63)) & 1) {
+            if (out) out[count] = low;
+            count++;
+        }
+    }
+    return count;
+}
+
+static int and_bitset_bitset(uint64_t* out, const uint64_t* a, const uint64_t* b) {
+    int count = 0;
+#if defined(__SSE2__)
+    for (int w = 0; w < BITMAP_BITSET_WORDS; w += 2) {
+        __m128i v = _mm_and_si128(_mm_loadu_si128((const __m128i*)(a + w)),
+                                  _mm_loadu_si128((const __m128i*)(b + w)));
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i*)lanes, v);
+        if (out) _mm_storeu_si128((__m128i*)(out + w), v);
+        count += popcount64(lanes[0]) + popcount64(lanes[1]);
+    }
+#else
+    for (int w = 0; w < BITMAP_BITSET_WORDS; w++) {
+        uint64_t word = a[w] & b[w];
+        if (out) out[w] = word;
+        count += popcount64(word);
+    }
+#endif
+    return count;
+}
+
+static int container_and_cardinality(const BitmapContainer* a, const BitmapContainer* b) {
+    if (a->type == BITMAP_CONTAINER_ARRAY && b->type == BITMAP_CONTAINER_ARRAY) {
+        return and_array_array(NULL, a, b);
+    }
+    if (a->type == BITMAP_CONTAINER_ARRAY) return and_array_bitset(NULL, a, b);
+    if (b->type == BITMAP_CONTAINER_ARRAY) return and_array_bitset(NULL, b, a);
+    return and_bitset_bitset(NULL, a->data.words, b->data.words);
+}
+
+static bool container_and(BitmapContainer* out, const BitmapContainer* a, const BitmapContainer* b) {
+    out->key = a->key;
+
+    if (a->type == BITMAP_CONTAINER_BITSET && b->type == BITMAP_CONTAINER_BITSET) {
+        out->type = BITMAP_CONTAINER_BITSET;
+        out->capacity = 0;
+        out->data.words = (uint64_t*)malloc(BITMAP_BITSET_WORDS * sizeof(uint64_t));
+        if (!out->data.words) return false;
+        out->cardinality = and_bitset_bitset(out->data.words, a->data.words, b->data.words);
+        if (out->cardinality <= BITMAP_ARRAY_MAX) {
+            if (!bitset_to_array(out)) {
+                container_free(out);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int max_count = a->cardinality < b->cardinality ? a->cardinality : b->cardinality;
+    out->type = BITMAP_CONTAINER_ARRAY;
+    out->capacity = max_count > 0 ? max_count : 1;
+    out->data.values = (uint16_t*)malloc(out->capacity * sizeof(uint16_t));
+    if (!out->data.values) return false;
+
+    if (a->type == BITMAP_CONTAINER_ARRAY && b->type == BITMAP_CONTAINER_ARRAY) {
+        out->cardinality = and_array_array(out->data.values, a, b);
+    } else if (a->type == BITMAP_CONTAINER_ARRAY) {
+        out->cardinality = and_array_bitset(out->data.values, a, b);
+    } else {
+        out->cardinality = and_array_bitset(out->data.values, b, a);
+    }
+    return true;
+}
+
+static int or_bitset_bitset(uint64_t* out, const uint64_t* a, const uint64_t* b) {
+    int count = 0;
+#if defined(__SSE2__)
+    for (int w = 0; w < BITMAP_BITSET_WORDS; w += 2) {
+        __m128i v = _mm_or_si128(_mm_loadu_si128((const __m128i*)(a + w)),
+                                 _mm_loadu_si128((const __m128i*)(b + w)));
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i*)lanes, v);
+        _mm_storeu_si128((__m128i*)(out + w), v);
+        count += popcount64(lanes[0]) + popcount64(lanes[1]);
+    }
+#else
+    for (int w = 0; w < BITMAP_BITSET_WORDS; w++) {
+        out[w] = a[w] | b[w];
+        count += popcount64(out[w]);
+    }
+#endif
+    return count;
+}
+
+/* out = a AND NOT b */
+static int andnot_bitset_bitset(uint64_t* out, const uint64_t* a, const uint64_t* b) {
+    int count = 0;
+#if defined(__SSE2__)
+    for (int w = 0; w < BITMAP_BITSET_WORDS; w += 2) {
+        __m128i v = _mm_andnot_si128(_mm_loadu_si128((const __m128i*)(b + w)),
+                                     _mm_loadu_si128((const __m128i*)(a + w)));
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i*)lanes, v);
+        _mm_storeu_si128((__m128i*)(out + w), v);
+        count += popcount64(lanes[0]) + popcount64(lanes[1]);
+    }
+#else
+    for (int w = 0; w < BITMAP_BITSET_WORDS; w++) {
+        out[w] = a[w] & ~b[w];
+        count += popcount64(out[w]);
+    }
+#endif
+    return count;
+}
+
+static bool container_copy(BitmapContainer* to, const BitmapContainer* from) {
+    *to = *from;
+
+    size_t size = from->type == BITMAP_CONTAINER_BITSET
+        ? BITMAP_BITSET_WORDS * sizeof(uint64_t)
+        : (size_t)from->cardinality * sizeof(uint16_t);
+    void* data = malloc(size > 0 ? size : 1);
+    if (!data) return false;
+    memcpy(data, from->data.values, size);
+
+    to->data.values = (uint16_t*)data;
+    if (to->type == BITMAP_CONTAINER_ARRAY) to->capacity = from->cardinality;
+    return true;
+}
+
+/* Start a bitset result holding a copy of words */
+static bool bitset_from_words(BitmapContainer* out, const uint64_t* words) {
+    out->type = BITMAP_CONTAINER_BITSET;
+    out->capacity = 0;
+    out->data.words = (uint64_t*)malloc(BITMAP_BITSET_WORDS * sizeof(uint64_t));
+    if (!out->data.words) return false;
+    if (words) memcpy(out->data.words, words, BITMAP_BITSET_WORDS * sizeof(uint64_t));
+    return true;
+}
+
+/* Store a bitset result of at most BITMAP_ARRAY_MAX values as an array */
+static bool shrink_bitset(BitmapContainer* out) {
+    if (out->cardinality > BITMAP_ARRAY_MAX) return true;
+    if (bitset_to_array(out)) return true;
+    container_free(out);
+    return false;
+}
+
+static bool container_or(BitmapContainer* out, const BitmapContainer* a, const BitmapContainer* b) {
+    out->key = a->key;
+
+    if (a->type == BITMAP_CONTAINER_ARRAY && b->type == BITMAP_CONTAINER_ARRAY) {
+        out->type = BITMAP_CONTAINER_ARRAY;
+        out->capacity = a->cardinality + b->cardinality > 0 ? a->cardinality + b->cardinality : 1;
+        out->data.values = (uint16_t*)malloc(out->capacity * sizeof(uint16_t));
+        if (!out->data.values) return false;
+
+        int i = 0, j = 0, count = 0;
+        while (i < a->cardinality || j < b->cardinality) {
+            if (j == b->cardinality || (i < a->cardinality && a->data.values[i] < b->data.values[j])) {
+                out->data.values[count++] = a->data.values[i++];
+            } else if (i == a->cardinality || b->data.values[j] < a->data.values[i]) {
+                out->data.values[count++] = b->data.values[j++];
+            } else {
+                out->data.values[count++] = a->data.values[i++];
+                j++;
+            }
+        }
+        out->cardinality = count;
+        if (count > BITMAP_ARRAY_MAX && !array_to_bitset(out)) {
+            container_free(out);
+            return false;
+        }
+        return true;
+    }
+
+    if (a->type == BITMAP_CONTAINER_BITSET && b->type == BITMAP_CONTAINER_BITSET) {
+        if (!bitset_from_words(out, NULL)) return false;
+        out->cardinality = or_bitset_bitset(out->data.words, a->data.words, b->data.words);
+        return true;
+    }
+
+    const BitmapContainer* array = a->type == BITMAP_CONTAINER_ARRAY ? a : b;
+    const BitmapContainer* bitset = a->type == BITMAP_CONTAINER_ARRAY ? b : a;
+    if (!bitset_from_words(out, bitset->data.words)) return false;
+    out->cardinality = bitset->cardinality;
+    for (int i = 0; i < array->cardinality; i++) {
+        uint16_t low = array->data.values[i];
+        uint64_t bit = 1ULL << (low & 63);
+        if (!(out->data.words[low >> 6] & bit)) {
+            out->data.words[low >> 6] |= bit;
+            out->cardinality++;
+        }
+    }
+    return true;
+}
+
+/* out = a AND NOT b */
+static bool container_andnot(BitmapContainer* out, const BitmapContainer* a, const BitmapContainer* b) {
+    out->key = a->key;
+
+    if (a->type == BITMAP_CONTAINER_ARRAY) {
+        out->type = BITMAP_CONTAINER_ARRAY;
+        out->capacity = a->cardinality > 0 ? a->cardinality : 1;
+        out->data.values = (uint16_t*)malloc(out->capacity * sizeof(uint16_t));
+        if (!out->data.values) return false;
+
+        int count = 0;
+        if (b->type == BITMAP_CONTAINER_ARRAY) {
+            int j = 0;
+            for (int i = 0; i < a->cardinality; i++) {
+                uint16_t low = a->data.values[i];
+                while (j < b->cardinality && b->data.values[j] < low) j++;
+                if (j == b->cardinality || b->data.values[j] != low) out->data.values[count++] = low;
+            }
+        } else {
+            for (int i = 0; i < a->cardinality; i++) {
+                uint16_t low = a->data.values[i];
+                if (!((b->data.words[low >> 6] >> (low & 63)) & 1)) out->data.values[count++] = low;
+            }
+        }
+        out->cardinality = count;
+        return true;
+    }
+
+    if (b->type == BITMAP_CONTAINER_BITSET) {
+        if (!bitset_from_words(out, NULL)) return false;
+        out->cardinality = andnot_bitset_bitset(out->data.words, a->data.words, b->data.words);
+        return shrink_bitset(out);
+    }
+
+    if (!bitset_from_words(out, a->data.words)) return false;
+    out->cardinality = a->cardinality;
+    for (int i = 0; i < b->cardinality; i++) {
+        uint16_t low = b->data.values[i];
+        uint64_t bit = 1ULL << (low & 63);
+        if (out->data.words[low >> 6] & bit) {
+            out->data.words[low >> 6] &= ~bit;
+            out->cardinality--;
+        }
+    }
+    return shrink_bitset(out);
+}
+
+static bool reserve_containers(Bitmap* bitmap, int count) {
+    if (count <= bitmap->capacity) return true;
+
+    int new_capacity = bitmap->capacity == 0 ? 1 : bitmap->capacity;
+    while (new_capacity < count) new_capacity *= 2;
+
+    BitmapContainer* containers = (BitmapContainer*)realloc(bitmap->containers,
+                                                            new_capacity * sizeof(BitmapContainer));
+    if (!containers) return false;
+    bitmap->containers = containers;
+    bitmap->capacity = new_capacity;
+    return true;
+}
+
+void bitmap_init(Bitmap* bitmap) {
+    bitmap->containers = NULL;
+    bitmap->count = 0;
+    bitmap->capacity = 0;
+}
+
+void bitmap_free(Bitmap* bitmap) {
+    for (int i = 0; i < bitmap->count; i++) {
+        container_free(&bitmap->containers[i]);
+    }
+    free(bitmap->containers);
+    bitmap_init(bitmap);
+}
+
+bool bitmap_append(Bitmap* bitmap, uint32_t value) {
+    uint16_t key = (uint16_t)(value >> 16);
+    uint16_t low = (uint16_t)(value & 0xFFFF);
+
+    BitmapContainer* last = bitmap->count > 0 ? &bitmap->containers[bitmap->count - 1] : NULL;
+    if (last && last->key > key) return false;
+
+    if (!last || last->key != key) {
+        if (!reserve_containers(bitmap, bitmap->count + 1)) return false;
+        last = &bitmap->containers[bitmap->count++];
+        last->key = key;
+        last->type = BITMAP_CONTAINER_ARRAY;
+        last->cardinality = 0;
+        last->capacity = 0;
+        last->data.values = NULL;
+    }
+
+    return container_append(last, low);
+}
+
+bool bitmap_contains(const Bitmap* bitmap, uint32_t value) {
+    uint16_t key = (uint16_t)(value >> 16);
+    int lo = 0;
+    int hi = bitmap->count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) >> 1;
+        uint16_t mid_key = bitmap->containers[mid].key;
+        if (mid_key == key) {
+            return container_contains(&bitmap->containers[mid], (uint16_t)(value & 0xFFFF));
+        }
+        if (mid_key < key) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return false;
+}
+
+uint32_t bitmap_cardinality(const Bitmap* bitmap) {
+    uint32_t total = 0;
+    for (int i = 0; i < bitmap->count; i++) {
+        total += (uint32_t)bitmap->containers[i].cardinality;
+    }
+    return total;
+}
+
+bool bitmap_copy(Bitmap* dest, const Bitmap* src) {
+    bitmap_free(dest);
+    if (!reserve_containers(dest, src->count)) return false;
+
+    for (int i = 0; i < src->count; i++) {
+        if (!container_copy(&dest->containers[i], &src->containers[i])) {
+            bitmap_free(dest);
+            return false;
+        }
+        dest->count++;
+    }
+    return true;
+}
+
+bool bitmap_and(Bitmap* out, const Bitmap* a, const Bitmap* b) {
+    bitmap_free(out);
+
+    int i = 0, j = 0;
+    while (i < a->count && j < b->count) {
+        const BitmapContainer* ca = &a->containers[i];
+        const BitmapContainer* cb = &b->containers[j];
+
+        if (ca->key < cb->key) {
+            i++;
+        } else if (ca->key > cb->key) {
+            j++;
+        } else {
+            if (!reserve_containers(out, out->count + 1)) {
+                bitmap_free(out);
+                return false;
+            }
+
+            BitmapContainer* result = &out->containers[out->count];
+            if (!container_and(result, ca, cb)) {
+                bitmap_free(out);
+                return false;
+            }
+
+            if (result->cardinality > 0) {
+                out->count++;
+            } else {
+                container_free(result);
+            }
+            i++;
+            j++;
+        }
+    }
+    return true;
+}
+
+bool bitmap_or(Bitmap* out, const Bitmap* a, const Bitmap* b) {
+    bitmap_free(out);
+    if (!reserve_containers(out, a->count + b->count)) return false;
+
+    int i = 0, j = 0;
+    while (i < a->count || j < b->count) {
+        const BitmapContainer* ca = i < a->count ? &a->containers[i] : NULL;
+        const BitmapContainer* cb = j < b->count ? &b->containers[j] : NULL;
+        BitmapContainer* result = &out->containers[out->count];
+
+        bool ok;
+        if (!cb || (ca && ca->key < cb->key)) {
+            ok = container_copy(result, ca);
+            i++;
+        } else if (!ca || cb->key < ca->key) {
+            ok = container_copy(result, cb);
+            j++;
+        } else {
+            ok = container_or(result, ca, cb);
+            i++;
+            j++;
+        }
+        if (!ok) {
+            bitmap_free(out);
+            return false;
+        }
+        out->count++;
+    }
+    return true;
+}
+
+bool bitmap_andnot(Bitmap* out, const Bitmap* a, const Bitmap* b) {
+    bitmap_free(out);
+    if (!reserve_containers(out, a->count)) return false;
+
+    int j = 0;
+    for (int i = 0; i < a->count; i++) {
+        const BitmapContainer* ca = &a->containers[i];
+        while (j < b->count && b->containers[j].key < ca->key) j++;
+
+        BitmapContainer* result = &out->containers[out->count];
+        bool ok = j < b->count && b->containers[j].key == ca->key
+            ? container_andnot(result, ca, &b->containers[j])
+            : container_copy(result, ca);
+        if (!ok) {
+            bitmap_free(out);
+            return false;
+        }
+
+        if (result->cardinality > 0) {
+            out->count++;
+        } else {
+            container_free(result);
+        }
+    }
+    return true;
+}
+
+uint32_t bitmap_and_cardinality(const Bitmap* a, const Bitmap* b) {
+    uint32_t total = 0;
+    int i = 0, j = 0;
+    while (i < a->count && j < b->count) {
+        const BitmapContainer* ca = &a->containers[i];
+        const BitmapContainer* cb = &b->containers[j];
+
+        if (ca->key < cb->key) {
+            i++;
+        } else if (ca->key > cb->key) {
+            j++;
+        } else {
+            total += (uint32_t)container_and_cardinality(ca, cb);
+            i++;
+            j++;
+        }
+    }
+    return total;
+}
+
+/* Index of the first array value at least low */
+static int array_lower_bound(const uint16_t* values, int count, uint16_t low) {
+    int lo = 0;
+    int hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (values[mid] < low) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+uint32_t bitmap_to_array(const Bitmap* bitmap, uint32_t* values, uint32_t max_values) {
+    return bitmap_to_array_from(bitmap, 0, values, max_values);
+}
+
+uint32_t bitmap_to_array_from(const Bitmap* bitmap, uint32_t from, uint32_t* values, uint32_t max_values) {
+    uint16_t from_key = (uint16_t)(from >> 16);
+    int lo = 0;
+    int hi = bitmap->count;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (bitmap->containers[mid].key < from_key) lo = mid + 1;
+        else hi = mid;
+    }
+
+    uint32_t count = 0;
+    for (int i = lo; i < bitmap->count && count < max_values; i++) {
+        const BitmapContainer* container = &bitmap->containers[i];
+        uint32_t high = (uint32_t)container->key << 16;
+        /* Only the first container can start partway through */
+        uint16_t start = container->key == from_key ? (uint16_t)(from & 0xFFFF) : 0;
+
+        if (container->type == BITMAP_CONTAINER_ARRAY) {
+            int j = array_lower_bound(container->data.values, container->cardinality, start);
+            for (; j < container->cardinality && count < max_values; j++) {
+                values[count++] = high | container->data.values[j];
+            }
+        } else {
+            for (int w = start >> 6; w < BITMAP_BITSET_WORDS && count < max_values; w++) {
+                uint64_t word = container->data.words[w];
+                if (w == start >> 6) word &= ~(uint64_t)0 << (start & 63);
+                while (word && count < max_values) {
+                    values[count++] = high | (uint32_t)(w * 64 + ctz64(word));
+                    word &= word - 1;
+                }
+            }
+        }
+    }
+    return count;
+}
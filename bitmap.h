@@ -0,0 +1,155 @@
+/**
+ * NeuroChef - Compressed Bitmaps
+ * 
+ * This header declares a Roaring-style compressed bitmap of 32-bit values.
+ * Values are split into 65536-wide containers keyed by their high 16 bits;
+ * sparse containers hold a sorted array of the low 16 bits and dense ones a
+ * 65536-bit bitset. Used as posting lists for the recipe attribute index.
+ */
+
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Containers with more values than this are stored as bitsets */
+#define BITMAP_ARRAY_MAX 4096
+#define BITMAP_BITSET_WORDS 1024
+
+typedef enum {
+    BITMAP_CONTAINER_ARRAY,
+    BITMAP_CONTAINER_BITSET
+} BitmapContainerType;
+
+typedef struct {
+    uint16_t key;
+    uint16_t type;
+    int cardinality;
+    int capacity;
+    union {
+        uint16_t* values;
+        uint64_t* words;
+    } data;
+} BitmapContainer;
+
+typedef struct {
+    BitmapContainer* containers;
+    int count;
+    int capacity;
+} Bitmap;
+
+/**
+ * Initialize an empty bitmap
+ * 
+ * @param bitmap The bitmap to initialize
+ */
+void bitmap_init(Bitmap* bitmap);
+
+/**
+ * Free the memory owned by a bitmap
+ * 
+ * @param bitmap The bitmap to free
+ */
+void bitmap_free(Bitmap* bitmap);
+
+/**
+ * Append a value to the bitmap
+ * 
+ * Values must be appended in non-decreasing order; appending the current
+ * maximum again is a no-op.
+ * 
+ * @param bitmap The bitmap
+ * @param value The value to append
+ * @return true on success, false if out of memory or out of order
+ */
+bool bitmap_append(Bitmap* bitmap, uint32_t value);
+
+/**
+ * Check whether a value is in the bitmap
+ * 
+ * @param bitmap The bitmap
+ * @param value The value to look for
+ * @return true if the value is present
+ */
+bool bitmap_contains(const Bitmap* bitmap, uint32_t value);
+
+/**
+ * Count the values in the bitmap
+ * 
+ * @param bitmap The bitmap
+ * @return The number of values
+ */
+uint32_t bitmap_cardinality(const Bitmap* bitmap);
+
+/**
+ * Replace the contents of a bitmap with a copy of another
+ * 
+ * @param dest The bitmap to overwrite
+ * @param src The bitmap to copy
+ * @return true on success, false if out of memory
+ */
+bool bitmap_copy(Bitmap* dest, const Bitmap* src);
+
+/**
+ * Intersect two bitmaps into a third
+ * 
+ * @param out Receives a AND b; must not alias a or b
+ * @param a The first bitmap
+ * @param b The second bitmap
+ * @return true on success, false if out of memory
+ */
+bool bitmap_and(Bitmap* out, const Bitmap* a, const Bitmap* b);
+
+/**
+ * Unite two bitmaps into a third
+ * 
+ * @param out Receives a OR b; must not alias a or b
+ * @param a The first bitmap
+ * @param b The second bitmap
+ * @return true on success, false if out of memory
+ */
+bool bitmap_or(Bitmap* out, const Bitmap* a, const Bitmap* b);
+
+/**
+ * Subtract one bitmap from another into a third
+ * 
+ * @param out Receives the values of a that are not in b; must not alias a or b
+ * @param a The bitmap to subtract from
+ * @param b The values to remove
+ * @return true on success, false if out of memory
+ */
+bool bitmap_andnot(Bitmap* out, const Bitmap* a, const Bitmap* b);
+
+/**
+ * Count the values in the intersection of two bitmaps without building it
+ * 
+ * @param a The first bitmap
+ * @param b The second bitmap
+ * @return The cardinality of a AND b
+ */
+uint32_t bitmap_and_cardinality(const Bitmap* a, const Bitmap* b);
+
+/**
+ * Copy the values of a bitmap into an array in increasing order
+ * 
+ * @param bitmap The bitmap
+ * @param values Receives up to max_values values
+ * @param max_values The capacity of values
+ * @return The number of values written
+ */
+uint32_t bitmap_to_array(const Bitmap* bitmap, uint32_t* values, uint32_t max_values);
+
+/**
+ * Copy the values of a bitmap from a starting value on, in increasing
+ * order, so a large bitmap can be read a batch at a time
+ * 
+ * @param bitmap The bitmap
+ * @param from The smallest value to copy
+ * @param values Receives up to max_values values
+ * @param max_values The capacity of values
+ * @return The number of values written
+ */
+uint32_t bitmap_to_array_from(const Bitmap* bitmap, uint32_t from, uint32_t* values, uint32_t max_values);
+
+#endif /* BITMAP_H */
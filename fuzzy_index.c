@@ -0,0 +1,326 @@
+/**
+ * NeuroChef - Fuzzy Name Index Implementation
+ * 
+ * This file implements the trigram index and Myers' edit distance, one
+ * 64-bit word per text byte for names up to 64 bytes and blocks of words
+ * for longer ones.
+ */
+
+#include "fuzzy_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TRIGRAM_ALPHABET FUZZY_TRIGRAM_ALPHABET
+#define TRIGRAM_COUNT FUZZY_TRIGRAM_COUNT
+#define MAX_TRIGRAMS FUZZY_MAX_NAME_LENGTH
+
+static int symbol_code(char c) {
+    if (c >= 'a' && c <= 'z') return c - 'a' + 1;
+    if (c >= '0' && c <= '9') return c - '0' + 27;
+    return 0;
+}
+
+/* Distinct trigram codes of normalized text, sorted ascending */
+static int extract_trigrams(const char* text, size_t length, uint32_t* trigrams) {
+    if (length < 3) return 0;
+
+    int count = 0;
+    for (size_t i = 0; i + 3 <= length && count < MAX_TRIGRAMS; i++) {
+        trigrams[count++] = (uint32_t)(symbol_code(text[i]) * TRIGRAM_ALPHABET * TRIGRAM_ALPHABET +
+                                       symbol_code(text[i + 1]) * TRIGRAM_ALPHABET +
+                                       symbol_code(text[i + 2]));
+    }
+
+    /* Names are short, so insertion sort beats qsort here */
+    for (int i = 1; i < count; i++) {
+        uint32_t current = trigrams[i];
+        int j = i - 1;
+        while (j >= 0 && trigrams[j] > current) {
+            trigrams[j + 1] = trigrams[j];
+            j--;
+        }
+        trigrams[j + 1] = current;
+    }
+
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique == 0 || trigrams[unique - 1] != trigrams[i]) {
+            trigrams[unique++] = trigrams[i];
+        }
+    }
+    return unique;
+}
+
+size_t fuzzy_normalize(StringView text, char* out, size_t out_size) {
+    size_t length = 0;
+    bool pending_space = false;
+
+    for (size_t i = 0; i < text.length && length + 1 < out_size; i++) {
+        char c = text.data[i];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+            if (pending_space && length > 0 && length + 2 < out_size) {
+                out[length++] = ' ';
+            }
+            out[length++] = c;
+            pending_space = false;
+        } else {
+            pending_space = true;
+        }
+    }
+
+    out[length] = '\0';
+    return length;
+}
+
+bool fuzzy_index_build(FuzzyIndex* index, const StringView* names, int count) {
+    index->offsets = (uint32_t*)calloc(TRIGRAM_COUNT + 1, sizeof(uint32_t));
+    index->postings = NULL;
+    index->name_count = count;
+    if (!index->offsets) return false;
+
+    char normalized[FUZZY_MAX_NAME_LENGTH];
+    uint32_t trigrams[MAX_TRIGRAMS];
+
+    /* First pass counts postings per trigram */
+    for (int i = 0; i < count; i++) {
+        size_t length = fuzzy_normalize(names[i], normalized, sizeof(normalized));
+        int trigram_count = extract_trigrams(normalized, length, trigrams);
+        for (int t = 0; t < trigram_count; t++) {
+            index->offsets[trigrams[t] + 1]++;
+        }
+    }
+
+    for (int t = 0; t < TRIGRAM_COUNT; t++) {
+        index->offsets[t + 1] += index->offsets[t];
+    }
+
+    uint32_t total = index->offsets[TRIGRAM_COUNT];
+    index->postings = (uint32_t*)malloc((total > 0 ? total : 1) * sizeof(uint32_t));
+    uint32_t* fill = (uint32_t*)malloc(TRIGRAM_COUNT * sizeof(uint32_t));
+    if (!index->postings || !fill) {
+        free(fill);
+        fuzzy_index_free(index);
+        return false;
+    }
+    memcpy(fill, index->offsets, TRIGRAM_COUNT * sizeof(uint32_t));
+
+    /* Second pass fills postings; lists come out sorted by name position */
+    for (int i = 0; i < count; i++) {
+        size_t length = fuzzy_normalize(names[i], normalized, sizeof(normalized));
+        int trigram_count = extract_trigrams(normalized, length, trigrams);
+        for (int t = 0; t < trigram_count; t++) {
+            index->postings[fill[trigrams[t]]++] = (uint32_t)i;
+        }
+    }
+
+    free(fill);
+    return true;
+}
+
+static uint32_t posting_length(const FuzzyIndex* index, uint32_t trigram) {
+    return index->offsets[trigram + 1] - index->offsets[trigram];
+}
+
+int fuzzy_index_candidates(const FuzzyIndex* index, const char* query, size_t query_length,
+                           int max_edits, int max_candidates, int32_t** candidates) {
+    *candidates = NULL;
+    if (!index->offsets || index->name_count == 0) return 0;
+
+    uint32_t trigrams[MAX_TRIGRAMS];
+    int trigram_count = extract_trigrams(query, query_length, trigrams);
+    if (trigram_count == 0) return 0;
+
+    int min_shared = trigram_count - 3 * max_edits;
+    if (min_shared < 1) min_shared = 1;
+
+    /* Rarest lists first: any match must appear in one of the first
+       trigram_count - min_shared + 1 of them */
+    for (int i = 1; i < trigram_count; i++) {
+        uint32_t current = trigrams[i];
+        int j = i - 1;
+        while (j >= 0 && posting_length(index, trigrams[j]) > posting_length(index, current)) {
+            trigrams[j + 1] = trigrams[j];
+            j--;
+        }
+        trigrams[j + 1] = current;
+    }
+
+    uint8_t* shared = (uint8_t*)calloc(index->name_count, sizeof(uint8_t));
+    if (!shared) return -1;
+
+    int32_t* found = NULL;
+    int found_count = 0;
+    int found_capacity = 0;
+    int scan_lists = trigram_count - min_shared + 1;
+
+    for (int t = 0; t < scan_lists; t++) {
+        const uint32_t* list = index->postings + index->offsets[trigrams[t]];
+        uint32_t length = posting_length(index, trigrams[t]);
+
+        for (uint32_t p = 0; p < length; p++) {
+            uint32_t name = list[p];
+            if (shared[name]++ > 0) continue;
+
+            if (found_count == found_capacity) {
+                int new_capacity = found_capacity == 0 ? 256 : found_capacity * 2;
+                int32_t* new_found = (int32_t*)realloc(found, new_capacity * sizeof(int32_t));
+                if (!new_found) {
+                    free(found);
+                    free(shared);
+                    return -1;
+                }
+                found = new_found;
+                found_capacity = new_capacity;
+            }
+            found[found_count++] = (int32_t)name;
+        }
+    }
+
+    /* The remaining, more common lists only add to names already found */
+    for (int t = scan_lists; t < trigram_count; t++) {
+        const uint32_t* list = index->postings + index->offsets[trigrams[t]];
+        uint32_t length = posting_length(index, trigrams[t]);
+        for (uint32_t p = 0; p < length; p++) {
+            if (shared[list[p]] > 0) shared[list[p]]++;
+        }
+    }
+
+    int kept = 0;
+    int by_count[MAX_TRIGRAMS + 1];
+    memset(by_count, 0, sizeof(by_count));
+    for (int c = 0; c < found_count; c++) {
+        int count = shared[found[c]];
+        if (count >= min_shared) {
+            by_count[count]++;
+            found[kept++] = found[c];
+        }
+    }
+
+    /* Keep the max_candidates names sharing the most trigrams, in name order */
+    int threshold = trigram_count;
+    int selected = by_count[threshold];
+    while (threshold > min_shared && selected + by_count[threshold - 1] <= max_candidates) {
+        threshold--;
+        selected += by_count[threshold];
+    }
+
+    int result_count = 0;
+    for (int c = 0; c < kept && result_count < max_candidates; c++) {
+        if (shared[found[c]] >= threshold) {
+            found[result_count++] = found[c];
+        }
+    }
+
+    free(shared);
+    if (result_count == 0) {
+        free(found);
+        return 0;
+    }
+    *candidates = found;
+    return result_count;
+}
+
+/* Patterns longer than one word are split into 64-row blocks, each passing
+   the change in the score along its last row down to the next block */
+#define MAX_PATTERN_WORDS ((FUZZY_MAX_NAME_LENGTH + 63) / 64)
+
+static int blocked_edit_distance(const char* pattern, size_t pattern_length,
+                                 const char* text, size_t text_length) {
+    int words = (int)((pattern_length + 63) / 64);
+    uint64_t peq[256][MAX_PATTERN_WORDS];
+    memset(peq, 0, sizeof(peq));
+    for (size_t i = 0; i < pattern_length; i++) {
+        peq[(unsigned char)pattern[i]][i / 64] |= 1ULL << (i % 64);
+    }
+
+    uint64_t pv[MAX_PATTERN_WORDS];
+    uint64_t mv[MAX_PATTERN_WORDS];
+    for (int w = 0; w < words; w++) {
+        pv[w] = ~0ULL;
+        mv[w] = 0;
+    }
+    uint64_t high_bit = 1ULL << ((pattern_length - 1) % 64);
+    int score = (int)pattern_length;
+    int best = score;
+
+    for (size_t j = 0; j < text_length; j++) {
+        const uint64_t* eqs = peq[(unsigned char)text[j]];
+        /* The text may start anywhere, so the first row never changes */
+        int carry = 0;
+
+        for (int w = 0; w < words; w++) {
+            uint64_t eq = eqs[w];
+            uint64_t xv = eq | mv[w];
+            if (carry < 0) eq |= 1;
+            uint64_t xh = (((eq & pv[w]) + pv[w]) ^ pv[w]) | eq;
+            uint64_t ph = mv[w] | ~(xh | pv[w]);
+            uint64_t mh = pv[w] & xh;
+
+            uint64_t out_bit = w == words - 1 ? high_bit : 1ULL << 63;
+            int carry_out = (ph & out_bit) ? 1 : (mh & out_bit) ? -1 : 0;
+
+            ph <<= 1;
+            mh <<= 1;
+            if (carry < 0) mh |= 1;
+            else if (carry > 0) ph |= 1;
+            pv[w] = mh | ~(xv | ph);
+            mv[w] = ph & xv;
+            carry = carry_out;
+        }
+
+        score += carry;
+        if (score < best) best = score;
+    }
+    return best;
+}
+
+int fuzzy_edit_distance(const char* pattern, size_t pattern_length,
+                        const char* text, size_t text_length) {
+    if (pattern_length > FUZZY_MAX_NAME_LENGTH) pattern_length = FUZZY_MAX_NAME_LENGTH;
+    if (pattern_length == 0) return 0;
+    if (pattern_length > 64) {
+        return blocked_edit_distance(pattern, pattern_length, text, text_length);
+    }
+
+    uint64_t peq[256];
+    memset(peq, 0, sizeof(peq));
+    for (size_t i = 0; i < pattern_length; i++) {
+        peq[(unsigned char)pattern[i]] |= 1ULL << i;
+    }
+
+    uint64_t pv = ~0ULL;
+    uint64_t mv = 0;
+    uint64_t high_bit = 1ULL << (pattern_length - 1);
+    int score = (int)pattern_length;
+    int best = score;
+
+    for (size_t j = 0; j < text_length; j++) {
+        uint64_t eq = peq[(unsigned char)text[j]];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+
+        if (ph & high_bit) score++;
+        else if (mh & high_bit) score--;
+
+        /* The text may start anywhere, so no carry is shifted into the first row */
+        ph <<= 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        if (score < best) best = score;
+    }
+    return best;
+}
+
+void fuzzy_index_free(FuzzyIndex* index) {
+    free(index->offsets);
+    free(index->postings);
+    index->offsets = NULL;
+    index->postings = NULL;
+    index->name_count = 0;
+}
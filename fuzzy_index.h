@@ -0,0 +1,92 @@
+/**
+ * NeuroChef - Fuzzy Name Index
+ * 
+ * This header declares a trigram inverted index over names and a
+ * bit-parallel (Myers) edit distance. The index picks candidates that share
+ * enough trigrams with a query; the edit distance then ranks them.
+ */
+
+#ifndef FUZZY_INDEX_H
+#define FUZZY_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "string_view.h"
+
+/* Names are normalized into buffers of this size; longer names are truncated */
+#define FUZZY_MAX_NAME_LENGTH 256
+
+/* Trigrams are encoded over a 37-symbol alphabet: space, a-z, 0-9 */
+#define FUZZY_TRIGRAM_ALPHABET 37
+#define FUZZY_TRIGRAM_COUNT (FUZZY_TRIGRAM_ALPHABET * FUZZY_TRIGRAM_ALPHABET * FUZZY_TRIGRAM_ALPHABET)
+
+typedef struct {
+    /* CSR layout: postings for trigram t are postings[offsets[t] .. offsets[t + 1]),
+       with FUZZY_TRIGRAM_COUNT + 1 offsets */
+    uint32_t* offsets;
+    uint32_t* postings;
+    int name_count;
+} FuzzyIndex;
+
+/**
+ * Normalize text for fuzzy matching: lowercase ASCII letters and digits, with
+ * every other run of bytes collapsed to a single space and the ends trimmed
+ * 
+ * @param text The text to normalize
+ * @param out Receives the normalized text (NUL-terminated)
+ * @param out_size The size of out
+ * @return The length of the normalized text
+ */
+size_t fuzzy_normalize(StringView text, char* out, size_t out_size);
+
+/**
+ * Build a trigram index over a list of names
+ * 
+ * @param index The index to build
+ * @param names The names; the index of each name is its position in this array
+ * @param count The number of names
+ * @return true on success, false if out of memory
+ */
+bool fuzzy_index_build(FuzzyIndex* index, const StringView* names, int count);
+
+/**
+ * Find the names that could be within max_edits of a normalized query
+ * 
+ * Uses the trigram count filter: each edit destroys at most three trigrams,
+ * so a match must share all but 3 * max_edits of the query's trigrams. When
+ * more names pass, only those sharing the most trigrams are kept.
+ * 
+ * @param index The index
+ * @param query The normalized query
+ * @param query_length The length of the query
+ * @param max_edits The largest edit distance that will be accepted
+ * @param max_candidates The most candidates to return
+ * @param candidates Receives a malloc'd array of name positions (caller must free)
+ * @return The number of candidates, or -1 on allocation failure
+ */
+int fuzzy_index_candidates(const FuzzyIndex* index, const char* query, size_t query_length,
+                           int max_edits, int max_candidates, int32_t** candidates);
+
+/**
+ * Compute the edit distance between a pattern and its best match anywhere in
+ * a text, using Myers' bit-parallel algorithm
+ * 
+ * @param pattern The pattern
+ * @param pattern_length The pattern length (at most FUZZY_MAX_NAME_LENGTH
+ *                       bytes are used)
+ * @param text The text to search
+ * @param text_length The text length
+ * @return The smallest number of edits that turns the pattern into a substring of text
+ */
+int fuzzy_edit_distance(const char* pattern, size_t pattern_length,
+                        const char* text, size_t text_length);
+
+/**
+ * Free the memory owned by an index
+ * 
+ * @param index The index to free
+ */
+void fuzzy_index_free(FuzzyIndex* index);
+
+#endif /* FUZZY_INDEX_H */
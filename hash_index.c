@@ -0,0 +1,68 @@
+/**
+ * NeuroChef - Hash Index Implementation
+ * 
+ * This file implements the linear-probing hash index.
+ */
+
+#include "hash_index.h"
+#include <stdlib.h>
+
+bool hash_index_init(HashIndex* index, int expected_count) {
+    /* Keep the load factor at or below one half */
+    uint32_t capacity = 16;
+    while (capacity < (uint32_t)expected_count * 2) {
+        capacity *= 2;
+    }
+
+    index->slots = (HashSlot*)malloc(capacity * sizeof(HashSlot));
+    index->mask = capacity - 1;
+    index->count = 0;
+    if (!index->slots) return false;
+
+    for (uint32_t i = 0; i < capacity; i++) {
+        index->slots[i].hash = 0;
+        index->slots[i].value = HASH_INDEX_EMPTY;
+    }
+    return true;
+}
+
+bool hash_index_insert(HashIndex* index, uint32_t hash, int32_t value) {
+    if ((uint32_t)index->count >= index->mask) return false;
+
+    uint32_t slot = hash & index->mask;
+    while (index->slots[slot].value != HASH_INDEX_EMPTY) {
+        slot = (slot + 1) & index->mask;
+    }
+
+    index->slots[slot].hash = hash;
+    index->slots[slot].value = value;
+    index->count++;
+    return true;
+}
+
+int32_t hash_index_probe(const HashIndex* index, uint32_t hash, uint32_t* cursor) {
+    if (!index->slots) return HASH_INDEX_EMPTY;
+
+    /* The cursor counts probes so far; the table always has an empty slot */
+    while (*cursor <= index->mask) {
+        uint32_t slot = (hash + *cursor) & index->mask;
+        (*cursor)++;
+
+        const HashSlot* entry = &index->slots[slot];
+        if (entry->value == HASH_INDEX_EMPTY) {
+            *cursor = index->mask + 1;
+            break;
+        }
+        if (entry->hash == hash) {
+            return entry->value;
+        }
+    }
+    return HASH_INDEX_EMPTY;
+}
+
+void hash_index_free(HashIndex* index) {
+    free(index->slots);
+    index->slots = NULL;
+    index->mask = 0;
+    index->count = 0;
+}
@@ -0,0 +1,67 @@
+/**
+ * NeuroChef - Hash Index
+ * 
+ * This header declares a fixed-size open-addressing table that maps 32-bit
+ * key hashes to integer values (recipe indices). The table stores only the
+ * hash, so callers confirm each candidate against the real key. It holds no
+ * pointers and can be built once and shared read-only.
+ */
+
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HASH_INDEX_EMPTY (-1)
+
+typedef struct {
+    uint32_t hash;
+    int32_t value;
+} HashSlot;
+
+typedef struct {
+    HashSlot* slots;
+    uint32_t mask;
+    int count;
+} HashIndex;
+
+/**
+ * Allocate an empty index sized for a number of entries
+ * 
+ * @param index The index to initialize
+ * @param expected_count The number of entries that will be inserted
+ * @return true on success, false if out of memory
+ */
+bool hash_index_init(HashIndex* index, int expected_count);
+
+/**
+ * Insert a value under a hash; duplicate hashes are kept in insertion order
+ * 
+ * @param index The index
+ * @param hash The key hash
+ * @param value The non-negative value to store
+ * @return true on success, false if the index is full
+ */
+bool hash_index_insert(HashIndex* index, uint32_t hash, int32_t value);
+
+/**
+ * Return the next value stored under a hash
+ * 
+ * Start with *cursor set to 0 and call repeatedly until HASH_INDEX_EMPTY.
+ * 
+ * @param index The index
+ * @param hash The key hash
+ * @param cursor Probe state, updated on each call
+ * @return The next candidate value, or HASH_INDEX_EMPTY when exhausted
+ */
+int32_t hash_index_probe(const HashIndex* index, uint32_t hash, uint32_t* cursor);
+
+/**
+ * Free the memory owned by an index
+ * 
+ * @param index The index to free
+ */
+void hash_index_free(HashIndex* index);
+
+#endif /* HASH_INDEX_H */
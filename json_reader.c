@@ -0,0 +1,171 @@
+/**
+ * NeuroChef - JSON Reader Implementation
+ * 
+ * This file implements the forward-only JSON tokenizer used by the recipe loader.
+ */
+
+#include "json_reader.h"
+#include "json_scan.h"
+#include <string.h>
+
+static bool is_json_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static void skip_whitespace(JsonReader* reader) {
+    reader->pos = json_scan_nonspace(reader->pos, reader->end);
+}
+
+static bool fail(JsonReader* reader) {
+    reader->error = true;
+    return false;
+}
+
+static bool expect_char(JsonReader* reader, char c) {
+    skip_whitespace(reader);
+    if (reader->pos >= reader->end || *reader->pos != c) {
+        return fail(reader);
+    }
+    reader->pos++;
+    return true;
+}
+
+static const char* find_string_end(const char* p, const char* end) {
+    for (;;) {
+        p = json_scan_string(p, end);
+        if (p >= end) return NULL;
+        if (*p == '"') return p;
+        /* Step over the backslash and the character it escapes */
+        p += 2;
+    }
+}
+
+void json_reader_init(JsonReader* reader, const char* data, size_t length) {
+    reader->start = data;
+    reader->pos = data;
+    reader->end = data + length;
+    reader->error = false;
+}
+
+char json_peek(JsonReader* reader) {
+    skip_whitespace(reader);
+    return reader->pos < reader->end ? *reader->pos : '\0';
+}
+
+bool json_begin_object(JsonReader* reader) {
+    return expect_char(reader, '{');
+}
+
+bool json_begin_array(JsonReader* reader) {
+    return expect_char(reader, '[');
+}
+
+bool json_next_key(JsonReader* reader, const char** key, size_t* key_length) {
+    if (reader->error) return false;
+
+    char c = json_peek(reader);
+    if (c == '}') {
+        reader->pos++;
+        return false;
+    }
+    if (c == ',') {
+        reader->pos++;
+    }
+
+    if (!json_read_string(reader, key, key_length)) return false;
+    return expect_char(reader, ':');
+}
+
+bool json_next_element(JsonReader* reader) {
+    if (reader->error) return false;
+
+    char c = json_peek(reader);
+    if (c == ']') {
+        reader->pos++;
+        return false;
+    }
+    if (c == ',') {
+        reader->pos++;
+        c = json_peek(reader);
+    }
+
+    if (c == '\0') return fail(reader);
+    return true;
+}
+
+bool json_read_string(JsonReader* reader, const char** value, size_t* length) {
+    if (!expect_char(reader, '"')) return false;
+
+    const char* value_end = find_string_end(reader->pos, reader->end);
+    if (!value_end) return fail(reader);
+
+    *value = reader->pos;
+    *length = (size_t)(value_end - reader->pos);
+    reader->pos = value_end + 1;
+    return true;
+}
+
+bool json_read_int(JsonReader* reader, int* value) {
+    skip_whitespace(reader);
+
+    const char* p = reader->pos;
+    bool negative = false;
+    if (p < reader->end && *p == '-') {
+        negative = true;
+        p++;
+    }
+    if (p >= reader->end || *p < '0' || *p > '9') return fail(reader);
+
+    long result = 0;
+    while (p < reader->end && *p >= '0' && *p <= '9') {
+        if (result < 100000000L) {
+            result = result * 10 + (*p - '0');
+        }
+        p++;
+    }
+
+    /* Fractions and exponents are accepted but truncated */
+    while (p < reader->end && (*p == '.' || *p == 'e' || *p == 'E' ||
+                               *p == '+' || *p == '-' || (*p >= '0' && *p <= '9'))) {
+        p++;
+    }
+
+    reader->pos = p;
+    *value = (int)(negative ? -result : result);
+    return true;
+}
+
+bool json_skip_value(JsonReader* reader) {
+    char c = json_peek(reader);
+
+    if (c == '"') {
+        const char* value;
+        size_t length;
+        return json_read_string(reader, &value, &length);
+    }
+
+    if (c == '{' || c == '[') {
+        JsonScanState state = {0, false, false};
+        const char* close = json_scan_container(reader->pos, reader->end, &state);
+        if (close == reader->end) return fail(reader);
+        reader->pos = close + 1;
+        return true;
+    }
+
+    /* Numbers, true, false and null run until the next delimiter */
+    const char* p = reader->pos;
+    while (p < reader->end && *p != ',' && *p != '}' && *p != ']' && !is_json_space(*p)) {
+        p++;
+    }
+    if (p == reader->pos) return fail(reader);
+    reader->pos = p;
+    return true;
+}
+
+bool json_key_equals(const char* key, size_t key_length, const char* literal) {
+    return strlen(literal) == key_length && memcmp(key, literal, key_length) == 0;
+}
+
+size_t json_reader_offset(const JsonReader* reader) {
+    return (size_t)(reader->pos - reader->start);
+}
@@ -0,0 +1,124 @@
+/**
+ * NeuroChef - JSON Reader
+ * 
+ * This header declares a small forward-only JSON tokenizer. The reader walks
+ * a buffer exactly once; strings are returned as raw (still escaped) spans
+ * into the buffer, so no allocation happens while reading.
+ */
+
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    const char* start;
+    const char* pos;
+    const char* end;
+    bool error;
+} JsonReader;
+
+/**
+ * Initialize a reader over a buffer
+ * 
+ * @param reader The reader to initialize
+ * @param data The JSON text (does not need to be NUL-terminated)
+ * @param length The length of the JSON text in bytes
+ */
+void json_reader_init(JsonReader* reader, const char* data, size_t length);
+
+/**
+ * Peek at the next non-whitespace character without consuming it
+ * 
+ * @param reader The reader
+ * @return The next character, or '\0' at the end of input
+ */
+char json_peek(JsonReader* reader);
+
+/**
+ * Consume the opening brace of an object
+ * 
+ * @param reader The reader
+ * @return true if an object was opened, false otherwise
+ */
+bool json_begin_object(JsonReader* reader);
+
+/**
+ * Advance to the next key of the current object
+ * 
+ * Consumes the separating comma, the key and the colon, leaving the reader
+ * positioned at the value. Consumes the closing brace at the end of the object.
+ * 
+ * @param reader The reader
+ * @param key Receives the start of the raw key text
+ * @param key_length Receives the length of the key
+ * @return true if a key was read, false at the end of the object or on error
+ */
+bool json_next_key(JsonReader* reader, const char** key, size_t* key_length);
+
+/**
+ * Consume the opening bracket of an array
+ * 
+ * @param reader The reader
+ * @return true if an array was opened, false otherwise
+ */
+bool json_begin_array(JsonReader* reader);
+
+/**
+ * Advance to the next element of the current array
+ * 
+ * Consumes the separating comma, leaving the reader positioned at the element.
+ * Consumes the closing bracket at the end of the array.
+ * 
+ * @param reader The reader
+ * @return true if an element follows, false at the end of the array or on error
+ */
+bool json_next_element(JsonReader* reader);
+
+/**
+ * Read a string value
+ * 
+ * @param reader The reader
+ * @param value Receives the start of the raw string contents (without quotes)
+ * @param length Receives the length of the raw string contents
+ * @return true on success, false if the next value is not a string
+ */
+bool json_read_string(JsonReader* reader, const char** value, size_t* length);
+
+/**
+ * Read an integer value
+ * 
+ * @param reader The reader
+ * @param value Receives the integer
+ * @return true on success, false if the next value is not a number
+ */
+bool json_read_int(JsonReader* reader, int* value);
+
+/**
+ * Skip over the next value, including nested objects and arrays
+ * 
+ * @param reader The reader
+ * @return true on success, false on malformed input
+ */
+bool json_skip_value(JsonReader* reader);
+
+/**
+ * Compare a raw key against a NUL-terminated literal
+ * 
+ * @param key The raw key text
+ * @param key_length The length of the key
+ * @param literal The literal to compare against
+ * @return true if they are equal
+ */
+bool json_key_equals(const char* key, size_t key_length, const char* literal);
+
+/**
+ * Get the byte offset of the reader within its buffer
+ * 
+ * @param reader The reader
+ * @return The number of bytes consumed so far
+ */
+size_t json_reader_offset(const JsonReader* reader);
+
+#endif /* JSON_READER_H */
@@ -0,0 +1,397 @@
+/**
+ * NeuroChef - JSON Scanning Kernels Implementation
+ * 
+ * This file implements the scalar, SSE2 and AVX2 scanning kernels and the
+ * runtime choice between them. The string and whitespace kernels compare a
+ * block at a time and stop at the lowest set bit of the resulting mask.
+ * 
+ * The container kernel works on 64-byte blocks instead, in the manner of
+ * simdjson's first stage: the vector code only reduces each block to one
+ * bit per byte for quotes, backslashes, openers and closers, and the rest
+ * is done on those 64-bit masks. Escaped characters are found from runs of
+ * backslashes, the bytes inside strings by a prefix XOR over the unescaped
+ * quotes, and only the openers and closers left outside strings are
+ * visited one by one to track the depth. Braces and brackets differ only
+ * in bit 5 ('[' is 0x5B, '{' is 0x7B), so OR-ing in 0x20 lets one
+ * comparison find both. A final partial block is copied into a padded
+ * buffer rather than read past the end.
+ */
+
+#include "json_scan.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define JSON_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+typedef const char* (*ScanFunction)(const char* p, const char* end);
+typedef const char* (*ContainerFunction)(const char* p, const char* end, JsonScanState* state);
+
+static bool is_string_special(char c) {
+    return c == '"' || c == '\\';
+}
+
+static bool is_json_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/* ===== Scalar ===== */
+
+/* Backslashes are followed outside strings too, which only invalid JSON
+   has, so that every kernel stops at the same place on any input: the
+   block kernels find escapes before they know where strings are */
+static const char* scalar_container(const char* p, const char* end, JsonScanState* state) {
+    for (; p < end; p++) {
+        char c = *p;
+        if (state->escaped) {
+            state->escaped = false;
+            /* An escaped quote or backslash is plain text; an escaped
+               bracket outside a string still counts */
+            if (state->in_string || c == '"' || c == '\\') continue;
+        } else if (c == '\\') {
+            state->escaped = true;
+            continue;
+        }
+
+        if (state->in_string) {
+            if (c == '"') {
+                state->in_string = false;
+            }
+        } else if (c == '"') {
+            state->in_string = true;
+        } else if (c == '{' || c == '[') {
+            state->depth++;
+        } else if (c == '}' || c == ']') {
+            if (--state->depth == 0) return p;
+        }
+    }
+    return end;
+}
+
+static const char* scalar_string(const char* p, const char* end) {
+    while (p < end && !is_string_special(*p)) {
+        p++;
+    }
+    return p;
+}
+
+static const char* scalar_nonspace(const char* p, const char* end) {
+    while (p < end && is_json_space(*p)) {
+        p++;
+    }
+    return p;
+}
+
+#ifdef JSON_SCAN_X86
+
+/* ===== Block masks ===== */
+
+/* One bit per byte of a 64-byte block */
+typedef struct {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t open;
+    uint64_t close;
+} BlockMasks;
+
+#define BLOCK_SIZE 64
+
+/* Bit i becomes the XOR of bits 0..i, so a bit is set from each opening
+   quote up to, but not including, its closing quote */
+static uint64_t prefix_xor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+/* Find the bytes escaped by a backslash, up to the last byte of the block
+   that holds input. Most blocks have no backslashes; the rest are walked a
+   backslash at a time, since a backslash that is itself escaped does not
+   escape the byte after it. */
+static uint64_t escaped_bytes(uint64_t backslash, int last, JsonScanState* state) {
+    uint64_t escaped = 0;
+    if (state->escaped) {
+        escaped = 1;
+        backslash &= ~(uint64_t)1;
+        state->escaped = false;
+    }
+    while (backslash) {
+        int i = __builtin_ctzll(backslash);
+        if (i >= last) {
+            state->escaped = i == last;
+            break;
+        }
+        escaped |= (uint64_t)1 << (i + 1);
+        backslash &= ~((uint64_t)3 << i);
+    }
+    return escaped;
+}
+
+/* Track the depth through the first length bytes of a block; returns the
+   offset of the closing bracket, or -1 if the container does not end there */
+static int scan_block(const BlockMasks* masks, int length, JsonScanState* state) {
+    uint64_t valid = length == BLOCK_SIZE ? ~(uint64_t)0 : ((uint64_t)1 << length) - 1;
+    uint64_t quotes = masks->quote & ~escaped_bytes(masks->backslash, length - 1, state) & valid;
+    uint64_t in_string = prefix_xor(quotes);
+    if (state->in_string) in_string = ~in_string;
+    state->in_string = (in_string >> (length - 1)) & 1;
+
+    uint64_t brackets = (masks->open | masks->close) & ~in_string & valid;
+    while (brackets) {
+        int i = __builtin_ctzll(brackets);
+        if (masks->open & ((uint64_t)1 << i)) {
+            state->depth++;
+        } else if (--state->depth == 0) {
+            /* The state so far is for the whole block; at the closer, as
+               after the scalar kernel, the scan is outside any string */
+            state->in_string = false;
+            state->escaped = false;
+            return i;
+        }
+        brackets &= brackets - 1;
+    }
+    return -1;
+}
+
+/* Scan whole blocks with a classifier, then the rest through a padded copy.
+   Inlined into each kernel so that the classifier is inlined too. */
+__attribute__((always_inline))
+static inline const char* scan_blocks(const char* p, const char* end, JsonScanState* state,
+                                      void (*classify)(const char* block, BlockMasks* masks)) {
+    BlockMasks masks;
+    for (; end - p >= BLOCK_SIZE; p += BLOCK_SIZE) {
+        classify(p, &masks);
+        int offset = scan_block(&masks, BLOCK_SIZE, state);
+        if (offset >= 0) return p + offset;
+    }
+    if (p < end) {
+        char padded[BLOCK_SIZE];
+        int length = (int)(end - p);
+        memcpy(padded, p, (size_t)length);
+        memset(padded + length, ' ', (size_t)(BLOCK_SIZE - length));
+        classify(padded, &masks);
+        int offset = scan_block(&masks, length, state);
+        if (offset >= 0) return p + offset;
+    }
+    return end;
+}
+
+/* ===== SSE2 ===== */
+
+__attribute__((target("sse2")))
+static void sse2_classify(const char* block, BlockMasks* masks) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i open = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+
+    memset(masks, 0, sizeof(*masks));
+    for (int i = 0; i < BLOCK_SIZE; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(block + i));
+        __m128i folded = _mm_or_si128(bytes, case_bit);
+        masks->quote |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)) << i;
+        masks->backslash |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, backslash)) << i;
+        masks->open |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(folded, open)) << i;
+        masks->close |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(folded, close)) << i;
+    }
+}
+
+__attribute__((target("sse2")))
+static const char* sse2_container(const char* p, const char* end, JsonScanState* state) {
+    return scan_blocks(p, end, state, sse2_classify);
+}
+
+__attribute__((target("sse2")))
+static const char* sse2_string(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(matches);
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return scalar_string(p, end);
+}
+
+__attribute__((target("sse2")))
+static const char* sse2_nonspace(const char* p, const char* end) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+
+    /* Most runs are a single space; don't start a block for those */
+    if (p < end && !is_json_space(*p)) return p;
+
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        __m128i spaces = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, space),
+                                                   _mm_cmpeq_epi8(block, newline)),
+                                      _mm_or_si128(_mm_cmpeq_epi8(block, carriage_return),
+                                                   _mm_cmpeq_epi8(block, tab)));
+        unsigned int mask = ~(unsigned int)_mm_movemask_epi8(spaces) & 0xFFFFu;
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return scalar_nonspace(p, end);
+}
+
+/* ===== AVX2 ===== */
+
+__attribute__((target("avx2")))
+static void avx2_classify(const char* block, BlockMasks* masks) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i open = _mm256_set1_epi8('{');
+    const __m256i close = _mm256_set1_epi8('}');
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+
+    memset(masks, 0, sizeof(*masks));
+    for (int i = 0; i < BLOCK_SIZE; i += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(block + i));
+        __m256i folded = _mm256_or_si256(bytes, case_bit);
+        masks->quote |= (uint64_t)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, quote)) << i;
+        masks->backslash |= (uint64_t)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, backslash)) << i;
+        masks->open |= (uint64_t)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(folded, open)) << i;
+        masks->close |= (uint64_t)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(folded, close)) << i;
+    }
+}
+
+__attribute__((target("avx2")))
+static const char* avx2_container(const char* p, const char* end, JsonScanState* state) {
+    return scan_blocks(p, end, state, avx2_classify);
+}
+
+__attribute__((target("avx2")))
+static const char* avx2_string(const char* p, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+
+    for (; end - p >= 32; p += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)p);
+        __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(block, quote),
+                                          _mm256_cmpeq_epi8(block, backslash));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(matches);
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return sse2_string(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* avx2_nonspace(const char* p, const char* end) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriage_return = _mm256_set1_epi8('\r');
+    const __m256i tab = _mm256_set1_epi8('\t');
+
+    if (p < end && !is_json_space(*p)) return p;
+
+    for (; end - p >= 32; p += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)p);
+        __m256i spaces = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, space),
+                                                         _mm256_cmpeq_epi8(block, newline)),
+                                         _mm256_or_si256(_mm256_cmpeq_epi8(block, carriage_return),
+                                                         _mm256_cmpeq_epi8(block, tab)));
+        unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(spaces);
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return sse2_nonspace(p, end);
+}
+
+#endif /* JSON_SCAN_X86 */
+
+/* ===== Dispatch ===== */
+
+typedef struct {
+    ContainerFunction container;
+    ScanFunction string;
+    ScanFunction nonspace;
+} ScanKernels;
+
+static const ScanKernels KERNELS[] = {
+    [JSON_SCAN_SCALAR] = { scalar_container, scalar_string, scalar_nonspace },
+#ifdef JSON_SCAN_X86
+    [JSON_SCAN_SSE2] = { sse2_container, sse2_string, sse2_nonspace },
+    [JSON_SCAN_AVX2] = { avx2_container, avx2_string, avx2_nonspace },
+#endif
+};
+
+static const char* resolve_container(const char* p, const char* end, JsonScanState* state);
+static const char* resolve_string(const char* p, const char* end);
+static const char* resolve_nonspace(const char* p, const char* end);
+
+/* Each starts as a stub that picks the kernel on first use; written
+   atomically, since any thread may get there first */
+static ContainerFunction scan_container = resolve_container;
+static ScanFunction scan_string = resolve_string;
+static ScanFunction scan_nonspace = resolve_nonspace;
+static JsonScanKernel current_kernel = JSON_SCAN_SCALAR;
+
+JsonScanKernel json_scan_best_kernel(void) {
+#ifdef JSON_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return JSON_SCAN_AVX2;
+    if (__builtin_cpu_supports("sse2")) return JSON_SCAN_SSE2;
+#endif
+    return JSON_SCAN_SCALAR;
+}
+
+bool json_scan_set_kernel(JsonScanKernel kernel) {
+    if (kernel > json_scan_best_kernel()) return false;
+
+    __atomic_store_n(&current_kernel, kernel, __ATOMIC_RELAXED);
+    __atomic_store_n(&scan_container, KERNELS[kernel].container, __ATOMIC_RELAXED);
+    __atomic_store_n(&scan_string, KERNELS[kernel].string, __ATOMIC_RELAXED);
+    __atomic_store_n(&scan_nonspace, KERNELS[kernel].nonspace, __ATOMIC_RELAXED);
+    return true;
+}
+
+JsonScanKernel json_scan_kernel(void) {
+    if (__atomic_load_n(&scan_nonspace, __ATOMIC_RELAXED) == resolve_nonspace) {
+        json_scan_set_kernel(json_scan_best_kernel());
+    }
+    return __atomic_load_n(&current_kernel, __ATOMIC_RELAXED);
+}
+
+const char* json_scan_kernel_name(JsonScanKernel kernel) {
+    switch (kernel) {
+        case JSON_SCAN_AVX2: return "avx2";
+        case JSON_SCAN_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+static const char* resolve_container(const char* p, const char* end, JsonScanState* state) {
+    json_scan_set_kernel(json_scan_best_kernel());
+    return json_scan_container(p, end, state);
+}
+
+static const char* resolve_string(const char* p, const char* end) {
+    json_scan_set_kernel(json_scan_best_kernel());
+    return json_scan_string(p, end);
+}
+
+static const char* resolve_nonspace(const char* p, const char* end) {
+    json_scan_set_kernel(json_scan_best_kernel());
+    return json_scan_nonspace(p, end);
+}
+
+const char* json_scan_container(const char* p, const char* end, JsonScanState* state) {
+    return __atomic_load_n(&scan_container, __ATOMIC_RELAXED)(p, end, state);
+}
+
+const char* json_scan_string(const char* p, const char* end) {
+    return __atomic_load_n(&scan_string, __ATOMIC_RELAXED)(p, end);
+}
+
+const char* json_scan_nonspace(const char* p, const char* end) {
+    return __atomic_load_n(&scan_nonspace, __ATOMIC_RELAXED)(p, end);
+}
@@ -0,0 +1,95 @@
+/**
+ * NeuroChef - JSON Scanning Kernels
+ * 
+ * This header declares the byte searches the JSON readers spend their time
+ * in: finding the end of an object or array, the next quote or backslash
+ * inside a string, and the end of a run of whitespace. On x86 they compare
+ * 16 (SSE2) or 32 (AVX2) bytes at a time; elsewhere they fall back to a
+ * plain loop. The fastest kernel the processor supports is chosen the first
+ * time one is used.
+ */
+
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <stdbool.h>
+
+typedef enum {
+    JSON_SCAN_SCALAR,
+    JSON_SCAN_SSE2,
+    JSON_SCAN_AVX2
+} JsonScanKernel;
+
+/* Where a container scan stopped, so it can resume in the next buffer */
+typedef struct {
+    int depth;
+    bool in_string;
+    /* The next byte is escaped by a backslash */
+    bool escaped;
+} JsonScanState;
+
+/**
+ * Find the end of an object or array, skipping brackets inside strings
+ * 
+ * Start with a zeroed state at the opening bracket. If the container does
+ * not end before end, the state records where the scan stopped and the
+ * next call continues from there. A backslash escapes the byte after it
+ * wherever it appears, so every kernel stops at the same place even on
+ * invalid JSON.
+ * 
+ * @param p Where to start or resume scanning
+ * @param end The end of the buffer
+ * @param state The scan state
+ * @return The closing bracket of the container, or end
+ */
+const char* json_scan_container(const char* p, const char* end, JsonScanState* state);
+
+/**
+ * Find the next quote or backslash, as when scanning a string's contents
+ * 
+ * @param p Where to start searching
+ * @param end The end of the buffer
+ * @return The first quote or backslash, or end if there is none
+ */
+const char* json_scan_string(const char* p, const char* end);
+
+/**
+ * Skip JSON whitespace
+ * 
+ * @param p Where to start searching
+ * @param end The end of the buffer
+ * @return The first character that is not whitespace, or end
+ */
+const char* json_scan_nonspace(const char* p, const char* end);
+
+/**
+ * Get the fastest kernel this processor supports
+ * 
+ * @return The kernel
+ */
+JsonScanKernel json_scan_best_kernel(void);
+
+/**
+ * Use a particular kernel from now on, e.g. to compare them
+ * 
+ * @param kernel The kernel
+ * @return true if it was selected, false if the processor does not support it
+ */
+bool json_scan_set_kernel(JsonScanKernel kernel);
+
+/**
+ * Get the kernel in use
+ * 
+ * @return The kernel
+ */
+JsonScanKernel json_scan_kernel(void);
+
+/**
+ * Get a kernel's name, e.g. "avx2"
+ * 
+ * @param kernel The kernel
+ * @return The name, a string literal
+ */
+const char* json_scan_kernel_name(JsonScanKernel kernel);
+
+#endif /* JSON_SCAN_H */
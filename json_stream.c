@@ -0,0 +1,230 @@
+/**
+ * NeuroChef - JSON Stream Implementation
+ * 
+ * This file implements the chunked JSON reader. Consumed input is dropped
+ * from the front of the buffer whenever the next chunk is read, so the
+ * buffer only ever holds the value being scanned plus one chunk.
+ */
+
+#include "json_stream.h"
+#include "json_scan.h"
+#include <stdlib.h>
+#include <string.h>
+
+static bool is_json_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static bool fail(JsonStream* stream) {
+    stream->error = true;
+    return false;
+}
+
+/* Drop consumed input and append the next chunk; returns false at the end
+   of the file or on a read error */
+static bool fill(JsonStream* stream) {
+    if (stream->eof || stream->error) return false;
+
+    if (stream->pos > 0) {
+        memmove(stream->buffer, stream->buffer + stream->pos, stream->end - stream->pos);
+        stream->base += stream->pos;
+        stream->end -= stream->pos;
+        stream->pos = 0;
+    }
+
+    if (stream->end + stream->chunk_size > stream->capacity) {
+        size_t new_capacity = stream->capacity * 2;
+        if (new_capacity < stream->end + stream->chunk_size) {
+            new_capacity = stream->end + stream->chunk_size;
+        }
+        char* new_buffer = (char*)realloc(stream->buffer, new_capacity);
+        if (!new_buffer) return fail(stream);
+        stream->buffer = new_buffer;
+        stream->capacity = new_capacity;
+    }
+
+    size_t read = fread(stream->buffer + stream->end, 1, stream->chunk_size, stream->file);
+    stream->end += read;
+    if (read == 0) {
+        if (ferror(stream->file)) return fail(stream);
+        stream->eof = true;
+        return false;
+    }
+    return true;
+}
+
+/* Find the end of the value at pos, reading more input as needed. When
+   keep is false, scanned input is dropped as it goes and only the length
+   of the tail still buffered is meaningful. */
+static bool scan_value(JsonStream* stream, bool keep, size_t* length) {
+    char first = json_stream_peek(stream);
+    if (first == '\0') return fail(stream);
+    if (first == ',' || first == '}' || first == ']' || first == ':') return fail(stream);
+
+    bool container = first == '{' || first == '[';
+    bool string = first == '"';
+    JsonScanState state = {0, false, false};
+    /* Peeking buffered the first character; a string starts past its quote */
+    size_t i = string ? 1 : 0;
+
+    for (;;) {
+        if (stream->pos + i == stream->end) {
+            if (!keep) {
+                stream->pos += i;
+                i = 0;
+            }
+            if (!fill(stream)) {
+                /* A number or literal may run to the end of the input */
+                if (!container && !string && !stream->error) break;
+                return fail(stream);
+            }
+        }
+
+        const char* cursor = stream->buffer + stream->pos + i;
+        const char* window_end = stream->buffer + stream->end;
+        if (container) {
+            const char* close = json_scan_container(cursor, window_end, &state);
+            i += (size_t)(close - cursor);
+            if (close < window_end) {
+                i++;
+                break;
+            }
+        } else if (string) {
+            if (state.escaped) {
+                state.escaped = false;
+                i++;
+                continue;
+            }
+            const char* next = json_scan_string(cursor, window_end);
+            i += (size_t)(next - cursor);
+            if (next == window_end) continue;
+            i++;
+            if (*next == '"') break;
+            state.escaped = true;
+        } else {
+            char c = *cursor;
+            if (c == ',' || c == '}' || c == ']' || is_json_space(c)) break;
+            i++;
+        }
+    }
+
+    *length = i;
+    return true;
+}
+
+bool json_stream_open(JsonStream* stream, const char* path, size_t chunk_size) {
+    memset(stream, 0, sizeof(*stream));
+    stream->chunk_size = chunk_size > 0 ? chunk_size : JSON_STREAM_CHUNK_SIZE;
+
+    if (strcmp(path, "-") == 0) {
+        stream->file = stdin;
+    } else {
+        stream->file = fopen(path, "rb");
+        stream->owns_file = true;
+    }
+    return stream->file != NULL;
+}
+
+void json_stream_close(JsonStream* stream) {
+    if (stream->file && stream->owns_file) {
+        fclose(stream->file);
+    }
+    free(stream->buffer);
+    memset(stream, 0, sizeof(*stream));
+}
+
+char json_stream_peek(JsonStream* stream) {
+    for (;;) {
+        while (stream->pos < stream->end && is_json_space(stream->buffer[stream->pos])) {
+            stream->pos++;
+        }
+        if (stream->pos < stream->end) return stream->buffer[stream->pos];
+        if (!fill(stream)) return '\0';
+    }
+}
+
+static bool expect_char(JsonStream* stream, char c) {
+    if (json_stream_peek(stream) != c) return fail(stream);
+    stream->pos++;
+    return true;
+}
+
+bool json_stream_begin_object(JsonStream* stream) {
+    return expect_char(stream, '{');
+}
+
+bool json_stream_begin_array(JsonStream* stream) {
+    return expect_char(stream, '[');
+}
+
+bool json_stream_next_key(JsonStream* stream, const char** key, size_t* key_length) {
+    if (stream->error) return false;
+
+    char c = json_stream_peek(stream);
+    if (c == '}') {
+        stream->pos++;
+        return false;
+    }
+    if (c == ',') {
+        stream->pos++;
+        c = json_stream_peek(stream);
+    }
+    if (c != '"') return fail(stream);
+
+    size_t length;
+    if (!scan_value(stream, true, &length)) return false;
+
+    /* Find the colon without consuming the key, so reading more input
+       cannot drop it */
+    size_t i = length;
+    for (;;) {
+        if (stream->pos + i == stream->end && !fill(stream)) return fail(stream);
+        char next = stream->buffer[stream->pos + i];
+        if (next == ':') break;
+        if (!is_json_space(next)) return fail(stream);
+        i++;
+    }
+
+    *key = stream->buffer + stream->pos + 1;
+    *key_length = length - 2;
+    stream->pos += i + 1;
+    return true;
+}
+
+bool json_stream_next_element(JsonStream* stream) {
+    if (stream->error) return false;
+
+    char c = json_stream_peek(stream);
+    if (c == ']') {
+        stream->pos++;
+        return false;
+    }
+    if (c == ',') {
+        stream->pos++;
+        c = json_stream_peek(stream);
+    }
+
+    if (c == '\0') return fail(stream);
+    return true;
+}
+
+bool json_stream_read_value(JsonStream* stream, JsonReader* reader) {
+    size_t length;
+    if (!scan_value(stream, true, &length)) return false;
+
+    json_reader_init(reader, stream->buffer + stream->pos, length);
+    stream->pos += length;
+    return true;
+}
+
+bool json_stream_skip_value(JsonStream* stream) {
+    size_t length;
+    if (!scan_value(stream, false, &length)) return false;
+
+    stream->pos += length;
+    return true;
+}
+
+size_t json_stream_offset(const JsonStream* stream) {
+    return stream->base + stream->pos;
+}
@@ -0,0 +1,124 @@
+/**
+ * NeuroChef - JSON Stream
+ * 
+ * This header declares a forward-only JSON reader over a file that is read
+ * in fixed-size chunks instead of all at once. Objects, arrays and keys are
+ * walked one token at a time; a single value can be buffered whole and
+ * handed to a JsonReader. Only the current value is held in memory, so the
+ * buffer grows to the largest value read, not to the size of the file.
+ * 
+ * Spans handed out (keys and buffered values) stay valid until the next
+ * call on the stream.
+ */
+
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "json_reader.h"
+
+/* Bytes read from the file at a time */
+#define JSON_STREAM_CHUNK_SIZE (1024 * 1024)
+
+typedef struct {
+    FILE* file;
+    bool owns_file;
+    char* buffer;
+    size_t capacity;
+    size_t chunk_size;
+    /* Unread input is buffer[pos, end) */
+    size_t pos;
+    size_t end;
+    /* File offset of buffer[0] */
+    size_t base;
+    bool eof;
+    bool error;
+} JsonStream;
+
+/**
+ * Open a file for streaming
+ * 
+ * @param stream The stream to initialize
+ * @param path The file to read, or "-" for standard input
+ * @param chunk_size Bytes to read at a time, or 0 for JSON_STREAM_CHUNK_SIZE
+ * @return true on success, false if the file could not be opened
+ */
+bool json_stream_open(JsonStream* stream, const char* path, size_t chunk_size);
+
+/**
+ * Close the file and free the buffer
+ * 
+ * @param stream The stream to close
+ */
+void json_stream_close(JsonStream* stream);
+
+/**
+ * Peek at the next non-whitespace character without consuming it
+ * 
+ * @param stream The stream
+ * @return The next character, or '\0' at the end of input
+ */
+char json_stream_peek(JsonStream* stream);
+
+/**
+ * Consume the opening brace of an object
+ * 
+ * @param stream The stream
+ * @return true if an object was opened, false otherwise
+ */
+bool json_stream_begin_object(JsonStream* stream);
+
+/**
+ * Advance to the next key of the current object, as json_next_key does
+ * 
+ * @param stream The stream
+ * @param key Receives the start of the raw key text
+ * @param key_length Receives the length of the key
+ * @return true if a key was read, false at the end of the object or on error
+ */
+bool json_stream_next_key(JsonStream* stream, const char** key, size_t* key_length);
+
+/**
+ * Consume the opening bracket of an array
+ * 
+ * @param stream The stream
+ * @return true if an array was opened, false otherwise
+ */
+bool json_stream_begin_array(JsonStream* stream);
+
+/**
+ * Advance to the next element of the current array, as json_next_element does
+ * 
+ * @param stream The stream
+ * @return true if an element follows, false at the end of the array or on error
+ */
+bool json_stream_next_element(JsonStream* stream);
+
+/**
+ * Buffer the whole next value and point a reader at it
+ * 
+ * @param stream The stream
+ * @param reader Receives a reader over exactly the value
+ * @return true on success, false on malformed or truncated input
+ */
+bool json_stream_read_value(JsonStream* stream, JsonReader* reader);
+
+/**
+ * Skip over the next value without buffering it
+ * 
+ * @param stream The stream
+ * @return true on success, false on malformed or truncated input
+ */
+bool json_stream_skip_value(JsonStream* stream);
+
+/**
+ * Get the byte offset of the stream within its file
+ * 
+ * @param stream The stream
+ * @return The number of bytes consumed so far
+ */
+size_t json_stream_offset(const JsonStream* stream);
+
+#endif /* JSON_STREAM_H */
@@ -2,160 +2,387 @@
  * NeuroChef - A chatbot for neurodivergent meal planning
  * 
  * This program provides a command-line interface for the NeuroChef chatbot.
- * It handles user input and processes recipe queries in C, falling back to
- * Python for other types of queries.
+ * It handles user input and processes recipe and meal-planning queries in C,
+ * falling back to Python for other types of queries.
  */
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include "query_context.h"
+#include "recipe_store.h"
 #include "recipe_utils.h"
+#include "response_cache.h"
+#include "server.h"
+#include "snapshot.h"
+#include "thread_pool.h"
+#ifdef NEUROCHEF_EMBED_PYTHON
+#include "python_bridge.h"
+#endif
 
 #define MAX_INPUT_SIZE 1024
-#define MAX_OUTPUT_SIZE 4096
-#define MAX_COMMAND_SIZE (MAX_INPUT_SIZE * 2 + 100)
-#define JSON_PATH "C:/Users/valky/Repos/neurochef/meal_data.json"
+#define RESPONSE_CACHE_CAPACITY 256
+#define BATCH_OUTPUT_BUFFER_SIZE (1 << 16)
+/* Queries read and answered together; output is written per block */
+#define BATCH_BLOCK_SIZE 4096
+#define DEFAULT_JSON_PATH "meal_data.json"
 
-static RecipeDB* recipe_db = NULL;
+/**
+ * Where the recipe database comes from, for the first load and for reloads
+ */
+typedef struct {
+    const char* json_path;
+    char* snapshot_path;
+    bool precompute;
+    FILE* messages;
+} DatabaseSource;
+
+static RecipeStore recipe_store;
+/* Interactive progress messages; batch mode turns them off */
+static bool verbose = true;
 
 /**
- * Call the Python script and get the response
+ * Read one line of any length, without the line terminator
  * 
- * @param input The user input to process
- * @return The response from the Python script
+ * @param stream The stream to read from
+ * @param line The builder to read into; it is reset first
+ * @return true if a line was read, false at end of input or out of memory
  */
-char* get_python_response(const char* input) {
-    char command[MAX_COMMAND_SIZE];
-    
-    // Call the Python module directly
-    // Escape quotes in the input to prevent command injection
-    char escaped_input[MAX_INPUT_SIZE * 2];
-    int j = 0;
-    for (int i = 0; input[i] != '\0'; i++) {
-        if (input[i] == '"' || input[i] == '\\') {
-            escaped_input[j++] = '\\';
-        }
-        escaped_input[j++] = input[i];
-    }
-    escaped_input[j] = '\0';
-
-    snprintf(command, sizeof(command), 
-             "python -m neurochef.logic \"%s\"", 
-             escaped_input);
+static bool read_line(FILE* stream, StringBuilder* line) {
+    char chunk[MAX_INPUT_SIZE];
 
-    FILE* pipe = popen(command, "r");
-    if (!pipe) {
-        return "Error: Failed to run Python script.";
+    sb_reset(line);
+    while (fgets(chunk, sizeof(chunk), stream)) {
+        size_t length = strlen(chunk);
+        bool complete = length > 0 && chunk[length - 1] == '\n';
+        if (!sb_append(line, chunk, length)) return false;
+        if (complete) break;
     }
+    if (line->length == 0) return false;
 
-    static char output[MAX_OUTPUT_SIZE];
-    if (!fgets(output, sizeof(output), pipe)) {
-        int exit_code = pclose(pipe);
-        if (exit_code != 0) {
-            if (strstr(command, "python") != NULL) {
-                return "Error: Python not found. Please ensure Python is installed and in your PATH.";
-            }
-            return "Error: Failed to execute command.";
-        }
-        return "No output from command.";
+    while (line->length > 0 &&
+           (line->data[line->length - 1] == '\n' || line->data[line->length - 1] == '\r')) {
+        sb_truncate(line, line->length - 1);
     }
+    return true;
+}
 
-    pclose(pipe);
-    
-    return output;
+/**
+ * One block of batch queries and the records rendered for them
+ */
+typedef struct {
+    QueryContext* contexts;     /* One per worker */
+    StringBuilder* outputs;     /* Records each worker rendered, in task order per worker */
+    StringBuilder queries;      /* The block's queries, each NUL-terminated */
+    size_t* query_offsets;
+    size_t* record_offsets;
+    size_t* record_lengths;
+    int* record_workers;
+    size_t count;
+} BatchBlock;
+
+/**
+ * Answer one batch query and append its JSON record to the worker's output
+ */
+static void run_batch_query(void* argument, int worker, size_t task) {
+    BatchBlock* block = (BatchBlock*)argument;
+    StringBuilder* record = &block->outputs[worker];
+    const char* query = block->queries.data + block->query_offsets[task];
+
+    struct timespec start, end;
+    ResponseInfo info;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const char* response = query_context_respond(&block->contexts[worker], query, &info);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long long latency_ns = (long long)(end.tv_sec - start.tv_sec) * 1000000000LL
+                         + (end.tv_nsec - start.tv_nsec);
+
+    size_t record_start = record->length;
+    append_response_json(record, block->contexts[worker].db, query, &info, response, latency_ns);
+
+    block->record_offsets[task] = record_start;
+    block->record_lengths[task] = record->length - record_start;
+    block->record_workers[task] = worker;
 }
 
 /**
- * Process user input and generate a response
+ * Answer one query per input line and write one JSON object per line
  * 
- * @param input The user input to process
- * @return The response to the user
+ * Queries are read in blocks and spread over the workers; records are
+ * written in input order whatever order the workers finish in.
+ * 
+ * @param path The file to read queries from, or "-" for standard input
+ * @param contexts One query context per worker
+ * @param pool The workers
+ * @return 0 on success, 1 if the input could not be read or memory ran out
  */
-char* process_input(const char* input) {
-    if (is_recipe_query(input)) {
-        printf("Processing as recipe query: %s\n", input);
-
-        QueryResult result = process_recipe_query(recipe_db, input);
-        
-        if (result.success) {
-            char* response = strdup(result.response);
-            free_query_result(&result);
-            return response;
-        } else {
-            char* error = strdup(result.response);
-            free_query_result(&result);
+static int run_batch(const char* path, QueryContext* contexts, ThreadPool* pool) {
+    FILE* stream = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!stream) {
+        fprintf(stderr, "Failed to open batch input: %s\n", path);
+        return 1;
+    }
 
-            if (strstr(error, "I couldn't find a recipe") == NULL) {
-                free(error);
-                printf("Recipe query processing failed, falling back to Python\n");
-                return get_python_response(input);
-            }
-            
-            return error;
-        }
+    BatchBlock block;
+    block.contexts = contexts;
+    block.outputs = (StringBuilder*)malloc((size_t)pool->thread_count * sizeof(StringBuilder));
+    block.query_offsets = (size_t*)malloc(BATCH_BLOCK_SIZE * sizeof(size_t));
+    block.record_offsets = (size_t*)malloc(BATCH_BLOCK_SIZE * sizeof(size_t));
+    block.record_lengths = (size_t*)malloc(BATCH_BLOCK_SIZE * sizeof(size_t));
+    block.record_workers = (int*)malloc(BATCH_BLOCK_SIZE * sizeof(int));
+    sb_init(&block.queries);
+
+    StringBuilder line;
+    sb_init(&line);
+
+    int exit_code = 0;
+    if (!block.outputs || !block.query_offsets || !block.record_offsets ||
+        !block.record_lengths || !block.record_workers) {
+        fprintf(stderr, "Out of memory starting batch\n");
+        free(block.outputs);
+        block.outputs = NULL;
+        exit_code = 1;
     } else {
-        printf("Not a recipe query, using Python: %s\n", input);
-
-        char* query_lower = str_to_lower(input);
-        if (query_lower) {
-            if (strstr(query_lower, "what should i") || 
-                strstr(query_lower, "suggest") || 
-                strstr(query_lower, "recommend") ||
-                (strstr(query_lower, "what are") && strstr(query_lower, "food"))) {
-                
-                free(query_lower);
-
-                char response[MAX_OUTPUT_SIZE];
-                snprintf(response, sizeof(response), 
-                         "I can tell you about specific recipes like Berry Blast Smoothie, "
-                         "Creamy Garlic Mashed Potatoes, Mild Chicken Salad, or Soft Baked Sweet Potato. "
-                         "Try asking something like 'What is in Berry Blast Smoothie?' or "
-                         "'How do I make Soft Baked Sweet Potato?'");
-                
-                return strdup(response);
-            }
-            free(query_lower);
+        for (int i = 0; i < pool->thread_count; i++) {
+            sb_init(&block.outputs[i]);
+        }
+    }
+
+    bool more = block.outputs != NULL;
+    while (more) {
+        sb_reset(&block.queries);
+        block.count = 0;
+        while (block.count < BATCH_BLOCK_SIZE && (more = read_line(stream, &line))) {
+            if (line.length == 0) continue;
+            block.query_offsets[block.count++] = block.queries.length;
+            sb_append(&block.queries, line.data, line.length);
+            sb_append(&block.queries, "", 1);
+        }
+        if (block.count == 0) break;
+
+        thread_pool_run(pool, block.count, run_batch_query, &block);
+
+        bool failed = block.queries.failed;
+        for (int i = 0; i < pool->thread_count; i++) {
+            failed = failed || block.outputs[i].failed;
+        }
+        if (failed) {
+            fprintf(stderr, "Out of memory writing batch output\n");
+            exit_code = 1;
+            break;
+        }
+
+        for (size_t i = 0; i < block.count; i++) {
+            const StringBuilder* output = &block.outputs[block.record_workers[i]];
+            fwrite(output->data + block.record_offsets[i], 1, block.record_lengths[i], stdout);
+        }
+        for (int i = 0; i < pool->thread_count; i++) {
+            sb_reset(&block.outputs[i]);
+            query_context_release(&contexts[i]);
         }
-        
-        return get_python_response(input);
     }
+
+    if (stream != stdin) {
+        fclose(stream);
+    }
+    if (block.outputs) {
+        for (int i = 0; i < pool->thread_count; i++) {
+            sb_free(&block.outputs[i]);
+        }
+        free(block.outputs);
+    }
+    free(block.query_offsets);
+    free(block.record_offsets);
+    free(block.record_lengths);
+    free(block.record_workers);
+    sb_free(&block.queries);
+    sb_free(&line);
+    fflush(stdout);
+    return exit_code;
 }
 
 /**
- * Initialize the recipe database
+ * Load the recipe database, from its snapshot when one is up to date
  * 
- * @return 0 on success, -1 on failure
+ * @param source Where to load from
+ * @param snapshot_status Receives whether the snapshot was used
+ * @return The database, or NULL on failure
  */
-int init_database() {
-    recipe_db = init_recipe_db(JSON_PATH);
+static RecipeDB* load_database(const DatabaseSource* source, SnapshotStatus* snapshot_status) {
+    RecipeDB* db = open_recipe_db(source->json_path, source->snapshot_path, snapshot_status);
     
-    if (!recipe_db) {
+    if (!db) {
         fprintf(stderr, "Failed to initialize recipe database\n");
-        return -1;
+        return NULL;
     }
     
-    if (recipe_db->error_message) {
-        fprintf(stderr, "Error initializing recipe database: %s\n", recipe_db->error_message);
-        free_recipe_db(recipe_db);
-        recipe_db = NULL;
-        return -1;
+    if (db->error_message) {
+        fprintf(stderr, "Error initializing recipe database: %s\n", db->error_message);
+        free_recipe_db(db);
+        return NULL;
     }
     
-    return 0;
+    db->verbose = verbose;
+    if (source->precompute && !precompute_recipe_responses(db)) {
+        fprintf(source->messages, "Warning: Not enough memory to precompute responses.\n");
+    }
+    return db;
+}
+
+/**
+ * Build a new database after the recipe file changed; runs on the
+ * recipe store's watcher thread while queries carry on
+ * 
+ * @param context The DatabaseSource
+ * @return The database, or NULL to keep the current one
+ */
+static RecipeDB* reload_database(void* context) {
+    const DatabaseSource* source = (const DatabaseSource*)context;
+    SnapshotStatus snapshot_status;
+    RecipeDB* db = load_database(source, &snapshot_status);
+    if (db) {
+        fprintf(source->messages, "Reloaded %d recipes from %s.\n", db->recipe_count, source->json_path);
+    } else {
+        fprintf(source->messages, "Warning: Keeping the current recipes; %s could not be loaded.\n",
+                source->json_path);
+    }
+    fflush(source->messages);
+    return db;
+}
+
+/**
+ * Compile a JSON recipe file into a snapshot
+ * 
+ * The file is streamed rather than mapped, so compiling needs memory for
+ * the recipes but not for the whole file.
+ * 
+ * @param json_path The JSON file
+ * @param snapshot_path Where to write the snapshot
+ * @return 0 on success, 1 on failure
+ */
+static int compile_snapshot(const char* json_path, const char* snapshot_path) {
+    RecipeDB* db = init_recipe_db_streaming(json_path);
+    if (!db || db->error_message) {
+        fprintf(stderr, "Error loading %s: %s\n", json_path,
+                db ? db->error_message : "out of memory");
+        free_recipe_db(db);
+        return 1;
+    }
+
+    const char* error = write_recipe_snapshot(db, json_path, snapshot_path);
+    if (error) {
+        fprintf(stderr, "Error writing %s: %s\n", snapshot_path, error);
+    } else {
+        printf("Wrote %d recipes to %s.\n", db->recipe_count, snapshot_path);
+    }
+    free_recipe_db(db);
+    return error ? 1 : 0;
+}
+
+/**
+ * Print command-line usage
+ * 
+ * @param program The name the program was run as
+ */
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--data <file>] [--no-reload] [--precompute]\n"
+                    "           [--batch <file|-> | --serve <address>] [--threads <n>]\n", program);
+    fprintf(stderr, "       %s --compile-snapshot <json> <snapshot>\n", program);
+    fprintf(stderr, "  --data <file>     Recipe file to load (default: %s)\n", DEFAULT_JSON_PATH);
+    fprintf(stderr, "  --no-reload       Do not reload the recipe file when it changes\n");
+    fprintf(stderr, "  --precompute      Render all recipe responses at startup (more memory, faster answers)\n");
+    fprintf(stderr, "  --batch <file|->  Answer one query per line and print one JSON object per line\n");
+    fprintf(stderr, "  --serve <address> Answer clients on a Unix socket path or [host:]port (Linux only)\n");
+    fprintf(stderr, "  --threads <n>     Worker threads for loading, --batch and --serve (default: one per processor)\n");
+    fprintf(stderr, "  --compile-snapshot Write a binary snapshot of a recipe file; the .ncdb file\n");
+    fprintf(stderr, "                    next to the recipe file is loaded instead of parsing it\n");
 }
 
 /**
  * Main function
  */
-int main() {
+int main(int argc, char* argv[]) {
     char input[MAX_INPUT_SIZE];
+    bool precompute = false;
+    bool reload = true;
+    const char* json_path = DEFAULT_JSON_PATH;
+    const char* batch_path = NULL;
+    const char* serve_address = NULL;
+    int thread_count = thread_pool_default_size();
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--precompute") == 0) {
+            precompute = true;
+        } else if (strcmp(argv[i], "--data") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--no-reload") == 0) {
+            reload = false;
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_path = argv[++i];
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            serve_address = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            thread_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--compile-snapshot") == 0 && i == 1 && argc == 4) {
+            return compile_snapshot(argv[2], argv[3]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (batch_path && serve_address) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    set_recipe_loader_threads(thread_count);
 
-    printf("Welcome to NeuroChef!\n");
+    /* The python command answers from the same file; set before any thread starts */
+#ifdef _WIN32
+    _putenv_s("NEUROCHEF_DATA", json_path);
+#else
+    setenv("NEUROCHEF_DATA", json_path, 1);
+#endif
 
-    if (init_database() != 0) {
-        printf("Warning: Recipe database initialization failed. Falling back to Python only.\n");
+    /* In batch mode stdout carries only JSON lines; messages go to stderr */
+    FILE* messages = stdout;
+    if (serve_address) {
+        verbose = false;
+    } else if (batch_path) {
+        verbose = false;
+        messages = stderr;
+        setvbuf(stdout, NULL, _IOFBF, BATCH_OUTPUT_BUFFER_SIZE);
     } else {
-        printf("Recipe database loaded with %d recipes.\n", recipe_db->recipe_count);
+        printf("Welcome to NeuroChef!\n");
+    }
+
+    DatabaseSource source;
+    source.json_path = json_path;
+    source.snapshot_path = default_snapshot_path(json_path);
+    source.precompute = precompute;
+    source.messages = messages;
+
+    SnapshotStatus snapshot_status;
+    RecipeDB* recipe_db = load_database(&source, &snapshot_status);
+    if (!recipe_db) {
+        fprintf(messages, "Warning: Recipe database initialization failed. Falling back to Python only.\n");
+    } else {
+        if (snapshot_status == SNAPSHOT_STALE || snapshot_status == SNAPSHOT_INVALID) {
+            fprintf(messages, "Warning: Recipe snapshot is %s; loaded the JSON file instead.\n",
+                    snapshot_status_name(snapshot_status));
+        }
+        if (verbose) {
+            printf("Recipe database loaded with %d recipes%s.\n", recipe_db->recipe_count,
+                   snapshot_status == SNAPSHOT_LOADED ? " from its snapshot" : "");
+            if (recipe_db->response_blob) {
+                printf("Precomputed responses: %zu KB.\n", recipe_db->response_blob_size / 1024);
+            }
+        }
+    }
+
+    if (verbose && recipe_db) {
         printf("You can now ask questions about specific recipes, like:\n");
         printf("- What is in Berry Blast Smoothie?\n");
         printf("- How do I make Creamy Garlic Mashed Potatoes?\n");
@@ -163,7 +390,55 @@ int main() {
         printf("- How long does it take to make Soft Baked Sweet Potato?\n");
     }
 
-    while (1) {
+#ifdef NEUROCHEF_EMBED_PYTHON
+    if (!python_bridge_init(NEUROCHEF_PYTHON_ROOT, json_path)) {
+        fprintf(messages, "Warning: Embedded Python unavailable. Falling back to the python command.\n");
+    }
+#endif
+
+    /* Queries read the database through the store, which swaps in reloads */
+    if (!recipe_store_init(&recipe_store, recipe_db)) {
+        fprintf(stderr, "Failed to initialize the recipe store\n");
+        return 1;
+    }
+    if (reload && !recipe_store_watch(&recipe_store, json_path, reload_database, &source)) {
+        fprintf(messages, "Warning: Cannot watch %s; changes need a restart.\n", json_path);
+    }
+
+    /* Each worker gets a context */
+    int context_count = batch_path ? thread_count : 1;
+    ThreadPool pool;
+    if (!thread_pool_init(&pool, context_count)) {
+        fprintf(messages, "Warning: Failed to start %d worker threads. Using one.\n", context_count);
+        context_count = 1;
+        thread_pool_init(&pool, context_count);
+    }
+
+    QueryContext* contexts = (QueryContext*)malloc((size_t)context_count * sizeof(QueryContext));
+    if (!contexts) {
+        fprintf(stderr, "Failed to allocate query contexts\n");
+        return 1;
+    }
+    for (int i = 0; i < context_count; i++) {
+        if (!query_context_init(&contexts[i], &recipe_store, RESPONSE_CACHE_CAPACITY)) {
+            fprintf(stderr, "Warning: Failed to allocate the response cache\n");
+        }
+        contexts[i].verbose = verbose;
+    }
+
+    int exit_code = 0;
+    if (batch_path) {
+        exit_code = run_batch(batch_path, contexts, &pool);
+    } else if (serve_address) {
+        ServerOptions options;
+        options.address = serve_address;
+        options.store = &recipe_store;
+        options.worker_count = thread_count;
+        options.cache_capacity = RESPONSE_CACHE_CAPACITY;
+        exit_code = server_run(&options) == 0 ? 0 : 1;
+    }
+
+    while (!batch_path && !serve_address) {
         printf("> ");
         fflush(stdout);
 
@@ -178,21 +453,34 @@ int main() {
             break;
         }
 
-        char* response = process_input(input);
-        printf("%s\n", response);
-        
-        if (response != NULL && 
-            strcmp(response, "Error: Failed to run Python script.") != 0 &&
-            strcmp(response, "Error: Python not found. Please ensure Python is installed and in your PATH.") != 0 &&
-            strcmp(response, "Error: Failed to execute command.") != 0 &&
-            strcmp(response, "No output from command.") != 0) {
-            free(response);
-        }
+        printf("%s\n", query_context_respond(&contexts[0], input, NULL));
+        query_context_release(&contexts[0]);
+    }
+
+#ifdef NEUROCHEF_EMBED_PYTHON
+    python_bridge_shutdown();
+#endif
+
+    ResponseCacheStats cache_stats = { 0, 0, 0, 0, 0 };
+    for (int i = 0; i < context_count; i++) {
+        ResponseCacheStats stats = response_cache_get_stats(&contexts[i].cache);
+        cache_stats.hits += stats.hits;
+        cache_stats.misses += stats.misses;
+        cache_stats.evictions += stats.evictions;
+        query_context_free(&contexts[i]);
     }
+    free(contexts);
+    thread_pool_free(&pool);
 
-    if (recipe_db) {
-        free_recipe_db(recipe_db);
+    if (!serve_address) {
+        fprintf(messages, "Response cache: %llu hits, %llu misses, %llu evictions\n",
+                (unsigned long long)cache_stats.hits,
+                (unsigned long long)cache_stats.misses,
+                (unsigned long long)cache_stats.evictions);
     }
+
+    recipe_store_free(&recipe_store);
+    free(source.snapshot_path);
     
-    return 0;
+    return exit_code;
 }
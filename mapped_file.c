@@ -0,0 +1,100 @@
+/**
+ * NeuroChef - Mapped Files Implementation
+ * 
+ * This file implements read-only file mappings with a portable fallback.
+ */
+
+#include "mapped_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static bool read_whole_file(MappedFile* file, const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return false;
+
+    if (fseek(fp, 0, SEEK_END) != 0) {
+        fclose(fp);
+        return false;
+    }
+    long size = ftell(fp);
+    rewind(fp);
+    if (size < 0) {
+        fclose(fp);
+        return false;
+    }
+
+    char* buffer = (char*)malloc((size_t)size + 1);
+    if (!buffer) {
+        fclose(fp);
+        return false;
+    }
+
+    size_t read = fread(buffer, 1, (size_t)size, fp);
+    fclose(fp);
+    buffer[read] = '\0';
+
+    file->data = buffer;
+    file->length = read;
+    file->mapped = false;
+    return true;
+}
+
+bool mapped_file_open(MappedFile* file, const char* path) {
+    file->data = NULL;
+    file->length = 0;
+    file->mapped = false;
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    if (st.st_size == 0) {
+        close(fd);
+        return true;
+    }
+
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return read_whole_file(file, path);
+    }
+
+    file->data = (const char*)data;
+    file->length = (size_t)st.st_size;
+    file->mapped = true;
+    return true;
+#else
+    return read_whole_file(file, path);
+#endif
+}
+
+void mapped_file_close(MappedFile* file) {
+    if (!file || !file->data) return;
+
+#ifndef _WIN32
+    if (file->mapped) {
+        munmap((void*)file->data, file->length);
+    } else {
+        free((void*)file->data);
+    }
+#else
+    free((void*)file->data);
+#endif
+
+    file->data = NULL;
+    file->length = 0;
+    file->mapped = false;
+}
@@ -0,0 +1,36 @@
+/**
+ * NeuroChef - Mapped Files
+ * 
+ * This header declares a read-only view of a whole file. On POSIX systems the
+ * file is memory-mapped; elsewhere it is read into a single heap buffer.
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    const char* data;
+    size_t length;
+    bool mapped;
+} MappedFile;
+
+/**
+ * Map a file read-only into memory
+ * 
+ * @param file The structure to fill in
+ * @param path The path of the file to map
+ * @return true on success, false if the file could not be opened or read
+ */
+bool mapped_file_open(MappedFile* file, const char* path);
+
+/**
+ * Unmap a file previously opened with mapped_file_open
+ * 
+ * @param file The mapped file to release
+ */
+void mapped_file_close(MappedFile* file);
+
+#endif /* MAPPED_FILE_H */
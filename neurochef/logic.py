@@ -10,14 +10,59 @@ import json
 import sys
 import os
 
-def load_data():
-    """Load meal data from JSON file."""
+def data_path():
+    """Path of the meal data: $NEUROCHEF_DATA if set, else meal_data.json next to the package."""
+    json_path = os.environ.get("NEUROCHEF_DATA")
+    if json_path:
+        return json_path
     script_dir = os.path.dirname(os.path.abspath(__file__))
-    json_path = os.path.join(os.path.dirname(script_dir), "meal_data.json")
+    return os.path.join(os.path.dirname(script_dir), "meal_data.json")
+
+def load_data(json_path=None):
+    """Load meal data from JSON file."""
+    if json_path is None:
+        json_path = data_path()
     
-    with open(json_path, 'r') as file:
+    with open(json_path, 'r', encoding='utf-8') as file:
         return json.load(file)
 
+# The data current_data last loaded, and the file's (path, mtime, size) then
+_loaded = {"stamp": None, "data": None}
+
+def current_data(json_path=None):
+    """Return the meal data, loading it again whenever the file has changed.
+
+    If the changed file cannot be read or parsed, the data loaded before is
+    kept, as the chatbot keeps its recipes when a reload fails.
+    """
+    if json_path is None:
+        json_path = data_path()
+    try:
+        info = os.stat(json_path)
+        stamp = (json_path, info.st_mtime_ns, info.st_size)
+        if stamp != _loaded["stamp"]:
+            _loaded["data"] = load_data(json_path)
+            _loaded["stamp"] = stamp
+    except (OSError, ValueError):
+        if _loaded["data"] is None:
+            raise
+    return _loaded["data"]
+
+MINUTES_PER_UNIT = {
+    "minutes": 1, "minute": 1, "mins": 1, "min": 1,
+    "hours": 60, "hour": 60, "hrs": 60, "hr": 60,
+    "days": 24 * 60, "day": 24 * 60,
+    "seconds": 1 / 60, "second": 1 / 60, "secs": 1 / 60, "sec": 1 / 60
+}
+
+def time_in_minutes(time):
+    """Convert a prep or cook time to minutes, or None if its unit is unknown."""
+    factor = MINUTES_PER_UNIT.get(str(time.get("unit", "")).lower())
+    duration = time.get("duration", 0)
+    if factor is None or not isinstance(duration, int) or duration < 0:
+        return None
+    return -(-duration // 60) if factor < 1 else duration * factor
+
 def find_matches(user_input, data):
     """Find matches in the data based on user input."""
     user_input = user_input.lower()
@@ -49,7 +94,8 @@ def find_matches(user_input, data):
     elif any(word in user_input for word in ["quick", "fast", "time", "minutes"]):
         quick_meals = [f"{meal['name']} ({meal['prep_time']['duration']} {meal['prep_time']['unit']})" 
                       for meal in data["meals"] 
-                      if meal['prep_time']['unit'] == "minutes" and meal['prep_time']['duration'] <= 15]
+                      if time_in_minutes(meal['prep_time']) is not None
+                      and time_in_minutes(meal['prep_time']) <= 15]
         if quick_meals:
             response = f"Here are some quick meals: {', '.join(quick_meals)}."
         else:
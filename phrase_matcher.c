@@ -0,0 +1,145 @@
+/**
+ * NeuroChef - Phrase Matcher Implementation
+ * 
+ * This file implements the Aho-Corasick automaton. Input bytes are mapped to
+ * a small alphabet of the characters that occur in the phrases, so the
+ * transition table stays compact.
+ */
+
+#include "phrase_matcher.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t lower_byte(char c) {
+    return (uint8_t)tolower((unsigned char)c);
+}
+
+bool phrase_matcher_build(PhraseMatcher* matcher, const char* const* phrases, int count) {
+    memset(matcher, 0, sizeof(PhraseMatcher));
+
+    /* Class 0 stands for every byte that appears in no phrase */
+    int max_states = 1;
+    matcher->class_count = 1;
+    for (int p = 0; p < count; p++) {
+        for (const char* c = phrases[p]; *c; c++) {
+            uint8_t byte = lower_byte(*c);
+            if (matcher->byte_class[byte] == 0) {
+                matcher->byte_class[byte] = (uint8_t)matcher->class_count++;
+            }
+            max_states++;
+        }
+    }
+    for (int byte = 'A'; byte <= 'Z'; byte++) {
+        matcher->byte_class[byte] = matcher->byte_class[tolower(byte)];
+    }
+
+    int classes = matcher->class_count;
+    matcher->transitions = (int32_t*)malloc((size_t)max_states * classes * sizeof(int32_t));
+    matcher->terminal = (int32_t*)malloc(max_states * sizeof(int32_t));
+    matcher->output_link = (int32_t*)malloc(max_states * sizeof(int32_t));
+    matcher->phrase_lengths = (size_t*)malloc((count > 0 ? count : 1) * sizeof(size_t));
+    int32_t* fail = (int32_t*)malloc(max_states * sizeof(int32_t));
+    int32_t* queue = (int32_t*)malloc(max_states * sizeof(int32_t));
+    if (!matcher->transitions || !matcher->terminal || !matcher->output_link ||
+        !matcher->phrase_lengths || !fail || !queue) {
+        free(fail);
+        free(queue);
+        phrase_matcher_free(matcher);
+        return false;
+    }
+
+    for (int i = 0; i < max_states * classes; i++) {
+        matcher->transitions[i] = -1;
+    }
+    matcher->terminal[0] = -1;
+    matcher->state_count = 1;
+    matcher->phrase_count = count;
+
+    /* Build the trie */
+    for (int p = 0; p < count; p++) {
+        int state = 0;
+        for (const char* c = phrases[p]; *c; c++) {
+            int cls = matcher->byte_class[lower_byte(*c)];
+            int32_t* next = &matcher->transitions[state * classes + cls];
+            if (*next < 0) {
+                *next = matcher->state_count;
+                matcher->terminal[matcher->state_count] = -1;
+                matcher->state_count++;
+            }
+            state = *next;
+        }
+        matcher->terminal[state] = p;
+        matcher->phrase_lengths[p] = strlen(phrases[p]);
+    }
+
+    /* Breadth-first pass: failure links, output links and missing transitions */
+    int head = 0;
+    int tail = 0;
+    fail[0] = 0;
+    matcher->output_link[0] = -1;
+    for (int cls = 0; cls < classes; cls++) {
+        int32_t* next = &matcher->transitions[cls];
+        if (*next < 0) {
+            *next = 0;
+        } else {
+            fail[*next] = 0;
+            matcher->output_link[*next] = -1;
+            queue[tail++] = *next;
+        }
+    }
+
+    while (head < tail) {
+        int state = queue[head++];
+        for (int cls = 0; cls < classes; cls++) {
+            int32_t* next = &matcher->transitions[state * classes + cls];
+            int32_t fallback = matcher->transitions[fail[state] * classes + cls];
+            if (*next < 0) {
+                *next = fallback;
+            } else {
+                int child = *next;
+                fail[child] = fallback;
+                matcher->output_link[child] = matcher->terminal[fallback] >= 0
+                    ? fallback : matcher->output_link[fallback];
+                queue[tail++] = child;
+            }
+        }
+    }
+
+    free(fail);
+    free(queue);
+    return true;
+}
+
+int phrase_matcher_scan(const PhraseMatcher* matcher, const char* text, size_t length,
+                        PhraseMatch* matches, int max_matches) {
+    if (!matcher->transitions) return 0;
+
+    int count = 0;
+    int state = 0;
+    int classes = matcher->class_count;
+
+    for (size_t i = 0; i < length; i++) {
+        state = matcher->transitions[state * classes + matcher->byte_class[(uint8_t)text[i]]];
+
+        int out = matcher->terminal[state] >= 0 ? state : matcher->output_link[state];
+        while (out >= 0) {
+            int phrase = matcher->terminal[out];
+            if (count < max_matches) {
+                matches[count].phrase = phrase;
+                matches[count].start = i + 1 - matcher->phrase_lengths[phrase];
+            }
+            count++;
+            out = matcher->output_link[out];
+        }
+    }
+    return count;
+}
+
+void phrase_matcher_free(PhraseMatcher* matcher) {
+    free(matcher->transitions);
+    free(matcher->terminal);
+    free(matcher->output_link);
+    free(matcher->phrase_lengths);
+    memset(matcher, 0, sizeof(PhraseMatcher));
+}
@@ -0,0 +1,68 @@
+/**
+ * NeuroChef - Phrase Matcher
+ * 
+ * This header declares an Aho-Corasick automaton that finds every occurrence
+ * of a fixed set of phrases in one pass over the input, ignoring ASCII case.
+ */
+
+#ifndef PHRASE_MATCHER_H
+#define PHRASE_MATCHER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    int phrase;
+    size_t start;
+} PhraseMatch;
+
+typedef struct {
+    int state_count;
+    int class_count;
+    uint8_t byte_class[256];
+    /* Full DFA: transitions[state * class_count + class] */
+    int32_t* transitions;
+    /* Phrase ending at each state, or -1 */
+    int32_t* terminal;
+    /* Nearest proper suffix state that ends a phrase, or -1 */
+    int32_t* output_link;
+    size_t* phrase_lengths;
+    int phrase_count;
+} PhraseMatcher;
+
+/**
+ * Compile a set of phrases into an automaton
+ * 
+ * Phrases are matched case-insensitively and must be distinct.
+ * 
+ * @param matcher The matcher to build
+ * @param phrases The phrases; a match reports the phrase's index in this array
+ * @param count The number of phrases
+ * @return true on success, false if out of memory
+ */
+bool phrase_matcher_build(PhraseMatcher* matcher, const char* const* phrases, int count);
+
+/**
+ * Find every phrase occurrence in a text
+ * 
+ * Matches are reported in order of their end position.
+ * 
+ * @param matcher The compiled matcher
+ * @param text The text to scan
+ * @param length The length of the text
+ * @param matches Receives up to max_matches matches
+ * @param max_matches The capacity of matches
+ * @return The total number of matches, which may exceed max_matches
+ */
+int phrase_matcher_scan(const PhraseMatcher* matcher, const char* text, size_t length,
+                        PhraseMatch* matches, int max_matches);
+
+/**
+ * Free the memory owned by a matcher
+ * 
+ * @param matcher The matcher to free
+ */
+void phrase_matcher_free(PhraseMatcher* matcher);
+
+#endif /* PHRASE_MATCHER_H */
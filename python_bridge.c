@@ -0,0 +1,138 @@
+/**
+ * NeuroChef - Embedded Python Bridge Implementation
+ * 
+ * This file embeds CPython to call neurochef.logic without a subprocess.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "python_bridge.h"
+#include <stdlib.h>
+#include <string.h>
+
+static PyObject* find_matches = NULL;
+static PyObject* current_data = NULL;
+/* The meal data file, or None for the module's default */
+static PyObject* data_path = NULL;
+/* Thread state saved while the GIL is released between queries */
+static PyThreadState* main_thread_state = NULL;
+
+static bool prepend_module_root(const char* module_root) {
+    PyObject* sys_path = PySys_GetObject("path");
+    if (!sys_path) return false;
+
+    PyObject* root = PyUnicode_DecodeFSDefault(module_root);
+    if (!root) return false;
+
+    int status = PyList_Insert(sys_path, 0, root);
+    Py_DECREF(root);
+    return status == 0;
+}
+
+bool python_bridge_init(const char* module_root, const char* json_path) {
+    if (main_thread_state) return true;
+
+    /* Read meal_data.json as UTF-8 whatever the process locale is */
+    PyPreConfig preconfig;
+    PyPreConfig_InitPythonConfig(&preconfig);
+    preconfig.utf8_mode = 1;
+    if (PyStatus_Exception(Py_PreInitialize(&preconfig))) return false;
+
+    /* Leave signal handling (Ctrl-C) to the chatbot */
+    Py_InitializeEx(0);
+    if (!Py_IsInitialized()) return false;
+
+    PyObject* module = NULL;
+    PyObject* meal_data = NULL;
+
+    if (module_root && !prepend_module_root(module_root)) goto fail;
+
+    module = PyImport_ImportModule("neurochef.logic");
+    if (!module) goto fail;
+
+    find_matches = PyObject_GetAttrString(module, "find_matches");
+    current_data = PyObject_GetAttrString(module, "current_data");
+    if (!find_matches || !current_data) goto fail;
+
+    if (json_path) {
+        data_path = PyUnicode_DecodeFSDefault(json_path);
+    } else {
+        data_path = Py_None;
+        Py_INCREF(data_path);
+    }
+    if (!data_path) goto fail;
+
+    /* Load the data now so a missing or broken file is reported at startup */
+    meal_data = PyObject_CallFunctionObjArgs(current_data, data_path, NULL);
+    if (!meal_data) goto fail;
+
+    Py_DECREF(meal_data);
+    Py_DECREF(module);
+
+    main_thread_state = PyEval_SaveThread();
+    return true;
+
+fail:
+    PyErr_Print();
+    Py_XDECREF(module);
+    Py_CLEAR(find_matches);
+    Py_CLEAR(current_data);
+    Py_CLEAR(data_path);
+    Py_FinalizeEx();
+    return false;
+}
+
+bool python_bridge_available(void) {
+    return main_thread_state != NULL;
+}
+
+char* python_bridge_respond(const char* input) {
+    if (!main_thread_state || !input) return NULL;
+
+    PyGILState_STATE gil = PyGILState_Ensure();
+    char* response = NULL;
+
+    /* Undecodable bytes must not turn a query into an error */
+    PyObject* text = PyUnicode_DecodeUTF8(input, (Py_ssize_t)strlen(input), "replace");
+    /* Reloaded by the module when the file has changed */
+    PyObject* meal_data = text ? PyObject_CallFunctionObjArgs(current_data, data_path, NULL) : NULL;
+    PyObject* result = meal_data ? PyObject_CallFunctionObjArgs(find_matches, text, meal_data, NULL) : NULL;
+
+    if (result && PyUnicode_Check(result)) {
+        Py_ssize_t length = 0;
+        const char* utf8 = PyUnicode_AsUTF8AndSize(result, &length);
+        if (utf8) {
+            while (length > 0 && utf8[length - 1] == '\n') {
+                length--;
+            }
+            response = (char*)malloc((size_t)length + 1);
+            if (response) {
+                memcpy(response, utf8, (size_t)length);
+                response[length] = '\0';
+            }
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        PyErr_Print();
+    }
+    Py_XDECREF(result);
+    Py_XDECREF(meal_data);
+    Py_XDECREF(text);
+    PyGILState_Release(gil);
+
+    return response;
+}
+
+void python_bridge_shutdown(void) {
+    if (!main_thread_state) return;
+
+    PyEval_RestoreThread(main_thread_state);
+    main_thread_state = NULL;
+
+    Py_CLEAR(find_matches);
+    Py_CLEAR(current_data);
+    Py_CLEAR(data_path);
+    Py_FinalizeEx();
+}
@@ -0,0 +1,48 @@
+/**
+ * NeuroChef - Embedded Python Bridge
+ * 
+ * This header declares an in-process bridge to the Python logic module. The
+ * interpreter is started once and neurochef.logic is imported once; each
+ * fallback query is then a single function call. The module keeps the meal
+ * data loaded and reads it again only when the file changes.
+ */
+
+#ifndef PYTHON_BRIDGE_H
+#define PYTHON_BRIDGE_H
+
+#include <stdbool.h>
+
+/**
+ * Start the embedded interpreter, import neurochef.logic and load its data
+ * 
+ * @param module_root Directory containing the neurochef package, or NULL to
+ *                    rely on the interpreter's default search path
+ * @param json_path The meal data file the chatbot loaded, or NULL for the
+ *                  module's default
+ * @return true if the bridge is ready to answer queries
+ */
+bool python_bridge_init(const char* module_root, const char* json_path);
+
+/**
+ * Check whether python_bridge_init succeeded
+ * 
+ * @return true if the bridge is ready to answer queries
+ */
+bool python_bridge_available(void);
+
+/**
+ * Answer a query with neurochef.logic.find_matches
+ * 
+ * Safe to call from any thread once the bridge is initialized.
+ * 
+ * @param input The user input to process
+ * @return The whole response, which the caller must free, or NULL on error
+ */
+char* python_bridge_respond(const char* input);
+
+/**
+ * Release the module and data and shut the interpreter down
+ */
+void python_bridge_shutdown(void);
+
+#endif /* PYTHON_BRIDGE_H */
@@ -0,0 +1,353 @@
+/**
+ * NeuroChef - Query Contexts Implementation
+ * 
+ * This file implements query answering: recipe and guidance questions are
+ * answered from the recipe database, everything else by the Python logic
+ * module, either embedded or run as a subprocess.
+ */
+
+#include "query_context.h"
+#include "recipe_filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef NEUROCHEF_EMBED_PYTHON
+#include "python_bridge.h"
+#endif
+
+#define MAX_INPUT_SIZE 1024
+#define MAX_OUTPUT_SIZE 4096
+#define MAX_COMMAND_SIZE (MAX_INPUT_SIZE * 2 + 100)
+
+/**
+ * Run the Python module in a subprocess and read its whole output
+ * 
+ * @param input The user input to process
+ * @param succeeded Set to true if the script produced the response
+ * @return The response from the Python script, which the caller must free
+ */
+static char* run_python_command(const char* input, bool* succeeded) {
+    char command[MAX_COMMAND_SIZE];
+    
+    // Call the Python module directly
+    // Escape quotes in the input to prevent command injection
+    char escaped_input[MAX_INPUT_SIZE * 2];
+    int j = 0;
+    for (int i = 0; input[i] != '\0' && j < (int)sizeof(escaped_input) - 2; i++) {
+        if (input[i] == '"' || input[i] == '\\') {
+            escaped_input[j++] = '\\';
+        }
+        escaped_input[j++] = input[i];
+    }
+    escaped_input[j] = '\0';
+
+    snprintf(command, sizeof(command), 
+             "python -m neurochef.logic \"%s\"", 
+             escaped_input);
+
+    FILE* pipe = popen(command, "r");
+    if (!pipe) {
+        return strdup("Error: Failed to run Python script.");
+    }
+
+    size_t capacity = MAX_OUTPUT_SIZE;
+    size_t length = 0;
+    char* output = (char*)malloc(capacity);
+    if (!output) {
+        pclose(pipe);
+        return strdup("Error: Out of memory.");
+    }
+
+    size_t read;
+    while ((read = fread(output + length, 1, capacity - length - 1, pipe)) > 0) {
+        length += read;
+        if (capacity - length - 1 == 0) {
+            char* grown = (char*)realloc(output, capacity * 2);
+            if (!grown) break;
+            output = grown;
+            capacity *= 2;
+        }
+    }
+    output[length] = '\0';
+
+    int exit_code = pclose(pipe);
+    if (length == 0) {
+        free(output);
+        if (exit_code != 0) {
+            return strdup("Error: Python not found. Please ensure Python is installed and in your PATH.");
+        }
+        return strdup("No output from command.");
+    }
+
+    while (length > 0 && (output[length - 1] == '\n' || output[length - 1] == '\r')) {
+        output[--length] = '\0';
+    }
+    
+    *succeeded = exit_code == 0;
+    return output;
+}
+
+/**
+ * Get a response from the Python logic module
+ * 
+ * Uses the embedded interpreter when it is available and falls back to
+ * running the module in a subprocess otherwise.
+ * 
+ * @param input The user input to process
+ * @param succeeded Set to true if the module produced the response, false
+ *                  if the response is an error message
+ * @return The response from the Python module, which the caller must free
+ */
+static char* get_python_response(const char* input, bool* succeeded) {
+    *succeeded = false;
+#ifdef NEUROCHEF_EMBED_PYTHON
+    if (python_bridge_available()) {
+        char* response = python_bridge_respond(input);
+        if (response) {
+            *succeeded = true;
+            return response;
+        }
+    }
+#endif
+    return run_python_command(input, succeeded);
+}
+
+/**
+ * Append the Python module's response, unless the context defers Python
+ * queries to another thread
+ * 
+ * @param context The context whose builder receives the response
+ * @param input The user input to process
+ * @param info Receives the outcome, or is marked deferred
+ * @return true if the module answered, false if the output is an error
+ *         message or the query was deferred
+ */
+static bool answer_with_python(QueryContext* context, const char* input, ResponseInfo* info) {
+    if (context->defer_python) {
+        info->deferred = true;
+        info->success = false;
+        return false;
+    }
+
+    bool succeeded;
+    char* response = get_python_response(input, &succeeded);
+    if (response) {
+        sb_append_cstr(&context->response, response);
+        free(response);
+    }
+    info->success = succeeded;
+    return succeeded;
+}
+
+/**
+ * Generate a response for a parsed query
+ * 
+ * The response depends only on the normalized text, which keys the cache;
+ * the Python module is given that text as well.
+ * 
+ * @param context The context whose database answers the query
+ * @param input The user input, for progress messages
+ * @param query The parsed input
+ * @param info Receives the recipe and outcome of the query
+ * @return true if the response can be cached, false if it is a transient error
+ */
+static bool generate_response(QueryContext* context, const char* input, const ParsedQuery* query,
+                              ResponseInfo* info) {
+    StringBuilder* out = &context->response;
+
+    info->recipe_index = -1;
+    info->success = true;
+
+    if (parsed_query_is_recipe(query)) {
+        if (context->verbose) {
+            printf("Processing as recipe query: %s\n", input);
+        }
+
+        QueryResult result = render_parsed_query(context->db, query, out);
+        if (result.success) {
+            if (result.response != out->data) {
+                sb_append(out, result.response, result.response_length);
+            }
+            info->recipe_index = result.recipe_index;
+            return true;
+        }
+
+        /* Keep the error unless a guidance answer or Python replaces it */
+        if (result.response != out->data) {
+            sb_append(out, result.response, result.response_length);
+        }
+        size_t error_length = out->length;
+
+        if (answer_guidance_query(context->db, query, out)) {
+            sb_drop_prefix(out, error_length);
+            return true;
+        }
+
+        if (strstr(sb_cstr(out), "I couldn't find a recipe") == NULL) {
+            if (context->verbose) {
+                printf("Recipe query processing failed, falling back to Python\n");
+            }
+            sb_reset(out);
+            return answer_with_python(context, query->normalized, info);
+        }
+        info->success = false;
+        return true;
+    }
+
+    if (context->verbose) {
+        printf("Not a recipe query: %s\n", input);
+    }
+
+    if (query->is_suggestion) {
+        sb_append_cstr(out,
+                       "I can tell you about specific recipes like Berry Blast Smoothie, "
+                       "Creamy Garlic Mashed Potatoes, Mild Chicken Salad, or Soft Baked Sweet Potato. "
+                       "Try asking something like 'What is in Berry Blast Smoothie?' or "
+                       "'How do I make Soft Baked Sweet Potato?'");
+        return true;
+    }
+
+    if (answer_guidance_query(context->db, query, out)) {
+        return true;
+    }
+    return answer_with_python(context, query->normalized, info);
+}
+
+/**
+ * Generate the response to a filter query
+ * 
+ * @param context The context whose database answers the query
+ * @param filter The parsed filter
+ * @param info Receives the outcome of the query
+ * @return true if the response can be cached, false if it is a transient error
+ */
+static bool answer_filter(QueryContext* context, const RecipeFilter* filter, ResponseInfo* info) {
+    if (context->verbose) {
+        printf("Processing as filter query\n");
+    }
+
+    info->recipe_index = -1;
+    info->success = answer_filter_query(context->db, filter, &context->response);
+    return info->success;
+}
+
+/**
+ * Get the finished response of a query
+ * 
+ * @param context The context whose builder holds the response
+ * @param info The outcome of the query; marked failed if out of memory
+ * @return The response, or NULL if the query was deferred
+ */
+static const char* finish_response(QueryContext* context, ResponseInfo* info) {
+    if (info->deferred) {
+        return NULL;
+    }
+    if (context->response.failed) {
+        info->success = false;
+        return "Error: Out of memory.";
+    }
+    return sb_cstr(&context->response);
+}
+
+bool query_context_init(QueryContext* context, RecipeStore* store, int cache_capacity) {
+    context->store = store;
+    context->reader = store ? recipe_store_register(store) : NULL;
+    context->db = NULL;
+    context->verbose = false;
+    context->defer_python = false;
+    sb_init(&context->key);
+    sb_init(&context->response);
+    bool cached = response_cache_init(&context->cache, cache_capacity);
+    return cached && (context->reader || !store);
+}
+
+const char* query_context_respond(QueryContext* context, const char* input, ResponseInfo* info) {
+    ResponseInfo local_info;
+    if (!info) info = &local_info;
+    info->type = QUERY_UNKNOWN;
+    info->recipe_index = -1;
+    info->success = false;
+    info->deferred = false;
+
+    StringBuilder* out = &context->response;
+    sb_reset(out);
+    if (context->reader) {
+        context->db = recipe_store_acquire(context->store, context->reader);
+    }
+
+    /* A hit is answered without classifying the query at all */
+    StringBuilder* key = &context->key;
+    sb_reset(key);
+    if (!normalize_query(input, key)) {
+        answer_with_python(context, input, info);
+        return info->deferred ? NULL : sb_cstr(out);
+    }
+
+    uint32_t version = context->db ? context->db->version : 0;
+    const ResponseCacheEntry* cached = response_cache_get(&context->cache, key->data, key->length,
+                                                          version);
+    if (cached) {
+        sb_append_cstr(out, cached->response);
+        info->type = cached->type;
+        info->recipe_index = cached->recipe_index;
+        info->success = cached->success;
+        return finish_response(context, info);
+    }
+
+    ParsedQuery query;
+    if (!parse_query(input, &query)) {
+        answer_with_python(context, input, info);
+        return info->deferred ? NULL : sb_cstr(out);
+    }
+
+    info->type = query.type;
+
+    /* Compound constraints are answered from the indexes, not one recipe */
+    RecipeFilter filter;
+    bool is_filter = context->db && parse_recipe_filter(context->db, &query, &filter);
+    if (is_filter) {
+        info->type = QUERY_FILTER;
+    }
+    if ((is_filter ? answer_filter(context, &filter, info)
+                   : generate_response(context, input, &query, info)) && !out->failed) {
+        response_cache_put(&context->cache, key->data, key->length, info->type, version,
+                           sb_cstr(out), info->recipe_index, info->success);
+    }
+
+    free_parsed_query(&query);
+    return finish_response(context, info);
+}
+
+void query_context_release(QueryContext* context) {
+    if (context->reader) {
+        recipe_store_release(context->reader);
+        context->db = NULL;
+    }
+}
+
+bool append_response_json(StringBuilder* out, const RecipeDB* db, const char* query,
+                          const ResponseInfo* info, const char* response, long long latency_ns) {
+    sb_append_cstr(out, "{\"query\":");
+    sb_append_json_string(out, query, strlen(query));
+    sb_appendf(out, ",\"type\":\"%s\",\"recipe_id\":", query_type_name(info->type));
+    if (info->recipe_index >= 0 && db) {
+        StringView id = db->recipes[info->recipe_index].id;
+        sb_append_json_string(out, id.data, id.length);
+    } else {
+        sb_append_cstr(out, "null");
+    }
+    sb_appendf(out, ",\"success\":%s,\"response\":", info->success ? "true" : "false");
+    sb_append_json_string(out, response, strlen(response));
+    sb_appendf(out, ",\"latency_ns\":%lld}\n", latency_ns);
+    return !out->failed;
+}
+
+void query_context_free(QueryContext* context) {
+    query_context_release(context);
+    recipe_store_unregister(context->store, context->reader);
+    context->reader = NULL;
+    response_cache_free(&context->cache);
+    sb_free(&context->key);
+    sb_free(&context->response);
+    context->db = NULL;
+}
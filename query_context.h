@@ -0,0 +1,106 @@
+/**
+ * NeuroChef - Query Contexts
+ * 
+ * This header declares the per-thread state for answering chatbot queries:
+ * a response builder, a response cache and a reader of the recipe store. A
+ * context answers recipe, filter and guidance questions in C and falls back
+ * to the Python logic module for everything else. Each thread needs its own
+ * context, but any number of contexts may share one store.
+ * 
+ * Each query is answered from the database that is current when it starts;
+ * the context keeps that database alive until its next query or until
+ * query_context_release, so a reload never changes a response mid-query.
+ */
+
+#ifndef QUERY_CONTEXT_H
+#define QUERY_CONTEXT_H
+
+#include <stdbool.h>
+#include "recipe_store.h"
+#include "recipe_utils.h"
+#include "response_cache.h"
+#include "string_builder.h"
+
+/**
+ * What a context found out about a query besides the response text
+ */
+typedef struct {
+    QueryType type;
+    int recipe_index;       /* Recipe the response is about, or -1 */
+    bool success;           /* false if the response is an error message */
+    bool deferred;          /* Needs Python, which the context was told not to call */
+} ResponseInfo;
+
+typedef struct {
+    RecipeStore* store;
+    RecipeStoreReader* reader;
+    /* The database the last query was answered from; NULL sends queries to Python */
+    const RecipeDB* db;
+    ResponseCache cache;
+    /* The normalized input, which keys the cache */
+    StringBuilder key;
+    StringBuilder response;
+    bool verbose;           /* Print progress messages for each query */
+    bool defer_python;      /* Leave queries that need Python unanswered */
+} QueryContext;
+
+/**
+ * Initialize a context
+ * 
+ * @param context The context to initialize
+ * @param store The store to answer from, or NULL to answer only with Python
+ * @param cache_capacity Number of responses to cache
+ * @return true on success, false if the cache or reader could not be
+ *         allocated; the context still works, only without caching or
+ *         without the recipe database
+ */
+bool query_context_init(QueryContext* context, RecipeStore* store, int cache_capacity);
+
+/**
+ * Answer one user query
+ * 
+ * Repeated queries are answered from the context's response cache, which is
+ * probed with the normalized input before the query is classified. When
+ * defer_python is set, a query only the Python module can answer is left
+ * unanswered so the caller can hand it to a context that may block.
+ * 
+ * @param context The context
+ * @param input The user input to process
+ * @param info Receives the query type, recipe and outcome (may be NULL)
+ * @return The response, valid until the next call on this context, or NULL
+ *         if the query was deferred
+ */
+const char* query_context_respond(QueryContext* context, const char* input, ResponseInfo* info);
+
+/**
+ * Let go of the database the last query was answered from, so a reload can
+ * free it while the context is idle; the last response becomes invalid
+ * 
+ * @param context The context
+ */
+void query_context_release(QueryContext* context);
+
+/**
+ * Append a response as one line of JSON: the query, its type, the recipe
+ * id, success, the response text and the latency
+ * 
+ * @param out The builder to append to
+ * @param db The database the response came from (the context's db), for
+ *           the recipe id, or NULL
+ * @param query The user input
+ * @param info What query_context_respond reported
+ * @param response The response text
+ * @param latency_ns Time taken to answer, in nanoseconds
+ * @return true on success, false if out of memory
+ */
+bool append_response_json(StringBuilder* out, const RecipeDB* db, const char* query,
+                          const ResponseInfo* info, const char* response, long long latency_ns);
+
+/**
+ * Free the memory owned by a context
+ * 
+ * @param context The context to free
+ */
+void query_context_free(QueryContext* context);
+
+#endif /* QUERY_CONTEXT_H */
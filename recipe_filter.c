@@ -0,0 +1,964 @@
+/**
+ * NeuroChef - Recipe Filters Implementation
+ * 
+ * This file implements filter queries: a word-level parser that turns the
+ * constraints in a query into a predicate tree, a planner that orders the
+ * predicates by how many recipes each one keeps, and an executor that walks
+ * the candidates of the most selective one.
+ */
+
+#include "recipe_filter.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Words of a query the parser looks at */
+#define FILTER_MAX_WORDS 64
+/* Longest attribute value looked up, in words */
+#define FILTER_MAX_NGRAM 3
+/* Field words looked for before and after a time constraint */
+#define FILTER_FIELD_LOOKBEHIND 3
+#define FILTER_FIELD_LOOKAHEAD 2
+#define FILTER_MAX_PAGE 1000
+/* Candidates read from a posting bitmap at a time */
+#define FILTER_BATCH_SIZE 256
+/* A time range drives the search only if it keeps at most this fraction of
+   the catalog; wider ranges are cheaper to check per recipe than to sort */
+#define FILTER_TIME_DRIVER_DIVISOR 16
+
+#define COUNT_OF(array) ((int)(sizeof(array) / sizeof((array)[0])))
+
+typedef enum {
+    COMPARE_AT_MOST,
+    COMPARE_AT_LEAST,
+    COMPARE_BETWEEN
+} Comparison;
+
+static const struct {
+    const char* text;
+    Comparison comparison;
+} COMPARISONS[] = {
+    { "no more than", COMPARE_AT_MOST }, { "no longer than", COMPARE_AT_MOST },
+    { "less than", COMPARE_AT_MOST }, { "fewer than", COMPARE_AT_MOST },
+    { "at most", COMPARE_AT_MOST }, { "up to", COMPARE_AT_MOST },
+    { "under", COMPARE_AT_MOST }, { "below", COMPARE_AT_MOST },
+    { "within", COMPARE_AT_MOST }, { "in", COMPARE_AT_MOST },
+    { "more than", COMPARE_AT_LEAST }, { "longer than", COMPARE_AT_LEAST },
+    { "at least", COMPARE_AT_LEAST }, { "over", COMPARE_AT_LEAST },
+    { "above", COMPARE_AT_LEAST },
+    { "between", COMPARE_BETWEEN }
+};
+
+/* Words that exclude the attributes after them */
+static const char* EXCLUSION_WORDS[] = {
+    "without", "no", "not", "avoid", "avoiding", "except", "excluding"
+};
+
+/* Words an exclusion carries across, e.g. "not too crunchy or spicy" */
+static const char* EXCLUSION_CONNECTIVES[] = {
+    "and", "or", "nor", "too", "very", "any", "anything"
+};
+
+/* Words that ask for a list of meals rather than one recipe */
+static const char* LIST_WORDS[] = {
+    "meals", "meal", "dishes", "dish", "recipes", "foods", "something",
+    "anything", "options", "ideas"
+};
+
+/*
+ * Sensory and meal words a user may ask for whether or not a recipe in the
+ * catalog has them; asking for one no recipe has finds nothing
+ */
+static const char* ATTRIBUTE_WORDS[] = {
+    "crunchy", "crispy", "crisp", "chewy", "slimy", "grainy", "stringy", "lumpy",
+    "mushy", "gritty", "tender", "firm", "flaky", "sticky", "silky", "velvety",
+    "thick", "juicy", "moist", "rubbery", "gooey", "runny", "chunky", "crumbly",
+    "fluffy", "smooth", "soft", "creamy", "liquid", "uniform", "slippery",
+    "hot", "warm", "cold", "chilled", "frozen", "iced", "lukewarm", "room temperature",
+    "sweet", "sour", "salty", "bitter", "spicy", "tangy", "savory", "savoury",
+    "mild", "bland", "umami", "earthy", "herby", "nutty", "fruity", "smoky",
+    "garlicky", "cheesy", "zesty", "peppery", "acidic", "pungent", "fishy",
+    "aromatic", "herbal", "neutral", "buttery", "tart", "citrusy", "minty",
+    "breakfast", "brunch", "lunch", "dinner", "supper", "snack", "dessert",
+    "side", "appetizer", "comfort"
+};
+
+/* Words that carry no constraint of their own */
+static const char* FILLER_WORDS[] = {
+    "a", "an", "the", "some", "any", "that", "that's", "thats", "this", "these",
+    "those", "which", "what", "what's", "whats", "who", "how", "is", "are", "be",
+    "it", "it's", "its", "i", "i'm", "im", "me", "my", "we", "us", "our", "you",
+    "your", "to", "of", "for", "in", "on", "at", "by", "from", "as", "with",
+    "and", "or", "nor", "but", "so", "please", "can", "could", "would",
+    "should", "will", "do", "does", "give", "show", "find", "list", "tell",
+    "suggest", "recommend", "want", "need", "like", "make", "eat", "have",
+    "get", "there", "here", "ones", "kind", "kinds", "type", "types", "more",
+    "less", "than", "up", "under", "over", "below", "above", "within",
+    "between", "most", "least", "only", "just", "also", "really", "time",
+    "times", "take", "takes", "prep", "preparation", "cook", "cooking",
+    "total", "page", "taste", "tastes", "texture", "textures", "smell",
+    "smells", "temperature", "flavor", "flavors", "feel", "today", "tonight",
+    "now", "food", "recipe"
+};
+
+static const char* NUMBER_WORDS[] = {
+    "one", "two", "three", "four", "five", "six", "seven", "eight", "nine",
+    "ten", "eleven", "twelve"
+};
+
+typedef struct {
+    const RecipeDB* db;
+    RecipeFilter* filter;
+    StringView words[FILTER_MAX_WORDS];
+    int word_count;
+    bool failed;
+} FilterParser;
+
+static bool word_is(StringView word, const char* text) {
+    return sv_equals(word, sv_from_cstr(text));
+}
+
+static bool word_in(StringView word, const char** list, int count) {
+    for (int i = 0; i < count; i++) {
+        if (word_is(word, list[i])) return true;
+    }
+    return false;
+}
+
+static bool is_digits(StringView word) {
+    if (word.length == 0) return false;
+    for (size_t i = 0; i < word.length; i++) {
+        if (!isdigit((unsigned char)word.data[i])) return false;
+    }
+    return true;
+}
+
+static bool is_time_unit(StringView word) {
+    return recipe_time_in_minutes(1, word) != RECIPE_MINUTES_UNKNOWN;
+}
+
+static void tokenize(FilterParser* parser, const char* text, size_t length) {
+    size_t i = 0;
+    while (i < length && parser->word_count < FILTER_MAX_WORDS) {
+        while (i < length && !isalnum((unsigned char)text[i]) && text[i] != '\'') i++;
+        size_t start = i;
+        while (i < length && (isalnum((unsigned char)text[i]) || text[i] == '\'')) i++;
+        if (i > start) {
+            StringView word = { text + start, i - start };
+            parser->words[parser->word_count++] = word;
+        }
+    }
+}
+
+/* Match a phrase of space-separated words at word i; returns the number of
+   words matched, or 0 */
+static int match_phrase(const FilterParser* parser, int i, const char* phrase) {
+    int matched = 0;
+    const char* p = phrase;
+    while (*p) {
+        const char* space = strchr(p, ' ');
+        size_t length = space ? (size_t)(space - p) : strlen(p);
+        StringView part = { p, length };
+        if (i + matched >= parser->word_count || !sv_equals(parser->words[i + matched], part)) return 0;
+        matched++;
+        p += length;
+        if (*p == ' ') p++;
+    }
+    return matched;
+}
+
+/* Parse a number at word i, in digits or words ("an hour"); returns the
+   number of words used, or 0 */
+static int parse_number(const FilterParser* parser, int i, int* value) {
+    if (i >= parser->word_count) return 0;
+    StringView word = parser->words[i];
+
+    if (is_digits(word)) {
+        if (word.length > 6) return 0;
+        int number = 0;
+        for (size_t k = 0; k < word.length; k++) {
+            number = number * 10 + (word.data[k] - '0');
+        }
+        *value = number;
+        return 1;
+    }
+    if (word_is(word, "a") || word_is(word, "an")) {
+        *value = 1;
+        return 1;
+    }
+    for (int k = 0; k < COUNT_OF(NUMBER_WORDS); k++) {
+        if (word_is(word, NUMBER_WORDS[k])) {
+            *value = k + 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Parse a number and an optional unit at word i; returns the number of
+   words used, or 0. unit is left empty when none follows. */
+static int parse_duration(const FilterParser* parser, int i, int* value, StringView* unit) {
+    int used = parse_number(parser, i, value);
+    if (used == 0) return 0;
+
+    unit->data = "";
+    unit->length = 0;
+    if (i + used < parser->word_count && is_time_unit(parser->words[i + used])) {
+        *unit = parser->words[i + used];
+        used++;
+    }
+    return used;
+}
+
+static bool field_word(StringView word, RecipeTimeField* field) {
+    if (word_is(word, "prep") || word_is(word, "preparation")) {
+        *field = RECIPE_TIME_PREP;
+    } else if (word_is(word, "cook") || word_is(word, "cooking")) {
+        *field = RECIPE_TIME_COOK;
+    } else if (word_is(word, "total")) {
+        *field = RECIPE_TIME_TOTAL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static int add_node(FilterParser* parser, FilterNodeType type) {
+    RecipeFilter* filter = parser->filter;
+    if (filter->node_count == RECIPE_FILTER_MAX_NODES) {
+        parser->failed = true;
+        return -1;
+    }
+
+    FilterNode* node = &filter->nodes[filter->node_count];
+    memset(node, 0, sizeof(*node));
+    node->type = type;
+    node->first_child = -1;
+    node->next_sibling = -1;
+    return filter->node_count++;
+}
+
+static void append_child(RecipeFilter* filter, int parent, int child) {
+    int* link = &filter->nodes[parent].first_child;
+    while (*link >= 0) {
+        link = &filter->nodes[*link].next_sibling;
+    }
+    *link = child;
+}
+
+/*
+ * Parse a time constraint such as "under 20 minutes total" or "prep time
+ * between 5 and 10 minutes" at word i. The field is the nearest field word
+ * before the comparison, looking no further back than floor, or else one
+ * just after the duration. Returns the index of the first word after the
+ * constraint, or 0 if there is none at i.
+ */
+static int parse_time_constraint(FilterParser* parser, int i, int floor) {
+    Comparison comparison = COMPARE_AT_MOST;
+    int used = 0;
+    for (int k = 0; k < COUNT_OF(COMPARISONS) && used == 0; k++) {
+        used = match_phrase(parser, i, COMPARISONS[k].text);
+        comparison = COMPARISONS[k].comparison;
+    }
+    if (used == 0) return 0;
+
+    int end = i + used;
+    int first;
+    StringView first_unit;
+    int first_used = parse_duration(parser, end, &first, &first_unit);
+    if (first_used == 0) return 0;
+    end += first_used;
+
+    int32_t min_minutes = 0;
+    int32_t max_minutes = INT32_MAX;
+    if (comparison == COMPARE_BETWEEN) {
+        if (end >= parser->word_count ||
+            !(word_is(parser->words[end], "and") || word_is(parser->words[end], "to"))) {
+            return 0;
+        }
+        int second;
+        StringView second_unit;
+        int second_used = parse_duration(parser, end + 1, &second, &second_unit);
+        if (second_used == 0 || second_unit.length == 0) return 0;
+        end += 1 + second_used;
+
+        /* "between 10 and 20 minutes": the first number takes the second's unit */
+        if (first_unit.length == 0) first_unit = second_unit;
+        min_minutes = recipe_time_in_minutes(first, first_unit);
+        max_minutes = recipe_time_in_minutes(second, second_unit);
+        if (min_minutes > max_minutes) {
+            int32_t swap = min_minutes;
+            min_minutes = max_minutes;
+            max_minutes = swap;
+        }
+    } else {
+        if (first_unit.length == 0) return 0;
+        int32_t minutes = recipe_time_in_minutes(first, first_unit);
+        if (comparison == COMPARE_AT_MOST) {
+            max_minutes = minutes;
+        } else {
+            min_minutes = minutes;
+        }
+    }
+    if (min_minutes == RECIPE_MINUTES_UNKNOWN || max_minutes == RECIPE_MINUTES_UNKNOWN) return 0;
+
+    RecipeTimeField field = RECIPE_TIME_TOTAL;
+    bool found = false;
+    for (int k = i - 1; k >= floor && k >= i - FILTER_FIELD_LOOKBEHIND && !found; k--) {
+        StringView word = parser->words[k];
+        if (is_digits(word) || is_time_unit(word)) break;
+        found = field_word(word, &field);
+    }
+    for (int k = end; k < parser->word_count && k < end + FILTER_FIELD_LOOKAHEAD && !found; k++) {
+        if (is_digits(parser->words[k])) break;
+        if (field_word(parser->words[k], &field)) {
+            found = true;
+            end = k + 1;
+        }
+    }
+
+    int node = add_node(parser, FILTER_TIME);
+    if (node < 0) return 0;
+    parser->filter->nodes[node].field = field;
+    parser->filter->nodes[node].min_minutes = min_minutes;
+    parser->filter->nodes[node].max_minutes = max_minutes;
+    append_child(parser->filter, parser->filter->root, node);
+    return end;
+}
+
+/* The attribute kinds under which any recipe has the value */
+static uint32_t attribute_kinds(const RecipeDB* db, SymbolId id) {
+    uint32_t kinds = 0;
+    for (int kind = 0; kind < ATTRIBUTE_KIND_COUNT; kind++) {
+        if (db->attribute_index[kind] && bitmap_cardinality(&db->attribute_index[kind][id]) > 0) {
+            kinds |= 1u << kind;
+        }
+    }
+    return kinds;
+}
+
+/* The run of n words starting at word i, as written */
+static StringView word_span(const FilterParser* parser, int i, int n) {
+    StringView last = parser->words[i + n - 1];
+    StringView span = { parser->words[i].data, (size_t)(last.data + last.length - parser->words[i].data) };
+    return span;
+}
+
+/* The lengths to look a span up under: as written, and without "s" or "es"
+   ("dinners", "dishes"); returns how many differ */
+static int plural_forms(StringView span, size_t lengths[3]) {
+    int count = 0;
+    lengths[count++] = span.length;
+    if (span.length > 1 && span.data[span.length - 1] == 's') {
+        lengths[count++] = span.length - 1;
+        if (span.length > 2 && span.data[span.length - 2] == 'e') lengths[count++] = span.length - 2;
+    }
+    return count;
+}
+
+/*
+ * Find the longest attribute value some recipe has starting at word i,
+ * trying each run of words as written (so "mildly garlic-y" keeps its
+ * hyphen) and without a plural ending. Returns the number of words used,
+ * or 0 if no recipe has a value starting there.
+ */
+static int parse_attribute(const FilterParser* parser, int i, SymbolId* id, uint32_t* kinds, bool* plural) {
+    for (int n = FILTER_MAX_NGRAM; n >= 1; n--) {
+        if (i + n > parser->word_count) continue;
+
+        StringView span = word_span(parser, i, n);
+        size_t lengths[3];
+        int form_count = plural_forms(span, lengths);
+        for (int k = 0; k < form_count; k++) {
+            StringView candidate = { span.data, lengths[k] };
+            SymbolId found = symbol_table_find(&parser->db->symbols, candidate);
+            if (found == SYMBOL_NONE) continue;
+            uint32_t found_kinds = attribute_kinds(parser->db, found);
+            if (found_kinds == 0) continue;
+            *id = found;
+            *kinds = found_kinds;
+            *plural = k > 0;
+            return n;
+        }
+    }
+    return 0;
+}
+
+/* Whether a guidance entry such as "chewy (excessively)" names the value */
+static bool guidance_names(StringView entry, StringView value) {
+    for (size_t k = 0; k < entry.length; k++) {
+        if (entry.data[k] == ' ' && k + 1 < entry.length && entry.data[k + 1] == '(') {
+            entry.length = k;
+            break;
+        }
+    }
+    return sv_equals_ignore_case(entry, value);
+}
+
+static bool in_guidance_list(const StringList* list, StringView value) {
+    for (int k = 0; k < list->count; k++) {
+        if (guidance_names(list->items[k], value)) return true;
+    }
+    return false;
+}
+
+/*
+ * Find a sensory or meal word at word i that no recipe has: one of
+ * ATTRIBUTE_WORDS or a value the sensory guidance names, such as the
+ * "crunchy" of the avoidance triggers. Returns the number of words used,
+ * or 0.
+ */
+static int parse_unknown_attribute(const FilterParser* parser, int i) {
+    const SensoryConsiderations* guidance = &parser->db->sensory_considerations;
+
+    for (int n = FILTER_MAX_NGRAM; n >= 1; n--) {
+        if (i + n > parser->word_count) continue;
+
+        StringView span = word_span(parser, i, n);
+        size_t lengths[3];
+        int form_count = plural_forms(span, lengths);
+        for (int k = 0; k < form_count; k++) {
+            StringView candidate = { span.data, lengths[k] };
+            for (int w = 0; w < COUNT_OF(ATTRIBUTE_WORDS); w++) {
+                if (sv_equals(candidate, sv_from_cstr(ATTRIBUTE_WORDS[w]))) return n;
+            }
+            for (int d = 0; d < SENSORY_DIMENSION_COUNT; d++) {
+                if (in_guidance_list(&guidance->avoidance_triggers[d], candidate) ||
+                    in_guidance_list(&guidance->preferred_profiles[d], candidate)) {
+                    return n;
+                }
+            }
+            for (int m = 0; m < guidance->texture_mapping_count; m++) {
+                if (guidance_names(guidance->texture_mappings[m].trigger, candidate)) return n;
+            }
+        }
+    }
+    return 0;
+}
+
+/* A word that is not part of any constraint but asks for something */
+static bool is_unrecognized(const FilterParser* parser, int i) {
+    StringView word = parser->words[i];
+    int number;
+    return !word_in(word, FILLER_WORDS, COUNT_OF(FILLER_WORDS)) &&
+           !word_in(word, LIST_WORDS, COUNT_OF(LIST_WORDS)) &&
+           !word_in(word, EXCLUSION_CONNECTIVES, COUNT_OF(EXCLUSION_CONNECTIVES)) &&
+           !is_time_unit(word) && !is_digits(word) && parse_number(parser, i, &number) == 0;
+}
+
+/* Turn the attribute at target into an OR of itself and node */
+static void join_or(FilterParser* parser, int target, int node) {
+    RecipeFilter* filter = parser->filter;
+    if (filter->nodes[target].type != FILTER_OR) {
+        int copy = add_node(parser, FILTER_ATTRIBUTE);
+        if (copy < 0) return;
+        filter->nodes[copy] = filter->nodes[target];
+        filter->nodes[copy].next_sibling = -1;
+
+        int next_sibling = filter->nodes[target].next_sibling;
+        memset(&filter->nodes[target], 0, sizeof(FilterNode));
+        filter->nodes[target].type = FILTER_OR;
+        filter->nodes[target].first_child = copy;
+        filter->nodes[target].next_sibling = next_sibling;
+    }
+    append_child(filter, target, node);
+}
+
+bool parse_recipe_filter(const RecipeDB* db, const ParsedQuery* query, RecipeFilter* filter) {
+    if (!db || !query || !query->normalized || !filter) return false;
+    if (db->recipe_count == 0) return false;
+
+    /* "How long does X take" is about X, even if X is "Quick Soft Oats" */
+    bool is_recipe = parsed_query_is_recipe(query);
+    if (query->type != QUERY_GENERAL && is_recipe) return false;
+
+    FilterParser parser;
+    parser.db = db;
+    parser.filter = filter;
+    parser.word_count = 0;
+    parser.failed = false;
+    tokenize(&parser, query->normalized, query->normalized_length);
+
+    filter->node_count = 0;
+    filter->page = 1;
+    filter->unrecognized_count = 0;
+    filter->root = add_node(&parser, FILTER_AND);
+
+    int positives = 0;
+    int exclusions = 0;
+    int times = 0;
+    bool list_cue = false;
+    bool meal_type = false;
+
+    bool negate = false;
+    /* The last attribute kept, and whether it directly precedes an "or" */
+    int last_positive = -1;
+    bool after_positive = false;
+    bool pending_or = false;
+    /* Field words before here belong to an earlier time constraint */
+    int time_floor = 0;
+
+    int i = 0;
+    while (i < parser.word_count && !parser.failed) {
+        StringView word = parser.words[i];
+
+        if (word_is(word, "page") && i + 1 < parser.word_count && is_digits(parser.words[i + 1]) &&
+            parser.words[i + 1].length <= 4) {
+            int page = atoi(parser.words[i + 1].data);
+            filter->page = page < 1 ? 1 : page > FILTER_MAX_PAGE ? FILTER_MAX_PAGE : page;
+            negate = after_positive = pending_or = false;
+            i += 2;
+            continue;
+        }
+
+        int end = parse_time_constraint(&parser, i, time_floor);
+        if (end > 0) {
+            times++;
+            time_floor = end;
+            negate = after_positive = pending_or = false;
+            i = end;
+            continue;
+        }
+
+        if (word_in(word, EXCLUSION_WORDS, COUNT_OF(EXCLUSION_WORDS))) {
+            negate = true;
+            after_positive = pending_or = false;
+            i++;
+            continue;
+        }
+
+        SymbolId id = SYMBOL_NONE;
+        uint32_t kinds = 0;
+        bool plural = false;
+        int used = parse_attribute(&parser, i, &id, &kinds, &plural);
+        bool known = used > 0;
+        if (!known) used = parse_unknown_attribute(&parser, i);
+        if (used > 0) {
+            int node = add_node(&parser, known ? FILTER_ATTRIBUTE : FILTER_UNKNOWN);
+            if (node < 0) break;
+            filter->nodes[node].value = id;
+            filter->nodes[node].kinds = kinds;
+            filter->nodes[node].term = word_span(&parser, i, used);
+
+            if (negate) {
+                int not_node = add_node(&parser, FILTER_NOT);
+                if (not_node < 0) break;
+                append_child(filter, not_node, node);
+                append_child(filter, filter->root, not_node);
+                exclusions++;
+                after_positive = false;
+            } else {
+                if (pending_or && last_positive >= 0) {
+                    join_or(&parser, last_positive, node);
+                } else {
+                    append_child(filter, filter->root, node);
+                    last_positive = node;
+                    positives++;
+                }
+                if (kinds & (1u << ATTRIBUTE_MEAL_TYPE)) {
+                    meal_type = true;
+                    /* "snacks", "dinners" */
+                    if (plural) list_cue = true;
+                }
+                after_positive = true;
+            }
+            pending_or = false;
+            i += used;
+            continue;
+        }
+
+        if (word_is(word, "or")) {
+            pending_or = after_positive;
+        } else if (!negate || !word_in(word, EXCLUSION_CONNECTIVES, COUNT_OF(EXCLUSION_CONNECTIVES))) {
+            if (word_in(word, LIST_WORDS, COUNT_OF(LIST_WORDS))) list_cue = true;
+            negate = false;
+            pending_or = false;
+        }
+        if (is_unrecognized(&parser, i) && filter->unrecognized_count < RECIPE_FILTER_MAX_UNRECOGNIZED) {
+            filter->unrecognized[filter->unrecognized_count++] = word;
+        }
+        after_positive = false;
+        i++;
+    }
+    if (parser.failed) return false;
+
+    if (times + exclusions > 0) return true;
+    /* Two attributes alone could be part of a recipe's name */
+    return positives >= 2 &&
+           (list_cue || query->excludes_recipe || query->is_suggestion || (meal_type && !is_recipe));
+}
+
+/* ===== Planning and execution ===== */
+
+/* The slice of the field's time index whose times are in the node's range */
+static void time_range(const RecipeDB* db, const FilterNode* node, int* begin, int* end) {
+    const TimeIndex* index = &db->time_index[node->field];
+
+    int low = 0;
+    int high = index->count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (index->minutes[mid] < node->min_minutes) low = mid + 1; else high = mid;
+    }
+    *begin = low;
+
+    high = index->count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (index->minutes[mid] <= node->max_minutes) low = mid + 1; else high = mid;
+    }
+    *end = low;
+}
+
+/* How many recipes a predicate keeps: exact for attributes and times,
+   bounds combined from the children otherwise */
+static int estimate_node(const RecipeDB* db, const RecipeFilter* filter, int index) {
+    const FilterNode* node = &filter->nodes[index];
+    int total = db->recipe_count;
+
+    switch (node->type) {
+        case FILTER_ATTRIBUTE: {
+            long long sum = 0;
+            for (int kind = 0; kind < ATTRIBUTE_KIND_COUNT; kind++) {
+                if (node->kinds & (1u << kind)) {
+                    sum += bitmap_cardinality(&db->attribute_index[kind][node->value]);
+                }
+            }
+            return sum < total ? (int)sum : total;
+        }
+        case FILTER_TIME: {
+            int begin, end;
+            time_range(db, node, &begin, &end);
+            return end - begin;
+        }
+        case FILTER_UNKNOWN:
+            return 0;
+        case FILTER_NOT:
+            return total - estimate_node(db, filter, node->first_child);
+        case FILTER_OR: {
+            long long sum = 0;
+            for (int child = node->first_child; child >= 0; child = filter->nodes[child].next_sibling) {
+                sum += estimate_node(db, filter, child);
+            }
+            return sum < total ? (int)sum : total;
+        }
+        default: {
+            int smallest = total;
+            for (int child = node->first_child; child >= 0; child = filter->nodes[child].next_sibling) {
+                int estimate = estimate_node(db, filter, child);
+                if (estimate < smallest) smallest = estimate;
+            }
+            return smallest;
+        }
+    }
+}
+
+/* Cheaper checks first among predicates that keep as many recipes */
+static int node_cost(const FilterNode* node) {
+    switch (node->type) {
+        case FILTER_UNKNOWN: return 0;
+        case FILTER_TIME: return 0;
+        case FILTER_ATTRIBUTE: return 1;
+        case FILTER_NOT: return 2;
+        default: return 3;
+    }
+}
+
+static bool node_matches(const RecipeDB* db, const RecipeFilter* filter, int index, int recipe) {
+    const FilterNode* node = &filter->nodes[index];
+
+    switch (node->type) {
+        case FILTER_ATTRIBUTE:
+            for (int kind = 0; kind < ATTRIBUTE_KIND_COUNT; kind++) {
+                if ((node->kinds & (1u << kind)) &&
+                    bitmap_contains(&db->attribute_index[kind][node->value], (uint32_t)recipe)) {
+                    return true;
+                }
+            }
+            return false;
+        case FILTER_TIME: {
+            int32_t minutes = get_recipe_time_column(db, node->field)[recipe];
+            return minutes != RECIPE_MINUTES_UNKNOWN &&
+                   minutes >= node->min_minutes && minutes <= node->max_minutes;
+        }
+        case FILTER_UNKNOWN:
+            return false;
+        case FILTER_NOT:
+            return !node_matches(db, filter, node->first_child, recipe);
+        case FILTER_OR:
+            for (int child = node->first_child; child >= 0; child = filter->nodes[child].next_sibling) {
+                if (node_matches(db, filter, child, recipe)) return true;
+            }
+            return false;
+        default:
+            for (int child = node->first_child; child >= 0; child = filter->nodes[child].next_sibling) {
+                if (!node_matches(db, filter, child, recipe)) return false;
+            }
+            return true;
+    }
+}
+
+/*
+ * The root's predicates in the order they are checked, most selective
+ * first, and the one whose candidates are walked: the most selective
+ * attribute of a single kind or narrow time range, or -1 to scan every
+ * recipe. A plan is empty when some predicate is known to match nothing.
+ */
+typedef struct {
+    int checks[RECIPE_FILTER_MAX_NODES];
+    int check_count;
+    int driver;
+    int driver_estimate;
+    bool empty;
+} FilterPlan;
+
+static void plan_filter(const RecipeDB* db, const RecipeFilter* filter, FilterPlan* plan) {
+    int estimates[RECIPE_FILTER_MAX_NODES];
+    plan->check_count = 0;
+    plan->driver = -1;
+    plan->driver_estimate = db->recipe_count;
+    plan->empty = false;
+
+    const FilterNode* root = &filter->nodes[filter->root];
+    for (int child = root->first_child; child >= 0; child = filter->nodes[child].next_sibling) {
+        int estimate = estimate_node(db, filter, child);
+        int cost = node_cost(&filter->nodes[child]);
+        if (filter->nodes[child].type == FILTER_UNKNOWN) plan->empty = true;
+
+        int j = plan->check_count++;
+        while (j > 0) {
+            int previous = plan->checks[j - 1];
+            if (estimates[j - 1] < estimate ||
+                (estimates[j - 1] == estimate && node_cost(&filter->nodes[previous]) <= cost)) {
+                break;
+            }
+            plan->checks[j] = previous;
+            estimates[j] = estimates[j - 1];
+            j--;
+        }
+        plan->checks[j] = child;
+        estimates[j] = estimate;
+    }
+
+    for (int i = 0; i < plan->check_count; i++) {
+        const FilterNode* node = &filter->nodes[plan->checks[i]];
+        bool drives = false;
+        if (node->type == FILTER_ATTRIBUTE) {
+            drives = (node->kinds & (node->kinds - 1)) == 0;
+        } else if (node->type == FILTER_TIME) {
+            drives = estimates[i] <= db->recipe_count / FILTER_TIME_DRIVER_DIVISOR;
+        }
+        if (drives) {
+            plan->driver = plan->checks[i];
+            plan->driver_estimate = estimates[i];
+            memmove(&plan->checks[i], &plan->checks[i + 1], (size_t)(plan->check_count - i - 1) * sizeof(int));
+            plan->check_count--;
+            break;
+        }
+    }
+}
+
+typedef struct {
+    int* recipe_indices;
+    int max_results;
+    int skip;
+    int count;
+    bool more;
+} FilterResults;
+
+/* Check a candidate against every predicate but the driver; returns false
+   once the page is full and a further match has been seen */
+static bool visit_candidate(const RecipeDB* db, const RecipeFilter* filter, const FilterPlan* plan,
+                            int recipe, FilterResults* results) {
+    for (int i = 0; i < plan->check_count; i++) {
+        if (!node_matches(db, filter, plan->checks[i], recipe)) return true;
+    }
+
+    if (results->skip > 0) {
+        results->skip--;
+        return true;
+    }
+    if (results->count == results->max_results) {
+        results->more = true;
+        return false;
+    }
+    results->recipe_indices[results->count++] = recipe;
+    return true;
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+int run_recipe_filter(const RecipeDB* db, const RecipeFilter* filter, int offset,
+                      int* recipe_indices, int max_results, bool* more) {
+    if (more) *more = false;
+    if (!db || !filter || !recipe_indices || max_results <= 0 || filter->node_count == 0) return 0;
+
+    FilterPlan plan;
+    plan_filter(db, filter, &plan);
+    if (plan.empty) return 0;
+
+    FilterResults results;
+    results.recipe_indices = recipe_indices;
+    results.max_results = max_results;
+    results.skip = offset > 0 ? offset : 0;
+    results.count = 0;
+    results.more = false;
+
+    if (plan.driver < 0) {
+        for (int recipe = 0; recipe < db->recipe_count; recipe++) {
+            if (!visit_candidate(db, filter, &plan, recipe, &results)) break;
+        }
+    } else if (plan.driver_estimate > 0 && filter->nodes[plan.driver].type == FILTER_ATTRIBUTE) {
+        const FilterNode* driver = &filter->nodes[plan.driver];
+        int kind = 0;
+        while (!(driver->kinds & (1u << kind))) kind++;
+        const Bitmap* posting = &db->attribute_index[kind][driver->value];
+
+        uint32_t batch[FILTER_BATCH_SIZE];
+        uint32_t from = 0;
+        bool running = true;
+        while (running) {
+            uint32_t count = bitmap_to_array_from(posting, from, batch, FILTER_BATCH_SIZE);
+            for (uint32_t i = 0; i < count && running; i++) {
+                running = visit_candidate(db, filter, &plan, (int)batch[i], &results);
+            }
+            if (count < FILTER_BATCH_SIZE) break;
+            from = batch[count - 1] + 1;
+        }
+    } else if (plan.driver_estimate > 0) {
+        /* The time index is in time order; visit its slice in recipe order */
+        const TimeIndex* index = &db->time_index[filter->nodes[plan.driver].field];
+        int begin, end;
+        time_range(db, &filter->nodes[plan.driver], &begin, &end);
+
+        int* candidates = (int*)malloc((size_t)(end - begin) * sizeof(int));
+        if (!candidates) return -1;
+        memcpy(candidates, index->recipes + begin, (size_t)(end - begin) * sizeof(int));
+        qsort(candidates, (size_t)(end - begin), sizeof(int), compare_ints);
+        for (int i = 0; i < end - begin; i++) {
+            if (!visit_candidate(db, filter, &plan, candidates[i], &results)) break;
+        }
+        free(candidates);
+    }
+
+    if (more) *more = results.more;
+    return results.count;
+}
+
+/* ===== Responses ===== */
+
+static const char* time_field_name(RecipeTimeField field) {
+    switch (field) {
+        case RECIPE_TIME_PREP: return "prep";
+        case RECIPE_TIME_COOK: return "cook";
+        default: return "total";
+    }
+}
+
+static void append_minutes(StringBuilder* out, int32_t minutes) {
+    sb_appendf(out, "%d minute%s", (int)minutes, minutes == 1 ? "" : "s");
+}
+
+/* Describe a predicate in words, e.g. "warm, soft and not crunchy" */
+static void describe_node(const RecipeDB* db, const RecipeFilter* filter, int index, StringBuilder* out) {
+    const FilterNode* node = &filter->nodes[index];
+
+    switch (node->type) {
+        case FILTER_ATTRIBUTE:
+            sb_append_view(out, get_symbol_name(db, node->value));
+            break;
+        case FILTER_UNKNOWN:
+            sb_append_view(out, node->term);
+            break;
+        case FILTER_TIME:
+            sb_appendf(out, "a %s time of ", time_field_name(node->field));
+            if (node->max_minutes == INT32_MAX) {
+                sb_append_cstr(out, "at least ");
+                append_minutes(out, node->min_minutes);
+            } else if (node->min_minutes == 0) {
+                sb_append_cstr(out, "at most ");
+                append_minutes(out, node->max_minutes);
+            } else {
+                sb_appendf(out, "%d to ", (int)node->min_minutes);
+                append_minutes(out, node->max_minutes);
+            }
+            break;
+        case FILTER_NOT:
+            sb_append_cstr(out, "not ");
+            describe_node(db, filter, node->first_child, out);
+            break;
+        case FILTER_OR:
+            for (int child = node->first_child; child >= 0; child = filter->nodes[child].next_sibling) {
+                if (child != node->first_child) sb_append_cstr(out, " or ");
+                describe_node(db, filter, child, out);
+            }
+            break;
+        default:
+            for (int child = node->first_child; child >= 0; child = filter->nodes[child].next_sibling) {
+                if (child != node->first_child) {
+                    sb_append_cstr(out, filter->nodes[child].next_sibling < 0 ? " and " : ", ");
+                }
+                describe_node(db, filter, child, out);
+            }
+            break;
+    }
+}
+
+/* Name the words the filter left out, e.g. "quick" in "quick soft dinner" */
+static void append_unrecognized(const RecipeFilter* filter, StringBuilder* out) {
+    if (filter->unrecognized_count == 0) return;
+
+    sb_append_cstr(out, "I didn't recognize ");
+    for (int i = 0; i < filter->unrecognized_count; i++) {
+        if (i > 0) sb_append_cstr(out, i + 1 == filter->unrecognized_count ? " or " : ", ");
+        sb_appendf(out, "\"%.*s\"", SV_ARG(filter->unrecognized[i]));
+    }
+    sb_append_cstr(out, filter->unrecognized_count == 1 ? ", so it was not used to filter."
+                                                        : ", so they were not used to filter.");
+}
+
+bool answer_filter_query(const RecipeDB* db, const RecipeFilter* filter, StringBuilder* out) {
+    if (!db || !filter || !out) return false;
+
+    int recipe_indices[RECIPE_FILTER_PAGE_SIZE];
+    bool more;
+    int offset = (filter->page - 1) * RECIPE_FILTER_PAGE_SIZE;
+    int count = run_recipe_filter(db, filter, offset, recipe_indices, RECIPE_FILTER_PAGE_SIZE, &more);
+    if (count < 0) return false;
+
+    if (count == 0) {
+        sb_append_cstr(out, filter->page > 1 ? "There are no more meals matching "
+                                             : "I couldn't find any meals matching ");
+        describe_node(db, filter, filter->root, out);
+        sb_append_cstr(out, filter->unrecognized_count > 0 ? ".\n" : ".");
+        append_unrecognized(filter, out);
+        return !out->failed;
+    }
+
+    sb_append_cstr(out, filter->page > 1 ? "Here are more meals matching " : "Here are meals matching ");
+    describe_node(db, filter, filter->root, out);
+    if (filter->page > 1) sb_appendf(out, " (page %d)", filter->page);
+    sb_append_cstr(out, ":\n");
+
+    for (int i = 0; i < count; i++) {
+        const Recipe* recipe = &db->recipes[recipe_indices[i]];
+        int32_t total = db->columns.total_minutes[recipe_indices[i]];
+        sb_appendf(out, "- %.*s", SV_ARG(recipe->name));
+        if (total != RECIPE_MINUTES_UNKNOWN) {
+            sb_append_cstr(out, " (");
+            append_minutes(out, total);
+            sb_append_cstr(out, " total)");
+        }
+        sb_append_cstr(out, "\n");
+    }
+    if (more) {
+        sb_appendf(out, "Ask for page %d to see more.", filter->page + 1);
+        if (filter->unrecognized_count > 0) sb_append_cstr(out, "\n");
+    }
+    append_unrecognized(filter, out);
+    return !out->failed;
+}
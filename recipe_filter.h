@@ -0,0 +1,116 @@
+/**
+ * NeuroChef - Recipe Filters
+ * 
+ * This header declares compound filter queries such as "warm, soft dinner
+ * under 20 minutes total" or "snacks without crunchy". A query is parsed
+ * into a small predicate tree over meal types, sensory attributes, prep,
+ * cook and total time ranges and excluded attributes. Running a filter
+ * estimates how many recipes each predicate keeps, reads candidates from
+ * the most selective posting bitmap or time index and checks the remaining
+ * predicates cheapest first, so the cost follows the smallest constraint
+ * rather than the size of the catalog.
+ */
+
+#ifndef RECIPE_FILTER_H
+#define RECIPE_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "recipe_utils.h"
+#include "string_builder.h"
+
+/* Predicates one query can hold */
+#define RECIPE_FILTER_MAX_NODES 32
+/* Recipes listed per page of a response */
+#define RECIPE_FILTER_PAGE_SIZE 10
+/* Words a response reports it did not recognize */
+#define RECIPE_FILTER_MAX_UNRECOGNIZED 4
+
+typedef enum {
+    FILTER_AND,
+    FILTER_OR,
+    FILTER_NOT,
+    FILTER_ATTRIBUTE,
+    FILTER_TIME,
+    /* A sensory or meal word no recipe has, which matches nothing */
+    FILTER_UNKNOWN
+} FilterNodeType;
+
+typedef struct {
+    FilterNodeType type;
+    /* Children of AND, OR and NOT nodes as indices into RecipeFilter.nodes;
+       -1 ends a list */
+    int first_child;
+    int next_sibling;
+    /* ATTRIBUTE: the value, matched under any attribute kind in kinds
+       (a bit per AttributeKind) */
+    SymbolId value;
+    uint32_t kinds;
+    /* TIME: an inclusive range of minutes */
+    RecipeTimeField field;
+    int32_t min_minutes;
+    int32_t max_minutes;
+    /* UNKNOWN: the word as written in the query */
+    StringView term;
+} FilterNode;
+
+typedef struct {
+    FilterNode nodes[RECIPE_FILTER_MAX_NODES];
+    int node_count;
+    /* An AND of every constraint in the query */
+    int root;
+    /* The page asked for, e.g. "page 2"; pages start at 1 */
+    int page;
+    /* Words that were neither constraints nor filler, so they constrain
+       nothing; the response names them */
+    StringView unrecognized[RECIPE_FILTER_MAX_UNRECOGNIZED];
+    int unrecognized_count;
+} RecipeFilter;
+
+/**
+ * Parse a query into a filter, if it asks for meals meeting constraints
+ * 
+ * A query is a filter when it constrains a time or excludes an attribute,
+ * or lists two or more attributes while asking for meals in general. Queries
+ * about one named recipe, e.g. "How long does Berry Blast Smoothie take?",
+ * are never filters.
+ * 
+ * A sensory or meal word that no recipe has, e.g. "crunchy", still becomes
+ * a constraint, one that matches nothing, so an unknown word never widens
+ * the result. Terms in the filter point into the query's normalized text.
+ * 
+ * @param db The recipe database whose attribute values are recognized
+ * @param query The parsed query
+ * @param filter Receives the predicate tree
+ * @return true if the query is a filter query, false otherwise
+ */
+bool parse_recipe_filter(const RecipeDB* db, const ParsedQuery* query, RecipeFilter* filter);
+
+/**
+ * Find the recipes that satisfy a filter
+ * 
+ * Matches are returned in recipe order whichever predicate drives the
+ * search, so pages are stable.
+ * 
+ * @param db The recipe database
+ * @param filter The filter
+ * @param offset The number of matches to skip
+ * @param recipe_indices Receives matching indices into db->recipes
+ * @param max_results The capacity of recipe_indices
+ * @param more Set to true if further matches follow (may be NULL)
+ * @return The number of indices written, or -1 on allocation failure
+ */
+int run_recipe_filter(const RecipeDB* db, const RecipeFilter* filter, int offset,
+                      int* recipe_indices, int max_results, bool* more);
+
+/**
+ * Generate a response listing one page of the recipes a filter matches
+ * 
+ * @param db The recipe database
+ * @param filter The filter
+ * @param out The builder to append the response to
+ * @return true on success, false if out of memory
+ */
+bool answer_filter_query(const RecipeDB* db, const RecipeFilter* filter, StringBuilder* out);
+
+#endif /* RECIPE_FILTER_H */
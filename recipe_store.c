@@ -0,0 +1,352 @@
+/**
+ * NeuroChef - Recipe Store Implementation
+ * 
+ * This file implements publishing databases with hazard-pointer
+ * reclamation, and the thread that reloads a watched file.
+ * 
+ * A reader announces the database it is about to use in its slot and then
+ * checks that it is still current; a database that was swapped out is only
+ * freed after a scan of all slots finds no reader announcing it. With
+ * sequentially consistent loads and stores on both sides, either the
+ * reader sees the swap and retries, or the scan sees the reader.
+ */
+
+#include "recipe_store.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#define CACHE_LINE_SIZE 64
+/* Wait this long after the last change before reloading */
+#define RELOAD_QUIET_MS 200
+/* How often to retry freeing databases a reader still held */
+#define RECLAIM_INTERVAL_MS 50
+/* How often to check the file where inotify is unavailable */
+#define POLL_INTERVAL_MS 1000
+
+struct RecipeStoreReader {
+    /* The database this reader is using, read by the reclaimer */
+    const RecipeDB* hazard;
+    bool in_use;
+    RecipeStoreReader* next;
+    /* Keep each reader's hazard off other readers' cache lines */
+    char padding[CACHE_LINE_SIZE];
+};
+
+bool recipe_store_init(RecipeStore* store, RecipeDB* db) {
+    memset(store, 0, sizeof(*store));
+    store->current = db;
+    store->stop_fds[0] = -1;
+    store->stop_fds[1] = -1;
+    store->watch_fd = -1;
+    return pthread_mutex_init(&store->lock, NULL) == 0;
+}
+
+RecipeStoreReader* recipe_store_register(RecipeStore* store) {
+    pthread_mutex_lock(&store->lock);
+    RecipeStoreReader* reader = store->readers;
+    while (reader && reader->in_use) {
+        reader = reader->next;
+    }
+    if (!reader) {
+        reader = (RecipeStoreReader*)calloc(1, sizeof(RecipeStoreReader));
+        if (reader) {
+            reader->next = store->readers;
+            store->readers = reader;
+        }
+    }
+    if (reader) {
+        reader->in_use = true;
+    }
+    pthread_mutex_unlock(&store->lock);
+    return reader;
+}
+
+void recipe_store_unregister(RecipeStore* store, RecipeStoreReader* reader) {
+    if (!reader) return;
+    recipe_store_release(reader);
+    pthread_mutex_lock(&store->lock);
+    reader->in_use = false;
+    pthread_mutex_unlock(&store->lock);
+}
+
+const RecipeDB* recipe_store_acquire(RecipeStore* store, RecipeStoreReader* reader) {
+    RecipeDB* db;
+    do {
+        db = __atomic_load_n(&store->current, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&reader->hazard, db, __ATOMIC_SEQ_CST);
+    } while (db != __atomic_load_n(&store->current, __ATOMIC_SEQ_CST));
+    return db;
+}
+
+void recipe_store_release(RecipeStoreReader* reader) {
+    __atomic_store_n(&reader->hazard, NULL, __ATOMIC_RELEASE);
+}
+
+static bool is_held(const RecipeStore* store, const RecipeDB* db) {
+    for (const RecipeStoreReader* reader = store->readers; reader; reader = reader->next) {
+        if (__atomic_load_n(&reader->hazard, __ATOMIC_SEQ_CST) == db) return true;
+    }
+    return false;
+}
+
+static int reclaim_locked(RecipeStore* store) {
+    int kept = 0;
+    for (int i = 0; i < store->retired_count; i++) {
+        RecipeDB* db = store->retired[i];
+        if (is_held(store, db)) {
+            store->retired[kept++] = db;
+        } else {
+            free_recipe_db(db);
+        }
+    }
+    store->retired_count = kept;
+    return kept;
+}
+
+int recipe_store_reclaim(RecipeStore* store) {
+    pthread_mutex_lock(&store->lock);
+    int held = reclaim_locked(store);
+    pthread_mutex_unlock(&store->lock);
+    return held;
+}
+
+void recipe_store_publish(RecipeStore* store, RecipeDB* db) {
+    RecipeDB* old = __atomic_exchange_n(&store->current, db, __ATOMIC_SEQ_CST);
+    if (!old) return;
+
+    pthread_mutex_lock(&store->lock);
+    if (store->retired_count == store->retired_capacity) {
+        int capacity = store->retired_capacity ? store->retired_capacity * 2 : 4;
+        RecipeDB** retired = (RecipeDB**)realloc(store->retired, (size_t)capacity * sizeof(RecipeDB*));
+        if (retired) {
+            store->retired = retired;
+            store->retired_capacity = capacity;
+        }
+    }
+    if (store->retired_count < store->retired_capacity) {
+        store->retired[store->retired_count++] = old;
+    } else {
+        /* No room to defer it: wait out its readers, whose queries are short */
+        while (is_held(store, old)) {
+#ifndef _WIN32
+            sched_yield();
+#endif
+        }
+        free_recipe_db(old);
+    }
+    reclaim_locked(store);
+    pthread_mutex_unlock(&store->lock);
+}
+
+#ifndef _WIN32
+
+#ifdef __linux__
+/* Drain pending inotify events; returns true if any concern the watched file */
+static bool read_changes(RecipeStore* store) {
+    const char* name = strrchr(store->watch_path, '/');
+    name = name ? name + 1 : store->watch_path;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+
+    for (;;) {
+        ssize_t length = read(store->watch_fd, buffer, sizeof(buffer));
+        if (length <= 0) break;
+
+        for (char* p = buffer; p < buffer + length;) {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            if ((event->mask & IN_Q_OVERFLOW) ||
+                (event->len > 0 && strcmp(event->name, name) == 0)) {
+                changed = true;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
+#endif
+
+/* Poll the file's size and modification time; returns true if they changed */
+static bool file_changed(const char* path, struct stat* last) {
+    struct stat st;
+    if (stat(path, &st) != 0) return false;
+    bool changed = st.st_size != last->st_size || st.st_mtime != last->st_mtime;
+    *last = st;
+    return changed;
+}
+
+static void* watch_file(void* argument) {
+    RecipeStore* store = (RecipeStore*)argument;
+
+    struct stat last;
+    if (stat(store->watch_path, &last) != 0) {
+        memset(&last, 0, sizeof(last));
+    }
+
+    bool pending = false;
+    int held = 0;
+    for (;;) {
+        int timeout = pending ? RELOAD_QUIET_MS
+                    : held > 0 ? RECLAIM_INTERVAL_MS
+                    : store->watch_fd >= 0 ? -1 : POLL_INTERVAL_MS;
+        struct pollfd fds[2];
+        fds[0].fd = store->stop_fds[0];
+        fds[0].events = POLLIN;
+        fds[1].fd = store->watch_fd;
+        fds[1].events = POLLIN;
+
+        int ready = poll(fds, store->watch_fd >= 0 ? 2 : 1, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents) break;
+
+#ifdef __linux__
+        if (ready > 0 && store->watch_fd >= 0 && (fds[1].revents & POLLIN)) {
+            /* Each change restarts the quiet period */
+            if (read_changes(store)) pending = true;
+            continue;
+        }
+#endif
+        if (store->watch_fd < 0 && !pending && file_changed(store->watch_path, &last)) {
+            pending = true;
+            continue;
+        }
+
+        if (pending) {
+            pending = false;
+            RecipeDB* db = store->loader(store->loader_context);
+            if (db) recipe_store_publish(store, db);
+        }
+        held = recipe_store_reclaim(store);
+    }
+    return NULL;
+}
+
+bool recipe_store_watch(RecipeStore* store, const char* path, RecipeStoreLoader loader, void* context) {
+    if (store->watching) return false;
+
+    store->watch_path = (char*)malloc(strlen(path) + 1);
+    if (!store->watch_path) return false;
+    strcpy(store->watch_path, path);
+    store->loader = loader;
+    store->loader_context = context;
+
+#ifdef __linux__
+    /* Watch the directory, since editors often replace the file rather than
+       write it in place */
+    const char* slash = strrchr(path, '/');
+    size_t directory_length = slash ? (size_t)(slash - path) : 0;
+    char* directory = (char*)malloc(directory_length + 2);
+    if (directory) {
+        if (!slash) {
+            strcpy(directory, ".");
+        } else if (directory_length == 0) {
+            strcpy(directory, "/");
+        } else {
+            memcpy(directory, path, directory_length);
+            directory[directory_length] = '\0';
+        }
+        store->watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (store->watch_fd >= 0 &&
+            inotify_add_watch(store->watch_fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            close(store->watch_fd);
+            store->watch_fd = -1;
+        }
+        free(directory);
+    }
+#endif
+
+    if (pipe(store->stop_fds) != 0) {
+        store->stop_fds[0] = store->stop_fds[1] = -1;
+    } else {
+        /* Signals belong to the threads that handle them, not the watcher */
+        sigset_t all_signals, previous;
+        sigfillset(&all_signals);
+        pthread_sigmask(SIG_SETMASK, &all_signals, &previous);
+        int created = pthread_create(&store->watcher, NULL, watch_file, store);
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+        if (created == 0) {
+            store->watching = true;
+            return true;
+        }
+    }
+
+    if (store->stop_fds[0] >= 0) {
+        close(store->stop_fds[0]);
+        close(store->stop_fds[1]);
+        store->stop_fds[0] = store->stop_fds[1] = -1;
+    }
+    if (store->watch_fd >= 0) {
+        close(store->watch_fd);
+        store->watch_fd = -1;
+    }
+    free(store->watch_path);
+    store->watch_path = NULL;
+    return false;
+}
+
+static void stop_watching(RecipeStore* store) {
+    if (store->watching) {
+        ssize_t written = write(store->stop_fds[1], "", 1);
+        (void)written;
+        pthread_join(store->watcher, NULL);
+        close(store->stop_fds[0]);
+        close(store->stop_fds[1]);
+        if (store->watch_fd >= 0) close(store->watch_fd);
+        store->watching = false;
+    }
+}
+
+#else
+
+bool recipe_store_watch(RecipeStore* store, const char* path, RecipeStoreLoader loader, void* context) {
+    (void)store;
+    (void)path;
+    (void)loader;
+    (void)context;
+    return false;
+}
+
+static void stop_watching(RecipeStore* store) {
+    (void)store;
+}
+
+#endif
+
+void recipe_store_free(RecipeStore* store) {
+    stop_watching(store);
+
+    free_recipe_db(store->current);
+    store->current = NULL;
+    for (int i = 0; i < store->retired_count; i++) {
+        free_recipe_db(store->retired[i]);
+    }
+    free(store->retired);
+    store->retired = NULL;
+    store->retired_count = 0;
+
+    RecipeStoreReader* reader = store->readers;
+    while (reader) {
+        RecipeStoreReader* next = reader->next;
+        free(reader);
+        reader = next;
+    }
+    store->readers = NULL;
+
+    free(store->watch_path);
+    store->watch_path = NULL;
+    pthread_mutex_destroy(&store->lock);
+}
@@ -0,0 +1,138 @@
+/**
+ * NeuroChef - Recipe Store
+ * 
+ * This header declares the holder of the current RecipeDB, which lets the
+ * database be replaced while queries are running. A new database is built
+ * off to the side and published with one atomic pointer swap; queries that
+ * already started keep the version they began with, and a replaced version
+ * is freed once no reader holds it.
+ * 
+ * Readers never wait. Each thread that queries registers a reader and, for
+ * each query, acquires the current database and releases it afterwards;
+ * the reader's slot is the hazard pointer that keeps that version alive.
+ * Publishing and freeing happen on the thread that reloads.
+ * 
+ * A store can also watch the JSON file it was loaded from and reload it
+ * whenever it changes: with inotify on Linux, by polling its size and
+ * modification time elsewhere on POSIX.
+ */
+
+#ifndef RECIPE_STORE_H
+#define RECIPE_STORE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include "recipe_utils.h"
+
+/**
+ * Builds a new database for a reload
+ * 
+ * @param context The context passed to recipe_store_watch
+ * @return The database, or NULL to keep the current one
+ */
+typedef RecipeDB* (*RecipeStoreLoader)(void* context);
+
+typedef struct RecipeStoreReader RecipeStoreReader;
+
+typedef struct {
+    /* Read and swapped atomically */
+    RecipeDB* current;
+    /* Guards the reader list and the retired databases */
+    pthread_mutex_t lock;
+    RecipeStoreReader* readers;
+    /* Replaced databases that a reader may still hold */
+    RecipeDB** retired;
+    int retired_count;
+    int retired_capacity;
+    /* The watcher thread, see recipe_store_watch */
+    bool watching;
+    pthread_t watcher;
+    int stop_fds[2];
+    int watch_fd;
+    char* watch_path;
+    RecipeStoreLoader loader;
+    void* loader_context;
+} RecipeStore;
+
+/**
+ * Initialize a store
+ * 
+ * @param store The store to initialize
+ * @param db The first database, or NULL; the store takes ownership
+ * @return true on success, false if the store's lock could not be created
+ */
+bool recipe_store_init(RecipeStore* store, RecipeDB* db);
+
+/**
+ * Register a reader; each querying thread needs its own
+ * 
+ * @param store The store
+ * @return The reader, or NULL if out of memory
+ */
+RecipeStoreReader* recipe_store_register(RecipeStore* store);
+
+/**
+ * Give a reader back to the store for reuse; it must not hold a database
+ * 
+ * @param store The store
+ * @param reader The reader
+ */
+void recipe_store_unregister(RecipeStore* store, RecipeStoreReader* reader);
+
+/**
+ * Get the current database and keep it alive until released
+ * 
+ * @param store The store
+ * @param reader The calling thread's reader
+ * @return The database, or NULL if none has been loaded
+ */
+const RecipeDB* recipe_store_acquire(RecipeStore* store, RecipeStoreReader* reader);
+
+/**
+ * Let go of the database a reader acquired
+ * 
+ * @param reader The reader
+ */
+void recipe_store_release(RecipeStoreReader* reader);
+
+/**
+ * Make a database current; the one it replaces is freed once no reader
+ * holds it
+ * 
+ * @param store The store
+ * @param db The new database; the store takes ownership
+ */
+void recipe_store_publish(RecipeStore* store, RecipeDB* db);
+
+/**
+ * Free the replaced databases that no reader holds any more
+ * 
+ * @param store The store
+ * @return Number of replaced databases still held
+ */
+int recipe_store_reclaim(RecipeStore* store);
+
+/**
+ * Reload whenever a file changes, on a background thread
+ * 
+ * Changes are collected for a short quiet period first, so an editor
+ * saving in several steps causes one reload.
+ * 
+ * @param store The store
+ * @param path The file to watch
+ * @param loader Builds the new database; NULL results are ignored
+ * @param context Passed to the loader
+ * @return true if the file is being watched, false if watching is not
+ *         supported or the watcher could not start
+ */
+bool recipe_store_watch(RecipeStore* store, const char* path, RecipeStoreLoader loader, void* context);
+
+/**
+ * Stop watching and free every database the store owns; no reader may
+ * hold a database
+ * 
+ * @param store The store to free
+ */
+void recipe_store_free(RecipeStore* store);
+
+#endif /* RECIPE_STORE_H */
@@ -5,17 +5,30 @@
  */
 
 #include "recipe_utils.h"
+#include "json_reader.h"
+#include "json_stream.h"
+#include "phrase_matcher.h"
+#include "string_builder.h"
+#include "thread_pool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
+#include <pthread.h>
 
 #define MAX_LINE_LENGTH 4096
 #define MAX_RECIPE_COUNT 100
 #define MAX_INGREDIENTS 50
 #define MAX_STEPS 30
 #define MAX_SENSORY_ATTRS 10
-#define MAX_RESPONSE_LENGTH 4096
+#define RECIPE_ARENA_CHUNK_SIZE (64 * 1024)
+/* Smaller files are not worth starting threads for */
+#define PARALLEL_LOAD_MIN_BYTES (1024 * 1024)
+#define FUZZY_MAX_EDITS 3
+#define FUZZY_MAX_CANDIDATES 256
+/* One precomputed response per QueryType up to QUERY_GENERAL */
+#define RESPONSE_SLOT_COUNT 5
 
 static char* str_duplicate(const char* str) {
     if (!str) return NULL;
@@ -38,1165 +51,2209 @@ char* str_to_lower(const char* str) {
     return lower;
 }
 
-static char* extract_string_value(const char* json, const char* key) {
-    char search_key[256];
-    snprintf(search_key, sizeof(search_key), "\"%s\"", key);
-    
-    char* key_pos = strstr(json, search_key);
-    if (!key_pos) return NULL;
-    
-    char* colon_pos = strchr(key_pos, ':');
-    if (!colon_pos) return NULL;
+static const StringView UNKNOWN_UNIT = { "unknown", 7 };
+
+typedef struct {
+    JsonReader reader;
+    Arena* arena;
+    SymbolTable* symbols;
+    StringView* scratch;
+    int scratch_count;
+    int scratch_capacity;
+    SymbolId* symbol_scratch;
+    int symbol_scratch_count;
+    int symbol_scratch_capacity;
+    Ingredient* ingredient_scratch;
+    int ingredient_scratch_count;
+    int ingredient_scratch_capacity;
+    /* Set when the input is a stream whose buffer is reused, so strings
+       must be copied into the arena rather than pointing into the input */
+    bool copy_strings;
+    /* Set on parallel workers, which cannot share the symbol table: values
+       are logged instead, and a recipe's ids index its own run of the log
+       until merge_meal_symbols interns them in recipe order */
+    bool log_symbols;
+    StringView* symbol_log;
+    size_t symbol_log_count;
+    size_t symbol_log_capacity;
+    size_t recipe_log_start;
+    bool out_of_memory;
+    bool out_of_symbols;
+} RecipeLoader;
+
+static StringView keep_string(RecipeLoader* loader, StringView value) {
+    if (!loader->copy_strings || !value.data) return value;
+
+    /* Empty strings still need a non-NULL pointer to count as present */
+    char* copy = (char*)arena_alloc(loader->arena, value.length > 0 ? value.length : 1);
+    if (!copy) {
+        loader->out_of_memory = true;
+        value.data = NULL;
+        value.length = 0;
+        return value;
+    }
+    memcpy(copy, value.data, value.length);
+    value.data = copy;
+    return value;
+}
 
-    char* value_start = colon_pos + 1;
-    while (*value_start && isspace(*value_start)) value_start++;
-    
-    if (*value_start != '"') return NULL;
-    
-    value_start++;
+static StringView read_string_value(RecipeLoader* loader) {
+    JsonReader* reader = &loader->reader;
+    StringView view = { NULL, 0 };
+    if (json_peek(reader) != '"') {
+        json_skip_value(reader);
+        return view;
+    }
+    json_read_string(reader, &view.data, &view.length);
+    return keep_string(loader, view);
+}
 
-    char* value_end = value_start;
-    while (*value_end && *value_end != '"') {
-        if (*value_end == '\\' && *(value_end + 1)) {
-            value_end += 2;
-        } else {
-            value_end++;
+static void push_scratch(RecipeLoader* loader, StringView value) {
+    if (loader->scratch_count == loader->scratch_capacity) {
+        int new_capacity = loader->scratch_capacity == 0 ? 64 : loader->scratch_capacity * 2;
+        StringView* new_scratch = (StringView*)realloc(loader->scratch, new_capacity * sizeof(StringView));
+        if (!new_scratch) {
+            loader->out_of_memory = true;
+            return;
         }
+        loader->scratch = new_scratch;
+        loader->scratch_capacity = new_capacity;
     }
-    
-    if (*value_end != '"') return NULL;
-    
-    size_t value_len = value_end - value_start;
-    char* value = (char*)malloc(value_len + 1);
-    if (!value) return NULL;
-    
-    strncpy(value, value_start, value_len);
-    value[value_len] = '\0';
-    
-    return value;
+    loader->scratch[loader->scratch_count++] = value;
 }
 
-static int extract_int_value(const char* json, const char* key) {
-    char search_key[256];
-    snprintf(search_key, sizeof(search_key), "\"%s\"", key);
-    
-    char* key_pos = strstr(json, search_key);
-    if (!key_pos) return -1;
-    
-    char* colon_pos = strchr(key_pos, ':');
-    if (!colon_pos) return -1;
+static StringView* commit_scratch(RecipeLoader* loader, int* count) {
+    *count = 0;
+    if (loader->scratch_count == 0) return NULL;
 
-    char* value_start = colon_pos + 1;
-    while (*value_start && isspace(*value_start)) value_start++;
-    
-    return atoi(value_start);
+    StringView* array = (StringView*)arena_copy(loader->arena, loader->scratch,
+                                                loader->scratch_count * sizeof(StringView));
+    if (!array) {
+        loader->out_of_memory = true;
+    } else {
+        *count = loader->scratch_count;
+    }
+    loader->scratch_count = 0;
+    return array;
 }
 
-static char** extract_string_array(const char* json, const char* key, int* count) {
+static StringView* read_string_array(RecipeLoader* loader, int* count) {
+    JsonReader* reader = &loader->reader;
     *count = 0;
-    
-    char search_key[256];
-    snprintf(search_key, sizeof(search_key), "\"%s\"", key);
-    
-    char* key_pos = strstr(json, search_key);
-    if (!key_pos) return NULL;
-    
-    char* array_start = strchr(key_pos, '[');
-    if (!array_start) return NULL;
-    
-    char* array_end = strchr(array_start, ']');
-    if (!array_end) return NULL;
-
-    int element_count = 0;
-    char* p = array_start;
-    while (p < array_end) {
-        if (*p == '"') {
-            element_count++;
-            p++;
-            while (p < array_end && *p != '"') {
-                if (*p == '\\' && *(p + 1)) {
-                    p += 2;
-                } else {
-                    p++;
-                }
-            }
+    if (json_peek(reader) != '[') {
+        json_skip_value(reader);
+        return NULL;
+    }
+
+    json_begin_array(reader);
+    while (json_next_element(reader)) {
+        StringView value = read_string_value(loader);
+        if (value.data) {
+            push_scratch(loader, value);
         }
-        p++;
     }
-    
-    if (element_count == 0) return NULL;
-
-    char** array = (char**)malloc(element_count * sizeof(char*));
-    if (!array) return NULL;
-
-    p = array_start;
-    int i = 0;
-    while (p < array_end && i < element_count) {
-        if (*p == '"') {
-            char* value_start = p + 1;
-            char* value_end = value_start;
-
-            while (value_end < array_end && *value_end != '"') {
-                if (*value_end == '\\' && *(value_end + 1)) {
-                    value_end += 2;
-                } else {
-                    value_end++;
+    return commit_scratch(loader, count);
+}
+
+static void push_symbol(RecipeLoader* loader, SymbolId id) {
+    if (loader->symbol_scratch_count == loader->symbol_scratch_capacity) {
+        int new_capacity = loader->symbol_scratch_capacity == 0 ? 64 : loader->symbol_scratch_capacity * 2;
+        SymbolId* new_scratch = (SymbolId*)realloc(loader->symbol_scratch, new_capacity * sizeof(SymbolId));
+        if (!new_scratch) {
+            loader->out_of_memory = true;
+            return;
+        }
+        loader->symbol_scratch = new_scratch;
+        loader->symbol_scratch_capacity = new_capacity;
+    }
+    loader->symbol_scratch[loader->symbol_scratch_count++] = id;
+}
+
+static SymbolId log_symbol(RecipeLoader* loader, StringView value) {
+    size_t index = loader->symbol_log_count - loader->recipe_log_start;
+    if (index >= SYMBOL_MAX_COUNT) return SYMBOL_NONE;
+
+    if (loader->symbol_log_count == loader->symbol_log_capacity) {
+        size_t new_capacity = loader->symbol_log_capacity == 0 ? 256 : loader->symbol_log_capacity * 2;
+        StringView* new_log = (StringView*)realloc(loader->symbol_log, new_capacity * sizeof(StringView));
+        if (!new_log) {
+            loader->out_of_memory = true;
+            return SYMBOL_NONE;
+        }
+        loader->symbol_log = new_log;
+        loader->symbol_log_capacity = new_capacity;
+    }
+    loader->symbol_log[loader->symbol_log_count++] = value;
+    return (SymbolId)index;
+}
+
+static SymbolId* read_symbol_array(RecipeLoader* loader, int* count) {
+    JsonReader* reader = &loader->reader;
+    *count = 0;
+    if (json_peek(reader) != '[') {
+        json_skip_value(reader);
+        return NULL;
+    }
+
+    json_begin_array(reader);
+    while (json_next_element(reader)) {
+        StringView value = read_string_value(loader);
+        if (!value.data) continue;
+
+        SymbolId id = SYMBOL_NONE;
+        if (loader->log_symbols) {
+            id = log_symbol(loader, value);
+        } else {
+            /* When copying, only the first occurrence of a value needs a copy */
+            if (loader->copy_strings) {
+                id = symbol_table_find(loader->symbols, value);
+                if (id == SYMBOL_NONE) {
+                    value = keep_string(loader, value);
+                    if (!value.data) continue;
                 }
             }
-            
-            if (*value_end == '"') {
-                size_t value_len = value_end - value_start;
-                array[i] = (char*)malloc(value_len + 1);
-                if (array[i]) {
-                    strncpy(array[i], value_start, value_len);
-                    array[i][value_len] = '\0';
-                    i++;
-                }
+            if (id == SYMBOL_NONE) {
+                id = symbol_table_intern(loader->symbols, value);
             }
         }
-        p++;
+        if (id == SYMBOL_NONE) {
+            loader->out_of_symbols = true;
+            continue;
+        }
+        push_symbol(loader, id);
     }
-    
-    *count = i;
+
+    if (loader->symbol_scratch_count == 0) return NULL;
+
+    SymbolId* array = (SymbolId*)arena_copy(loader->arena, loader->symbol_scratch,
+                                            loader->symbol_scratch_count * sizeof(SymbolId));
+    if (!array) {
+        loader->out_of_memory = true;
+    } else {
+        *count = loader->symbol_scratch_count;
+    }
+    loader->symbol_scratch_count = 0;
     return array;
 }
 
-static char** extract_ingredient_names(const char* json, int* count) {
+static void read_string_list(RecipeLoader* loader, StringList* list) {
+    list->items = read_string_array(loader, &list->count);
+}
+
+static int find_key_index(const char* key, size_t key_len, const char* const* names, int count) {
+    for (int i = 0; i < count; i++) {
+        if (json_key_equals(key, key_len, names[i])) return i;
+    }
+    return -1;
+}
+
+static const char* const EXECUTIVE_CHALLENGE_KEYS[EXECUTIVE_CHALLENGE_COUNT] = {
+    "difficulty_planning",
+    "difficulty_initiating",
+    "difficulty_monitoring",
+    "difficulty_shifting",
+    "memory_challenges"
+};
+
+static const char* const SENSORY_DIMENSION_KEYS[SENSORY_DIMENSION_COUNT] = {
+    "texture",
+    "smell",
+    "taste",
+    "temperature",
+    "appearance"
+};
+
+static void push_ingredient(RecipeLoader* loader, const Ingredient* ingredient) {
+    if (loader->ingredient_scratch_count == loader->ingredient_scratch_capacity) {
+        int new_capacity = loader->ingredient_scratch_capacity == 0 ? 16 : loader->ingredient_scratch_capacity * 2;
+        Ingredient* new_scratch = (Ingredient*)realloc(loader->ingredient_scratch, new_capacity * sizeof(Ingredient));
+        if (!new_scratch) {
+            loader->out_of_memory = true;
+            return;
+        }
+        loader->ingredient_scratch = new_scratch;
+        loader->ingredient_scratch_capacity = new_capacity;
+    }
+    loader->ingredient_scratch[loader->ingredient_scratch_count++] = *ingredient;
+}
+
+static Ingredient* read_ingredients(RecipeLoader* loader, int* count) {
+    JsonReader* reader = &loader->reader;
     *count = 0;
-    
-    char* ingredients_start = strstr(json, "\"ingredients\"");
-    if (!ingredients_start) return NULL;
-    
-    char* array_start = strchr(ingredients_start, '[');
-    if (!array_start) return NULL;
-    
-    char* array_end = NULL;
-    int bracket_count = 1;
-    char* p = array_start + 1;
+    if (json_peek(reader) != '[') {
+        json_skip_value(reader);
+        return NULL;
+    }
+
+    json_begin_array(reader);
+    while (json_next_element(reader)) {
+        if (json_peek(reader) != '{') {
+            json_skip_value(reader);
+            continue;
+        }
 
-    while (*p && bracket_count > 0) {
-        if (*p == '[') bracket_count++;
-        else if (*p == ']') bracket_count--;
-        p++;
+        Ingredient ingredient;
+        memset(&ingredient, 0, sizeof(ingredient));
+        const char* key;
+        size_t key_len;
+        json_begin_object(reader);
+        while (json_next_key(reader, &key, &key_len)) {
+            if (!ingredient.name.data && json_key_equals(key, key_len, "name")) {
+                ingredient.name = read_string_value(loader);
+            } else if (json_key_equals(key, key_len, "notes")) {
+                ingredient.notes = read_string_value(loader);
+            } else if (json_key_equals(key, key_len, "options")) {
+                read_string_list(loader, &ingredient.options);
+            } else {
+                json_skip_value(reader);
+            }
+        }
+
+        if (ingredient.name.data) {
+            push_ingredient(loader, &ingredient);
+        }
     }
-    
-    if (bracket_count != 0) return NULL;
-    array_end = p - 1;
 
-    int ingredient_count = 0;
-    p = array_start;
-    while (p < array_end) {
-        if (*p == '{') ingredient_count++;
-        p++;
+    if (loader->ingredient_scratch_count == 0) return NULL;
+
+    Ingredient* array = (Ingredient*)arena_copy(loader->arena, loader->ingredient_scratch,
+                                                loader->ingredient_scratch_count * sizeof(Ingredient));
+    if (!array) {
+        loader->out_of_memory = true;
+    } else {
+        *count = loader->ingredient_scratch_count;
+    }
+    loader->ingredient_scratch_count = 0;
+    return array;
+}
+
+static unsigned int read_executive_support(JsonReader* reader) {
+    unsigned int support = 0;
+    if (json_peek(reader) != '{') {
+        json_skip_value(reader);
+        return support;
     }
-    
-    if (ingredient_count == 0) return NULL;
-
-    char** ingredients = (char**)malloc(ingredient_count * sizeof(char*));
-    if (!ingredients) return NULL;
-
-    p = array_start;
-    int i = 0;
-    while (p < array_end && i < ingredient_count) {
-        if (*p == '{') {
-            char* obj_start = p;
-            int obj_bracket_count = 1;
-            p++;
-            
-            while (p < array_end && obj_bracket_count > 0) {
-                if (*p == '{') obj_bracket_count++;
-                else if (*p == '}') obj_bracket_count--;
-                p++;
+
+    const char* key;
+    size_t key_len;
+    json_begin_object(reader);
+    while (json_next_key(reader, &key, &key_len)) {
+        int challenge = find_key_index(key, key_len, EXECUTIVE_CHALLENGE_KEYS, EXECUTIVE_CHALLENGE_COUNT);
+        if (challenge >= 0 && json_peek(reader) == 't') {
+            support |= 1u << challenge;
+        }
+        json_skip_value(reader);
+    }
+    return support;
+}
+
+static void read_time(RecipeLoader* loader, int* duration, StringView* unit) {
+    JsonReader* reader = &loader->reader;
+    if (json_peek(reader) != '{') {
+        json_skip_value(reader);
+        return;
+    }
+
+    const char* key;
+    size_t key_len;
+    json_begin_object(reader);
+    while (json_next_key(reader, &key, &key_len)) {
+        if (json_key_equals(key, key_len, "duration")) {
+            if (!json_read_int(reader, duration)) return;
+        } else if (json_key_equals(key, key_len, "unit")) {
+            *unit = read_string_value(loader);
+        } else {
+            json_skip_value(reader);
+        }
+    }
+}
+
+static void read_sensory_profile(RecipeLoader* loader, Recipe* recipe) {
+    JsonReader* reader = &loader->reader;
+    if (json_peek(reader) != '{') {
+        json_skip_value(reader);
+        return;
+    }
+
+    const char* key;
+    size_t key_len;
+    json_begin_object(reader);
+    while (json_next_key(reader, &key, &key_len)) {
+        if (json_key_equals(key, key_len, "texture")) {
+            recipe->sensory_texture = read_symbol_array(loader, &recipe->sensory_texture_count);
+        } else if (json_key_equals(key, key_len, "temperature")) {
+            recipe->sensory_temperature = read_symbol_array(loader, &recipe->sensory_temperature_count);
+        } else if (json_key_equals(key, key_len, "taste")) {
+            recipe->sensory_taste = read_symbol_array(loader, &recipe->sensory_taste_count);
+        } else if (json_key_equals(key, key_len, "smell")) {
+            recipe->sensory_smell = read_symbol_array(loader, &recipe->sensory_smell_count);
+        } else {
+            json_skip_value(reader);
+        }
+    }
+}
+
+static void read_recipe(RecipeLoader* loader, Recipe* recipe) {
+    JsonReader* reader = &loader->reader;
+    memset(recipe, 0, sizeof(Recipe));
+
+    const char* key;
+    size_t key_len;
+    json_begin_object(reader);
+    while (json_next_key(reader, &key, &key_len)) {
+        if (json_key_equals(key, key_len, "id")) {
+            recipe->id = read_string_value(loader);
+        } else if (json_key_equals(key, key_len, "name")) {
+            recipe->name = read_string_value(loader);
+        } else if (json_key_equals(key, key_len, "description")) {
+            recipe->description = read_string_value(loader);
+        } else if (json_key_equals(key, key_len, "meal_type")) {
+            recipe->meal_type = read_symbol_array(loader, &recipe->meal_type_count);
+        } else if (json_key_equals(key, key_len, "prep_time")) {
+            read_time(loader, &recipe->prep_time_duration, &recipe->prep_time_unit);
+        } else if (json_key_equals(key, key_len, "cook_time")) {
+            read_time(loader, &recipe->cook_time_duration, &recipe->cook_time_unit);
+        } else if (json_key_equals(key, key_len, "ingredients")) {
+            recipe->ingredients = read_ingredients(loader, &recipe->ingredients_count);
+        } else if (json_key_equals(key, key_len, "preparation_steps")) {
+            recipe->preparation_steps = read_string_array(loader, &recipe->preparation_steps_count);
+        } else if (json_key_equals(key, key_len, "sensory_profile")) {
+            read_sensory_profile(loader, recipe);
+        } else if (json_key_equals(key, key_len, "notes")) {
+            recipe->notes = read_string_value(loader);
+        } else if (json_key_equals(key, key_len, "executive_function_support")) {
+            recipe->executive_function_support = read_executive_support(reader);
+        } else {
+            json_skip_value(reader);
+        }
+    }
+
+    if (!recipe->prep_time_unit.data) recipe->prep_time_unit = UNKNOWN_UNIT;
+    if (!recipe->cook_time_unit.data) recipe->cook_time_unit = UNKNOWN_UNIT;
+}
+
+/* Read the meal object at the reader into the next recipe slot */
+static const char* add_recipe(RecipeLoader* loader, RecipeDB* db, int* capacity) {
+    if (db->recipe_count == *capacity) {
+        int new_capacity = *capacity == 0 ? 16 : *capacity * 2;
+        Recipe* new_recipes = (Recipe*)realloc(db->recipes, new_capacity * sizeof(Recipe));
+        if (!new_recipes) {
+            return "Failed to allocate memory for recipes";
+        }
+        db->recipes = new_recipes;
+        *capacity = new_capacity;
+    }
+
+    read_recipe(loader, &db->recipes[db->recipe_count]);
+    if (loader->out_of_memory) {
+        return "Failed to allocate memory for recipe data";
+    }
+    if (loader->out_of_symbols) {
+        return "Too many distinct meal type and sensory values";
+    }
+    if (!loader->reader.error) {
+        db->recipe_count++;
+    }
+    return NULL;
+}
+
+/* Threads for parsing meals; 0 means one per processor */
+static int recipe_loader_threads = 0;
+
+void set_recipe_loader_threads(int thread_count) {
+    recipe_loader_threads = thread_count > 0 ? thread_count : 0;
+}
+
+/* Bytes init_recipe_db_streaming reads at a time; 0 means the default */
+static size_t recipe_stream_chunk_size = 0;
+
+void set_recipe_stream_chunk_size(size_t chunk_size) {
+    recipe_stream_chunk_size = chunk_size;
+}
+
+/* A meal object's place in the source, and its run of the symbol log */
+typedef struct {
+    size_t start;
+    size_t end;
+    int worker;
+    size_t log_start;
+    size_t log_count;
+} MealSpan;
+
+typedef struct {
+    const char* source;
+    MealSpan* spans;
+    Recipe* recipes;
+    /* One per worker */
+    RecipeLoader* loaders;
+} ParallelMeals;
+
+static void parse_meal(void* context, int worker, size_t task) {
+    ParallelMeals* meals = (ParallelMeals*)context;
+    RecipeLoader* loader = &meals->loaders[worker];
+    MealSpan* span = &meals->spans[task];
+
+    loader->reader.pos = meals->source + span->start;
+    loader->reader.end = meals->source + span->end;
+    loader->recipe_log_start = loader->symbol_log_count;
+    read_recipe(loader, &meals->recipes[task]);
+
+    span->worker = worker;
+    span->log_start = loader->recipe_log_start;
+    span->log_count = loader->symbol_log_count - loader->recipe_log_start;
+}
+
+static void remap_symbols(SymbolId* ids, int count, const SymbolId* interned) {
+    for (int i = 0; i < count; i++) {
+        ids[i] = interned[ids[i]];
+    }
+}
+
+/* Intern the logged symbol values in recipe order, which hands out the
+   same ids as parsing the meals one after another */
+static const char* merge_meal_symbols(RecipeDB* db, const ParallelMeals* meals) {
+    SymbolId* interned = NULL;
+    size_t capacity = 0;
+    const char* error = NULL;
+
+    for (int i = 0; i < db->recipe_count && !error; i++) {
+        const MealSpan* span = &meals->spans[i];
+        if (span->log_count > capacity) {
+            SymbolId* new_interned = (SymbolId*)realloc(interned, span->log_count * sizeof(SymbolId));
+            if (!new_interned) {
+                error = "Failed to allocate memory for recipe data";
+                break;
             }
-            
-            char* obj_end = p;
-
-            char obj_str[MAX_LINE_LENGTH];
-            size_t obj_len = obj_end - obj_start;
-            if (obj_len < MAX_LINE_LENGTH - 1) {
-                strncpy(obj_str, obj_start, obj_len);
-                obj_str[obj_len] = '\0';
-                
-                char* name = extract_string_value(obj_str, "name");
-                if (name) {
-                    ingredients[i++] = name;
-                }
+            interned = new_interned;
+            capacity = span->log_count;
+        }
+
+        const StringView* values = meals->loaders[span->worker].symbol_log + span->log_start;
+        for (size_t k = 0; k < span->log_count; k++) {
+            interned[k] = symbol_table_intern(&db->symbols, values[k]);
+            if (interned[k] == SYMBOL_NONE) {
+                error = "Too many distinct meal type and sensory values";
+                break;
             }
+        }
+        if (error) break;
+
+        Recipe* recipe = &db->recipes[i];
+        remap_symbols(recipe->meal_type, recipe->meal_type_count, interned);
+        remap_symbols(recipe->sensory_texture, recipe->sensory_texture_count, interned);
+        remap_symbols(recipe->sensory_temperature, recipe->sensory_temperature_count, interned);
+        remap_symbols(recipe->sensory_taste, recipe->sensory_taste_count, interned);
+        remap_symbols(recipe->sensory_smell, recipe->sensory_smell_count, interned);
+    }
+
+    free(interned);
+    return error;
+}
+
+/* Parse the meals array on a thread pool: a structural pass finds each
+   meal object, then workers parse them into pre-sized slots with their own
+   arenas. Returns false, with the reader back at the first element, when
+   the meals should be read one at a time instead; malformed input always
+   goes that way, so errors are reported exactly as the sequential loop
+   reports them. */
+static bool read_meals_parallel(RecipeLoader* loader, RecipeDB* db, const char** error) {
+    JsonReader* reader = &loader->reader;
+    int thread_count = recipe_loader_threads > 0 ? recipe_loader_threads : thread_pool_default_size();
+    if (thread_count < 2 || loader->copy_strings ||
+        (size_t)(reader->end - reader->start) < PARALLEL_LOAD_MIN_BYTES) {
+        return false;
+    }
+
+    const char* first_element = reader->pos;
+    MealSpan* spans = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    bool found = true;
+
+    while (json_next_element(reader)) {
+        if (json_peek(reader) != '{') {
+            json_skip_value(reader);
+            continue;
+        }
+        if (count == capacity) {
+            size_t new_capacity = capacity == 0 ? 1024 : capacity * 2;
+            MealSpan* new_spans = (MealSpan*)realloc(spans, new_capacity * sizeof(MealSpan));
+            if (!new_spans) {
+                found = false;
+                break;
+            }
+            spans = new_spans;
+            capacity = new_capacity;
+        }
+        spans[count].start = (size_t)(reader->pos - reader->start);
+        if (!json_skip_value(reader)) break;
+        spans[count++].end = (size_t)(reader->pos - reader->start);
+    }
+
+    Recipe* recipes = NULL;
+    RecipeLoader* loaders = NULL;
+    Arena* arenas = NULL;
+    bool parsed = found && !reader->error && count > 0 && count <= INT_MAX;
+    if (parsed) {
+        recipes = (Recipe*)malloc(count * sizeof(Recipe));
+        loaders = (RecipeLoader*)calloc((size_t)thread_count, sizeof(RecipeLoader));
+        arenas = (Arena*)malloc((size_t)thread_count * sizeof(Arena));
+        parsed = recipes && loaders && arenas;
+    }
+
+    ThreadPool pool;
+    if (parsed && thread_pool_init(&pool, thread_count)) {
+        for (int w = 0; w < thread_count; w++) {
+            arena_init(&arenas[w], RECIPE_ARENA_CHUNK_SIZE);
+            loaders[w].arena = &arenas[w];
+            loaders[w].log_symbols = true;
+            json_reader_init(&loaders[w].reader, reader->start, (size_t)(reader->end - reader->start));
+        }
+
+        ParallelMeals meals = { reader->start, spans, recipes, loaders };
+        thread_pool_run(&pool, count, parse_meal, &meals);
+        thread_pool_free(&pool);
+
+        for (int w = 0; w < thread_count; w++) {
+            if (loaders[w].reader.error || loaders[w].out_of_memory || loaders[w].out_of_symbols) {
+                parsed = false;
+            }
+        }
+        if (parsed) {
+            db->recipes = recipes;
+            db->recipe_count = (int)count;
+            *error = merge_meal_symbols(db, &meals);
+        }
+
+        for (int w = 0; w < thread_count; w++) {
+            if (parsed) {
+                arena_adopt(loader->arena, &arenas[w]);
+            } else {
+                arena_free(&arenas[w]);
+            }
+            free(loaders[w].scratch);
+            free(loaders[w].symbol_scratch);
+            free(loaders[w].ingredient_scratch);
+            free(loaders[w].symbol_log);
+        }
+    } else {
+        parsed = false;
+    }
+
+    free(spans);
+    free(loaders);
+    free(arenas);
+    if (!parsed) {
+        free(recipes);
+        reader->pos = first_element;
+        reader->error = false;
+    }
+    return parsed;
+}
+
+static const char* read_meals(RecipeLoader* loader, RecipeDB* db) {
+    JsonReader* reader = &loader->reader;
+    if (!json_begin_array(reader)) {
+        return "Invalid meals array format in JSON";
+    }
+
+    const char* error = NULL;
+    if (read_meals_parallel(loader, db, &error)) {
+        return error;
+    }
+
+    int capacity = 0;
+    while (json_next_element(reader)) {
+        if (json_peek(reader) != '{') {
+            json_skip_value(reader);
+            continue;
+        }
+
+        const char* error = add_recipe(loader, db, &capacity);
+        if (error) return error;
+        if (reader->error) break;
+    }
+
+    return NULL;
+}
+
+/* Like read_meals, but buffers one meal at a time from a stream */
+static const char* stream_meals(RecipeLoader* loader, JsonStream* stream, RecipeDB* db) {
+    if (!json_stream_begin_array(stream)) {
+        return "Invalid meals array format in JSON";
+    }
+
+    int capacity = 0;
+    while (json_stream_next_element(stream)) {
+        if (json_stream_peek(stream) != '{') {
+            json_stream_skip_value(stream);
+            continue;
+        }
+        if (!json_stream_read_value(stream, &loader->reader)) break;
+
+        const char* error = add_recipe(loader, db, &capacity);
+        if (error) return error;
+        if (loader->reader.error) break;
+    }
+
+    return NULL;
+}
+
+/* Read an object of dimension -> string array, e.g. avoidance_triggers */
+static void read_dimension_lists(RecipeLoader* loader, StringList* lists) {
+    JsonReader* reader = &loader->reader;
+    if (json_peek(reader) != '{') {
+        json_skip_value(reader);
+        return;
+    }
+
+    const char* key;
+    size_t key_len;
+    json_begin_object(reader);
+    while (json_next_key(reader, &key, &key_len)) {
+        int dimension = find_key_index(key, key_len, SENSORY_DIMENSION_KEYS, SENSORY_DIMENSION_COUNT);
+        if (dimension >= 0) {
+            read_string_list(loader, &lists[dimension]);
         } else {
-            p++;
+            json_skip_value(reader);
         }
     }
-    
-    *count = i;
-    return ingredients;
+}
+
+static void read_texture_mappings(RecipeLoader* loader, SensoryConsiderations* sensory) {
+    JsonReader* reader = &loader->reader;
+    if (json_peek(reader) != '{') {
+        json_skip_value(reader);
+        return;
+    }
+
+    TextureMapping* mappings = NULL;
+    int count = 0;
+    int capacity = 0;
+
+    const char* key;
+    size_t key_len;
+    json_begin_object(reader);
+    while (json_next_key(reader, &key, &key_len)) {
+        if (count == capacity) {
+            int new_capacity = capacity == 0 ? 8 : capacity * 2;
+            TextureMapping* new_mappings = (TextureMapping*)realloc(mappings, new_capacity * sizeof(TextureMapping));
+            if (!new_mappings) {
+                loader->out_of_memory = true;
+                json_skip_value(reader);
+                continue;
+            }
+            mappings = new_mappings;
+            capacity = new_capacity;
+        }
+
+        TextureMapping* mapping = &mappings[count++];
+        mapping->trigger.data = key;
+        mapping->trigger.length = key_len;
+        mapping->trigger = keep_string(loader, mapping->trigger);
+        read_string_list(loader, &mapping->alternatives);
+    }
+
+    if (count > 0) {
+        sensory->texture_mappings = (TextureMapping*)arena_copy(loader->arena, mappings,
+                                                                count * sizeof(TextureMapping));
+        if (sensory->texture_mappings) {
+            sensory->texture_mapping_count = count;
+        } else {
+            loader->out_of_memory = true;
+        }
+    }
+    free(mappings);
+}
+
+static void read_sensory_considerations(RecipeLoader* loader, SensoryConsiderations* sensory) {
+    JsonReader* reader = &loader->reader;
+    if (json_peek(reader) != '{') {
+        json_skip_value(reader);
+        return;
+    }
+
+    const char* key;
+    size_t key_len;
+    json_begin_object(reader);
+    while (json_next_key(reader, &key, &key_len)) {
+        if (json_key_equals(key, key_len, "avoidance_triggers")) {
+            read_dimension_lists(loader, sensory->avoidance_triggers);
+        } else if (json_key_equals(key, key_len, "preferred_sensory_profiles")) {
+            read_dimension_lists(loader, sensory->preferred_profiles);
+        } else if (json_key_equals(key, key_len, "texture_mapping")) {
+            read_texture_mappings(loader, sensory);
+        } else {
+            json_skip_value(reader);
+        }
+    }
+}
+
+static void read_executive_strategies(RecipeLoader* loader, StringList* strategies) {
+    JsonReader* reader = &loader->reader;
+    if (json_peek(reader) != '{') {
+        json_skip_value(reader);
+        return;
+    }
+
+    const char* key;
+    size_t key_len;
+    json_begin_object(reader);
+    while (json_next_key(reader, &key, &key_len)) {
+        int challenge = find_key_index(key, key_len, EXECUTIVE_CHALLENGE_KEYS, EXECUTIVE_CHALLENGE_COUNT);
+        if (challenge >= 0) {
+            read_string_list(loader, &strategies[challenge]);
+        } else {
+            json_skip_value(reader);
+        }
+    }
+}
+
+static void read_customization_options(RecipeLoader* loader, CustomizationOptions* options) {
+    JsonReader* reader = &loader->reader;
+    if (json_peek(reader) != '{') {
+        json_skip_value(reader);
+        return;
+    }
+
+    const char* key;
+    size_t key_len;
+    json_begin_object(reader);
+    while (json_next_key(reader, &key, &key_len)) {
+        if (json_key_equals(key, key_len, "dietary_restrictions")) {
+            read_string_list(loader, &options->dietary_restrictions);
+        } else if (json_key_equals(key, key_len, "allergy_information")) {
+            options->allergy_information = read_string_value(loader);
+        } else if (json_key_equals(key, key_len, "preferred_cuisines")) {
+            read_string_list(loader, &options->preferred_cuisines);
+        } else if (json_key_equals(key, key_len, "time_constraints")) {
+            read_string_list(loader, &options->time_constraints);
+        } else if (json_key_equals(key, key_len, "available_equipment")) {
+            read_string_list(loader, &options->available_equipment);
+        } else {
+            json_skip_value(reader);
+        }
+    }
+}
+
+/* Drop a leading article so "the berry blast smoothie" keys like "Berry Blast Smoothie" */
+static StringView normalize_recipe_name(StringView name) {
+    static const char* articles[] = { "a ", "an ", "the " };
+
+    for (size_t i = 0; i < sizeof(articles) / sizeof(articles[0]); i++) {
+        StringView article = sv_from_cstr(articles[i]);
+        if (name.length > article.length) {
+            StringView prefix = { name.data, article.length };
+            if (sv_equals_ignore_case(prefix, article)) {
+                name.data += article.length;
+                name.length -= article.length;
+                break;
+            }
+        }
+    }
+    return name;
+}
+
+static bool build_lookup_indices(RecipeDB* db) {
+    if (!hash_index_init(&db->name_index, db->recipe_count) ||
+        !hash_index_init(&db->id_index, db->recipe_count)) {
+        return false;
+    }
+
+    StringView* names = (StringView*)malloc(db->recipe_count * sizeof(StringView));
+    if (!names) return false;
+
+    for (int i = 0; i < db->recipe_count; i++) {
+        const Recipe* recipe = &db->recipes[i];
+        if (recipe->name.data) {
+            StringView key = normalize_recipe_name(recipe->name);
+            hash_index_insert(&db->name_index, sv_hash_ignore_case(key), i);
+        }
+        if (recipe->id.data) {
+            hash_index_insert(&db->id_index, sv_hash(recipe->id), i);
+        }
+        names[i] = normalize_recipe_name(recipe->name);
+    }
+
+    bool built = fuzzy_index_build(&db->fuzzy_index, names, db->recipe_count);
+    free(names);
+    return built;
+}
+
+static bool build_attribute_index(RecipeDB* db) {
+    int symbol_count = db->symbols.count;
+    if (symbol_count == 0) return true;
+
+    for (int kind = 0; kind < ATTRIBUTE_KIND_COUNT; kind++) {
+        db->attribute_index[kind] = (Bitmap*)malloc(symbol_count * sizeof(Bitmap));
+        if (!db->attribute_index[kind]) return false;
+        for (int id = 0; id < symbol_count; id++) {
+            bitmap_init(&db->attribute_index[kind][id]);
+        }
+    }
+
+    for (int i = 0; i < db->recipe_count; i++) {
+        for (int kind = 0; kind < ATTRIBUTE_KIND_COUNT; kind++) {
+            int count;
+            const SymbolId* ids = get_recipe_attributes(&db->recipes[i], (AttributeKind)kind, &count);
+            for (int j = 0; j < count; j++) {
+                if (!bitmap_append(&db->attribute_index[kind][ids[j]], (uint32_t)i)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+int32_t recipe_time_in_minutes(int duration, StringView unit) {
+    static const struct {
+        const char* name;
+        int minutes;
+    } units[] = {
+        { "minutes", 1 }, { "minute", 1 }, { "mins", 1 }, { "min", 1 },
+        { "hours", 60 }, { "hour", 60 }, { "hrs", 60 }, { "hr", 60 },
+        { "days", 24 * 60 }, { "day", 24 * 60 },
+        { "seconds", 0 }, { "second", 0 }, { "secs", 0 }, { "sec", 0 }
+    };
+
+    if (duration < 0) return RECIPE_MINUTES_UNKNOWN;
+    for (size_t i = 0; i < sizeof(units) / sizeof(units[0]); i++) {
+        if (!sv_equals_ignore_case(unit, sv_from_cstr(units[i].name))) continue;
+        if (units[i].minutes == 0) return (int32_t)(duration / 60 + (duration % 60 != 0));
+        if (duration > INT32_MAX / units[i].minutes) return RECIPE_MINUTES_UNKNOWN;
+        return (int32_t)duration * units[i].minutes;
+    }
+    return RECIPE_MINUTES_UNKNOWN;
+}
+
+const int32_t* get_recipe_time_column(const RecipeDB* db, RecipeTimeField field) {
+    switch (field) {
+        case RECIPE_TIME_PREP: return db->columns.prep_minutes;
+        case RECIPE_TIME_COOK: return db->columns.cook_minutes;
+        default: return db->columns.total_minutes;
+    }
+}
+
+static int compare_time_keys(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/* Sort the recipes with a known time by (minutes, index), packed into one key */
+static bool build_time_index(RecipeDB* db, RecipeTimeField field) {
+    const int32_t* column = get_recipe_time_column(db, field);
+    TimeIndex* index = &db->time_index[field];
+
+    uint64_t* keys = (uint64_t*)malloc((size_t)db->recipe_count * sizeof(uint64_t));
+    if (!keys) return false;
+    int count = 0;
+    for (int i = 0; i < db->recipe_count; i++) {
+        if (column[i] == RECIPE_MINUTES_UNKNOWN) continue;
+        keys[count++] = (uint64_t)(uint32_t)column[i] << 32 | (uint32_t)i;
+    }
+    qsort(keys, (size_t)count, sizeof(uint64_t), compare_time_keys);
+
+    index->minutes = (int32_t*)malloc((size_t)count * sizeof(int32_t) + 1);
+    index->recipes = (int32_t*)malloc((size_t)count * sizeof(int32_t) + 1);
+    if (!index->minutes || !index->recipes) {
+        free(keys);
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        index->minutes[i] = (int32_t)(keys[i] >> 32);
+        index->recipes[i] = (int32_t)(keys[i] & 0xFFFFFFFFu);
+    }
+    index->count = count;
+    free(keys);
+    return true;
+}
+
+static bool build_recipe_columns(RecipeDB* db) {
+    RecipeColumns* columns = &db->columns;
+    size_t count = (size_t)db->recipe_count;
+    columns->prep_minutes = (int32_t*)malloc(count * sizeof(int32_t));
+    columns->cook_minutes = (int32_t*)malloc(count * sizeof(int32_t));
+    columns->total_minutes = (int32_t*)malloc(count * sizeof(int32_t));
+    columns->executive_function_support = (uint32_t*)malloc(count * sizeof(uint32_t));
+    if (!columns->prep_minutes || !columns->cook_minutes || !columns->total_minutes ||
+        !columns->executive_function_support) {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const Recipe* recipe = &db->recipes[i];
+        int32_t prep = recipe_time_in_minutes(recipe->prep_time_duration, recipe->prep_time_unit);
+        int32_t cook = recipe_time_in_minutes(recipe->cook_time_duration, recipe->cook_time_unit);
+        bool known = prep != RECIPE_MINUTES_UNKNOWN && cook != RECIPE_MINUTES_UNKNOWN &&
+                     prep <= INT32_MAX - cook;
+        columns->prep_minutes[i] = prep;
+        columns->cook_minutes[i] = cook;
+        columns->total_minutes[i] = known ? prep + cook : RECIPE_MINUTES_UNKNOWN;
+        columns->executive_function_support[i] = recipe->executive_function_support;
+    }
+
+    for (int field = 0; field < RECIPE_TIME_FIELD_COUNT; field++) {
+        if (!build_time_index(db, (RecipeTimeField)field)) return false;
+    }
+    return true;
+}
+
+static void free_recipe_columns(RecipeColumns* columns) {
+    free(columns->prep_minutes);
+    free(columns->cook_minutes);
+    free(columns->total_minutes);
+    free(columns->executive_function_support);
+    memset(columns, 0, sizeof(*columns));
+}
+
+static void free_time_indexes(RecipeDB* db) {
+    for (int field = 0; field < RECIPE_TIME_FIELD_COUNT; field++) {
+        free(db->time_index[field].minutes);
+        free(db->time_index[field].recipes);
+        memset(&db->time_index[field], 0, sizeof(TimeIndex));
+    }
+}
+
+static void free_attribute_index(RecipeDB* db) {
+    for (int kind = 0; kind < ATTRIBUTE_KIND_COUNT; kind++) {
+        if (!db->attribute_index[kind]) continue;
+        for (int id = 0; id < db->symbols.count; id++) {
+            bitmap_free(&db->attribute_index[kind][id]);
+        }
+        free(db->attribute_index[kind]);
+        db->attribute_index[kind] = NULL;
+    }
+}
+
+typedef enum {
+    SECTION_SENSORY_CONSIDERATIONS,
+    SECTION_EXECUTIVE_STRATEGIES,
+    SECTION_CUSTOMIZATION_OPTIONS,
+    SECTION_COUNT
+} GuidanceSection;
+
+static const char* const SECTION_KEYS[SECTION_COUNT] = {
+    "sensory_considerations",
+    "executive_function_support_strategies",
+    "customization_options"
+};
+
+/* Read the guidance section at the reader */
+static void read_section(RecipeLoader* loader, RecipeDB* db, GuidanceSection section) {
+    switch (section) {
+        case SECTION_SENSORY_CONSIDERATIONS:
+            read_sensory_considerations(loader, &db->sensory_considerations);
+            break;
+        case SECTION_EXECUTIVE_STRATEGIES:
+            read_executive_strategies(loader, db->executive_strategies);
+            break;
+        case SECTION_CUSTOMIZATION_OPTIONS:
+            read_customization_options(loader, &db->customization);
+            break;
+        default:
+            break;
+    }
+}
+
+uint32_t next_recipe_db_version(void) {
+    /* The reload watcher loads databases while other threads may too */
+    static uint32_t next_version = 1;
+    return __atomic_fetch_add(&next_version, 1, __ATOMIC_RELAXED);
+}
+
+static RecipeDB* create_recipe_db(void) {
+    RecipeDB* db = (RecipeDB*)calloc(1, sizeof(RecipeDB));
+    if (!db) return NULL;
+
+    db->version = next_recipe_db_version();
+    db->verbose = true;
+
+    arena_init(&db->arena, RECIPE_ARENA_CHUNK_SIZE);
+    symbol_table_init(&db->symbols);
+    return db;
+}
+
+/* Check what was read and build the indices; error is the parser's own */
+static void finish_recipe_db(RecipeDB* db, RecipeLoader* loader, const char* error, bool found_meals) {
+    free(loader->scratch);
+    free(loader->symbol_scratch);
+    free(loader->ingredient_scratch);
+
+    if (!error && !found_meals) {
+        error = "Failed to find meals array in JSON";
+    } else if (!error && db->recipe_count == 0) {
+        error = "No recipes found in JSON";
+    } else if (!error && !build_recipe_columns(db)) {
+        error = "Failed to allocate memory for recipe columns";
+    } else if (!error && !build_attribute_index(db)) {
+        error = "Failed to allocate memory for attribute index";
+    } else if (!error && !build_lookup_indices(db)) {
+        error = "Failed to allocate memory for lookup indices";
+    }
+
+    if (error) {
+        db->error_message = str_duplicate(error);
+    }
 }
 
 RecipeDB* init_recipe_db(const char* json_path) {
-    RecipeDB* db = (RecipeDB*)malloc(sizeof(RecipeDB));
+    RecipeDB* db = create_recipe_db();
     if (!db) return NULL;
-    
-    db->recipes = NULL;
-    db->recipe_count = 0;
-    db->error_message = NULL;
 
-    FILE* file = fopen(json_path, "r");
-    if (!file) {
+    if (!mapped_file_open(&db->source, json_path)) {
         char error_msg[256];
         snprintf(error_msg, sizeof(error_msg), "Failed to open JSON file: %s", json_path);
         db->error_message = str_duplicate(error_msg);
         return db;
     }
-
-    char line[MAX_LINE_LENGTH];
-    char* json_buffer = NULL;
-    size_t buffer_size = 0;
-    size_t buffer_capacity = 0;
     
-    while (fgets(line, sizeof(line), file)) {
-        size_t line_len = strlen(line);
-
-        if (buffer_size + line_len + 1 > buffer_capacity) {
-            buffer_capacity = buffer_capacity == 0 ? 16384 : buffer_capacity * 2;
-            char* new_buffer = (char*)realloc(json_buffer, buffer_capacity);
-            if (!new_buffer) {
-                free(json_buffer);
-                fclose(file);
-                db->error_message = str_duplicate("Failed to allocate memory for JSON buffer");
-                return db;
-            }
-            json_buffer = new_buffer;
-        }
-
-        strcpy(json_buffer + buffer_size, line);
-        buffer_size += line_len;
-    }
-    
-    fclose(file);
-    
-    if (!json_buffer) {
+    if (db->source.length == 0) {
         db->error_message = str_duplicate("Empty JSON file");
         return db;
     }
 
-    json_buffer[buffer_size] = '\0';
+    RecipeLoader loader = { .arena = &db->arena, .symbols = &db->symbols };
+    JsonReader* reader = &loader.reader;
+    json_reader_init(reader, db->source.data, db->source.length);
 
-    char* meals_start = strstr(json_buffer, "\"meals\"");
-    if (!meals_start) {
-        free(json_buffer);
-        db->error_message = str_duplicate("Failed to find meals array in JSON");
-        return db;
+    const char* error = NULL;
+    bool found_meals = false;
+    const char* key;
+    size_t key_len;
+
+    if (!json_begin_object(reader)) {
+        error = "Invalid JSON: expected a top-level object";
     }
-    
-    char* array_start = strchr(meals_start, '[');
-    if (!array_start) {
-        free(json_buffer);
-        db->error_message = str_duplicate("Invalid meals array format in JSON");
-        return db;
+
+    while (!error && json_next_key(reader, &key, &key_len)) {
+        int section = find_key_index(key, key_len, SECTION_KEYS, SECTION_COUNT);
+        if (!found_meals && json_key_equals(key, key_len, "meals")) {
+            found_meals = true;
+            error = read_meals(&loader, db);
+        } else if (section >= 0) {
+            read_section(&loader, db, (GuidanceSection)section);
+        } else {
+            json_skip_value(reader);
+        }
+
+        if (!error && loader.out_of_memory) {
+            error = "Failed to allocate memory for recipe data";
+        }
     }
 
-    int recipe_count = 0;
-    char* p = array_start;
-    while (*p) {
-        if (*p == '{') recipe_count++;
-        else if (*p == ']') break;
-        p++;
+    char error_msg[256];
+    if (!error && reader->error) {
+        snprintf(error_msg, sizeof(error_msg), "Malformed JSON near byte %zu",
+                 json_reader_offset(reader));
+        error = error_msg;
     }
-    
-    if (recipe_count == 0) {
-        free(json_buffer);
-        db->error_message = str_duplicate("No recipes found in JSON");
+
+    finish_recipe_db(db, &loader, error, found_meals);
+    return db;
+}
+
+RecipeDB* init_recipe_db_streaming(const char* json_path) {
+    RecipeDB* db = create_recipe_db();
+    if (!db) return NULL;
+
+    JsonStream stream;
+    if (!json_stream_open(&stream, json_path, recipe_stream_chunk_size)) {
+        char error_msg[256];
+        snprintf(error_msg, sizeof(error_msg), "Failed to open JSON file: %s", json_path);
+        db->error_message = str_duplicate(error_msg);
         return db;
     }
 
-    db->recipes = (Recipe*)malloc(recipe_count * sizeof(Recipe));
-    if (!db->recipes) {
-        free(json_buffer);
-        db->error_message = str_duplicate("Failed to allocate memory for recipes");
+    if (json_stream_peek(&stream) == '\0' && !stream.error) {
+        json_stream_close(&stream);
+        db->error_message = str_duplicate("Empty JSON file");
         return db;
     }
 
-    p = array_start;
-    int i = 0;
-    while (*p && i < recipe_count) {
-        if (*p == '{') {
-            char* obj_start = p;
-            int obj_bracket_count = 1;
-            p++;
-            
-            while (*p && obj_bracket_count > 0) {
-                if (*p == '{') obj_bracket_count++;
-                else if (*p == '}') obj_bracket_count--;
-                p++;
-            }
-            
-            char* obj_end = p;
-
-            char recipe_str[MAX_LINE_LENGTH * 10];
-            size_t obj_len = obj_end - obj_start;
-            if (obj_len < sizeof(recipe_str) - 1) {
-                strncpy(recipe_str, obj_start, obj_len);
-                recipe_str[obj_len] = '\0';
-                
-                Recipe* recipe = &db->recipes[i];
-
-                recipe->id = extract_string_value(recipe_str, "id");
-                recipe->name = extract_string_value(recipe_str, "name");
-                recipe->description = extract_string_value(recipe_str, "description");
-
-                recipe->meal_type = extract_string_array(recipe_str, "meal_type", &recipe->meal_type_count);
-
-                char* prep_time_str = strstr(recipe_str, "\"prep_time\"");
-                if (prep_time_str) {
-                    recipe->prep_time_duration = extract_int_value(prep_time_str, "duration");
-                    recipe->prep_time_unit = extract_string_value(prep_time_str, "unit");
-                } else {
-                    recipe->prep_time_duration = 0;
-                    recipe->prep_time_unit = str_duplicate("unknown");
-                }
-                
-                char* cook_time_str = strstr(recipe_str, "\"cook_time\"");
-                if (cook_time_str) {
-                    recipe->cook_time_duration = extract_int_value(cook_time_str, "duration");
-                    recipe->cook_time_unit = extract_string_value(cook_time_str, "unit");
-                } else {
-                    recipe->cook_time_duration = 0;
-                    recipe->cook_time_unit = str_duplicate("unknown");
-                }
+    RecipeLoader loader = { .arena = &db->arena, .symbols = &db->symbols, .copy_strings = true };
+    JsonReader* reader = &loader.reader;
+    json_reader_init(reader, NULL, 0);
 
-                recipe->ingredients = extract_ingredient_names(recipe_str, &recipe->ingredients_count);
-
-                recipe->preparation_steps = extract_string_array(recipe_str, "preparation_steps", &recipe->preparation_steps_count);
-
-                char* sensory_str = strstr(recipe_str, "\"sensory_profile\"");
-                if (sensory_str) {
-                    recipe->sensory_texture = extract_string_array(sensory_str, "texture", &recipe->sensory_texture_count);
-                    recipe->sensory_temperature = extract_string_array(sensory_str, "temperature", &recipe->sensory_temperature_count);
-                    recipe->sensory_taste = extract_string_array(sensory_str, "taste", &recipe->sensory_taste_count);
-                    recipe->sensory_smell = extract_string_array(sensory_str, "smell", &recipe->sensory_smell_count);
-                } else {
-                    recipe->sensory_texture = NULL;
-                    recipe->sensory_texture_count = 0;
-                    recipe->sensory_temperature = NULL;
-                    recipe->sensory_temperature_count = 0;
-                    recipe->sensory_taste = NULL;
-                    recipe->sensory_taste_count = 0;
-                    recipe->sensory_smell = NULL;
-                    recipe->sensory_smell_count = 0;
-                }
-                
-                i++;
+    const char* error = NULL;
+    bool found_meals = false;
+    const char* key;
+    size_t key_len;
+
+    if (!json_stream_begin_object(&stream)) {
+        error = "Invalid JSON: expected a top-level object";
+    }
+
+    while (!error && !reader->error && json_stream_next_key(&stream, &key, &key_len)) {
+        int section = find_key_index(key, key_len, SECTION_KEYS, SECTION_COUNT);
+        if (!found_meals && json_key_equals(key, key_len, "meals")) {
+            found_meals = true;
+            error = stream_meals(&loader, &stream, db);
+        } else if (section >= 0) {
+            if (json_stream_read_value(&stream, reader)) {
+                read_section(&loader, db, (GuidanceSection)section);
             }
         } else {
-            p++;
+            json_stream_skip_value(&stream);
+        }
+
+        if (!error && loader.out_of_memory) {
+            error = "Failed to allocate memory for recipe data";
         }
     }
-    
-    db->recipe_count = i;
-    free(json_buffer);
-    
+
+    char error_msg[256];
+    if (!error && (stream.error || reader->error)) {
+        /* A reader error lies within the value last taken from the stream */
+        size_t offset = json_stream_offset(&stream);
+        if (reader->error) {
+            offset -= (size_t)(reader->end - reader->start) - json_reader_offset(reader);
+        }
+        snprintf(error_msg, sizeof(error_msg), "Malformed JSON near byte %zu", offset);
+        error = error_msg;
+    }
+    json_stream_close(&stream);
+
+    finish_recipe_db(db, &loader, error, found_meals);
     return db;
 }
 
 void free_recipe_db(RecipeDB* db) {
     if (!db) return;
     
-    if (db->recipes) {
-        for (int i = 0; i < db->recipe_count; i++) {
-            Recipe* recipe = &db->recipes[i];
-            
-            free(recipe->id);
-            free(recipe->name);
-            free(recipe->description);
-
-            if (recipe->meal_type) {
-                for (int j = 0; j < recipe->meal_type_count; j++) {
-                    free(recipe->meal_type[j]);
-                }
-                free(recipe->meal_type);
-            }
-
-            if (recipe->ingredients) {
-                for (int j = 0; j < recipe->ingredients_count; j++) {
-                    free(recipe->ingredients[j]);
-                }
-                free(recipe->ingredients);
-            }
-
-            if (recipe->preparation_steps) {
-                for (int j = 0; j < recipe->preparation_steps_count; j++) {
-                    free(recipe->preparation_steps[j]);
-                }
-                free(recipe->preparation_steps);
-            }
-
-            if (recipe->sensory_texture) {
-                for (int j = 0; j < recipe->sensory_texture_count; j++) {
-                    free(recipe->sensory_texture[j]);
-                }
-                free(recipe->sensory_texture);
-            }
-            
-            if (recipe->sensory_temperature) {
-                for (int j = 0; j < recipe->sensory_temperature_count; j++) {
-                    free(recipe->sensory_temperature[j]);
-                }
-                free(recipe->sensory_temperature);
-            }
-            
-            if (recipe->sensory_taste) {
-                for (int j = 0; j < recipe->sensory_taste_count; j++) {
-                    free(recipe->sensory_taste[j]);
-                }
-                free(recipe->sensory_taste);
-            }
-            
-            if (recipe->sensory_smell) {
-                for (int j = 0; j < recipe->sensory_smell_count; j++) {
-                    free(recipe->sensory_smell[j]);
-                }
-                free(recipe->sensory_smell);
-            }
-            
-            free(recipe->prep_time_unit);
-            free(recipe->cook_time_unit);
-        }
-        
+    /* A snapshot's records and indices go away with its mapping */
+    if (!db->from_snapshot) {
+        free_recipe_columns(&db->columns);
+        free_time_indexes(db);
+        free_attribute_index(db);
+        hash_index_free(&db->name_index);
+        hash_index_free(&db->id_index);
+        fuzzy_index_free(&db->fuzzy_index);
         free(db->recipes);
+        symbol_table_free(&db->symbols);
     }
-    
+    free(db->response_blob);
+    free(db->response_offsets);
+    arena_free(&db->arena);
+    mapped_file_close(&db->source);
     free(db->error_message);
     free(db);
 }
 
-static Recipe* find_recipe_by_name(RecipeDB* db, const char* name) {
-    if (!db || !name) return NULL;
-    
-    char* name_lower = str_to_lower(name);
-    if (!name_lower) return NULL;
-    
-    Recipe* found_recipe = NULL;
-    int best_match_score = 0;
+static int fuzzy_search_view(const RecipeDB* db, StringView query, FuzzyMatch* matches, int max_matches);
 
-    char* cleaned_name = name_lower;
-    if (strncmp(cleaned_name, "a ", 2) == 0) cleaned_name += 2;
-    else if (strncmp(cleaned_name, "an ", 3) == 0) cleaned_name += 3;
-    else if (strncmp(cleaned_name, "the ", 4) == 0) cleaned_name += 4;
+static Recipe* find_recipe_by_name_view(const RecipeDB* db, StringView name) {
+    if (!db || !name.data) return NULL;
 
-    printf("Searching for recipe: '%s' (cleaned: '%s')\n", name, cleaned_name);
-    printf("Database has %d recipes\n", db->recipe_count);
-    
-    for (int i = 0; i < db->recipe_count; i++) {
-        char* recipe_name_lower = str_to_lower(db->recipes[i].name);
-        if (!recipe_name_lower) continue;
+    StringView cleaned_name = normalize_recipe_name(name);
 
-        printf("Comparing with: '%s'\n", db->recipes[i].name);
+    if (db->verbose) {
+        printf("Searching for recipe: '%.*s' (cleaned: '%.*s')\n", SV_ARG(name), SV_ARG(cleaned_name));
+    }
 
-        if (strcmp(recipe_name_lower, cleaned_name) == 0) {
-            found_recipe = &db->recipes[i];
-            free(recipe_name_lower);
-            break;
+    uint32_t cursor = 0;
+    uint32_t hash = sv_hash_ignore_case(cleaned_name);
+    int32_t candidate;
+    while ((candidate = hash_index_probe(&db->name_index, hash, &cursor)) != HASH_INDEX_EMPTY) {
+        Recipe* recipe = &db->recipes[candidate];
+        if (sv_equals_ignore_case(normalize_recipe_name(recipe->name), cleaned_name)) {
+            return recipe;
         }
+    }
 
-        if (strstr(recipe_name_lower, cleaned_name) || strstr(cleaned_name, recipe_name_lower)) {
-            int score = 100 - abs((int)strlen(recipe_name_lower) - (int)strlen(cleaned_name));
+    /* No exact match: try the closest name within a few typos */
+    FuzzyMatch match;
+    if (fuzzy_search_view(db, name, &match, 1) == 1) {
+        return &db->recipes[match.recipe_index];
+    }
+
+    /* Last resort: the best substring match in either direction */
+    Recipe* found_recipe = NULL;
+    int best_match_score = 0;
+
+    for (int i = 0; i < db->recipe_count; i++) {
+        StringView recipe_name = db->recipes[i].name;
+
+        if (sv_contains_ignore_case(recipe_name, cleaned_name) ||
+            sv_contains_ignore_case(cleaned_name, recipe_name)) {
+            int score = 100 - abs((int)recipe_name.length - (int)cleaned_name.length);
 
             if (score > best_match_score) {
                 best_match_score = score;
                 found_recipe = &db->recipes[i];
             }
         }
-        
-        free(recipe_name_lower);
     }
     
-    free(name_lower);
     return found_recipe;
 }
 
-static QueryType determine_query_type(const char* query) {
-    if (!query) return QUERY_UNKNOWN;
-    
-    char* query_lower = str_to_lower(query);
-    if (!query_lower) return QUERY_UNKNOWN;
-    
-    QueryType type = QUERY_UNKNOWN;
-    
-    if (strstr(query_lower, "what is in") || 
-        strstr(query_lower, "ingredients") || 
-        strstr(query_lower, "what's in")) {
-        type = QUERY_INGREDIENTS;
-    } else if (strstr(query_lower, "how do i make") || 
-               strstr(query_lower, "how to make") || 
-               strstr(query_lower, "preparation") || 
-               strstr(query_lower, "instructions") || 
-               strstr(query_lower, "steps")) {
-        type = QUERY_PREPARATION;
-    } else if (strstr(query_lower, "texture") || 
-               strstr(query_lower, "taste") || 
-               strstr(query_lower, "smell") || 
-               strstr(query_lower, "sensory") || 
-               strstr(query_lower, "feel") || 
-               strstr(query_lower, "temperature")) {
-        type = QUERY_SENSORY;
-    } else if (strstr(query_lower, "how long") || 
-               strstr(query_lower, "time") || 
-               strstr(query_lower, "duration") || 
-               strstr(query_lower, "minutes") || 
-               strstr(query_lower, "hours")) {
-        type = QUERY_TIME;
-    } else {
-        type = QUERY_GENERAL;
+static int max_typos_for_length(size_t length) {
+    int max_edits = (int)(length / 5);
+    if (max_edits < 1) max_edits = 1;
+    if (max_edits > FUZZY_MAX_EDITS) max_edits = FUZZY_MAX_EDITS;
+    return max_edits;
+}
+
+static bool is_better_match(const FuzzyMatch* a, const FuzzyMatch* b) {
+    if (a->distance != b->distance) return a->distance < b->distance;
+    if (a->length_difference != b->length_difference) return a->length_difference < b->length_difference;
+    return a->recipe_index < b->recipe_index;
+}
+
+static int fuzzy_search_view(const RecipeDB* db, StringView query, FuzzyMatch* matches, int max_matches) {
+    if (!db || !query.data || !matches || max_matches <= 0) return 0;
+
+    char normalized_query[FUZZY_MAX_NAME_LENGTH];
+    size_t query_length = fuzzy_normalize(normalize_recipe_name(query),
+                                          normalized_query, sizeof(normalized_query));
+    if (query_length == 0) return 0;
+
+    int max_edits = max_typos_for_length(query_length);
+    int32_t* candidates;
+    int candidate_count = fuzzy_index_candidates(&db->fuzzy_index, normalized_query, query_length,
+                                                 max_edits, FUZZY_MAX_CANDIDATES, &candidates);
+    if (candidate_count <= 0) return 0;
+
+    char normalized_name[FUZZY_MAX_NAME_LENGTH];
+    int match_count = 0;
+
+    for (int c = 0; c < candidate_count; c++) {
+        int index = candidates[c];
+        size_t name_length = fuzzy_normalize(normalize_recipe_name(db->recipes[index].name),
+                                             normalized_name, sizeof(normalized_name));
+
+        int distance = fuzzy_edit_distance(normalized_query, query_length, normalized_name, name_length);
+        if (distance > max_edits) continue;
+
+        FuzzyMatch match;
+        match.recipe_index = index;
+        match.distance = distance;
+        match.length_difference = abs((int)name_length - (int)query_length);
+        match.score = 1.0 - (double)distance / (double)query_length;
+
+        /* Insert into the sorted top-k list */
+        int position = match_count < max_matches ? match_count : max_matches;
+        while (position > 0 && is_better_match(&match, &matches[position - 1])) {
+            if (position < max_matches) matches[position] = matches[position - 1];
+            position--;
+        }
+        if (position < max_matches) {
+            matches[position] = match;
+            if (match_count < max_matches) match_count++;
+        }
     }
-    
-    free(query_lower);
-    return type;
+
+    free(candidates);
+    return match_count;
 }
 
-static char* extract_recipe_name(const char* query, QueryType query_type) {
-    if (!query) return NULL;
-    
-    char* query_lower = str_to_lower(query);
-    if (!query_lower) return NULL;
-    
-    char* recipe_name = NULL;
-    char* start_pos = NULL;
-    
-    switch (query_type) {
-        case QUERY_INGREDIENTS:
-            if ((start_pos = strstr(query_lower, "what is in "))) {
-                start_pos += 11;
-            } else if ((start_pos = strstr(query_lower, "what's in "))) {
-                start_pos += 10;
-            } else if ((start_pos = strstr(query_lower, "ingredients in "))) {
-                start_pos += 14;
-            } else if ((start_pos = strstr(query_lower, "ingredients for "))) {
-                start_pos += 16;
-            }
-            break;
-            
-        case QUERY_PREPARATION:
-            if ((start_pos = strstr(query_lower, "how do i make "))) {
-                start_pos += 14;
-            } else if ((start_pos = strstr(query_lower, "how to make "))) {
-                start_pos += 12;
-            } else if ((start_pos = strstr(query_lower, "preparation for "))) {
-                start_pos += 16;
-            } else if ((start_pos = strstr(query_lower, "instructions for "))) {
-                start_pos += 17;
-            } else if ((start_pos = strstr(query_lower, "steps for "))) {
-                start_pos += 10;
-            }
-            break;
-            
-        case QUERY_SENSORY:
-            if ((start_pos = strstr(query_lower, "texture of "))) {
-                start_pos += 11;
-            } else if ((start_pos = strstr(query_lower, "taste of "))) {
-                start_pos += 9;
-            } else if ((start_pos = strstr(query_lower, "smell of "))) {
-                start_pos += 9;
-            } else if ((start_pos = strstr(query_lower, "sensory profile of "))) {
-                start_pos += 19;
-            } else if ((start_pos = strstr(query_lower, "feel of "))) {
-                start_pos += 8;
-            } else if ((start_pos = strstr(query_lower, "temperature of "))) {
-                start_pos += 15;
-            }
-            break;
-            
-        case QUERY_TIME:
-            if ((start_pos = strstr(query_lower, "how long to make "))) {
-                start_pos += 16;
-            } else if ((start_pos = strstr(query_lower, "time to make "))) {
-                start_pos += 13;
-            } else if ((start_pos = strstr(query_lower, "duration of "))) {
-                start_pos += 12;
-            } else if ((start_pos = strstr(query_lower, "how long does "))) {
-                start_pos += 14;
-                char* it_take = strstr(start_pos, "it take to make ");
-                if (it_take == start_pos) {
-                    start_pos += 16;
-                }
+int fuzzy_search_recipes(const RecipeDB* db, const char* query, FuzzyMatch* matches, int max_matches) {
+    if (!query) return 0;
+    return fuzzy_search_view(db, sv_from_cstr(query), matches, max_matches);
+}
+
+/* Roles a query phrase can play; a phrase may have several */
+#define PHRASE_TRIGGER      0x01  /* selects the query type */
+#define PHRASE_NAME_PREFIX  0x02  /* the recipe name follows the phrase */
+#define PHRASE_NOT_RECIPE   0x04  /* asks for ideas rather than about one recipe */
+#define PHRASE_SUGGESTION   0x08  /* asks for meal suggestions */
+#define PHRASE_WHAT_ARE     0x10
+#define PHRASE_FOOD         0x20
+
+#define MAX_PHRASE_MATCHES 128
+
+typedef struct {
+    const char* text;
+    QueryType type;
+    unsigned int roles;
+} QueryPhrase;
+
+/*
+ * Every phrase the classifier looks for. Query types are tried in enum
+ * order; within a type, name prefixes are tried in table order.
+ */
+static const QueryPhrase QUERY_PHRASES[] = {
+    { "what is in",                     QUERY_INGREDIENTS, PHRASE_TRIGGER },
+    { "ingredients",                    QUERY_INGREDIENTS, PHRASE_TRIGGER },
+    { "what's in",                      QUERY_INGREDIENTS, PHRASE_TRIGGER },
+    { "what is in ",                    QUERY_INGREDIENTS, PHRASE_NAME_PREFIX },
+    { "what's in ",                     QUERY_INGREDIENTS, PHRASE_NAME_PREFIX },
+    { "ingredients in ",                QUERY_INGREDIENTS, PHRASE_NAME_PREFIX },
+    { "ingredients for ",               QUERY_INGREDIENTS, PHRASE_NAME_PREFIX },
+
+    { "how do i make",                  QUERY_PREPARATION, PHRASE_TRIGGER },
+    { "how to make",                    QUERY_PREPARATION, PHRASE_TRIGGER },
+    { "preparation",                    QUERY_PREPARATION, PHRASE_TRIGGER },
+    { "instructions",                   QUERY_PREPARATION, PHRASE_TRIGGER },
+    { "steps",                          QUERY_PREPARATION, PHRASE_TRIGGER },
+    { "how do i make ",                 QUERY_PREPARATION, PHRASE_NAME_PREFIX },
+    { "how to make ",                   QUERY_PREPARATION, PHRASE_NAME_PREFIX },
+    { "preparation for ",               QUERY_PREPARATION, PHRASE_NAME_PREFIX },
+    { "instructions for ",              QUERY_PREPARATION, PHRASE_NAME_PREFIX },
+    { "steps for ",                     QUERY_PREPARATION, PHRASE_NAME_PREFIX },
+
+    { "texture",                        QUERY_SENSORY, PHRASE_TRIGGER },
+    { "taste",                          QUERY_SENSORY, PHRASE_TRIGGER },
+    { "smell",                          QUERY_SENSORY, PHRASE_TRIGGER },
+    { "sensory",                        QUERY_SENSORY, PHRASE_TRIGGER },
+    { "feel",                           QUERY_SENSORY, PHRASE_TRIGGER },
+    { "temperature",                    QUERY_SENSORY, PHRASE_TRIGGER },
+    { "texture of ",                    QUERY_SENSORY, PHRASE_NAME_PREFIX },
+    { "taste of ",                      QUERY_SENSORY, PHRASE_NAME_PREFIX },
+    { "smell of ",                      QUERY_SENSORY, PHRASE_NAME_PREFIX },
+    { "sensory profile of ",            QUERY_SENSORY, PHRASE_NAME_PREFIX },
+    { "feel of ",                       QUERY_SENSORY, PHRASE_NAME_PREFIX },
+    { "temperature of ",                QUERY_SENSORY, PHRASE_NAME_PREFIX },
+
+    { "how long",                       QUERY_TIME, PHRASE_TRIGGER },
+    { "time",                           QUERY_TIME, PHRASE_TRIGGER },
+    { "duration",                       QUERY_TIME, PHRASE_TRIGGER },
+    { "minutes",                        QUERY_TIME, PHRASE_TRIGGER },
+    { "hours",                          QUERY_TIME, PHRASE_TRIGGER },
+    { "how long to make ",              QUERY_TIME, PHRASE_NAME_PREFIX },
+    { "time to make ",                  QUERY_TIME, PHRASE_NAME_PREFIX },
+    { "duration of ",                   QUERY_TIME, PHRASE_NAME_PREFIX },
+    { "how long does it take to make ", QUERY_TIME, PHRASE_NAME_PREFIX },
+    { "how long does ",                 QUERY_TIME, PHRASE_NAME_PREFIX },
+
+    { "what should i",                  QUERY_UNKNOWN, PHRASE_NOT_RECIPE | PHRASE_SUGGESTION },
+    { "what can i",                     QUERY_UNKNOWN, PHRASE_NOT_RECIPE },
+    { "what are",                       QUERY_UNKNOWN, PHRASE_NOT_RECIPE | PHRASE_WHAT_ARE },
+    { "suggest",                        QUERY_UNKNOWN, PHRASE_NOT_RECIPE | PHRASE_SUGGESTION },
+    { "recommendation",                 QUERY_UNKNOWN, PHRASE_NOT_RECIPE },
+    { "recommend",                      QUERY_UNKNOWN, PHRASE_NOT_RECIPE | PHRASE_SUGGESTION },
+    { "ideas",                          QUERY_UNKNOWN, PHRASE_NOT_RECIPE },
+    { "options",                        QUERY_UNKNOWN, PHRASE_NOT_RECIPE },
+    { "food",                           QUERY_UNKNOWN, PHRASE_FOOD }
+};
+
+#define QUERY_PHRASE_COUNT ((int)(sizeof(QUERY_PHRASES) / sizeof(QUERY_PHRASES[0])))
+
+/* Names too generic to be a recipe, e.g. "what is in dinner" */
+static const char* GENERIC_NAMES[] = {
+    "dinner", "lunch", "breakfast", "meal", "food", "foods",
+    "recipe", "recipes", "dish", "dishes"
+};
+
+/* Built on first use; pthread_once makes that safe from any thread */
+static PhraseMatcher query_matcher;
+static bool query_matcher_ready = false;
+static pthread_once_t query_matcher_once = PTHREAD_ONCE_INIT;
+
+static void build_query_matcher(void) {
+    const char* texts[QUERY_PHRASE_COUNT];
+    for (int i = 0; i < QUERY_PHRASE_COUNT; i++) {
+        texts[i] = QUERY_PHRASES[i].text;
+    }
+    query_matcher_ready = phrase_matcher_build(&query_matcher, texts, QUERY_PHRASE_COUNT);
+}
+
+static const PhraseMatcher* get_query_matcher(void) {
+    pthread_once(&query_matcher_once, build_query_matcher);
+    return query_matcher_ready ? &query_matcher : NULL;
+}
+
+static bool is_generic_name(StringView name) {
+    for (size_t i = 0; i < sizeof(GENERIC_NAMES) / sizeof(GENERIC_NAMES[0]); i++) {
+        if (sv_equals_ignore_case(name, sv_from_cstr(GENERIC_NAMES[i]))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Lowercase a query, trim it and collapse runs of whitespace to one space
+ * 
+ * @param query The query
+ * @param length The length of the query
+ * @param normalized Receives the text; it must hold length + 1 bytes
+ * @return The length of the normalized text
+ */
+static size_t normalize_query_into(const char* query, size_t length, char* normalized) {
+    size_t out = 0;
+    bool pending_space = false;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)query[i];
+        if (isspace(c)) {
+            pending_space = out > 0;
+            continue;
+        }
+        if (pending_space) {
+            normalized[out++] = ' ';
+            pending_space = false;
+        }
+        normalized[out++] = (char)tolower(c);
+    }
+    normalized[out] = '\0';
+    return out;
+}
+
+static char* normalize_query_text(const char* query, size_t length, size_t* normalized_length) {
+    char* normalized = (char*)malloc(length + 1);
+    if (!normalized) return NULL;
+
+    *normalized_length = normalize_query_into(query, length, normalized);
+    return normalized;
+}
+
+bool normalize_query(const char* query, StringBuilder* out) {
+    if (!query) return false;
+
+    size_t length = strlen(query);
+    if (!sb_reserve(out, length)) return false;
+
+    out->length += normalize_query_into(query, length, out->data + out->length);
+    return true;
+}
+
+/*
+ * Classify a query in a single pass: every phrase occurrence is found at
+ * once, which yields the query type, where the recipe name starts and
+ * whether the query asks for suggestions.
+ */
+bool parse_query(const char* query, ParsedQuery* parsed) {
+    if (!parsed) return false;
+
+    memset(parsed, 0, sizeof(*parsed));
+    parsed->text = query;
+    parsed->type = QUERY_UNKNOWN;
+    if (!query) return false;
+
+    size_t query_length = strlen(query);
+    parsed->normalized = normalize_query_text(query, query_length, &parsed->normalized_length);
+    if (!parsed->normalized) return false;
+
+    const PhraseMatcher* matcher = get_query_matcher();
+    if (!matcher) {
+        free_parsed_query(parsed);
+        return false;
+    }
+
+    /* Classify the normalized text only, so inputs that normalize alike
+       (and so share a response cache entry) are answered alike */
+    const char* text = parsed->normalized;
+    size_t text_length = parsed->normalized_length;
+
+    PhraseMatch matches[MAX_PHRASE_MATCHES];
+    int match_count = phrase_matcher_scan(matcher, text, text_length, matches, MAX_PHRASE_MATCHES);
+    if (match_count > MAX_PHRASE_MATCHES) match_count = MAX_PHRASE_MATCHES;
+
+    size_t first_start[QUERY_PHRASE_COUNT];
+    bool seen[QUERY_PHRASE_COUNT];
+    memset(seen, 0, sizeof(seen));
+
+    unsigned int roles = 0;
+    QueryType type = QUERY_GENERAL;
+    for (int i = 0; i < match_count; i++) {
+        int phrase = matches[i].phrase;
+        if (!seen[phrase]) {
+            seen[phrase] = true;
+            first_start[phrase] = matches[i].start;
+        }
+        roles |= QUERY_PHRASES[phrase].roles;
+        if ((QUERY_PHRASES[phrase].roles & PHRASE_TRIGGER) && QUERY_PHRASES[phrase].type < type) {
+            type = QUERY_PHRASES[phrase].type;
+        }
+    }
+    parsed->type = type;
+    parsed->excludes_recipe = (roles & PHRASE_NOT_RECIPE) != 0;
+    parsed->is_suggestion = (roles & PHRASE_SUGGESTION) ||
+                            ((roles & PHRASE_WHAT_ARE) && (roles & PHRASE_FOOD));
+
+    const char* start_pos = NULL;
+    if (type == QUERY_GENERAL) {
+        start_pos = text;
+    } else {
+        for (int p = 0; p < QUERY_PHRASE_COUNT; p++) {
+            if (seen[p] && QUERY_PHRASES[p].type == type &&
+                (QUERY_PHRASES[p].roles & PHRASE_NAME_PREFIX)) {
+                start_pos = text + first_start[p] + strlen(QUERY_PHRASES[p].text);
+                break;
             }
-            break;
-            
-        case QUERY_GENERAL:
-            start_pos = query_lower;
-            break;
-            
-        default:
-            break;
+        }
     }
-    
+
     if (start_pos) {
-        size_t len = strlen(start_pos);
+        size_t len = text_length - (size_t)(start_pos - text);
 
-        while (len > 0 && (ispunct(start_pos[len-1]) || isspace(start_pos[len-1]))) {
+        /* A name with surrounding space would miss the exact name index */
+        while (len > 0 && isspace((unsigned char)*start_pos)) {
+            start_pos++;
             len--;
         }
-        
+        while (len > 0 && (ispunct((unsigned char)start_pos[len - 1]) ||
+                           isspace((unsigned char)start_pos[len - 1]))) {
+            len--;
+        }
+
         if (len > 0) {
-            size_t offset = start_pos - query_lower;
-            
-            recipe_name = (char*)malloc(len + 1);
-            if (recipe_name) {
-                strncpy(recipe_name, query + offset, len);
-                recipe_name[len] = '\0';
-            }
+            parsed->name.data = start_pos;
+            parsed->name.length = len;
+            parsed->is_generic_name = is_generic_name(parsed->name);
         }
     }
-    
-    free(query_lower);
-    return recipe_name;
+
+    return true;
+}
+
+bool parsed_query_is_recipe(const ParsedQuery* parsed) {
+    if (!parsed || !parsed->normalized) return false;
+
+    if (parsed->excludes_recipe) return false;
+    if (parsed->name.length == 0) return false;
+
+    return !parsed->is_generic_name;
+}
+
+void free_parsed_query(ParsedQuery* parsed) {
+    if (!parsed) return;
+
+    free(parsed->normalized);
+    parsed->normalized = NULL;
+    parsed->normalized_length = 0;
 }
 
-static char* generate_ingredients_response(Recipe* recipe) {
+static bool generate_ingredients_response(StringBuilder* out, Recipe* recipe) {
     if (!recipe || !recipe->ingredients || recipe->ingredients_count == 0) {
-        return str_duplicate("I couldn't find information about the ingredients for this recipe.");
+        return sb_append_cstr(out, "I couldn't find information about the ingredients for this recipe.");
     }
     
-    char* response = (char*)malloc(MAX_RESPONSE_LENGTH);
-    if (!response) return NULL;
-    
-    snprintf(response, MAX_RESPONSE_LENGTH, "The ingredients for %s are:\n", recipe->name);
+    sb_appendf(out, "The ingredients for %.*s are:\n", SV_ARG(recipe->name));
     
-    size_t offset = strlen(response);
     for (int i = 0; i < recipe->ingredients_count; i++) {
-        size_t remaining = MAX_RESPONSE_LENGTH - offset;
-        int written = snprintf(response + offset, remaining, "- %s\n", recipe->ingredients[i]);
-        
-        if (written < 0 || written >= (int)remaining) {
-            strncat(response, "...", MAX_RESPONSE_LENGTH - offset - 1);
-            break;
-        }
-        
-        offset += written;
+        sb_appendf(out, "- %.*s\n", SV_ARG(recipe->ingredients[i].name));
     }
     
-    return response;
+    return !out->failed;
 }
 
-static char* generate_preparation_response(Recipe* recipe) {
+static bool generate_preparation_response(StringBuilder* out, Recipe* recipe) {
     if (!recipe || !recipe->preparation_steps || recipe->preparation_steps_count == 0) {
-        return str_duplicate("I couldn't find preparation instructions for this recipe.");
+        return sb_append_cstr(out, "I couldn't find preparation instructions for this recipe.");
     }
     
-    char* response = (char*)malloc(MAX_RESPONSE_LENGTH);
-    if (!response) return NULL;
+    sb_appendf(out, "Here's how to make %.*s:\n", SV_ARG(recipe->name));
     
-    snprintf(response, MAX_RESPONSE_LENGTH, "Here's how to make %s:\n", recipe->name);
-    
-    size_t offset = strlen(response);
     for (int i = 0; i < recipe->preparation_steps_count; i++) {
-        size_t remaining = MAX_RESPONSE_LENGTH - offset;
-        int written = snprintf(response + offset, remaining, "%d. %s\n", i + 1, recipe->preparation_steps[i]);
-        
-        if (written < 0 || written >= (int)remaining) {
-            strncat(response, "...", MAX_RESPONSE_LENGTH - offset - 1);
-            break;
-        }
-        
-        offset += written;
+        sb_appendf(out, "%d. %.*s\n", i + 1, SV_ARG(recipe->preparation_steps[i]));
     }
     
-    return response;
+    return !out->failed;
 }
 
-static char* generate_sensory_response(Recipe* recipe) {
-    if (!recipe) {
-        return str_duplicate("I couldn't find sensory information for this recipe.");
-    }
-    
-    char* response = (char*)malloc(MAX_RESPONSE_LENGTH);
-    if (!response) return NULL;
-    
-    snprintf(response, MAX_RESPONSE_LENGTH, "Sensory profile for %s:\n", recipe->name);
-    
-    size_t offset = strlen(response);
-    size_t remaining;
-    int written;
-
-    if (recipe->sensory_texture && recipe->sensory_texture_count > 0) {
-        remaining = MAX_RESPONSE_LENGTH - offset;
-        written = snprintf(response + offset, remaining, "Texture: ");
-        if (written > 0 && written < (int)remaining) {
-            offset += written;
-            
-            for (int i = 0; i < recipe->sensory_texture_count; i++) {
-                remaining = MAX_RESPONSE_LENGTH - offset;
-                written = snprintf(response + offset, remaining, 
-                                  "%s%s", 
-                                  recipe->sensory_texture[i],
-                                  (i < recipe->sensory_texture_count - 1) ? ", " : "\n");
-                
-                if (written < 0 || written >= (int)remaining) {
-                    strncat(response, "...\n", MAX_RESPONSE_LENGTH - offset - 1);
-                    offset = strlen(response);
-                    break;
-                }
-                
-                offset += written;
-            }
-        }
-    }
+/* Append "Label: a, b, c\n" for one sensory dimension, if it has values */
+static void append_attribute_line(StringBuilder* out, const RecipeDB* db, const char* label,
+                                  const SymbolId* ids, int count) {
+    if (!ids || count == 0) return;
 
-    if (recipe->sensory_temperature && recipe->sensory_temperature_count > 0) {
-        remaining = MAX_RESPONSE_LENGTH - offset;
-        written = snprintf(response + offset, remaining, "Temperature: ");
-        if (written > 0 && written < (int)remaining) {
-            offset += written;
-            
-            for (int i = 0; i < recipe->sensory_temperature_count; i++) {
-                remaining = MAX_RESPONSE_LENGTH - offset;
-                written = snprintf(response + offset, remaining, 
-                                  "%s%s", 
-                                  recipe->sensory_temperature[i],
-                                  (i < recipe->sensory_temperature_count - 1) ? ", " : "\n");
-                
-                if (written < 0 || written >= (int)remaining) {
-                    strncat(response, "...\n", MAX_RESPONSE_LENGTH - offset - 1);
-                    offset = strlen(response);
-                    break;
-                }
-                
-                offset += written;
-            }
-        }
+    sb_appendf(out, "%s: ", label);
+    for (int i = 0; i < count; i++) {
+        sb_append_view(out, symbol_table_name(&db->symbols, ids[i]));
+        sb_append_cstr(out, i < count - 1 ? ", " : "\n");
     }
+}
 
-    if (recipe->sensory_taste && recipe->sensory_taste_count > 0) {
-        remaining = MAX_RESPONSE_LENGTH - offset;
-        written = snprintf(response + offset, remaining, "Taste: ");
-        if (written > 0 && written < (int)remaining) {
-            offset += written;
-            
-            for (int i = 0; i < recipe->sensory_taste_count; i++) {
-                remaining = MAX_RESPONSE_LENGTH - offset;
-                written = snprintf(response + offset, remaining, 
-                                  "%s%s", 
-                                  recipe->sensory_taste[i],
-                                  (i < recipe->sensory_taste_count - 1) ? ", " : "\n");
-                
-                if (written < 0 || written >= (int)remaining) {
-                    strncat(response, "...\n", MAX_RESPONSE_LENGTH - offset - 1);
-                    offset = strlen(response);
-                    break;
-                }
-                
-                offset += written;
-            }
-        }
+/* Append at most two values, then "..." if there are more */
+static void append_attribute_sample(StringBuilder* out, const RecipeDB* db, const SymbolId* ids, int count) {
+    for (int i = 0; i < count && i < 2; i++) {
+        if (i > 0) sb_append_cstr(out, ", ");
+        sb_append_view(out, symbol_table_name(&db->symbols, ids[i]));
     }
-
-    if (recipe->sensory_smell && recipe->sensory_smell_count > 0) {
-        remaining = MAX_RESPONSE_LENGTH - offset;
-        written = snprintf(response + offset, remaining, "Smell: ");
-        if (written > 0 && written < (int)remaining) {
-            offset += written;
-            
-            for (int i = 0; i < recipe->sensory_smell_count; i++) {
-                remaining = MAX_RESPONSE_LENGTH - offset;
-                written = snprintf(response + offset, remaining, 
-                                  "%s%s", 
-                                  recipe->sensory_smell[i],
-                                  (i < recipe->sensory_smell_count - 1) ? ", " : "\n");
-                
-                if (written < 0 || written >= (int)remaining) {
-                    strncat(response, "...\n", MAX_RESPONSE_LENGTH - offset - 1);
-                    offset = strlen(response);
-                    break;
-                }
-                
-                offset += written;
-            }
-        }
+    if (count > 2) {
+        sb_append_cstr(out, "...");
     }
-    
-    return response;
 }
 
-static char* generate_time_response(Recipe* recipe) {
+static bool generate_sensory_response(StringBuilder* out, const RecipeDB* db, Recipe* recipe) {
     if (!recipe) {
-        return str_duplicate("I couldn't find time information for this recipe.");
+        return sb_append_cstr(out, "I couldn't find sensory information for this recipe.");
     }
     
-    char* response = (char*)malloc(MAX_RESPONSE_LENGTH);
-    if (!response) return NULL;
+    sb_appendf(out, "Sensory profile for %.*s:\n", SV_ARG(recipe->name));
     
-    snprintf(response, MAX_RESPONSE_LENGTH, "Time information for %s:\n", recipe->name);
+    append_attribute_line(out, db, "Texture", recipe->sensory_texture, recipe->sensory_texture_count);
+    append_attribute_line(out, db, "Temperature", recipe->sensory_temperature, recipe->sensory_temperature_count);
+    append_attribute_line(out, db, "Taste", recipe->sensory_taste, recipe->sensory_taste_count);
+    append_attribute_line(out, db, "Smell", recipe->sensory_smell, recipe->sensory_smell_count);
     
-    size_t offset = strlen(response);
-    size_t remaining = MAX_RESPONSE_LENGTH - offset;
-    int written;
-    
-    written = snprintf(response + offset, remaining, 
-                      "Preparation time: %d %s\n", 
-                      recipe->prep_time_duration, 
-                      recipe->prep_time_unit);
+    return !out->failed;
+}
+
+static bool generate_time_response(StringBuilder* out, const RecipeDB* db, Recipe* recipe) {
+    if (!recipe) {
+        return sb_append_cstr(out, "I couldn't find time information for this recipe.");
+    }
     
-    if (written > 0 && written < (int)remaining) {
-        offset += written;
-        remaining = MAX_RESPONSE_LENGTH - offset;
-        
-        written = snprintf(response + offset, remaining, 
-                          "Cooking time: %d %s\n", 
-                          recipe->cook_time_duration, 
-                          recipe->cook_time_unit);
-        
-        if (written > 0 && written < (int)remaining) {
-            offset += written;
-            remaining = MAX_RESPONSE_LENGTH - offset;
-            
-            written = snprintf(response + offset, remaining, 
-                              "Total time: %d %s\n", 
-                              recipe->prep_time_duration + recipe->cook_time_duration, 
-                              recipe->prep_time_unit);
-        }
+    sb_appendf(out, "Time information for %.*s:\n", SV_ARG(recipe->name));
+    
+    sb_appendf(out, "Preparation time: %d %.*s\n", 
+               recipe->prep_time_duration, 
+               SV_ARG(recipe->prep_time_unit));
+    
+    sb_appendf(out, "Cooking time: %d %.*s\n", 
+               recipe->cook_time_duration, 
+               SV_ARG(recipe->cook_time_unit));
+    
+    /* Times in different units are only added once converted */
+    int32_t total_minutes = db->columns.total_minutes[recipe - db->recipes];
+    if (sv_equals(recipe->prep_time_unit, recipe->cook_time_unit) &&
+        recipe->prep_time_duration >= 0 && recipe->cook_time_duration >= 0) {
+        sb_appendf(out, "Total time: %lld %.*s\n", 
+                   (long long)recipe->prep_time_duration + recipe->cook_time_duration, 
+                   SV_ARG(recipe->prep_time_unit));
+    } else if (total_minutes != RECIPE_MINUTES_UNKNOWN) {
+        sb_appendf(out, "Total time: %d minutes\n", (int)total_minutes);
+    } else {
+        sb_append_cstr(out, "Total time: unknown\n");
     }
     
-    return response;
+    return !out->failed;
 }
 
-static char* generate_general_response(Recipe* recipe) {
+static bool generate_general_response(StringBuilder* out, const RecipeDB* db, Recipe* recipe) {
     if (!recipe) {
-        return str_duplicate("I couldn't find information about this recipe.");
+        return sb_append_cstr(out, "I couldn't find information about this recipe.");
     }
     
-    char* response = (char*)malloc(MAX_RESPONSE_LENGTH);
-    if (!response) return NULL;
-    
-    snprintf(response, MAX_RESPONSE_LENGTH, "About %s:\n", recipe->name);
-    
-    size_t offset = strlen(response);
-    size_t remaining = MAX_RESPONSE_LENGTH - offset;
-    int written;
+    sb_appendf(out, "About %.*s:\n", SV_ARG(recipe->name));
 
-    if (recipe->description) {
-        written = snprintf(response + offset, remaining, "%s\n\n", recipe->description);
-        
-        if (written > 0 && written < (int)remaining) {
-            offset += written;
-            remaining = MAX_RESPONSE_LENGTH - offset;
-        }
+    if (recipe->description.data) {
+        sb_appendf(out, "%.*s\n\n", SV_ARG(recipe->description));
     }
 
-    if (recipe->meal_type && recipe->meal_type_count > 0) {
-        written = snprintf(response + offset, remaining, "Meal type: ");
-        
-        if (written > 0 && written < (int)remaining) {
-            offset += written;
-            remaining = MAX_RESPONSE_LENGTH - offset;
-            
-            for (int i = 0; i < recipe->meal_type_count; i++) {
-                written = snprintf(response + offset, remaining, 
-                                  "%s%s", 
-                                  recipe->meal_type[i],
-                                  (i < recipe->meal_type_count - 1) ? ", " : "\n");
-                
-                if (written < 0 || written >= (int)remaining) {
-                    strncat(response, "...\n", MAX_RESPONSE_LENGTH - offset - 1);
-                    offset = strlen(response);
-                    break;
-                }
-                
-                offset += written;
-                remaining = MAX_RESPONSE_LENGTH - offset;
-            }
-        }
-    }
+    append_attribute_line(out, db, "Meal type", recipe->meal_type, recipe->meal_type_count);
 
-    written = snprintf(response + offset, remaining, 
-                      "Preparation time: %d %s\n", 
-                      recipe->prep_time_duration, 
-                      recipe->prep_time_unit);
-    
-    if (written > 0 && written < (int)remaining) {
-        offset += written;
-        remaining = MAX_RESPONSE_LENGTH - offset;
-    }
+    sb_appendf(out, "Preparation time: %d %.*s\n", 
+               recipe->prep_time_duration, 
+               SV_ARG(recipe->prep_time_unit));
     
-    written = snprintf(response + offset, remaining, 
-                      "Cooking time: %d %s\n\n", 
-                      recipe->cook_time_duration, 
-                      recipe->cook_time_unit);
-    
-    if (written > 0 && written < (int)remaining) {
-        offset += written;
-        remaining = MAX_RESPONSE_LENGTH - offset;
-    }
+    sb_appendf(out, "Cooking time: %d %.*s\n\n", 
+               recipe->cook_time_duration, 
+               SV_ARG(recipe->cook_time_unit));
 
     if (recipe->ingredients && recipe->ingredients_count > 0) {
-        written = snprintf(response + offset, remaining, 
-                          "Contains %d ingredients including ", 
-                          recipe->ingredients_count);
+        sb_appendf(out, "Contains %d ingredients including ", recipe->ingredients_count);
+
+        int max_examples = recipe->ingredients_count < 3 ? recipe->ingredients_count : 3;
+        for (int i = 0; i < max_examples; i++) {
+            if (i > 0) sb_append_cstr(out, ", ");
+            sb_append_view(out, recipe->ingredients[i].name);
+        }
         
-        if (written > 0 && written < (int)remaining) {
-            offset += written;
-            remaining = MAX_RESPONSE_LENGTH - offset;
-
-            int max_examples = recipe->ingredients_count < 3 ? recipe->ingredients_count : 3;
-            
-            for (int i = 0; i < max_examples; i++) {
-                written = snprintf(response + offset, remaining, 
-                                  "%s%s", 
-                                  recipe->ingredients[i],
-                                  (i < max_examples - 1) ? ", " : "");
-                
-                if (written < 0 || written >= (int)remaining) {
-                    strncat(response, "...\n", MAX_RESPONSE_LENGTH - offset - 1);
-                    offset = strlen(response);
-                    break;
-                }
-                
-                offset += written;
-                remaining = MAX_RESPONSE_LENGTH - offset;
-            }
-            
-            if (recipe->ingredients_count > 3) {
-                written = snprintf(response + offset, remaining, " and others");
-                
-                if (written > 0 && written < (int)remaining) {
-                    offset += written;
-                    remaining = MAX_RESPONSE_LENGTH - offset;
-                }
-            }
-            
-            written = snprintf(response + offset, remaining, ".\n");
-            
-            if (written > 0 && written < (int)remaining) {
-                offset += written;
-                remaining = MAX_RESPONSE_LENGTH - offset;
-            }
+        if (recipe->ingredients_count > 3) {
+            sb_append_cstr(out, " and others");
         }
+        
+        sb_append_cstr(out, ".\n");
     }
 
-    if ((recipe->sensory_texture && recipe->sensory_texture_count > 0) ||
-        (recipe->sensory_taste && recipe->sensory_taste_count > 0)) {
+    bool has_texture = recipe->sensory_texture && recipe->sensory_texture_count > 0;
+    bool has_taste = recipe->sensory_taste && recipe->sensory_taste_count > 0;
+    if (has_texture || has_taste) {
+        sb_append_cstr(out, "Sensory profile: ");
         
-        written = snprintf(response + offset, remaining, "Sensory profile: ");
+        if (has_texture) {
+            sb_append_cstr(out, "Texture - ");
+            append_attribute_sample(out, db, recipe->sensory_texture, recipe->sensory_texture_count);
+        }
         
-        if (written > 0 && written < (int)remaining) {
-            offset += written;
-            remaining = MAX_RESPONSE_LENGTH - offset;
-            
-            if (recipe->sensory_texture && recipe->sensory_texture_count > 0) {
-                written = snprintf(response + offset, remaining, "Texture - ");
-                
-                if (written > 0 && written < (int)remaining) {
-                    offset += written;
-                    remaining = MAX_RESPONSE_LENGTH - offset;
-                    
-                    for (int i = 0; i < recipe->sensory_texture_count && i < 2; i++) {
-                        written = snprintf(response + offset, remaining, 
-                                          "%s%s", 
-                                          recipe->sensory_texture[i],
-                                          (i < recipe->sensory_texture_count - 1 && i < 1) ? ", " : "");
-                        
-                        if (written < 0 || written >= (int)remaining) {
-                            strncat(response, "...", MAX_RESPONSE_LENGTH - offset - 1);
-                            offset = strlen(response);
-                            break;
-                        }
-                        
-                        offset += written;
-                        remaining = MAX_RESPONSE_LENGTH - offset;
-                    }
-                    
-                    if (recipe->sensory_texture_count > 2) {
-                        written = snprintf(response + offset, remaining, "...");
-                        
-                        if (written > 0 && written < (int)remaining) {
-                            offset += written;
-                            remaining = MAX_RESPONSE_LENGTH - offset;
-                        }
-                    }
-                }
-            }
-            
-            if (recipe->sensory_taste && recipe->sensory_taste_count > 0) {
-                if (recipe->sensory_texture && recipe->sensory_texture_count > 0) {
-                    written = snprintf(response + offset, remaining, ", Taste - ");
-                } else {
-                    written = snprintf(response + offset, remaining, "Taste - ");
-                }
-                
-                if (written > 0 && written < (int)remaining) {
-                    offset += written;
-                    remaining = MAX_RESPONSE_LENGTH - offset;
-                    
-                    for (int i = 0; i < recipe->sensory_taste_count && i < 2; i++) {
-                        written = snprintf(response + offset, remaining, 
-                                          "%s%s", 
-                                          recipe->sensory_taste[i],
-                                          (i < recipe->sensory_taste_count - 1 && i < 1) ? ", " : "");
-                        
-                        if (written < 0 || written >= (int)remaining) {
-                            strncat(response, "...", MAX_RESPONSE_LENGTH - offset - 1);
-                            offset = strlen(response);
-                            break;
-                        }
-                        
-                        offset += written;
-                        remaining = MAX_RESPONSE_LENGTH - offset;
-                    }
-                    
-                    if (recipe->sensory_taste_count > 2) {
-                        written = snprintf(response + offset, remaining, "...");
-                        
-                        if (written > 0 && written < (int)remaining) {
-                            offset += written;
-                            remaining = MAX_RESPONSE_LENGTH - offset;
-                        }
-                    }
-                }
-            }
-            
-            written = snprintf(response + offset, remaining, "\n");
-            
-            if (written > 0 && written < (int)remaining) {
-                offset += written;
-                remaining = MAX_RESPONSE_LENGTH - offset;
-            }
+        if (has_taste) {
+            sb_append_cstr(out, has_texture ? ", Taste - " : "Taste - ");
+            append_attribute_sample(out, db, recipe->sensory_taste, recipe->sensory_taste_count);
         }
+        
+        sb_append_cstr(out, "\n");
     }
     
-    return response;
+    return !out->failed;
+}
+
+const char* query_type_name(QueryType type) {
+    switch (type) {
+        case QUERY_INGREDIENTS: return "ingredients";
+        case QUERY_PREPARATION: return "preparation";
+        case QUERY_SENSORY: return "sensory";
+        case QUERY_TIME: return "time";
+        case QUERY_GENERAL: return "general";
+        case QUERY_FILTER: return "filter";
+        default: return "unknown";
+    }
 }
 
 bool is_recipe_query(const char* query) {
-    if (!query) return false;
-    
-    char* query_lower = str_to_lower(query);
-    if (!query_lower) return false;
-
-    if (strstr(query_lower, "what should i") || 
-        strstr(query_lower, "what can i") ||
-        strstr(query_lower, "what are") ||
-        strstr(query_lower, "suggest") ||
-        strstr(query_lower, "recommendation") ||
-        strstr(query_lower, "recommend") ||
-        strstr(query_lower, "ideas") ||
-        strstr(query_lower, "options")) {
-        free(query_lower);
-        return false;
+    ParsedQuery parsed;
+    if (!parse_query(query, &parsed)) return false;
+
+    bool is_recipe = parsed_query_is_recipe(&parsed);
+    free_parsed_query(&parsed);
+    return is_recipe;
+}
+
+bool is_suggestion_query(const char* query) {
+    ParsedQuery parsed;
+    if (!parse_query(query, &parsed)) return false;
+
+    bool is_suggestion = parsed.is_suggestion;
+    free_parsed_query(&parsed);
+    return is_suggestion;
+}
+
+static int response_slot(QueryType type) {
+    if (type < QUERY_INGREDIENTS || type > QUERY_GENERAL) type = QUERY_GENERAL;
+    return (int)type;
+}
+
+static bool generate_response(StringBuilder* out, const RecipeDB* db, Recipe* recipe, QueryType type) {
+    switch (type) {
+        case QUERY_INGREDIENTS:
+            return generate_ingredients_response(out, recipe);
+        case QUERY_PREPARATION:
+            return generate_preparation_response(out, recipe);
+        case QUERY_SENSORY:
+            return generate_sensory_response(out, db, recipe);
+        case QUERY_TIME:
+            return generate_time_response(out, db, recipe);
+        default:
+            return generate_general_response(out, db, recipe);
     }
-    
-    free(query_lower);
+}
 
-    QueryType type = determine_query_type(query);
-    char* recipe_name = extract_recipe_name(query, type);
-    
-    if (!recipe_name) {
-        return false;
+bool precompute_recipe_responses(RecipeDB* db) {
+    if (!db || db->error_message) return false;
+    if (db->response_offsets) return true;
+
+    size_t* offsets = (size_t*)malloc((size_t)db->recipe_count * RESPONSE_SLOT_COUNT * sizeof(size_t));
+    if (!offsets) return false;
+
+    /* Responses are rendered straight into the blob, each followed by a NUL */
+    StringBuilder blob;
+    sb_init(&blob);
+    bool ok = true;
+
+    for (int i = 0; ok && i < db->recipe_count; i++) {
+        Recipe* recipe = &db->recipes[i];
+        size_t* row = &offsets[(size_t)i * RESPONSE_SLOT_COUNT];
+
+        for (int type = QUERY_INGREDIENTS; ok && type <= QUERY_GENERAL; type++) {
+            row[response_slot((QueryType)type)] = blob.length;
+            ok = generate_response(&blob, db, recipe, (QueryType)type) && sb_append(&blob, "", 1);
+        }
     }
 
-    char* name_lower = str_to_lower(recipe_name);
-    bool is_generic = false;
-    
-    if (strcmp(name_lower, "dinner") == 0 ||
-        strcmp(name_lower, "lunch") == 0 ||
-        strcmp(name_lower, "breakfast") == 0 ||
-        strcmp(name_lower, "meal") == 0 ||
-        strcmp(name_lower, "food") == 0 ||
-        strcmp(name_lower, "foods") == 0 ||
-        strcmp(name_lower, "recipe") == 0 ||
-        strcmp(name_lower, "recipes") == 0 ||
-        strcmp(name_lower, "dish") == 0 ||
-        strcmp(name_lower, "dishes") == 0) {
-        is_generic = true;
+    if (!ok) {
+        sb_free(&blob);
+        free(offsets);
+        return false;
     }
-    
-    free(name_lower);
-    free(recipe_name);
-    
-    return !is_generic;
+
+    /* Give back the slack from doubling */
+    db->response_blob_size = blob.length;
+    db->response_blob = sb_detach(&blob);
+    char* trimmed = (char*)realloc(db->response_blob, db->response_blob_size + 1);
+    if (trimmed) db->response_blob = trimmed;
+    db->response_offsets = offsets;
+    return true;
 }
 
-QueryResult process_recipe_query(RecipeDB* db, const char* query) {
+QueryResult render_parsed_query(const RecipeDB* db, const ParsedQuery* query, StringBuilder* out) {
     QueryResult result = {
         .success = false,
-        .recipe_name = NULL,
+        .recipe_name = { NULL, 0 },
+        .recipe_index = -1,
         .query_type = QUERY_UNKNOWN,
-        .response = NULL
+        .response = NULL,
+        .response_length = 0,
+        .borrowed = true
     };
+
+    sb_reset(out);
     
-    if (!db || !query) {
-        result.response = str_duplicate("Error: Invalid database or query.");
-        return result;
+    if (!db || !query || !query->normalized) {
+        sb_append_cstr(out, "Error: Invalid database or query.");
+    } else if (query->name.length == 0) {
+        result.query_type = query->type;
+        sb_append_cstr(out, "I couldn't identify a recipe in your query. Try asking about a specific recipe, like 'What is in Berry Blast Smoothie?'");
+    } else {
+        result.query_type = query->type;
+        result.recipe_name = query->name;
+
+        Recipe* recipe = find_recipe_by_name_view(db, query->name);
+        if (recipe) {
+            result.recipe_index = (int)(recipe - db->recipes);
+        }
+
+        if (!recipe) {
+            sb_appendf(out, "I couldn't find a recipe for '%.*s'. Please try another recipe name.", 
+                       SV_ARG(query->name));
+        } else if (db->response_offsets) {
+            size_t row = (size_t)(recipe - db->recipes) * RESPONSE_SLOT_COUNT;
+            size_t start = db->response_offsets[row + response_slot(query->type)];
+            result.recipe_name = recipe->name;
+            result.response = db->response_blob + start;
+            result.response_length = strlen(result.response);
+            result.success = true;
+            return result;
+        } else {
+            result.recipe_name = recipe->name;
+            result.success = generate_response(out, db, recipe, query->type);
+        }
     }
 
-    QueryType type = determine_query_type(query);
-    result.query_type = type;
+    if (out->failed) {
+        result.success = false;
+        result.response = (char*)"Error: Out of memory.";
+        result.response_length = strlen(result.response);
+    } else {
+        result.response = out->data;
+        result.response_length = out->length;
+    }
+    return result;
+}
+
+QueryResult process_parsed_query(const RecipeDB* db, const ParsedQuery* query) {
+    StringBuilder out;
+    sb_init(&out);
 
-    char* recipe_name = extract_recipe_name(query, type);
-    if (!recipe_name) {
-        result.response = str_duplicate("I couldn't identify a recipe in your query. Try asking about a specific recipe, like 'What is in Berry Blast Smoothie?'");
-        return result;
+    QueryResult result = render_parsed_query(db, query, &out);
+    if (result.response == out.data) {
+        result.response = sb_detach(&out);
+        result.borrowed = false;
     }
-    
-    result.recipe_name = recipe_name;
+    sb_free(&out);
+    return result;
+}
 
-    Recipe* recipe = find_recipe_by_name(db, recipe_name);
-    if (!recipe) {
-        char* response = (char*)malloc(MAX_RESPONSE_LENGTH);
-        if (response) {
-            snprintf(response, MAX_RESPONSE_LENGTH, 
-                    "I couldn't find a recipe for '%s'. Please try another recipe name.", 
-                    recipe_name);
-            result.response = response;
-        } else {
-            result.response = str_duplicate("I couldn't find that recipe.");
+QueryResult process_recipe_query(const RecipeDB* db, const char* query) {
+    ParsedQuery parsed;
+    parse_query(query, &parsed);
+
+    QueryResult result = process_parsed_query(db, &parsed);
+    /* A name that matched no recipe points into the parsed query */
+    if (result.recipe_index < 0) {
+        result.recipe_name.data = NULL;
+        result.recipe_name.length = 0;
+    }
+    free_parsed_query(&parsed);
+    return result;
+}
+
+static void append_joined(StringBuilder* out, const StringList* list) {
+    for (int i = 0; i < list->count; i++) {
+        if (i > 0) sb_append_cstr(out, ", ");
+        sb_append_view(out, list->items[i]);
+    }
+}
+
+static bool query_mentions_any(const ParsedQuery* query, const char* const* words, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (strstr(query->normalized, words[i])) return true;
+    }
+    return false;
+}
+
+/* "For smooth textures, you might enjoy: A, B." over the texture index */
+static void append_texture_meals(StringBuilder* out, const RecipeDB* db, const char* texture) {
+    SymbolId id = find_symbol_id(db, texture);
+    if (id == SYMBOL_NONE || !db->attribute_index[ATTRIBUTE_TEXTURE]) return;
+
+    const Bitmap* meals = &db->attribute_index[ATTRIBUTE_TEXTURE][id];
+    uint32_t count = bitmap_cardinality(meals);
+    if (count == 0) return;
+
+    uint32_t* indices = (uint32_t*)malloc(count * sizeof(uint32_t));
+    if (!indices) {
+        out->failed = true;
+        return;
+    }
+    bitmap_to_array(meals, indices, count);
+
+    sb_appendf(out, "For %s textures, you might enjoy: ", texture);
+    for (uint32_t i = 0; i < count; i++) {
+        if (i > 0) sb_append_cstr(out, ", ");
+        sb_append_view(out, db->recipes[indices[i]].name);
+    }
+    sb_append_cstr(out, ".\n");
+    free(indices);
+}
+
+static const StringList* find_texture_mapping(const RecipeDB* db, const char* trigger) {
+    const SensoryConsiderations* sensory = &db->sensory_considerations;
+    for (int i = 0; i < sensory->texture_mapping_count; i++) {
+        if (sv_equals(sensory->texture_mappings[i].trigger, sv_from_cstr(trigger))) {
+            return &sensory->texture_mappings[i].alternatives;
         }
-        return result;
     }
+    return NULL;
+}
 
-    switch (type) {
-        case QUERY_INGREDIENTS:
-            result.response = generate_ingredients_response(recipe);
-            break;
-            
-        case QUERY_PREPARATION:
-            result.response = generate_preparation_response(recipe);
-            break;
-            
-        case QUERY_SENSORY:
-            result.response = generate_sensory_response(recipe);
-            break;
-            
-        case QUERY_TIME:
-            result.response = generate_time_response(recipe);
-            break;
-            
-        case QUERY_GENERAL:
-            result.response = generate_general_response(recipe);
-            break;
-            
-        default:
-            result.response = generate_general_response(recipe);
-            break;
+static void answer_texture_query(StringBuilder* out, const RecipeDB* db, const ParsedQuery* query) {
+    size_t start = out->length;
+
+    if (strstr(query->normalized, "smooth")) {
+        append_texture_meals(out, db, "smooth");
     }
-    
-    if (result.response) {
-        result.success = true;
+
+    if (strstr(query->normalized, "soft")) {
+        append_texture_meals(out, db, "soft");
+    }
+
+    if (strstr(query->normalized, "crunchy")) {
+        sb_append_cstr(out, "I notice you mentioned crunchy textures. Some neurodivergent individuals avoid: ");
+        append_joined(out, &db->sensory_considerations.avoidance_triggers[SENSORY_TEXTURE]);
+        sb_append_cstr(out, ".\n");
+
+        const StringList* alternatives = find_texture_mapping(db, "crunchy");
+        if (alternatives) {
+            sb_append_cstr(out, "Instead, you might prefer: ");
+            append_joined(out, alternatives);
+            sb_append_cstr(out, ".\n");
+        }
+    }
+
+    if (out->length == start) {
+        sb_append_cstr(out, "I can help with meal suggestions based on sensory preferences. "
+                            "Try asking about specific textures like 'smooth', 'soft', or 'crunchy'.");
+    }
+}
+
+static void answer_quick_meal_query(StringBuilder* out, const RecipeDB* db) {
+    const int32_t* prep_minutes = db->columns.prep_minutes;
+
+    int found = 0;
+    for (int i = 0; i < db->recipe_count; i++) {
+        if (prep_minutes[i] == RECIPE_MINUTES_UNKNOWN || prep_minutes[i] > 15) continue;
+
+        const Recipe* recipe = &db->recipes[i];
+        sb_appendf(out, "%s%.*s (%d %.*s)",
+                   found == 0 ? "Here are some quick meals: " : ", ",
+                   SV_ARG(recipe->name), recipe->prep_time_duration,
+                   SV_ARG(recipe->prep_time_unit));
+        found++;
+    }
+
+    if (found > 0) {
+        sb_append_cstr(out, ".");
     } else {
-        result.response = str_duplicate("Error generating response.");
-        result.success = false;
+        sb_append_cstr(out, "I don't have any quick meals in my database yet.");
     }
-    
-    return result;
+}
+
+static void answer_executive_query(StringBuilder* out, const RecipeDB* db, const ParsedQuery* query) {
+    if (strstr(query->normalized, "planning")) {
+        sb_append_cstr(out, "For difficulty with planning, consider: ");
+        append_joined(out, &db->executive_strategies[EXECUTIVE_PLANNING]);
+        sb_append_cstr(out, ".");
+    } else if (strstr(query->normalized, "remember") || strstr(query->normalized, "memory")) {
+        sb_append_cstr(out, "For memory challenges, consider: ");
+        append_joined(out, &db->executive_strategies[EXECUTIVE_MEMORY]);
+        sb_append_cstr(out, ".");
+    } else {
+        sb_append_cstr(out, "I can help with executive function challenges. "
+                            "Try asking about 'planning' or 'memory challenges'.");
+    }
+}
+
+bool answer_guidance_query(const RecipeDB* db, const ParsedQuery* query, StringBuilder* out) {
+    static const char* const texture_words[] = { "texture", "sensory", "smooth", "soft", "crunchy" };
+    static const char* const quick_words[] = { "quick", "fast", "time", "minutes" };
+    static const char* const executive_words[] = { "planning", "remember", "executive", "function" };
+
+    if (!db || !query || !query->normalized) return false;
+
+    bool texture = query_mentions_any(query, texture_words, sizeof(texture_words) / sizeof(texture_words[0]));
+    bool quick = !texture && query_mentions_any(query, quick_words, sizeof(quick_words) / sizeof(quick_words[0]));
+    bool executive = !texture && !quick &&
+                     query_mentions_any(query, executive_words, sizeof(executive_words) / sizeof(executive_words[0]));
+    if (!texture && !quick && !executive) return false;
+
+    size_t start = out->length;
+    if (texture) {
+        answer_texture_query(out, db, query);
+    } else if (quick) {
+        answer_quick_meal_query(out, db);
+    } else {
+        answer_executive_query(out, db, query);
+    }
+
+    size_t length = out->length;
+    while (length > start && out->data[length - 1] == '\n') {
+        length--;
+    }
+    sb_truncate(out, length);
+    return true;
 }
 
 void free_query_result(QueryResult* result) {
     if (!result) return;
     
-    free(result->recipe_name);
-    free(result->response);
+    if (!result->borrowed) {
+        free(result->response);
+    }
     
-    result->recipe_name = NULL;
+    result->recipe_name.data = NULL;
+    result->recipe_name.length = 0;
     result->response = NULL;
+    result->response_length = 0;
 }
 
-const char* get_recipe_db_error(RecipeDB* db) {
+const char* get_recipe_db_error(const RecipeDB* db) {
     if (!db) return "Invalid database";
     return db->error_message;
 }
+
+void get_recipe_db_arena_stats(const RecipeDB* db, ArenaStats* stats) {
+    if (!stats) return;
+    if (!db) {
+        memset(stats, 0, sizeof(ArenaStats));
+        return;
+    }
+    arena_get_stats(&db->arena, stats);
+}
+
+SymbolId find_symbol_id(const RecipeDB* db, const char* name) {
+    if (!db || !name) return SYMBOL_NONE;
+    return symbol_table_find(&db->symbols, sv_from_cstr(name));
+}
+
+StringView get_symbol_name(const RecipeDB* db, SymbolId id) {
+    if (!db) {
+        StringView empty = { "", 0 };
+        return empty;
+    }
+    return symbol_table_name(&db->symbols, id);
+}
+
+const SymbolId* get_recipe_attributes(const Recipe* recipe, AttributeKind kind, int* count) {
+    switch (kind) {
+        case ATTRIBUTE_MEAL_TYPE:
+            *count = recipe->meal_type_count;
+            return recipe->meal_type;
+        case ATTRIBUTE_TEXTURE:
+            *count = recipe->sensory_texture_count;
+            return recipe->sensory_texture;
+        case ATTRIBUTE_TEMPERATURE:
+            *count = recipe->sensory_temperature_count;
+            return recipe->sensory_temperature;
+        case ATTRIBUTE_TASTE:
+            *count = recipe->sensory_taste_count;
+            return recipe->sensory_taste;
+        case ATTRIBUTE_SMELL:
+            *count = recipe->sensory_smell_count;
+            return recipe->sensory_smell;
+        default:
+            *count = 0;
+            return NULL;
+    }
+}
+
+/*
+ * Resolve filters to posting bitmaps sorted by ascending cardinality, so
+ * intersections start from the most selective list. Returns false if any
+ * value is unknown, in which case nothing can match.
+ */
+static bool resolve_filters(const RecipeDB* db, const AttributeFilter* filters, int filter_count,
+                            const Bitmap** postings) {
+    for (int i = 0; i < filter_count; i++) {
+        if ((int)filters[i].kind < 0 || (int)filters[i].kind >= ATTRIBUTE_KIND_COUNT) return false;
+        if (!db->attribute_index[filters[i].kind]) return false;
+
+        SymbolId id = find_symbol_id(db, filters[i].value);
+        if (id == SYMBOL_NONE) return false;
+        postings[i] = &db->attribute_index[filters[i].kind][id];
+    }
+
+    for (int i = 1; i < filter_count; i++) {
+        const Bitmap* current = postings[i];
+        uint32_t cardinality = bitmap_cardinality(current);
+        int j = i - 1;
+        while (j >= 0 && bitmap_cardinality(postings[j]) > cardinality) {
+            postings[j + 1] = postings[j];
+            j--;
+        }
+        postings[j + 1] = current;
+    }
+    return true;
+}
+
+/* Intersect postings[0..count) into result; count must be at least 1 */
+static bool intersect_postings(const Bitmap** postings, int count, Bitmap* result) {
+    if (!bitmap_copy(result, postings[0])) return false;
+
+    Bitmap scratch;
+    bitmap_init(&scratch);
+    for (int i = 1; i < count && result->count > 0; i++) {
+        if (!bitmap_and(&scratch, result, postings[i])) {
+            bitmap_free(&scratch);
+            return false;
+        }
+        Bitmap swap = *result;
+        *result = scratch;
+        scratch = swap;
+    }
+    bitmap_free(&scratch);
+    return true;
+}
+
+int count_recipes_with_attributes(const RecipeDB* db, const AttributeFilter* filters, int filter_count) {
+    if (!db) return 0;
+    if (filter_count <= 0) return db->recipe_count;
+
+    const Bitmap* postings[filter_count];
+    if (!resolve_filters(db, filters, filter_count, postings)) return 0;
+
+    if (filter_count == 1) return (int)bitmap_cardinality(postings[0]);
+    if (filter_count == 2) return (int)bitmap_and_cardinality(postings[0], postings[1]);
+
+    Bitmap result;
+    bitmap_init(&result);
+    if (!intersect_postings(postings, filter_count - 1, &result)) return -1;
+
+    int count = (int)bitmap_and_cardinality(&result, postings[filter_count - 1]);
+    bitmap_free(&result);
+    return count;
+}
+
+int find_recipes_with_attributes(const RecipeDB* db, const AttributeFilter* filters, int filter_count,
+                                 int* recipe_indices, int max_results) {
+    if (!db || !recipe_indices || max_results <= 0) return 0;
+
+    if (filter_count <= 0) {
+        int count = db->recipe_count < max_results ? db->recipe_count : max_results;
+        for (int i = 0; i < count; i++) {
+            recipe_indices[i] = i;
+        }
+        return count;
+    }
+
+    const Bitmap* postings[filter_count];
+    if (!resolve_filters(db, filters, filter_count, postings)) return 0;
+
+    Bitmap result;
+    bitmap_init(&result);
+    if (!intersect_postings(postings, filter_count, &result)) return -1;
+
+    int count = (int)bitmap_to_array(&result, (uint32_t*)recipe_indices, (uint32_t)max_results);
+    bitmap_free(&result);
+    return count;
+}
+
+Recipe* find_recipe_by_name(const RecipeDB* db, const char* name) {
+    if (!name) return NULL;
+    return find_recipe_by_name_view(db, sv_from_cstr(name));
+}
+
+Recipe* find_recipe_by_id(const RecipeDB* db, const char* id) {
+    if (!db || !id) return NULL;
+
+    StringView key = sv_from_cstr(id);
+    uint32_t cursor = 0;
+    uint32_t hash = sv_hash(key);
+    int32_t candidate;
+    while ((candidate = hash_index_probe(&db->id_index, hash, &cursor)) != HASH_INDEX_EMPTY) {
+        if (sv_equals(db->recipes[candidate].id, key)) {
+            return &db->recipes[candidate];
+        }
+    }
+    return NULL;
+}
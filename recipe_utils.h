@@ -2,66 +2,298 @@
  * NeuroChef - Recipe Utilities
  * 
  * This header file declares functions for recipe data management and query processing.
+ * 
+ * A loaded RecipeDB is immutable: every function taking a const RecipeDB*
+ * only reads it, so any number of threads may query one database at once as
+ * long as each uses its own builders and parsed queries.
  */
 
 #ifndef RECIPE_UTILS_H
 #define RECIPE_UTILS_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "bitmap.h"
+#include "fuzzy_index.h"
+#include "hash_index.h"
+#include "mapped_file.h"
+#include "string_builder.h"
+#include "string_view.h"
+#include "symbol_table.h"
 
 typedef struct {
-    char* id;
-    char* name;
-    char** meal_type;
+    StringView* items;
+    int count;
+} StringList;
+
+/* Keys of executive_function_support_strategies, in file order */
+typedef enum {
+    EXECUTIVE_PLANNING,
+    EXECUTIVE_INITIATING,
+    EXECUTIVE_MONITORING,
+    EXECUTIVE_SHIFTING,
+    EXECUTIVE_MEMORY,
+    EXECUTIVE_CHALLENGE_COUNT
+} ExecutiveChallenge;
+
+/* Keys of the sensory_considerations trigger and preference maps */
+typedef enum {
+    SENSORY_TEXTURE,
+    SENSORY_SMELL,
+    SENSORY_TASTE,
+    SENSORY_TEMPERATURE,
+    SENSORY_APPEARANCE,
+    SENSORY_DIMENSION_COUNT
+} SensoryDimension;
+
+typedef struct {
+    StringView name;
+    StringView notes;
+    StringList options;
+} Ingredient;
+
+/*
+ * A meal as written in the data file. Responses are rendered from these
+ * records; scans over every recipe read RecipeColumns instead.
+ */
+typedef struct {
+    StringView id;
+    StringView name;
+    SymbolId* meal_type;
     int meal_type_count;
-    char** ingredients;
+    Ingredient* ingredients;
     int ingredients_count;
-    char** preparation_steps;
+    StringView* preparation_steps;
     int preparation_steps_count;
     int prep_time_duration;
-    char* prep_time_unit;
+    StringView prep_time_unit;
     int cook_time_duration;
-    char* cook_time_unit;
-    char* description;
-    char** sensory_texture;
+    StringView cook_time_unit;
+    StringView description;
+    SymbolId* sensory_texture;
     int sensory_texture_count;
-    char** sensory_temperature;
+    SymbolId* sensory_temperature;
     int sensory_temperature_count;
-    char** sensory_taste;
+    SymbolId* sensory_taste;
     int sensory_taste_count;
-    char** sensory_smell;
+    SymbolId* sensory_smell;
     int sensory_smell_count;
+    StringView notes;
+    /* Bit (1u << ExecutiveChallenge) set for each challenge the meal helps with */
+    unsigned int executive_function_support;
 } Recipe;
 
+/* Marks a time whose unit is not recognized */
+#define RECIPE_MINUTES_UNKNOWN (-1)
+
+/*
+ * The per-recipe values that filters and scans compare, one contiguous
+ * array per field indexed like RecipeDB.recipes, so a pass over every
+ * recipe touches a few bytes per recipe rather than whole records. Times
+ * are converted to minutes when the database is loaded.
+ */
+typedef struct {
+    /* Each is RECIPE_MINUTES_UNKNOWN if its unit is not recognized */
+    int32_t* prep_minutes;
+    int32_t* cook_minutes;
+    /* Unknown if either time is */
+    int32_t* total_minutes;
+    /* As Recipe.executive_function_support */
+    uint32_t* executive_function_support;
+} RecipeColumns;
+
+typedef enum {
+    RECIPE_TIME_PREP,
+    RECIPE_TIME_COOK,
+    RECIPE_TIME_TOTAL,
+    RECIPE_TIME_FIELD_COUNT
+} RecipeTimeField;
+
+/*
+ * The recipes whose time is known, ordered by that time and then by
+ * recipe index, so the recipes in a range of times are a contiguous slice
+ * found by binary search.
+ */
+typedef struct {
+    int32_t* minutes;
+    int32_t* recipes;
+    int count;
+} TimeIndex;
+
+typedef struct {
+    StringView trigger;
+    StringList alternatives;
+} TextureMapping;
+
+typedef struct {
+    StringList avoidance_triggers[SENSORY_DIMENSION_COUNT];
+    StringList preferred_profiles[SENSORY_DIMENSION_COUNT];
+    TextureMapping* texture_mappings;
+    int texture_mapping_count;
+} SensoryConsiderations;
+
+typedef struct {
+    StringList dietary_restrictions;
+    StringView allergy_information;
+    StringList preferred_cuisines;
+    StringList time_constraints;
+    StringList available_equipment;
+} CustomizationOptions;
+
+typedef enum {
+    ATTRIBUTE_MEAL_TYPE,
+    ATTRIBUTE_TEXTURE,
+    ATTRIBUTE_TEMPERATURE,
+    ATTRIBUTE_TASTE,
+    ATTRIBUTE_SMELL,
+    ATTRIBUTE_KIND_COUNT
+} AttributeKind;
+
+typedef struct {
+    AttributeKind kind;
+    const char* value;
+} AttributeFilter;
+
 typedef struct {
     Recipe* recipes;
     int recipe_count;
+    RecipeColumns columns;
+    TimeIndex time_index[RECIPE_TIME_FIELD_COUNT];
     char* error_message;
+    /* Distinct for every database loaded by this process */
+    uint32_t version;
+    /* Log each recipe lookup to stdout; on by default */
+    bool verbose;
+    /* Records, symbols and indices live in the mapped snapshot in source,
+       not on the heap (see snapshot.h) */
+    bool from_snapshot;
+    MappedFile source;
+    Arena arena;
+    SymbolTable symbols;
+    /* One posting bitmap of recipe indices per symbol id, per attribute kind */
+    Bitmap* attribute_index[ATTRIBUTE_KIND_COUNT];
+    /* Exact-match lookups: normalized name and id hashes to recipe indices */
+    HashIndex name_index;
+    HashIndex id_index;
+    /* Trigram index over normalized names for typo-tolerant search */
+    FuzzyIndex fuzzy_index;
+    /* Guidance sections shared by all meals */
+    SensoryConsiderations sensory_considerations;
+    StringList executive_strategies[EXECUTIVE_CHALLENGE_COUNT];
+    CustomizationOptions customization;
+    /* Optional pre-rendered responses, see precompute_recipe_responses */
+    char* response_blob;
+    size_t response_blob_size;
+    size_t* response_offsets;
 } RecipeDB;
 
+typedef struct {
+    int recipe_index;
+    int distance;
+    int length_difference;
+    double score;
+} FuzzyMatch;
+
 typedef enum {
     QUERY_INGREDIENTS,
     QUERY_PREPARATION,
     QUERY_SENSORY,
     QUERY_TIME,
     QUERY_GENERAL,
+    /* Asks for the meals meeting some constraints, see recipe_filter.h */
+    QUERY_FILTER,
     QUERY_UNKNOWN
 } QueryType;
 
 typedef struct {
     bool success;
-    char* recipe_name;
+    /* The matched recipe's name, or the name as asked if none matched; that
+       is a view into the parsed query, and empty from process_recipe_query */
+    StringView recipe_name;
+    /* Index of the matched recipe in RecipeDB.recipes, or -1 */
+    int recipe_index;
     QueryType query_type;
     char* response;
+    size_t response_length;
+    /* The response points into a caller's builder or the precomputed table */
+    bool borrowed;
 } QueryResult;
 
+/*
+ * A query classified once per input. Classification reads only the
+ * normalized text, which is owned; the name is a span of it. The original
+ * text must outlive the parsed query.
+ */
+typedef struct {
+    const char* text;
+    /* Lowercased, trimmed, with whitespace runs collapsed to one space */
+    char* normalized;
+    size_t normalized_length;
+    QueryType type;
+    StringView name;
+    /* Asks for ideas or options rather than about one recipe */
+    bool excludes_recipe;
+    /* Asks for meal suggestions, e.g. "what should I eat?" */
+    bool is_suggestion;
+    /* The name is a generic word such as "dinner" or "recipes" */
+    bool is_generic_name;
+} ParsedQuery;
+
 /**
  * Initialize the recipe database by loading and parsing the JSON file
  * 
+ * The file stays mapped for the lifetime of the database; recipe fields are
+ * views into it. Meals in large files are parsed on several threads, see
+ * set_recipe_loader_threads.
+ * 
+ * @param json_path Path to the meal data JSON file
  * @return A pointer to the initialized RecipeDB structure
  */
 RecipeDB* init_recipe_db(const char* json_path);
 
+/**
+ * Initialize the recipe database by streaming the JSON file in chunks
+ * 
+ * Only one meal at a time is held in memory and its strings are copied into
+ * the database, so memory beyond the database itself stays bounded however
+ * large the file is. Slower than init_recipe_db, which maps the whole file;
+ * meant for compiling snapshots of very large catalogs. The database has no
+ * source mapping.
+ * 
+ * @param json_path Path to the meal data JSON file, or "-" for standard input
+ * @return A pointer to the initialized RecipeDB structure
+ */
+RecipeDB* init_recipe_db_streaming(const char* json_path);
+
+/**
+ * Set how many threads init_recipe_db parses meals on
+ * 
+ * Large files are split into meal objects that are parsed concurrently;
+ * the database is the same as with one thread. Call before loading.
+ * 
+ * @param thread_count Number of threads, or 0 for one per processor
+ */
+void set_recipe_loader_threads(int thread_count);
+
+/**
+ * Set how many bytes init_recipe_db_streaming reads at a time
+ * 
+ * The database does not depend on it; small chunks put value and key
+ * boundaries at every offset, which tests use. Call before loading.
+ * 
+ * @param chunk_size Bytes per read, or 0 for JSON_STREAM_CHUNK_SIZE
+ */
+void set_recipe_stream_chunk_size(size_t chunk_size);
+
+/**
+ * Get a version number distinct from every database loaded so far
+ * 
+ * @return The next version, for a newly loaded database
+ */
+uint32_t next_recipe_db_version(void);
+
 /**
  * Free the memory allocated for the recipe database
  * 
@@ -69,6 +301,17 @@ RecipeDB* init_recipe_db(const char* json_path);
  */
 void free_recipe_db(RecipeDB* db);
 
+/**
+ * Render every recipe's response to every query type into one packed blob
+ * 
+ * Afterwards recipe queries return borrowed views into the blob instead of
+ * formatting a fresh response, trading memory for latency.
+ * 
+ * @param db The recipe database
+ * @return true on success, false if the database is invalid or out of memory
+ */
+bool precompute_recipe_responses(RecipeDB* db);
+
 /**
  * Process a recipe query and generate a response
  * 
@@ -76,7 +319,78 @@ void free_recipe_db(RecipeDB* db);
  * @param query The user query string
  * @return A QueryResult structure containing the response
  */
-QueryResult process_recipe_query(RecipeDB* db, const char* query);
+QueryResult process_recipe_query(const RecipeDB* db, const char* query);
+
+/**
+ * Normalize a query the way parse_query does: lowercased, trimmed and with
+ * runs of whitespace collapsed to one space
+ * 
+ * Two queries that normalize alike get the same answer, so the normalized
+ * text can key a response cache without classifying the query.
+ * 
+ * @param query The user query string
+ * @param out The builder to append the normalized text to
+ * @return true on success, false if query is NULL or out of memory
+ */
+bool normalize_query(const char* query, StringBuilder* out);
+
+/**
+ * Parse a query once: normalize it, classify it and locate the recipe name
+ * 
+ * @param query The user query string; it must outlive the parsed query
+ * @param parsed The parsed query to fill in; release it with free_parsed_query
+ * @return true on success, false if query is NULL or allocation failed
+ */
+bool parse_query(const char* query, ParsedQuery* parsed);
+
+/**
+ * Free the memory owned by a parsed query
+ * 
+ * @param parsed The parsed query to free
+ */
+void free_parsed_query(ParsedQuery* parsed);
+
+/**
+ * Check if a parsed query names a specific recipe
+ * 
+ * @param parsed The parsed query
+ * @return true if the query is recipe-specific, false otherwise
+ */
+bool parsed_query_is_recipe(const ParsedQuery* parsed);
+
+/**
+ * Process a parsed recipe query and generate a response
+ * 
+ * @param db The recipe database
+ * @param query The parsed query
+ * @return A QueryResult structure containing the response
+ */
+QueryResult process_parsed_query(const RecipeDB* db, const ParsedQuery* query);
+
+/**
+ * Process a parsed recipe query, rendering the response into a builder
+ * 
+ * The builder is reset first. The response is borrowed: it points into the
+ * builder, or into the precomputed table if there is one, and stays valid
+ * until the builder is next modified.
+ * 
+ * @param db The recipe database
+ * @param query The parsed query
+ * @param out The builder to render into
+ * @return A QueryResult structure containing the response
+ */
+QueryResult render_parsed_query(const RecipeDB* db, const ParsedQuery* query, StringBuilder* out);
+
+/**
+ * Answer a texture, quick-meal or executive-function question from the
+ * guidance sections of the data file, the same way neurochef/logic.py does
+ * 
+ * @param db The recipe database
+ * @param query The parsed query
+ * @param out The builder the response is appended to
+ * @return true if answered, false if the query matches none of these intents
+ */
+bool answer_guidance_query(const RecipeDB* db, const ParsedQuery* query, StringBuilder* out);
 
 /**
  * Free the memory allocated for a query result
@@ -85,6 +399,14 @@ QueryResult process_recipe_query(RecipeDB* db, const char* query);
  */
 void free_query_result(QueryResult* result);
 
+/**
+ * Get a short lowercase name for a query type, e.g. "ingredients"
+ * 
+ * @param type The query type
+ * @return The name, a string literal
+ */
+const char* query_type_name(QueryType type);
+
 /**
  * Check if a query is a recipe-specific query
  * 
@@ -93,13 +415,137 @@ void free_query_result(QueryResult* result);
  */
 bool is_recipe_query(const char* query);
 
+/**
+ * Check if a query asks for meal suggestions rather than about one recipe,
+ * e.g. "what should I eat?" or "what are some soft foods?"
+ * 
+ * @param query The user query string
+ * @return true if the query asks for suggestions
+ */
+bool is_suggestion_query(const char* query);
+
 /**
  * Get the last error message from the recipe database
  * 
  * @param db The recipe database
  * @return The error message or NULL if no error
  */
-const char* get_recipe_db_error(RecipeDB* db);
+const char* get_recipe_db_error(const RecipeDB* db);
+
+/**
+ * Get memory usage statistics for the arena that holds the database's data
+ * 
+ * @param db The recipe database
+ * @param stats Receives the arena statistics (zeroed if db is NULL)
+ */
+void get_recipe_db_arena_stats(const RecipeDB* db, ArenaStats* stats);
+
+/**
+ * Find a recipe by its exact id, e.g. "smoothie_01"
+ * 
+ * @param db The recipe database
+ * @param id The recipe id
+ * @return The recipe, or NULL if no recipe has that id
+ */
+Recipe* find_recipe_by_id(const RecipeDB* db, const char* id);
+
+/**
+ * Find the recipe a user most likely means by a name: an exact match
+ * ignoring case and a leading article, else the closest name within a few
+ * typos, else the closest name containing or contained in it
+ * 
+ * @param db The recipe database
+ * @param name The recipe name as typed by the user
+ * @return The recipe, or NULL if nothing matches
+ */
+Recipe* find_recipe_by_name(const RecipeDB* db, const char* name);
+
+/**
+ * Find the recipes whose names best match a possibly misspelled query
+ * 
+ * Candidates come from a trigram index and are ranked by edit distance to
+ * the closest part of each name, so "berry blast smothie" finds
+ * "Berry Blast Smoothie". Matches allow roughly one typo per five characters.
+ * 
+ * @param db The recipe database
+ * @param query The recipe name as typed by the user
+ * @param matches Receives the best matches, best first; score is 1.0 for an exact match
+ * @param max_matches The capacity of matches (top-k)
+ * @return The number of matches written
+ */
+int fuzzy_search_recipes(const RecipeDB* db, const char* query, FuzzyMatch* matches, int max_matches);
+
+/**
+ * Look up the interned id of a meal type or sensory attribute value
+ * 
+ * @param db The recipe database
+ * @param name The attribute value, e.g. "smooth" or "breakfast"
+ * @return The symbol id, or SYMBOL_NONE if no recipe uses the value
+ */
+SymbolId find_symbol_id(const RecipeDB* db, const char* name);
+
+/**
+ * Get the text of an interned meal type or sensory attribute value
+ * 
+ * @param db The recipe database
+ * @param id The symbol id
+ * @return A view of the value, or an empty view for an unknown id
+ */
+StringView get_symbol_name(const RecipeDB* db, SymbolId id);
+
+/**
+ * Count the recipes that have every given attribute value
+ * 
+ * Each filter is answered from a posting bitmap, so the cost depends on the
+ * size of the smallest posting list rather than on the number of recipes.
+ * 
+ * @param db The recipe database
+ * @param filters The attribute values to match, e.g. {ATTRIBUTE_TEXTURE, "smooth"}
+ * @param filter_count The number of filters (0 matches every recipe)
+ * @return The number of matching recipes, or -1 on allocation failure
+ */
+int count_recipes_with_attributes(const RecipeDB* db, const AttributeFilter* filters, int filter_count);
+
+/**
+ * Find the recipes that have every given attribute value
+ * 
+ * @param db The recipe database
+ * @param filters The attribute values to match
+ * @param filter_count The number of filters (0 matches every recipe)
+ * @param recipe_indices Receives matching indices into db->recipes, in order
+ * @param max_results The capacity of recipe_indices
+ * @return The number of indices written, or -1 on allocation failure
+ */
+int find_recipes_with_attributes(const RecipeDB* db, const AttributeFilter* filters, int filter_count,
+                                 int* recipe_indices, int max_results);
+
+/**
+ * Get the symbol ids a recipe has for one attribute kind
+ * 
+ * @param recipe The recipe
+ * @param kind The attribute kind
+ * @param count Receives the number of ids
+ * @return The ids, or NULL if the recipe has none
+ */
+const SymbolId* get_recipe_attributes(const Recipe* recipe, AttributeKind kind, int* count);
+
+/**
+ * Get the column of one of the recipes' times
+ * 
+ * @param db The recipe database
+ * @param field Which time
+ * @return Minutes per recipe, RECIPE_MINUTES_UNKNOWN where the unit is not recognized
+ */
+const int32_t* get_recipe_time_column(const RecipeDB* db, RecipeTimeField field);
+
+/**
+ * Convert a duration to minutes, rounding seconds up
+ * 
+ * @param duration The duration
+ * @param unit Its unit, e.g. "minutes", "hr" or "days"
+ * @return The minutes, or RECIPE_MINUTES_UNKNOWN if the unit is not recognized
+ */
+int32_t recipe_time_in_minutes(int duration, StringView unit);
 
 /**
  * Convert a string to lowercase
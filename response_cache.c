@@ -0,0 +1,205 @@
+/**
+ * NeuroChef - Response Cache Implementation
+ * 
+ * This file implements the LRU cache as a fixed pool of entries threaded on
+ * a recency list and on per-bucket hash chains.
+ */
+
+#include "response_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_NONE (-1)
+
+static uint32_t cache_key_hash(const char* key, size_t key_length, uint32_t version) {
+    StringView view = { key, key_length };
+    uint32_t hash = sv_hash(view);
+    hash ^= version * 0x85EBCA6Bu;
+    return hash;
+}
+
+static bool entry_matches(const ResponseCacheEntry* entry, uint32_t hash, const char* key,
+                          size_t key_length, uint32_t version) {
+    return entry->hash == hash &&
+           entry->version == version &&
+           entry->key_length == key_length &&
+           memcmp(entry->key, key, key_length) == 0;
+}
+
+static void unlink_recency(ResponseCache* cache, int index) {
+    ResponseCacheEntry* entry = &cache->entries[index];
+    if (entry->prev != CACHE_NONE) {
+        cache->entries[entry->prev].next = entry->next;
+    } else {
+        cache->head = entry->next;
+    }
+    if (entry->next != CACHE_NONE) {
+        cache->entries[entry->next].prev = entry->prev;
+    } else {
+        cache->tail = entry->prev;
+    }
+    entry->prev = CACHE_NONE;
+    entry->next = CACHE_NONE;
+}
+
+static void push_front(ResponseCache* cache, int index) {
+    ResponseCacheEntry* entry = &cache->entries[index];
+    entry->prev = CACHE_NONE;
+    entry->next = cache->head;
+    if (cache->head != CACHE_NONE) {
+        cache->entries[cache->head].prev = index;
+    }
+    cache->head = index;
+    if (cache->tail == CACHE_NONE) {
+        cache->tail = index;
+    }
+}
+
+static void unlink_bucket(ResponseCache* cache, int index) {
+    int* link = &cache->buckets[cache->entries[index].hash & cache->bucket_mask];
+    while (*link != CACHE_NONE && *link != index) {
+        link = &cache->entries[*link].chain;
+    }
+    if (*link == index) {
+        *link = cache->entries[index].chain;
+    }
+}
+
+bool response_cache_init(ResponseCache* cache, int capacity) {
+    memset(cache, 0, sizeof(*cache));
+    if (capacity < 1) capacity = 1;
+
+    /* Keep bucket chains short: at least two buckets per entry */
+    uint32_t bucket_count = 16;
+    while (bucket_count < (uint32_t)capacity * 2) {
+        bucket_count *= 2;
+    }
+
+    cache->entries = (ResponseCacheEntry*)calloc(capacity, sizeof(ResponseCacheEntry));
+    cache->buckets = (int*)malloc(bucket_count * sizeof(int));
+    if (!cache->entries || !cache->buckets) {
+        response_cache_free(cache);
+        return false;
+    }
+
+    cache->bucket_mask = bucket_count - 1;
+    cache->capacity = capacity;
+    cache->head = CACHE_NONE;
+    cache->tail = CACHE_NONE;
+    for (uint32_t i = 0; i < bucket_count; i++) {
+        cache->buckets[i] = CACHE_NONE;
+    }
+    return true;
+}
+
+const ResponseCacheEntry* response_cache_get(ResponseCache* cache, const char* key, size_t key_length,
+                                             uint32_t version) {
+    if (!cache->entries || !key) return NULL;
+
+    uint32_t hash = cache_key_hash(key, key_length, version);
+    int index = cache->buckets[hash & cache->bucket_mask];
+    while (index != CACHE_NONE) {
+        ResponseCacheEntry* entry = &cache->entries[index];
+        if (entry_matches(entry, hash, key, key_length, version)) {
+            if (cache->head != index) {
+                unlink_recency(cache, index);
+                push_front(cache, index);
+            }
+            cache->hits++;
+            return entry;
+        }
+        index = entry->chain;
+    }
+
+    cache->misses++;
+    return NULL;
+}
+
+bool response_cache_put(ResponseCache* cache, const char* key, size_t key_length,
+                        QueryType type, uint32_t version, const char* response,
+                        int32_t recipe_index, bool success) {
+    if (!cache->entries || !key || !response) return false;
+
+    uint32_t hash = cache_key_hash(key, key_length, version);
+    size_t response_length = strlen(response);
+
+    /* One allocation holds the key followed by the response */
+    char* storage = (char*)malloc(key_length + 1 + response_length + 1);
+    if (!storage) return false;
+    memcpy(storage, key, key_length);
+    storage[key_length] = '\0';
+    memcpy(storage + key_length + 1, response, response_length + 1);
+
+    int index = cache->buckets[hash & cache->bucket_mask];
+    while (index != CACHE_NONE &&
+           !entry_matches(&cache->entries[index], hash, key, key_length, version)) {
+        index = cache->entries[index].chain;
+    }
+
+    if (index != CACHE_NONE) {
+        unlink_recency(cache, index);
+        unlink_bucket(cache, index);
+        free(cache->entries[index].key);
+    } else if (cache->count < cache->capacity) {
+        index = cache->count++;
+    } else {
+        index = cache->tail;
+        unlink_recency(cache, index);
+        unlink_bucket(cache, index);
+        free(cache->entries[index].key);
+        cache->evictions++;
+    }
+
+    ResponseCacheEntry* entry = &cache->entries[index];
+    entry->key = storage;
+    entry->key_length = key_length;
+    entry->type = type;
+    entry->version = version;
+    entry->hash = hash;
+    entry->response = storage + key_length + 1;
+    entry->recipe_index = recipe_index;
+    entry->success = success;
+
+    uint32_t bucket = hash & cache->bucket_mask;
+    entry->chain = cache->buckets[bucket];
+    cache->buckets[bucket] = index;
+    push_front(cache, index);
+    return true;
+}
+
+void response_cache_clear(ResponseCache* cache) {
+    if (!cache->entries) return;
+
+    for (int i = 0; i < cache->count; i++) {
+        free(cache->entries[i].key);
+        cache->entries[i].key = NULL;
+        cache->entries[i].response = NULL;
+    }
+    for (uint32_t i = 0; i <= cache->bucket_mask; i++) {
+        cache->buckets[i] = CACHE_NONE;
+    }
+    cache->count = 0;
+    cache->head = CACHE_NONE;
+    cache->tail = CACHE_NONE;
+}
+
+ResponseCacheStats response_cache_get_stats(const ResponseCache* cache) {
+    ResponseCacheStats stats;
+    stats.hits = cache->hits;
+    stats.misses = cache->misses;
+    stats.evictions = cache->evictions;
+    stats.entry_count = cache->count;
+    stats.capacity = cache->capacity;
+    return stats;
+}
+
+void response_cache_free(ResponseCache* cache) {
+    if (cache->entries) {
+        for (int i = 0; i < cache->count; i++) {
+            free(cache->entries[i].key);
+        }
+    }
+    free(cache->entries);
+    free(cache->buckets);
+    memset(cache, 0, sizeof(*cache));
+}
@@ -0,0 +1,120 @@
+/**
+ * NeuroChef - Response Cache
+ * 
+ * This header declares a bounded least-recently-used cache of chatbot
+ * responses. Entries are keyed by the normalized query text and the version
+ * of the dataset that produced them, so reloading the data never serves a
+ * stale answer. The query type is stored with the response rather than
+ * keyed on, so a hit needs no classification. That is only sound because
+ * answers depend on nothing but the key: parse_query classifies the
+ * normalized text, never the raw input. The cache is not thread-safe.
+ */
+
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "recipe_utils.h"
+
+typedef struct {
+    char* key;
+    size_t key_length;
+    QueryType type;
+    uint32_t version;
+    uint32_t hash;
+    char* response;
+    /* The recipe the response is about, or -1 */
+    int32_t recipe_index;
+    bool success;
+    /* Recency list, most recently used first */
+    int prev;
+    int next;
+    /* Next entry in the same hash bucket */
+    int chain;
+} ResponseCacheEntry;
+
+typedef struct {
+    ResponseCacheEntry* entries;
+    int* buckets;
+    uint32_t bucket_mask;
+    int capacity;
+    int count;
+    int head;
+    int tail;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} ResponseCache;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    int entry_count;
+    int capacity;
+} ResponseCacheStats;
+
+/**
+ * Allocate an empty cache
+ * 
+ * @param cache The cache to initialize
+ * @param capacity The maximum number of responses to keep
+ * @return true on success, false if out of memory
+ */
+bool response_cache_init(ResponseCache* cache, int capacity);
+
+/**
+ * Look up a cached response and mark it as recently used
+ * 
+ * @param cache The cache
+ * @param key The normalized query text
+ * @param key_length Length of the key in bytes
+ * @param version The dataset version the response must come from
+ * @return The cached entry, owned by the cache and valid until the next
+ *         put or clear, or NULL on a miss
+ */
+const ResponseCacheEntry* response_cache_get(ResponseCache* cache, const char* key, size_t key_length,
+                                             uint32_t version);
+
+/**
+ * Store a copy of a response, evicting the least recently used entry if full
+ * 
+ * @param cache The cache
+ * @param key The normalized query text
+ * @param key_length Length of the key in bytes
+ * @param type The query type, returned with the response on a hit
+ * @param version The dataset version that produced the response
+ * @param response The response to copy into the cache
+ * @param recipe_index The recipe the response is about, or -1
+ * @param success Whether the response answered the query
+ * @return true if the response was stored, false if out of memory
+ */
+bool response_cache_put(ResponseCache* cache, const char* key, size_t key_length,
+                        QueryType type, uint32_t version, const char* response,
+                        int32_t recipe_index, bool success);
+
+/**
+ * Drop every entry, e.g. after the dataset is reloaded; counters are kept
+ * 
+ * @param cache The cache
+ */
+void response_cache_clear(ResponseCache* cache);
+
+/**
+ * Get hit, miss and eviction counters
+ * 
+ * @param cache The cache
+ * @return The current statistics
+ */
+ResponseCacheStats response_cache_get_stats(const ResponseCache* cache);
+
+/**
+ * Free the memory owned by a cache
+ * 
+ * @param cache The cache to free
+ */
+void response_cache_free(ResponseCache* cache);
+
+#endif /* RESPONSE_CACHE_H */
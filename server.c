@@ -0,0 +1,899 @@
+/**
+ * NeuroChef - Server Implementation
+ * 
+ * This file implements the epoll event loop, the line and HTTP/1.1
+ * framings, and the worker threads that answer Python fallback queries.
+ * Workers hand finished jobs back through a completion list and wake the
+ * loop with an eventfd.
+ */
+
+#include "server.h"
+#include <stdio.h>
+
+#ifdef __linux__
+
+#include "query_context.h"
+#include "string_builder.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define SERVER_MAX_EVENTS 64
+#define SERVER_BACKLOG 128
+#define SERVER_READ_CHUNK 4096
+/* Largest request line, header block or body a client may send */
+#define SERVER_MAX_REQUEST (64 * 1024)
+/* Stop reading requests from a client that is not reading its answers */
+#define SERVER_MAX_PENDING_OUTPUT (1024 * 1024)
+
+typedef enum {
+    PROTOCOL_UNKNOWN,
+    PROTOCOL_LINE,
+    PROTOCOL_HTTP
+} Protocol;
+
+typedef struct Connection {
+    int fd;
+    Protocol protocol;
+    StringBuilder input;
+    size_t input_start;     /* Bytes of input already consumed */
+    StringBuilder output;
+    size_t output_sent;     /* Bytes of output already sent */
+    uint32_t events;        /* The epoll mask currently registered */
+    bool busy;              /* A worker is answering this connection's query */
+    bool peer_closed;       /* The client will send nothing more */
+    bool closing;           /* Close once the output is sent */
+    struct Connection* prev;
+    struct Connection* next;
+} Connection;
+
+typedef struct Job {
+    struct Job* next;
+    Connection* connection;
+    char* query;
+    bool keep_alive;
+    struct timespec start;
+    StringBuilder record;
+} Job;
+
+typedef struct {
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;
+    const char* unix_path;
+    RecipeStore* store;
+    QueryContext context;
+    Connection* connections;
+    /* Closed connections, freed once the current batch of events is done */
+    Connection* closed;
+    /* Scratch for decoded queries and the records rendered on the loop */
+    StringBuilder query;
+    StringBuilder record;
+
+    pthread_mutex_t lock;
+    pthread_cond_t job_ready;
+    Job* pending_head;
+    Job* pending_tail;
+    Job* done_head;
+    Job* done_tail;
+    bool stopping;
+    pthread_t* workers;
+    QueryContext* worker_contexts;
+    int worker_count;
+} Server;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_stop_signal(int signal_number) {
+    (void)signal_number;
+    stop_requested = 1;
+}
+
+static long long elapsed_ns(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)(now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec);
+}
+
+static bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/* ---- Listening ---------------------------------------------------------- */
+
+static int listen_unix(Server* server, const char* path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+
+    /* Replace a socket left behind by an earlier run, but nothing else */
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    server->unix_path = path;
+    return fd;
+}
+
+static int listen_tcp(const char* address) {
+    char host[256] = "127.0.0.1";
+    const char* port = address;
+    const char* colon = strrchr(address, ':');
+    if (colon) {
+        size_t host_length = (size_t)(colon - address);
+        if (host_length >= sizeof(host)) return -1;
+        memcpy(host, address, host_length);
+        host[host_length] = '\0';
+        port = colon + 1;
+    }
+
+    struct addrinfo hints;
+    struct addrinfo* results;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, port, &hints, &results) != 0) return -1;
+
+    int fd = -1;
+    for (struct addrinfo* result = results; result; result = result->ai_next) {
+        fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+        if (fd < 0) continue;
+
+        int enable = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        if (bind(fd, result->ai_addr, result->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(results);
+    return fd;
+}
+
+static int open_listener(Server* server, const char* address) {
+    int fd;
+    if (strchr(address, '/')) {
+        const char* path = strncmp(address, "unix:", 5) == 0 ? address + 5 : address;
+        fd = listen_unix(server, path);
+    } else {
+        fd = listen_tcp(address);
+    }
+    if (fd < 0) return -1;
+
+    if (listen(fd, SERVER_BACKLOG) != 0 || !set_nonblocking(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* ---- Connections -------------------------------------------------------- */
+
+static void update_events(Server* server, Connection* connection) {
+    uint32_t events = EPOLLOUT;
+    if (connection->output_sent == connection->output.length) {
+        events = connection->peer_closed ? 0 : EPOLLIN;
+    }
+    if (events != connection->events) {
+        struct epoll_event event;
+        event.events = events;
+        event.data.ptr = connection;
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->events = events;
+    }
+}
+
+static void free_connection(Connection* connection) {
+    sb_free(&connection->input);
+    sb_free(&connection->output);
+    free(connection);
+}
+
+/* Queue a closed connection to be freed; later events may still name it */
+static void retire_connection(Server* server, Connection* connection) {
+    connection->next = server->closed;
+    server->closed = connection;
+}
+
+static void free_closed_connections(Server* server) {
+    while (server->closed) {
+        Connection* next = server->closed->next;
+        free_connection(server->closed);
+        server->closed = next;
+    }
+}
+
+/* Close the socket now; the memory goes once no worker refers to it */
+static void close_connection(Server* server, Connection* connection) {
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    connection->fd = -1;
+
+    if (connection->prev) {
+        connection->prev->next = connection->next;
+    } else {
+        server->connections = connection->next;
+    }
+    if (connection->next) {
+        connection->next->prev = connection->prev;
+    }
+
+    if (!connection->busy) {
+        retire_connection(server, connection);
+    }
+}
+
+static void accept_connections(Server* server) {
+    for (;;) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) return;
+
+        Connection* connection = (Connection*)calloc(1, sizeof(Connection));
+        if (!connection || !set_nonblocking(fd)) {
+            free(connection);
+            close(fd);
+            continue;
+        }
+        int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        sb_init(&connection->input);
+        sb_init(&connection->output);
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            free_connection(connection);
+            close(fd);
+            continue;
+        }
+
+        connection->next = server->connections;
+        if (server->connections) {
+            server->connections->prev = connection;
+        }
+        server->connections = connection;
+    }
+}
+
+/* ---- Responses ---------------------------------------------------------- */
+
+static void send_answer(Connection* connection, const char* body, size_t length, bool keep_alive) {
+    if (connection->protocol == PROTOCOL_HTTP) {
+        sb_appendf(&connection->output,
+                   "HTTP/1.1 200 OK\r\n"
+                   "Content-Type: application/json\r\n"
+                   "Content-Length: %zu\r\n"
+                   "Connection: %s\r\n\r\n",
+                   length, keep_alive ? "keep-alive" : "close");
+    }
+    sb_append(&connection->output, body, length);
+    if (!keep_alive) {
+        connection->closing = true;
+    }
+}
+
+static void send_error(Connection* connection, const char* status, const char* message) {
+    if (connection->protocol == PROTOCOL_HTTP) {
+        sb_appendf(&connection->output,
+                   "HTTP/1.1 %s\r\n"
+                   "Content-Type: text/plain\r\n"
+                   "Content-Length: %zu\r\n"
+                   "Connection: close\r\n\r\n%s",
+                   status, strlen(message), message);
+    } else {
+        sb_appendf(&connection->output, "{\"error\":\"%s\"}\n", message);
+    }
+    connection->closing = true;
+}
+
+/* Send as much output as the socket takes; false if the connection closed */
+static bool flush_output(Server* server, Connection* connection) {
+    while (connection->output_sent < connection->output.length) {
+        ssize_t sent = send(connection->fd, connection->output.data + connection->output_sent,
+                            connection->output.length - connection->output_sent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            close_connection(server, connection);
+            return false;
+        }
+        connection->output_sent += (size_t)sent;
+    }
+
+    if (connection->output_sent == connection->output.length) {
+        sb_reset(&connection->output);
+        connection->output_sent = 0;
+        if (connection->output.failed) {
+            close_connection(server, connection);
+            return false;
+        }
+        if (connection->closing || (connection->peer_closed && !connection->busy)) {
+            close_connection(server, connection);
+            return false;
+        }
+    }
+    update_events(server, connection);
+    return true;
+}
+
+/* ---- Queries ------------------------------------------------------------ */
+
+static void answer_query(Server* server, Connection* connection, const char* query, bool keep_alive) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    ResponseInfo info;
+    const char* response = query_context_respond(&server->context, query, &info);
+    if (response) {
+        sb_reset(&server->record);
+        append_response_json(&server->record, server->context.db, query, &info, response,
+                             elapsed_ns(&start));
+        query_context_release(&server->context);
+        send_answer(connection, server->record.data, server->record.length, keep_alive);
+        return;
+    }
+    query_context_release(&server->context);
+
+    /* Only Python can answer this one; let a worker wait for it */
+    Job* job = (Job*)calloc(1, sizeof(Job));
+    char* copy = job ? strdup(query) : NULL;
+    if (!copy) {
+        free(job);
+        send_error(connection, "500 Internal Server Error", "out of memory");
+        return;
+    }
+    job->connection = connection;
+    job->query = copy;
+    job->keep_alive = keep_alive;
+    job->start = start;
+    sb_init(&job->record);
+    connection->busy = true;
+
+    pthread_mutex_lock(&server->lock);
+    if (server->pending_tail) {
+        server->pending_tail->next = job;
+    } else {
+        server->pending_head = job;
+    }
+    server->pending_tail = job;
+    pthread_cond_signal(&server->job_ready);
+    pthread_mutex_unlock(&server->lock);
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* Decode a URL query-string value into the builder */
+static void append_url_decoded(StringBuilder* out, const char* text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        if (c == '+') {
+            c = ' ';
+        } else if (c == '%' && i + 2 < length && hex_value(text[i + 1]) >= 0 && hex_value(text[i + 2]) >= 0) {
+            c = (char)(hex_value(text[i + 1]) * 16 + hex_value(text[i + 2]));
+            i += 2;
+        }
+        sb_append(out, &c, 1);
+    }
+}
+
+/* Find the value of the q parameter in a request target */
+static bool find_query_parameter(const char* target, size_t length, const char** value, size_t* value_length) {
+    const char* question = memchr(target, '?', length);
+    if (!question) return false;
+
+    const char* p = question + 1;
+    const char* end = target + length;
+    while (p < end) {
+        const char* separator = memchr(p, '&', (size_t)(end - p));
+        const char* parameter_end = separator ? separator : end;
+        if (parameter_end - p >= 2 && p[0] == 'q' && p[1] == '=') {
+            *value = p + 2;
+            *value_length = (size_t)(parameter_end - p - 2);
+            return true;
+        }
+        p = parameter_end + 1;
+    }
+    return false;
+}
+
+static bool header_equals(const char* line, size_t length, const char* name, const char** value, size_t* value_length) {
+    size_t name_length = strlen(name);
+    if (length <= name_length || line[name_length] != ':' || strncasecmp(line, name, name_length) != 0) {
+        return false;
+    }
+    const char* p = line + name_length + 1;
+    const char* end = line + length;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+    *value = p;
+    *value_length = (size_t)(end - p);
+    return true;
+}
+
+static bool value_contains(const char* value, size_t length, const char* token) {
+    size_t token_length = strlen(token);
+    for (size_t i = 0; i + token_length <= length; i++) {
+        if (strncasecmp(value + i, token, token_length) == 0) return true;
+    }
+    return false;
+}
+
+/*
+ * Handle one HTTP request from the start of the unread input. Returns the
+ * bytes it used, or 0 if the request is not complete yet.
+ */
+static size_t handle_http_request(Server* server, Connection* connection, const char* data, size_t length) {
+    const char* header_end = NULL;
+    size_t header_length = 0;
+    for (size_t i = 0; i + 1 < length; i++) {
+        if (data[i] == '\n' && (data[i + 1] == '\n' || (data[i + 1] == '\r' && i + 2 < length && data[i + 2] == '\n'))) {
+            header_end = data + i;
+            header_length = i + (data[i + 1] == '\n' ? 2 : 3);
+            break;
+        }
+    }
+    if (!header_end) {
+        if (length > SERVER_MAX_REQUEST) {
+            send_error(connection, "431 Request Header Fields Too Large", "request headers too large");
+        }
+        return 0;
+    }
+
+    /* Request line: METHOD SP target SP version */
+    const char* line_end = memchr(data, '\n', length);
+    const char* method_end = memchr(data, ' ', (size_t)(line_end - data));
+    const char* target = method_end ? method_end + 1 : NULL;
+    const char* target_end = target ? memchr(target, ' ', (size_t)(line_end - target)) : NULL;
+    if (!target_end) {
+        send_error(connection, "400 Bad Request", "malformed request line");
+        return header_length;
+    }
+    size_t method_length = (size_t)(method_end - data);
+    size_t target_length = (size_t)(target_end - target);
+    bool keep_alive = strncmp(target_end + 1, "HTTP/1.0", 8) != 0;
+
+    size_t content_length = 0;
+    const char* line = line_end + 1;
+    while (line < header_end) {
+        const char* next = memchr(line, '\n', (size_t)(header_end + 1 - line));
+        size_t line_length = (size_t)(next - line);
+        const char* value;
+        size_t value_length;
+        if (header_equals(line, line_length, "Content-Length", &value, &value_length)) {
+            content_length = (size_t)strtoul(value, NULL, 10);
+        } else if (header_equals(line, line_length, "Connection", &value, &value_length)) {
+            if (value_contains(value, value_length, "close")) keep_alive = false;
+            if (value_contains(value, value_length, "keep-alive")) keep_alive = true;
+        }
+        line = next + 1;
+    }
+
+    if (content_length > SERVER_MAX_REQUEST) {
+        send_error(connection, "413 Payload Too Large", "query too large");
+        return length;
+    }
+    if (length - header_length < content_length) {
+        return 0;
+    }
+    size_t used = header_length + content_length;
+
+    size_t path_length = target_length;
+    const char* question = memchr(target, '?', target_length);
+    if (question) path_length = (size_t)(question - target);
+    if (path_length != 6 || strncmp(target, "/query", 6) != 0) {
+        send_error(connection, "404 Not Found", "use /query");
+        return used;
+    }
+
+    sb_reset(&server->query);
+    if (method_length == 4 && strncmp(data, "POST", 4) == 0) {
+        sb_append(&server->query, data + header_length, content_length);
+    } else if (method_length == 3 && strncmp(data, "GET", 3) == 0) {
+        const char* value;
+        size_t value_length;
+        if (!find_query_parameter(target, target_length, &value, &value_length)) {
+            send_error(connection, "400 Bad Request", "missing q parameter");
+            return used;
+        }
+        append_url_decoded(&server->query, value, value_length);
+    } else {
+        send_error(connection, "405 Method Not Allowed", "use GET or POST");
+        return used;
+    }
+
+    answer_query(server, connection, sb_cstr(&server->query), keep_alive);
+    return used;
+}
+
+/* The first line of a connection decides its framing */
+static Protocol detect_protocol(const char* line, size_t length) {
+    static const char* const methods[] = { "GET ", "POST ", "HEAD ", "PUT ", "DELETE ", "OPTIONS " };
+    while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == '\n')) length--;
+
+    if (length < 8 || strncmp(line + length - 8, "HTTP/1.", 7) != 0) return PROTOCOL_LINE;
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (strncmp(line, methods[i], strlen(methods[i])) == 0) return PROTOCOL_HTTP;
+    }
+    return PROTOCOL_LINE;
+}
+
+/* Answer every complete request in the input, stopping at one sent to a worker */
+static void process_input(Server* server, Connection* connection) {
+    while (!connection->busy && !connection->closing &&
+           connection->output.length - connection->output_sent < SERVER_MAX_PENDING_OUTPUT) {
+        char* data = connection->input.data + connection->input_start;
+        size_t length = connection->input.length - connection->input_start;
+        char* newline = length > 0 ? (char*)memchr(data, '\n', length) : NULL;
+
+        if (connection->protocol == PROTOCOL_UNKNOWN) {
+            if (!newline) {
+                if (length > SERVER_MAX_REQUEST) {
+                    connection->protocol = PROTOCOL_LINE;
+                    send_error(connection, "", "request too large");
+                }
+                break;
+            }
+            connection->protocol = detect_protocol(data, (size_t)(newline - data));
+        }
+
+        if (connection->protocol == PROTOCOL_HTTP) {
+            size_t used = handle_http_request(server, connection, data, length);
+            if (used == 0) break;
+            connection->input_start += used;
+            continue;
+        }
+
+        if (!newline) {
+            if (length > SERVER_MAX_REQUEST) {
+                send_error(connection, "", "request too large");
+            }
+            break;
+        }
+        connection->input_start += (size_t)(newline - data) + 1;
+
+        /* The query ends at the newline, which becomes its terminator */
+        *newline = '\0';
+        if (newline > data && newline[-1] == '\r') newline[-1] = '\0';
+        if (data[0] == '\0') continue;
+        answer_query(server, connection, data, true);
+    }
+
+    /* Drop consumed input in one move rather than once per request */
+    if (connection->input_start > 0) {
+        sb_drop_prefix(&connection->input, connection->input_start);
+        connection->input_start = 0;
+    }
+}
+
+static void read_input(Server* server, Connection* connection) {
+    for (;;) {
+        if (!sb_reserve(&connection->input, SERVER_READ_CHUNK)) {
+            close_connection(server, connection);
+            return;
+        }
+        ssize_t received = recv(connection->fd, connection->input.data + connection->input.length,
+                                connection->input.capacity - connection->input.length - 1, 0);
+        if (received > 0) {
+            connection->input.length += (size_t)received;
+            connection->input.data[connection->input.length] = '\0';
+            continue;
+        }
+        if (received == 0) {
+            connection->peer_closed = true;
+            break;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        close_connection(server, connection);
+        return;
+    }
+
+    process_input(server, connection);
+    flush_output(server, connection);
+}
+
+/* ---- Workers ------------------------------------------------------------ */
+
+typedef struct {
+    Server* server;
+    int index;
+} WorkerStart;
+
+static void* worker_main(void* argument) {
+    WorkerStart* start = (WorkerStart*)argument;
+    Server* server = start->server;
+    QueryContext* context = &server->worker_contexts[start->index];
+    free(start);
+
+    for (;;) {
+        pthread_mutex_lock(&server->lock);
+        while (!server->stopping && !server->pending_head) {
+            pthread_cond_wait(&server->job_ready, &server->lock);
+        }
+        if (server->stopping) {
+            pthread_mutex_unlock(&server->lock);
+            break;
+        }
+        Job* job = server->pending_head;
+        server->pending_head = job->next;
+        if (!server->pending_head) server->pending_tail = NULL;
+        job->next = NULL;
+        pthread_mutex_unlock(&server->lock);
+
+        ResponseInfo info;
+        const char* response = query_context_respond(context, job->query, &info);
+        append_response_json(&job->record, context->db, job->query, &info, response, elapsed_ns(&job->start));
+        query_context_release(context);
+
+        pthread_mutex_lock(&server->lock);
+        if (server->done_tail) {
+            server->done_tail->next = job;
+        } else {
+            server->done_head = job;
+        }
+        server->done_tail = job;
+        pthread_mutex_unlock(&server->lock);
+
+        uint64_t one = 1;
+        ssize_t written = write(server->wake_fd, &one, sizeof(one));
+        (void)written;
+    }
+    return NULL;
+}
+
+static void free_job(Job* job) {
+    free(job->query);
+    sb_free(&job->record);
+    free(job);
+}
+
+static void finish_jobs(Server* server) {
+    uint64_t count;
+    ssize_t got = read(server->wake_fd, &count, sizeof(count));
+    (void)got;
+
+    pthread_mutex_lock(&server->lock);
+    Job* job = server->done_head;
+    server->done_head = NULL;
+    server->done_tail = NULL;
+    pthread_mutex_unlock(&server->lock);
+
+    while (job) {
+        Job* next = job->next;
+        Connection* connection = job->connection;
+        connection->busy = false;
+
+        if (connection->fd < 0) {
+            /* The client went away while the worker was busy */
+            retire_connection(server, connection);
+        } else {
+            if (job->record.failed) {
+                send_error(connection, "500 Internal Server Error", "out of memory");
+            } else {
+                send_answer(connection, job->record.data, job->record.length, job->keep_alive);
+            }
+            process_input(server, connection);
+            flush_output(server, connection);
+        }
+        free_job(job);
+        job = next;
+    }
+}
+
+static bool start_workers(Server* server, int worker_count, int cache_capacity) {
+    if (worker_count < 1) worker_count = 1;
+
+    server->workers = (pthread_t*)malloc((size_t)worker_count * sizeof(pthread_t));
+    server->worker_contexts = (QueryContext*)malloc((size_t)worker_count * sizeof(QueryContext));
+    if (!server->workers || !server->worker_contexts) return false;
+
+    for (int i = 0; i < worker_count; i++) {
+        query_context_init(&server->worker_contexts[i], server->store, cache_capacity);
+        WorkerStart* start = (WorkerStart*)malloc(sizeof(WorkerStart));
+        if (!start) break;
+        start->server = server;
+        start->index = i;
+        if (pthread_create(&server->workers[i], NULL, worker_main, start) != 0) {
+            free(start);
+            query_context_free(&server->worker_contexts[i]);
+            break;
+        }
+        server->worker_count++;
+    }
+    return server->worker_count > 0;
+}
+
+static void stop_workers(Server* server) {
+    pthread_mutex_lock(&server->lock);
+    server->stopping = true;
+    pthread_cond_broadcast(&server->job_ready);
+    pthread_mutex_unlock(&server->lock);
+
+    for (int i = 0; i < server->worker_count; i++) {
+        pthread_join(server->workers[i], NULL);
+        query_context_free(&server->worker_contexts[i]);
+    }
+    free(server->workers);
+    free(server->worker_contexts);
+
+    /* Jobs nobody will finish; their connections are freed below */
+    Job* lists[2] = { server->pending_head, server->done_head };
+    for (int i = 0; i < 2; i++) {
+        Job* job = lists[i];
+        while (job) {
+            Job* next = job->next;
+            if (job->connection->fd < 0) {
+                retire_connection(server, job->connection);
+            } else {
+                job->connection->busy = false;
+            }
+            free_job(job);
+            job = next;
+        }
+    }
+}
+
+/* ---- Event loop --------------------------------------------------------- */
+
+int server_run(const ServerOptions* options) {
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.store = options->store;
+    server.epoll_fd = -1;
+    server.wake_fd = -1;
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.job_ready, NULL);
+    sb_init(&server.query);
+    sb_init(&server.record);
+    query_context_init(&server.context, options->store, options->cache_capacity);
+    server.context.defer_python = true;
+
+    /* Signals are only delivered inside epoll_pwait, and never to workers */
+    sigset_t stop_signals, loop_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &loop_mask);
+    sigdelset(&loop_mask, SIGINT);
+    sigdelset(&loop_mask, SIGTERM);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_stop_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int result = -1;
+    server.listen_fd = open_listener(&server, options->address);
+    if (server.listen_fd < 0) {
+        fprintf(stderr, "Failed to listen on %s: %s\n", options->address, strerror(errno));
+        goto cleanup;
+    }
+
+    server.epoll_fd = epoll_create1(0);
+    server.wake_fd = eventfd(0, EFD_NONBLOCK);
+    if (server.epoll_fd < 0 || server.wake_fd < 0) {
+        fprintf(stderr, "Failed to start the event loop: %s\n", strerror(errno));
+        goto cleanup;
+    }
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = &server.listen_fd;
+    epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, server.listen_fd, &event);
+    event.data.ptr = &server.wake_fd;
+    epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, server.wake_fd, &event);
+
+    if (!start_workers(&server, options->worker_count, options->cache_capacity)) {
+        fprintf(stderr, "Failed to start worker threads\n");
+        goto cleanup;
+    }
+
+    printf("Serving on %s with %d worker threads\n", options->address, server.worker_count);
+    fflush(stdout);
+
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!stop_requested) {
+        int count = epoll_pwait(server.epoll_fd, events, SERVER_MAX_EVENTS, -1, &loop_mask);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Event loop failed: %s\n", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            void* source = events[i].data.ptr;
+            if (source == &server.listen_fd) {
+                accept_connections(&server);
+            } else if (source == &server.wake_fd) {
+                finish_jobs(&server);
+            } else {
+                Connection* connection = (Connection*)source;
+                /* An earlier event in this batch may have closed it */
+                if (connection->fd < 0) continue;
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    /* Both directions are gone, so no answer can be delivered */
+                    close_connection(&server, connection);
+                } else if (events[i].events & EPOLLIN) {
+                    read_input(&server, connection);
+                } else if (events[i].events & EPOLLOUT) {
+                    if (flush_output(&server, connection)) {
+                        process_input(&server, connection);
+                        flush_output(&server, connection);
+                    }
+                }
+            }
+        }
+        free_closed_connections(&server);
+    }
+    result = 0;
+    printf("Server stopped\n");
+
+cleanup:
+    if (server.workers) {
+        stop_workers(&server);
+    }
+    while (server.connections) {
+        close_connection(&server, server.connections);
+    }
+    free_closed_connections(&server);
+    if (server.listen_fd >= 0) {
+        close(server.listen_fd);
+        if (server.unix_path) unlink(server.unix_path);
+    }
+    if (server.wake_fd >= 0) close(server.wake_fd);
+    if (server.epoll_fd >= 0) close(server.epoll_fd);
+    query_context_free(&server.context);
+    sb_free(&server.query);
+    sb_free(&server.record);
+    pthread_cond_destroy(&server.job_ready);
+    pthread_mutex_destroy(&server.lock);
+    pthread_sigmask(SIG_SETMASK, &loop_mask, NULL);
+    return result;
+}
+
+#else
+
+int server_run(const ServerOptions* options) {
+    fprintf(stderr, "Cannot serve %s: server mode needs epoll and is only available on Linux\n",
+            options->address);
+    return -1;
+}
+
+#endif /* __linux__ */
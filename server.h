@@ -0,0 +1,48 @@
+/**
+ * NeuroChef - Server
+ * 
+ * This header declares the --serve mode: one event loop that accepts many
+ * client connections on a Unix domain socket or a TCP port and answers
+ * their queries from one shared RecipeStore, so the recipes can be reloaded
+ * while serving.
+ * 
+ * Two framings are accepted on the same socket, chosen by each
+ * connection's first line:
+ *   - Line mode: every newline-terminated line is a query, and every
+ *     answer is one line of JSON in the format written by --batch.
+ *   - HTTP/1.1: GET /query?q=<text> or POST /query with the query as the
+ *     body. The JSON answer is the response body; keep-alive is supported.
+ * 
+ * Queries answered in C run on the event loop. Queries that fall back to
+ * the Python module are handed to worker threads so they never block it.
+ * A connection's answers are always sent in the order it asked.
+ * 
+ * The event loop uses epoll, so serving is available on Linux only.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdbool.h>
+#include "recipe_store.h"
+
+typedef struct {
+    /* A Unix socket path (anything containing '/'), or [host:]port for TCP;
+       a bare port listens on 127.0.0.1 */
+    const char* address;
+    RecipeStore* store;
+    /* Threads that answer Python fallback queries */
+    int worker_count;
+    /* Responses cached by the event loop and by each worker */
+    int cache_capacity;
+} ServerOptions;
+
+/**
+ * Serve queries until SIGINT or SIGTERM
+ * 
+ * @param options Where to listen and what to answer from
+ * @return 0 after a clean shutdown, -1 if the server could not start
+ */
+int server_run(const ServerOptions* options);
+
+#endif /* SERVER_H */
@@ -0,0 +1,876 @@
+/**
+ * NeuroChef - Recipe Snapshots Implementation
+ * 
+ * This file implements writing and loading snapshots of a RecipeDB.
+ * 
+ * A snapshot is a header followed by one image: the RecipeDB structure,
+ * then every array and string it points to, then the relocation table.
+ * Each pointer in the image holds the preferred base address plus the
+ * offset of its target, and the relocation table lists the offset of every
+ * such pointer. Strings are stored once no matter how many views share
+ * them.
+ */
+
+#include "snapshot.h"
+#include "string_builder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define SNAPSHOT_MAGIC "NCDBSNAP"
+#define SNAPSHOT_FORMAT_VERSION 3
+#define SNAPSHOT_ALIGNMENT 16
+#define SNAPSHOT_STRING_TABLE_INITIAL 1024
+
+#define HASH_PRIME_1 0x9E3779B185EBCA87ULL
+#define HASH_PRIME_2 0xC2B2AE3D27D4EB4FULL
+#define HASH_PRIME_3 0x165667B19E3779F9ULL
+#define HASH_FILE_CHUNK_SIZE (1024 * 1024)
+
+typedef struct {
+    char magic[8];
+    uint32_t format_version;
+    uint32_t header_size;
+    /* Hash of the sizes and offsets of every structure in the image */
+    uint64_t layout;
+    uint64_t image_size;
+    uint64_t preferred_base;
+    uint64_t db_offset;
+    uint64_t relocation_offset;
+    uint64_t relocation_count;
+    /* The JSON file the snapshot was compiled from */
+    uint64_t source_size;
+    int64_t source_mtime_sec;
+    int64_t source_mtime_nsec;
+    uint64_t source_hash;
+    /* Hash of everything after the header, before relocation */
+    uint64_t payload_checksum;
+    /* Hash of the header with this field zeroed */
+    uint64_t header_checksum;
+} SnapshotHeader;
+
+typedef struct {
+    StringBuilder image;
+    uint64_t* relocations;
+    size_t relocation_count;
+    size_t relocation_capacity;
+    /* Open-addressed table of image offsets + 1 of the strings written so far */
+    size_t* strings;
+    size_t string_mask;
+    size_t string_count;
+    bool failed;
+} ImageWriter;
+
+/* ===== Hashing ===== */
+
+static uint64_t rotate_left(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t hash_round(uint64_t lane, uint64_t word) {
+    return rotate_left(lane + word * HASH_PRIME_2, 31) * HASH_PRIME_1;
+}
+
+/* A 64-bit hash reading four independent word lanes, fast enough to check a
+   whole image on every load. It can be fed in pieces: whole 32-byte blocks
+   go through the lanes and the last partial block is mixed in at the end. */
+typedef struct {
+    uint64_t lanes[4];
+    unsigned char block[32];
+    size_t block_length;
+    uint64_t length;
+} Hasher;
+
+static void hasher_init(Hasher* hasher) {
+    hasher->lanes[0] = HASH_PRIME_1 + HASH_PRIME_2;
+    hasher->lanes[1] = HASH_PRIME_2;
+    hasher->lanes[2] = 0;
+    hasher->lanes[3] = (uint64_t)0 - HASH_PRIME_1;
+    hasher->block_length = 0;
+    hasher->length = 0;
+}
+
+static void hash_block(Hasher* hasher, const unsigned char* block) {
+    for (int lane = 0; lane < 4; lane++) {
+        uint64_t word;
+        memcpy(&word, block + lane * 8, sizeof(word));
+        hasher->lanes[lane] = hash_round(hasher->lanes[lane], word);
+    }
+}
+
+static void hasher_update(Hasher* hasher, const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    hasher->length += length;
+
+    if (hasher->block_length > 0) {
+        size_t take = sizeof(hasher->block) - hasher->block_length;
+        if (take > length) take = length;
+        memcpy(hasher->block + hasher->block_length, bytes, take);
+        hasher->block_length += take;
+        bytes += take;
+        length -= take;
+        if (hasher->block_length < sizeof(hasher->block)) return;
+        hash_block(hasher, hasher->block);
+        hasher->block_length = 0;
+    }
+
+    for (; length >= 32; bytes += 32, length -= 32) {
+        hash_block(hasher, bytes);
+    }
+    memcpy(hasher->block, bytes, length);
+    hasher->block_length = length;
+}
+
+static uint64_t hasher_finish(const Hasher* hasher) {
+    const uint64_t* lanes = hasher->lanes;
+    const unsigned char* bytes = hasher->block;
+    size_t length = hasher->block_length;
+    size_t i = 0;
+
+    uint64_t hash = rotate_left(lanes[0], 1) + rotate_left(lanes[1], 7) +
+                    rotate_left(lanes[2], 12) + rotate_left(lanes[3], 18);
+    hash += hasher->length;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = rotate_left(hash ^ hash_round(0, word), 27) * HASH_PRIME_1 + HASH_PRIME_3;
+    }
+    for (; i < length; i++) {
+        hash = rotate_left(hash ^ (bytes[i] * HASH_PRIME_3), 11) * HASH_PRIME_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= HASH_PRIME_2;
+    hash ^= hash >> 29;
+    hash *= HASH_PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+static uint64_t hash_bytes(const void* data, size_t length) {
+    Hasher hasher;
+    hasher_init(&hasher);
+    hasher_update(&hasher, data, length);
+    return hasher_finish(&hasher);
+}
+
+/* Hash a file a chunk at a time, so even a huge one is never all in memory */
+static bool hash_file(const char* path, uint64_t* size, uint64_t* hash) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return false;
+
+    char* chunk = (char*)malloc(HASH_FILE_CHUNK_SIZE);
+    if (!chunk) {
+        fclose(fp);
+        return false;
+    }
+
+    Hasher hasher;
+    hasher_init(&hasher);
+    size_t read;
+    while ((read = fread(chunk, 1, HASH_FILE_CHUNK_SIZE, fp)) > 0) {
+        hasher_update(&hasher, chunk, read);
+    }
+    bool ok = !ferror(fp);
+    free(chunk);
+    fclose(fp);
+
+    *size = hasher.length;
+    *hash = hasher_finish(&hasher);
+    return ok;
+}
+
+/* Changes whenever a structure the image contains changes shape, and
+   between builds with different pointer sizes or byte orders */
+static uint64_t layout_fingerprint(void) {
+    const uint64_t layout[] = {
+        sizeof(void*), 0x0102030405060708ULL,
+        sizeof(StringView), sizeof(StringList), sizeof(Ingredient), sizeof(Recipe), sizeof(RecipeColumns),
+        sizeof(TimeIndex), RECIPE_TIME_FIELD_COUNT,
+        sizeof(TextureMapping), sizeof(SensoryConsiderations), sizeof(CustomizationOptions),
+        sizeof(SymbolTable), sizeof(SymbolId), sizeof(Bitmap), sizeof(BitmapContainer),
+        sizeof(HashSlot), sizeof(HashIndex), sizeof(FuzzyIndex), sizeof(RecipeDB),
+        offsetof(Recipe, ingredients), offsetof(Recipe, sensory_texture),
+        offsetof(Recipe, notes), offsetof(Recipe, executive_function_support),
+        offsetof(RecipeDB, columns), offsetof(RecipeDB, time_index), offsetof(RecipeDB, symbols), offsetof(RecipeDB, attribute_index),
+        offsetof(RecipeDB, fuzzy_index), offsetof(RecipeDB, customization),
+        ATTRIBUTE_KIND_COUNT, SENSORY_DIMENSION_COUNT, EXECUTIVE_CHALLENGE_COUNT,
+        BITMAP_BITSET_WORDS, FUZZY_TRIGRAM_COUNT
+    };
+    return hash_bytes(layout, sizeof(layout));
+}
+
+static uint64_t header_checksum(const SnapshotHeader* header) {
+    SnapshotHeader copy = *header;
+    copy.header_checksum = 0;
+    return hash_bytes(&copy, sizeof(copy));
+}
+
+/* ===== Writing ===== */
+
+static char* image_at(ImageWriter* writer, size_t offset) {
+    return writer->image.data + offset;
+}
+
+/* Append zeroed space; returns its offset, which stays valid as the image grows */
+static size_t image_reserve(ImageWriter* writer, size_t size, size_t alignment) {
+    if (writer->failed) return 0;
+
+    size_t offset = (writer->image.length + alignment - 1) & ~(alignment - 1);
+    size_t added = offset - writer->image.length + size;
+    if (!sb_reserve(&writer->image, added)) {
+        writer->failed = true;
+        return 0;
+    }
+    memset(writer->image.data + writer->image.length, 0, added + 1);
+    writer->image.length += added;
+    return offset;
+}
+
+static size_t image_copy(ImageWriter* writer, const void* data, size_t size, size_t alignment) {
+    size_t offset = image_reserve(writer, size, alignment);
+    if (!writer->failed && size > 0) memcpy(image_at(writer, offset), data, size);
+    return offset;
+}
+
+/* Point the pointer at field to target and list it for relocation */
+static void image_link(ImageWriter* writer, size_t field, size_t target) {
+    if (writer->failed) return;
+
+    if (writer->relocation_count == writer->relocation_capacity) {
+        size_t capacity = writer->relocation_capacity ? writer->relocation_capacity * 2 : 1024;
+        uint64_t* relocations = (uint64_t*)realloc(writer->relocations, capacity * sizeof(uint64_t));
+        if (!relocations) {
+            writer->failed = true;
+            return;
+        }
+        writer->relocations = relocations;
+        writer->relocation_capacity = capacity;
+    }
+    writer->relocations[writer->relocation_count++] = field;
+
+    uintptr_t address = SNAPSHOT_PREFERRED_BASE + target;
+    memcpy(image_at(writer, field), &address, sizeof(address));
+}
+
+/* Copy an array into the image and point field at it; a NULL array stays NULL */
+static void image_link_copy(ImageWriter* writer, size_t field, const void* data, size_t size) {
+    if (!data) return;
+    size_t offset = image_copy(writer, data, size, SNAPSHOT_ALIGNMENT);
+    image_link(writer, field, offset);
+}
+
+static bool grow_string_table(ImageWriter* writer) {
+    size_t capacity = writer->strings ? (writer->string_mask + 1) * 2 : SNAPSHOT_STRING_TABLE_INITIAL;
+    size_t* strings = (size_t*)calloc(capacity, sizeof(size_t));
+    if (!strings) return false;
+
+    if (writer->strings) {
+        for (size_t i = 0; i <= writer->string_mask; i++) {
+            size_t entry = writer->strings[i];
+            if (!entry) continue;
+            const char* text = image_at(writer, entry - 1);
+            size_t slot = (size_t)hash_bytes(text, strlen(text)) & (capacity - 1);
+            while (strings[slot]) slot = (slot + 1) & (capacity - 1);
+            strings[slot] = entry;
+        }
+        free(writer->strings);
+    }
+    writer->strings = strings;
+    writer->string_mask = capacity - 1;
+    return true;
+}
+
+/* Write a string once, NUL-terminated, and return its offset */
+static size_t image_string(ImageWriter* writer, StringView text) {
+    if (writer->failed) return 0;
+
+    /* Strings with embedded NULs are rare enough to store without sharing */
+    if (memchr(text.data, '\0', text.length)) {
+        size_t offset = image_reserve(writer, text.length + 1, 1);
+        if (!writer->failed) memcpy(image_at(writer, offset), text.data, text.length);
+        return offset;
+    }
+    if ((writer->string_count + 1) * 2 > writer->string_mask + 1 || !writer->strings) {
+        if (!grow_string_table(writer)) {
+            writer->failed = true;
+            return 0;
+        }
+    }
+
+    size_t slot = (size_t)hash_bytes(text.data, text.length) & writer->string_mask;
+    while (writer->strings[slot]) {
+        const char* existing = image_at(writer, writer->strings[slot] - 1);
+        if (strncmp(existing, text.data, text.length) == 0 && existing[text.length] == '\0') {
+            return writer->strings[slot] - 1;
+        }
+        slot = (slot + 1) & writer->string_mask;
+    }
+
+    size_t offset = image_reserve(writer, text.length + 1, 1);
+    if (writer->failed) return 0;
+    memcpy(image_at(writer, offset), text.data, text.length);
+    writer->strings[slot] = offset + 1;
+    writer->string_count++;
+    return offset;
+}
+
+/* Fill in the StringView at field */
+static void image_view(ImageWriter* writer, size_t field, StringView text) {
+    if (writer->failed || !text.data) return;
+    memcpy(image_at(writer, field + offsetof(StringView, length)), &text.length, sizeof(size_t));
+    size_t target = image_string(writer, text);
+    image_link(writer, field + offsetof(StringView, data), target);
+}
+
+/* Copy an array of views and point the pointer at field to it */
+static void image_views(ImageWriter* writer, size_t field, const StringView* items, int count) {
+    if (!items) return;
+    size_t array = image_reserve(writer, (size_t)count * sizeof(StringView), SNAPSHOT_ALIGNMENT);
+    for (int i = 0; i < count; i++) {
+        image_view(writer, array + (size_t)i * sizeof(StringView), items[i]);
+    }
+    image_link(writer, field, array);
+}
+
+/* Fill in the StringList at field */
+static void image_list(ImageWriter* writer, size_t field, const StringList* list) {
+    if (writer->failed) return;
+    memcpy(image_at(writer, field + offsetof(StringList, count)), &list->count, sizeof(int));
+    image_views(writer, field + offsetof(StringList, items), list->items, list->count);
+}
+
+static void write_ingredients(ImageWriter* writer, size_t field, const Ingredient* ingredients, int count) {
+    if (!ingredients) return;
+    size_t array = image_reserve(writer, (size_t)count * sizeof(Ingredient), SNAPSHOT_ALIGNMENT);
+    for (int i = 0; i < count; i++) {
+        size_t ingredient = array + (size_t)i * sizeof(Ingredient);
+        image_view(writer, ingredient + offsetof(Ingredient, name), ingredients[i].name);
+        image_view(writer, ingredient + offsetof(Ingredient, notes), ingredients[i].notes);
+        image_list(writer, ingredient + offsetof(Ingredient, options), &ingredients[i].options);
+    }
+    image_link(writer, field, array);
+}
+
+static void write_recipe(ImageWriter* writer, size_t field, const Recipe* recipe) {
+    if (writer->failed) return;
+
+    /* Scalars first, then every pointer through the writer */
+    Recipe scalars;
+    memset(&scalars, 0, sizeof(scalars));
+    scalars.meal_type_count = recipe->meal_type_count;
+    scalars.ingredients_count = recipe->ingredients_count;
+    scalars.preparation_steps_count = recipe->preparation_steps_count;
+    scalars.prep_time_duration = recipe->prep_time_duration;
+    scalars.cook_time_duration = recipe->cook_time_duration;
+    scalars.sensory_texture_count = recipe->sensory_texture_count;
+    scalars.sensory_temperature_count = recipe->sensory_temperature_count;
+    scalars.sensory_taste_count = recipe->sensory_taste_count;
+    scalars.sensory_smell_count = recipe->sensory_smell_count;
+    scalars.executive_function_support = recipe->executive_function_support;
+    memcpy(image_at(writer, field), &scalars, sizeof(scalars));
+
+    image_view(writer, field + offsetof(Recipe, id), recipe->id);
+    image_view(writer, field + offsetof(Recipe, name), recipe->name);
+    image_view(writer, field + offsetof(Recipe, prep_time_unit), recipe->prep_time_unit);
+    image_view(writer, field + offsetof(Recipe, cook_time_unit), recipe->cook_time_unit);
+    image_view(writer, field + offsetof(Recipe, description), recipe->description);
+    image_view(writer, field + offsetof(Recipe, notes), recipe->notes);
+
+    image_link_copy(writer, field + offsetof(Recipe, meal_type), recipe->meal_type,
+                    (size_t)recipe->meal_type_count * sizeof(SymbolId));
+    image_link_copy(writer, field + offsetof(Recipe, sensory_texture), recipe->sensory_texture,
+                    (size_t)recipe->sensory_texture_count * sizeof(SymbolId));
+    image_link_copy(writer, field + offsetof(Recipe, sensory_temperature), recipe->sensory_temperature,
+                    (size_t)recipe->sensory_temperature_count * sizeof(SymbolId));
+    image_link_copy(writer, field + offsetof(Recipe, sensory_taste), recipe->sensory_taste,
+                    (size_t)recipe->sensory_taste_count * sizeof(SymbolId));
+    image_link_copy(writer, field + offsetof(Recipe, sensory_smell), recipe->sensory_smell,
+                    (size_t)recipe->sensory_smell_count * sizeof(SymbolId));
+
+    write_ingredients(writer, field + offsetof(Recipe, ingredients),
+                      recipe->ingredients, recipe->ingredients_count);
+    image_views(writer, field + offsetof(Recipe, preparation_steps),
+                recipe->preparation_steps, recipe->preparation_steps_count);
+}
+
+static void write_bitmaps(ImageWriter* writer, size_t field, const Bitmap* bitmaps, int count) {
+    if (!bitmaps) return;
+    size_t array = image_reserve(writer, (size_t)count * sizeof(Bitmap), SNAPSHOT_ALIGNMENT);
+
+    for (int i = 0; i < count && !writer->failed; i++) {
+        const Bitmap* bitmap = &bitmaps[i];
+        size_t bitmap_field = array + (size_t)i * sizeof(Bitmap);
+        Bitmap scalars = { NULL, bitmap->count, bitmap->count };
+        memcpy(image_at(writer, bitmap_field), &scalars, sizeof(scalars));
+        if (!bitmap->containers) continue;
+
+        size_t containers = image_reserve(writer, (size_t)bitmap->count * sizeof(BitmapContainer),
+                                          SNAPSHOT_ALIGNMENT);
+        for (int c = 0; c < bitmap->count && !writer->failed; c++) {
+            const BitmapContainer* container = &bitmap->containers[c];
+            size_t container_field = containers + (size_t)c * sizeof(BitmapContainer);
+            bool is_bitset = container->type == BITMAP_CONTAINER_BITSET;
+
+            BitmapContainer copy;
+            memset(&copy, 0, sizeof(copy));
+            copy.key = container->key;
+            copy.type = container->type;
+            copy.cardinality = container->cardinality;
+            copy.capacity = is_bitset ? container->capacity : container->cardinality;
+            memcpy(image_at(writer, container_field), &copy, sizeof(copy));
+
+            if (is_bitset) {
+                image_link_copy(writer, container_field + offsetof(BitmapContainer, data),
+                                container->data.words, BITMAP_BITSET_WORDS * sizeof(uint64_t));
+            } else {
+                image_link_copy(writer, container_field + offsetof(BitmapContainer, data),
+                                container->data.values, (size_t)container->cardinality * sizeof(uint16_t));
+            }
+        }
+        image_link(writer, bitmap_field + offsetof(Bitmap, containers), containers);
+    }
+    image_link(writer, field, array);
+}
+
+static void write_guidance(ImageWriter* writer, size_t db_field, const RecipeDB* db) {
+    size_t sensory = db_field + offsetof(RecipeDB, sensory_considerations);
+    const SensoryConsiderations* considerations = &db->sensory_considerations;
+
+    for (int d = 0; d < SENSORY_DIMENSION_COUNT; d++) {
+        image_list(writer, sensory + offsetof(SensoryConsiderations, avoidance_triggers) +
+                   (size_t)d * sizeof(StringList), &considerations->avoidance_triggers[d]);
+        image_list(writer, sensory + offsetof(SensoryConsiderations, preferred_profiles) +
+                   (size_t)d * sizeof(StringList), &considerations->preferred_profiles[d]);
+    }
+
+    if (considerations->texture_mappings) {
+        int count = considerations->texture_mapping_count;
+        size_t array = image_reserve(writer, (size_t)count * sizeof(TextureMapping), SNAPSHOT_ALIGNMENT);
+        for (int i = 0; i < count; i++) {
+            size_t mapping = array + (size_t)i * sizeof(TextureMapping);
+            image_view(writer, mapping + offsetof(TextureMapping, trigger),
+                       considerations->texture_mappings[i].trigger);
+            image_list(writer, mapping + offsetof(TextureMapping, alternatives),
+                       &considerations->texture_mappings[i].alternatives);
+        }
+        image_link(writer, sensory + offsetof(SensoryConsiderations, texture_mappings), array);
+    }
+
+    for (int c = 0; c < EXECUTIVE_CHALLENGE_COUNT; c++) {
+        image_list(writer, db_field + offsetof(RecipeDB, executive_strategies) +
+                   (size_t)c * sizeof(StringList), &db->executive_strategies[c]);
+    }
+
+    size_t customization = db_field + offsetof(RecipeDB, customization);
+    const CustomizationOptions* options = &db->customization;
+    image_list(writer, customization + offsetof(CustomizationOptions, dietary_restrictions),
+               &options->dietary_restrictions);
+    image_view(writer, customization + offsetof(CustomizationOptions, allergy_information),
+               options->allergy_information);
+    image_list(writer, customization + offsetof(CustomizationOptions, preferred_cuisines),
+               &options->preferred_cuisines);
+    image_list(writer, customization + offsetof(CustomizationOptions, time_constraints),
+               &options->time_constraints);
+    image_list(writer, customization + offsetof(CustomizationOptions, available_equipment),
+               &options->available_equipment);
+}
+
+/* Lay out the database after the header; returns the offset of its RecipeDB */
+static size_t write_database(ImageWriter* writer, const RecipeDB* db) {
+    RecipeDB scalars;
+    memset(&scalars, 0, sizeof(scalars));
+    scalars.recipe_count = db->recipe_count;
+    for (int t = 0; t < RECIPE_TIME_FIELD_COUNT; t++) {
+        scalars.time_index[t].count = db->time_index[t].count;
+    }
+    scalars.symbols.count = db->symbols.count;
+    scalars.symbols.capacity = db->symbols.count;
+    scalars.symbols.slot_capacity = db->symbols.slot_capacity;
+    scalars.name_index.mask = db->name_index.mask;
+    scalars.name_index.count = db->name_index.count;
+    scalars.id_index.mask = db->id_index.mask;
+    scalars.id_index.count = db->id_index.count;
+    scalars.fuzzy_index.name_count = db->fuzzy_index.name_count;
+    scalars.sensory_considerations.texture_mapping_count = db->sensory_considerations.texture_mapping_count;
+
+    size_t field = image_copy(writer, &scalars, sizeof(scalars), SNAPSHOT_ALIGNMENT);
+
+    if (db->recipes) {
+        size_t recipes = image_reserve(writer, (size_t)db->recipe_count * sizeof(Recipe), SNAPSHOT_ALIGNMENT);
+        for (int i = 0; i < db->recipe_count; i++) {
+            write_recipe(writer, recipes + (size_t)i * sizeof(Recipe), &db->recipes[i]);
+        }
+        image_link(writer, field + offsetof(RecipeDB, recipes), recipes);
+    }
+
+    const RecipeColumns* columns = &db->columns;
+    size_t columns_field = field + offsetof(RecipeDB, columns);
+    size_t column_size = (size_t)db->recipe_count * sizeof(int32_t);
+    image_link_copy(writer, columns_field + offsetof(RecipeColumns, prep_minutes),
+                    columns->prep_minutes, column_size);
+    image_link_copy(writer, columns_field + offsetof(RecipeColumns, cook_minutes),
+                    columns->cook_minutes, column_size);
+    image_link_copy(writer, columns_field + offsetof(RecipeColumns, total_minutes),
+                    columns->total_minutes, column_size);
+    image_link_copy(writer, columns_field + offsetof(RecipeColumns, executive_function_support),
+                    columns->executive_function_support, (size_t)db->recipe_count * sizeof(uint32_t));
+
+    for (int t = 0; t < RECIPE_TIME_FIELD_COUNT; t++) {
+        const TimeIndex* index = &db->time_index[t];
+        size_t index_field = field + offsetof(RecipeDB, time_index) + (size_t)t * sizeof(TimeIndex);
+        size_t index_size = (size_t)index->count * sizeof(int32_t);
+        image_link_copy(writer, index_field + offsetof(TimeIndex, minutes), index->minutes, index_size);
+        image_link_copy(writer, index_field + offsetof(TimeIndex, recipes), index->recipes, index_size);
+    }
+
+    size_t symbols = field + offsetof(RecipeDB, symbols);
+    image_views(writer, symbols + offsetof(SymbolTable, names), db->symbols.names, db->symbols.count);
+    image_link_copy(writer, symbols + offsetof(SymbolTable, slots), db->symbols.slots,
+                    (size_t)db->symbols.slot_capacity * sizeof(SymbolId));
+
+    for (int kind = 0; kind < ATTRIBUTE_KIND_COUNT; kind++) {
+        write_bitmaps(writer, field + offsetof(RecipeDB, attribute_index) + (size_t)kind * sizeof(Bitmap*),
+                      db->attribute_index[kind], db->symbols.count);
+    }
+
+    if (db->name_index.slots) {
+        image_link_copy(writer, field + offsetof(RecipeDB, name_index) + offsetof(HashIndex, slots),
+                        db->name_index.slots, ((size_t)db->name_index.mask + 1) * sizeof(HashSlot));
+    }
+    if (db->id_index.slots) {
+        image_link_copy(writer, field + offsetof(RecipeDB, id_index) + offsetof(HashIndex, slots),
+                        db->id_index.slots, ((size_t)db->id_index.mask + 1) * sizeof(HashSlot));
+    }
+
+    const FuzzyIndex* fuzzy = &db->fuzzy_index;
+    if (fuzzy->offsets) {
+        size_t fuzzy_field = field + offsetof(RecipeDB, fuzzy_index);
+        image_link_copy(writer, fuzzy_field + offsetof(FuzzyIndex, offsets), fuzzy->offsets,
+                        (FUZZY_TRIGRAM_COUNT + 1) * sizeof(uint32_t));
+        image_link_copy(writer, fuzzy_field + offsetof(FuzzyIndex, postings), fuzzy->postings,
+                        fuzzy->offsets[FUZZY_TRIGRAM_COUNT] * sizeof(uint32_t));
+    }
+
+    write_guidance(writer, field, db);
+    return field;
+}
+
+static void get_modification_time(const struct stat* st, int64_t* seconds, int64_t* nanoseconds) {
+    *seconds = (int64_t)st->st_mtime;
+#if defined(__linux__)
+    *nanoseconds = (int64_t)st->st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+    *nanoseconds = (int64_t)st->st_mtimespec.tv_nsec;
+#else
+    *nanoseconds = 0;
+#endif
+}
+
+static const char* save_image(const char* path, const SnapshotHeader* header, const StringBuilder* image) {
+    size_t path_length = strlen(path);
+    char* temp_path = (char*)malloc(path_length + 5);
+    if (!temp_path) return "Out of memory writing snapshot";
+    memcpy(temp_path, path, path_length);
+    memcpy(temp_path + path_length, ".tmp", 5);
+
+    /* Written beside the target and renamed, so a reader never sees half a file */
+    FILE* fp = fopen(temp_path, "wb");
+    if (!fp) {
+        free(temp_path);
+        return "Could not create snapshot file";
+    }
+    bool written = fwrite(header, sizeof(*header), 1, fp) == 1 &&
+                   fwrite(image->data + sizeof(*header), 1, image->length - sizeof(*header), fp) ==
+                       image->length - sizeof(*header);
+    written = fclose(fp) == 0 && written;
+
+#ifdef _WIN32
+    if (written) remove(path);
+#endif
+    if (!written || rename(temp_path, path) != 0) {
+        remove(temp_path);
+        free(temp_path);
+        return "Could not write snapshot file";
+    }
+    free(temp_path);
+    return NULL;
+}
+
+const char* write_recipe_snapshot(const RecipeDB* db, const char* json_path, const char* snapshot_path) {
+    if (!db || db->error_message) return "Cannot snapshot a database that failed to load";
+
+    struct stat st;
+    if (stat(json_path, &st) != 0) return "Could not read JSON file";
+
+    /* A streamed database keeps no copy of its source, so hash the file */
+    uint64_t source_hash;
+    if (db->source.data) {
+        if ((uint64_t)st.st_size != db->source.length) return "JSON file changed while compiling";
+        source_hash = hash_bytes(db->source.data, db->source.length);
+    } else {
+        uint64_t source_size;
+        if (!hash_file(json_path, &source_size, &source_hash)) return "Could not read JSON file";
+        if ((uint64_t)st.st_size != source_size) return "JSON file changed while compiling";
+    }
+
+    ImageWriter writer;
+    memset(&writer, 0, sizeof(writer));
+    sb_init(&writer.image);
+
+    /* The header is filled in last; offsets in the image count from the file start */
+    image_reserve(&writer, sizeof(SnapshotHeader), SNAPSHOT_ALIGNMENT);
+    size_t db_offset = write_database(&writer, db);
+
+    size_t relocation_offset = image_reserve(&writer, writer.relocation_count * sizeof(uint64_t),
+                                             SNAPSHOT_ALIGNMENT);
+    if (!writer.failed && writer.relocation_count > 0) {
+        memcpy(image_at(&writer, relocation_offset), writer.relocations,
+               writer.relocation_count * sizeof(uint64_t));
+    }
+
+    const char* error = NULL;
+    if (writer.failed) {
+        error = "Out of memory writing snapshot";
+    } else {
+        SnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.format_version = SNAPSHOT_FORMAT_VERSION;
+        header.header_size = sizeof(SnapshotHeader);
+        header.layout = layout_fingerprint();
+        header.image_size = writer.image.length;
+        header.preferred_base = SNAPSHOT_PREFERRED_BASE;
+        header.db_offset = db_offset;
+        header.relocation_offset = relocation_offset;
+        header.relocation_count = writer.relocation_count;
+        header.source_size = (uint64_t)st.st_size;
+        get_modification_time(&st, &header.source_mtime_sec, &header.source_mtime_nsec);
+        header.source_hash = source_hash;
+        header.payload_checksum = hash_bytes(writer.image.data + sizeof(header),
+                                             writer.image.length - sizeof(header));
+        header.header_checksum = header_checksum(&header);
+        error = save_image(snapshot_path, &header, &writer.image);
+    }
+
+    sb_free(&writer.image);
+    free(writer.relocations);
+    free(writer.strings);
+    return error;
+}
+
+/* ===== Loading ===== */
+
+static bool header_is_valid(const SnapshotHeader* header, uint64_t file_size) {
+    return file_size >= sizeof(SnapshotHeader) + sizeof(RecipeDB) &&
+           memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 &&
+           header->format_version == SNAPSHOT_FORMAT_VERSION &&
+           header->header_size == sizeof(SnapshotHeader) &&
+           header->layout == layout_fingerprint() &&
+           header->header_checksum == header_checksum(header) &&
+           header->image_size == file_size &&
+           header->preferred_base == SNAPSHOT_PREFERRED_BASE &&
+           header->db_offset >= sizeof(SnapshotHeader) &&
+           header->db_offset <= file_size - sizeof(RecipeDB) &&
+           header->db_offset % SNAPSHOT_ALIGNMENT == 0 &&
+           header->relocation_offset % sizeof(uint64_t) == 0 &&
+           header->relocation_offset <= file_size &&
+           header->relocation_count <= (file_size - header->relocation_offset) / sizeof(uint64_t);
+}
+
+static bool source_matches(const SnapshotHeader* header, const char* json_path) {
+    struct stat st;
+    if (!json_path || stat(json_path, &st) != 0) return true;
+    if ((uint64_t)st.st_size != header->source_size) return false;
+
+    int64_t seconds, nanoseconds;
+    get_modification_time(&st, &seconds, &nanoseconds);
+    if (seconds == header->source_mtime_sec && nanoseconds == header->source_mtime_nsec) return true;
+
+    /* Touched but maybe not changed: compare contents */
+    uint64_t source_size, source_hash;
+    return hash_file(json_path, &source_size, &source_hash) &&
+           source_size == header->source_size && source_hash == header->source_hash;
+}
+
+/* Adjust every listed pointer for an image loaded at base */
+static bool relocate_image(char* base, const SnapshotHeader* header) {
+    const uint64_t* relocations = (const uint64_t*)(base + header->relocation_offset);
+    uintptr_t preferred = (uintptr_t)header->preferred_base;
+
+    for (uint64_t i = 0; i < header->relocation_count; i++) {
+        uint64_t field = relocations[i];
+        if (field < sizeof(SnapshotHeader) || field > header->image_size - sizeof(uintptr_t) ||
+            field % sizeof(uintptr_t) != 0) {
+            return false;
+        }
+        uintptr_t address;
+        memcpy(&address, base + field, sizeof(address));
+        if (address < preferred || address - preferred > header->image_size) return false;
+        address = (uintptr_t)base + (address - preferred);
+        memcpy(base + field, &address, sizeof(address));
+    }
+    return true;
+}
+
+static bool read_header(const char* path, SnapshotHeader* header, uint64_t* file_size) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return false;
+
+    /* A file too short for a header reads as size 0, which never validates */
+    long size = -1;
+    if (fread(header, sizeof(*header), 1, fp) == 1 && fseek(fp, 0, SEEK_END) == 0) {
+        size = ftell(fp);
+    }
+    fclose(fp);
+    *file_size = size > 0 ? (uint64_t)size : 0;
+    return true;
+}
+
+/* Map the image, at the preferred address if possible; returns NULL on failure */
+static char* map_image(const char* path, const SnapshotHeader* header, bool* relocated, bool* mapped) {
+    size_t size = (size_t)header->image_size;
+    *relocated = false;
+    *mapped = false;
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    void* data = mmap((void*)(uintptr_t)header->preferred_base, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED && data != (void*)(uintptr_t)header->preferred_base) {
+        munmap(data, size);
+        data = MAP_FAILED;
+    }
+    if (data == MAP_FAILED) {
+        /* Copy-on-write, so relocating never touches the file */
+        data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        *relocated = true;
+    }
+    close(fd);
+    if (data != MAP_FAILED) {
+        *mapped = true;
+        return (char*)data;
+    }
+#endif
+
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    char* buffer = (char*)malloc(size);
+    bool read = buffer && fread(buffer, 1, size, fp) == size;
+    fclose(fp);
+    if (!read) {
+        free(buffer);
+        return NULL;
+    }
+    *relocated = true;
+    return buffer;
+}
+
+static void unmap_image(char* data, size_t size, bool mapped) {
+#ifndef _WIN32
+    if (mapped) {
+        munmap(data, size);
+        return;
+    }
+#else
+    (void)size;
+    (void)mapped;
+#endif
+    free(data);
+}
+
+RecipeDB* load_recipe_snapshot(const char* snapshot_path, const char* json_path, SnapshotStatus* status) {
+    SnapshotStatus ignored;
+    if (!status) status = &ignored;
+
+    SnapshotHeader header;
+    uint64_t file_size;
+    if (!snapshot_path || !read_header(snapshot_path, &header, &file_size)) {
+        *status = SNAPSHOT_MISSING;
+        return NULL;
+    }
+    if (file_size > SIZE_MAX || !header_is_valid(&header, file_size)) {
+        *status = SNAPSHOT_INVALID;
+        return NULL;
+    }
+    if (!source_matches(&header, json_path)) {
+        *status = SNAPSHOT_STALE;
+        return NULL;
+    }
+
+    bool relocated, mapped;
+    char* data = map_image(snapshot_path, &header, &relocated, &mapped);
+    size_t size = (size_t)header.image_size;
+    bool valid = data && memcmp(data, &header, sizeof(header)) == 0 &&
+                 hash_bytes(data + sizeof(header), size - sizeof(header)) == header.payload_checksum;
+    if (valid && relocated) {
+        valid = relocate_image(data, &header);
+#ifndef _WIN32
+        if (valid && mapped) mprotect(data, size, PROT_READ);
+#endif
+    }
+
+    RecipeDB* db = valid ? (RecipeDB*)calloc(1, sizeof(RecipeDB)) : NULL;
+    if (!db) {
+        if (data) unmap_image(data, size, mapped);
+        *status = SNAPSHOT_INVALID;
+        return NULL;
+    }
+
+    /* The image's RecipeDB has every owned and per-process field zeroed */
+    memcpy(db, data + header.db_offset, sizeof(RecipeDB));
+    db->version = next_recipe_db_version();
+    db->verbose = true;
+    db->from_snapshot = true;
+    db->source.data = data;
+    db->source.length = size;
+    db->source.mapped = mapped;
+    arena_init(&db->arena, 0);
+
+    *status = SNAPSHOT_LOADED;
+    return db;
+}
+
+RecipeDB* open_recipe_db(const char* json_path, const char* snapshot_path, SnapshotStatus* status) {
+    SnapshotStatus ignored;
+    if (!status) status = &ignored;
+
+    if (snapshot_path) {
+        RecipeDB* db = load_recipe_snapshot(snapshot_path, json_path, status);
+        if (db) return db;
+    } else {
+        *status = SNAPSHOT_MISSING;
+    }
+    return init_recipe_db(json_path);
+}
+
+char* default_snapshot_path(const char* json_path) {
+    size_t length = strlen(json_path);
+    if (length >= 5 && strcmp(json_path + length - 5, ".json") == 0) length -= 5;
+
+    char* path = (char*)malloc(length + 6);
+    if (!path) return NULL;
+    memcpy(path, json_path, length);
+    memcpy(path + length, ".ncdb", 6);
+    return path;
+}
+
+const char* snapshot_status_name(SnapshotStatus status) {
+    switch (status) {
+        case SNAPSHOT_LOADED: return "loaded";
+        case SNAPSHOT_MISSING: return "missing";
+        case SNAPSHOT_STALE: return "stale";
+        case SNAPSHOT_INVALID: return "invalid";
+    }
+    return "unknown";
+}
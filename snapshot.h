@@ -0,0 +1,93 @@
+/**
+ * NeuroChef - Recipe Snapshots
+ * 
+ * This header declares a binary image of a loaded RecipeDB: its string
+ * pool, recipe records, columns and time indexes, interned symbols,
+ * attribute bitmaps and lookup indices, laid out exactly as they sit in
+ * memory. Loading a snapshot is a memory mapping plus a few checks instead
+ * of a JSON parse.
+ * 
+ * Every pointer in the image is written for a preferred load address and
+ * listed in a relocation table, so the image is position-independent: when
+ * the mapping lands at the preferred address nothing is touched, and
+ * anywhere else each listed pointer is adjusted once. The header carries a
+ * format version, a layout fingerprint of the structures, checksums of the
+ * header and payload, and the size, modification time and hash of the JSON
+ * file it was compiled from.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include "recipe_utils.h"
+
+/* Where snapshots are written to be mapped, chosen to be far from where
+   heaps, stacks and libraries usually live; a snapshot mapped anywhere
+   else is relocated */
+#if UINTPTR_MAX > 0xFFFFFFFFu
+#define SNAPSHOT_PREFERRED_BASE ((uintptr_t)0x3d0000000000ULL)
+#else
+#define SNAPSHOT_PREFERRED_BASE ((uintptr_t)0x50000000u)
+#endif
+
+typedef enum {
+    SNAPSHOT_LOADED,
+    SNAPSHOT_MISSING,       /* No snapshot file */
+    SNAPSHOT_STALE,         /* The JSON file changed since it was compiled */
+    SNAPSHOT_INVALID        /* Corrupt, truncated, or from another build */
+} SnapshotStatus;
+
+/**
+ * Write a snapshot of a database loaded from a JSON file
+ * 
+ * @param db The database, loaded with init_recipe_db or init_recipe_db_streaming
+ * @param json_path The JSON file the database was loaded from
+ * @param snapshot_path Where to write the snapshot
+ * @return NULL on success, or an error message
+ */
+const char* write_recipe_snapshot(const RecipeDB* db, const char* json_path, const char* snapshot_path);
+
+/**
+ * Load a snapshot if it is valid and was compiled from the JSON file as it
+ * is now
+ * 
+ * A snapshot is fresh when the JSON file's size and modification time
+ * match, or, if only the time differs, when its contents hash the same. A
+ * snapshot whose JSON file no longer exists is used as is.
+ * 
+ * @param snapshot_path The snapshot file
+ * @param json_path The JSON file it was compiled from
+ * @param status Receives why the snapshot was or was not loaded (may be NULL)
+ * @return The database, or NULL if the snapshot cannot be used
+ */
+RecipeDB* load_recipe_snapshot(const char* snapshot_path, const char* json_path, SnapshotStatus* status);
+
+/**
+ * Load from the snapshot when it is usable, otherwise from the JSON file
+ * 
+ * @param json_path The JSON file
+ * @param snapshot_path The snapshot file, or NULL to always parse the JSON
+ * @param status Receives what happened to the snapshot (may be NULL)
+ * @return The database, as from init_recipe_db
+ */
+RecipeDB* open_recipe_db(const char* json_path, const char* snapshot_path, SnapshotStatus* status);
+
+/**
+ * Get the conventional snapshot path for a JSON file: the same name with
+ * the .json extension replaced by .ncdb
+ * 
+ * @param json_path The JSON file
+ * @return The snapshot path, which the caller must free, or NULL if out of memory
+ */
+char* default_snapshot_path(const char* json_path);
+
+/**
+ * Get a short description of a snapshot status, e.g. "stale"
+ * 
+ * @param status The status
+ * @return The description, a string literal
+ */
+const char* snapshot_status_name(SnapshotStatus status);
+
+#endif /* SNAPSHOT_H */
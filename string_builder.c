@@ -0,0 +1,206 @@
+/**
+ * NeuroChef - String Builder Implementation
+ * 
+ * This file implements the growable string with amortized doubling.
+ */
+
+#include "string_builder.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SB_MIN_CAPACITY 256
+
+void sb_init(StringBuilder* builder) {
+    builder->data = NULL;
+    builder->length = 0;
+    builder->capacity = 0;
+    builder->owns_data = false;
+    builder->failed = false;
+}
+
+void sb_init_buffer(StringBuilder* builder, char* buffer, size_t capacity) {
+    sb_init(builder);
+    if (buffer && capacity > 0) {
+        builder->data = buffer;
+        builder->capacity = capacity;
+        buffer[0] = '\0';
+    }
+}
+
+void sb_reset(StringBuilder* builder) {
+    builder->length = 0;
+    builder->failed = false;
+    if (builder->data) {
+        builder->data[0] = '\0';
+    }
+}
+
+bool sb_reserve(StringBuilder* builder, size_t additional) {
+    if (builder->failed) return false;
+
+    /* Room for the terminator is always kept */
+    if (additional > SIZE_MAX - builder->length - 1) {
+        builder->failed = true;
+        return false;
+    }
+    size_t needed = builder->length + additional + 1;
+    if (needed <= builder->capacity) return true;
+
+    size_t new_capacity = builder->capacity < SB_MIN_CAPACITY ? SB_MIN_CAPACITY : builder->capacity;
+    while (new_capacity < needed) {
+        /* Doubling past half the address space would wrap */
+        new_capacity = new_capacity > SIZE_MAX / 2 ? needed : new_capacity * 2;
+    }
+
+    char* new_data;
+    if (builder->owns_data) {
+        new_data = (char*)realloc(builder->data, new_capacity);
+    } else {
+        new_data = (char*)malloc(new_capacity);
+        if (new_data && builder->data) {
+            memcpy(new_data, builder->data, builder->length + 1);
+        }
+    }
+
+    if (!new_data) {
+        builder->failed = true;
+        return false;
+    }
+
+    if (!builder->data) {
+        new_data[0] = '\0';
+    }
+    builder->data = new_data;
+    builder->capacity = new_capacity;
+    builder->owns_data = true;
+    return true;
+}
+
+bool sb_append(StringBuilder* builder, const char* text, size_t length) {
+    if (!sb_reserve(builder, length)) return false;
+
+    if (length > 0) {
+        memcpy(builder->data + builder->length, text, length);
+    }
+    builder->length += length;
+    builder->data[builder->length] = '\0';
+    return true;
+}
+
+bool sb_append_cstr(StringBuilder* builder, const char* text) {
+    return sb_append(builder, text, strlen(text));
+}
+
+bool sb_append_view(StringBuilder* builder, StringView view) {
+    return sb_append(builder, view.data, view.length);
+}
+
+bool sb_append_json_string(StringBuilder* builder, const char* text, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+
+    if (!sb_reserve(builder, length + 2)) return false;
+
+    sb_append(builder, "\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        /* Flush the plain bytes before this one, then its escape */
+        sb_append(builder, text + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"': sb_append(builder, "\\\"", 2); break;
+            case '\\': sb_append(builder, "\\\\", 2); break;
+            case '\n': sb_append(builder, "\\n", 2); break;
+            case '\r': sb_append(builder, "\\r", 2); break;
+            case '\t': sb_append(builder, "\\t", 2); break;
+            default: {
+                char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+                sb_append(builder, escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    sb_append(builder, text + run, length - run);
+    return sb_append(builder, "\"", 1);
+}
+
+bool sb_appendf(StringBuilder* builder, const char* format, ...) {
+    if (builder->failed) return false;
+
+    /* Try in place first; only measure and retry when the text does not fit */
+    size_t available = builder->capacity > builder->length ? builder->capacity - builder->length : 0;
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(available > 0 ? builder->data + builder->length : NULL, available, format, args);
+    va_end(args);
+
+    if (written < 0) return false;
+
+    if ((size_t)written >= available) {
+        if (!sb_reserve(builder, (size_t)written)) {
+            /* Undo the partial write */
+            if (builder->data) builder->data[builder->length] = '\0';
+            return false;
+        }
+
+        va_start(args, format);
+        vsnprintf(builder->data + builder->length, (size_t)written + 1, format, args);
+        va_end(args);
+    }
+
+    builder->length += (size_t)written;
+    return true;
+}
+
+void sb_truncate(StringBuilder* builder, size_t length) {
+    if (length >= builder->length) return;
+
+    builder->length = length;
+    builder->data[length] = '\0';
+}
+
+void sb_drop_prefix(StringBuilder* builder, size_t length) {
+    if (length >= builder->length) {
+        sb_reset(builder);
+        return;
+    }
+
+    memmove(builder->data, builder->data + length, builder->length - length + 1);
+    builder->length -= length;
+}
+
+const char* sb_cstr(const StringBuilder* builder) {
+    return builder->data ? builder->data : "";
+}
+
+char* sb_detach(StringBuilder* builder) {
+    char* result;
+    if (builder->failed) {
+        result = NULL;
+    } else if (builder->owns_data) {
+        result = builder->data;
+        builder->data = NULL;
+        builder->capacity = 0;
+        builder->owns_data = false;
+    } else {
+        result = (char*)malloc(builder->length + 1);
+        if (result) {
+            memcpy(result, sb_cstr(builder), builder->length + 1);
+        }
+    }
+
+    sb_reset(builder);
+    return result;
+}
+
+void sb_free(StringBuilder* builder) {
+    if (builder->owns_data) {
+        free(builder->data);
+    }
+    sb_init(builder);
+}
@@ -0,0 +1,152 @@
+/**
+ * NeuroChef - String Builder
+ * 
+ * This header declares a growable, always NUL-terminated string used to
+ * render responses. A builder can start on a caller-supplied buffer (for
+ * example on the stack) and only moves to the heap if the text outgrows it,
+ * so one builder reused across queries needs no per-query allocation.
+ */
+
+#ifndef STRING_BUILDER_H
+#define STRING_BUILDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "string_view.h"
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+    /* false while data is the caller's buffer */
+    bool owns_data;
+    /* An allocation failed; the contents are incomplete */
+    bool failed;
+} StringBuilder;
+
+/**
+ * Initialize an empty builder that allocates on first use
+ * 
+ * @param builder The builder to initialize
+ */
+void sb_init(StringBuilder* builder);
+
+/**
+ * Initialize an empty builder on a caller-supplied buffer
+ * 
+ * The buffer is used until the text outgrows it and is never freed.
+ * 
+ * @param builder The builder to initialize
+ * @param buffer The initial storage
+ * @param capacity Size of the buffer in bytes
+ */
+void sb_init_buffer(StringBuilder* builder, char* buffer, size_t capacity);
+
+/**
+ * Empty the builder, keeping its storage for reuse
+ * 
+ * @param builder The builder
+ */
+void sb_reset(StringBuilder* builder);
+
+/**
+ * Make sure the builder can hold extra bytes without growing
+ * 
+ * @param builder The builder
+ * @param additional Number of bytes that will be appended
+ * @return true on success, false if out of memory
+ */
+bool sb_reserve(StringBuilder* builder, size_t additional);
+
+/**
+ * Append raw bytes
+ * 
+ * @param builder The builder
+ * @param text The bytes to append
+ * @param length Number of bytes
+ * @return true on success, false if out of memory
+ */
+bool sb_append(StringBuilder* builder, const char* text, size_t length);
+
+/**
+ * Append a NUL-terminated string
+ * 
+ * @param builder The builder
+ * @param text The string to append
+ * @return true on success, false if out of memory
+ */
+bool sb_append_cstr(StringBuilder* builder, const char* text);
+
+/**
+ * Append the contents of a view
+ * 
+ * @param builder The builder
+ * @param view The view to append
+ * @return true on success, false if out of memory
+ */
+bool sb_append_view(StringBuilder* builder, StringView view);
+
+/**
+ * Append text as a quoted JSON string, escaping quotes, backslashes and
+ * control characters
+ * 
+ * @param builder The builder
+ * @param text The raw text
+ * @param length Number of bytes
+ * @return true on success, false if out of memory
+ */
+bool sb_append_json_string(StringBuilder* builder, const char* text, size_t length);
+
+/**
+ * Append printf-style formatted text
+ * 
+ * @param builder The builder
+ * @param format The format string
+ * @return true on success, false if out of memory or the format is invalid
+ */
+bool sb_appendf(StringBuilder* builder, const char* format, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+/**
+ * Shorten the text to a length no greater than the current one
+ * 
+ * @param builder The builder
+ * @param length The new length
+ */
+void sb_truncate(StringBuilder* builder, size_t length);
+
+/**
+ * Remove bytes from the front, e.g. to drop a message that was superseded
+ * 
+ * @param builder The builder
+ * @param length Number of bytes to remove
+ */
+void sb_drop_prefix(StringBuilder* builder, size_t length);
+
+/**
+ * Get the text built so far
+ * 
+ * @param builder The builder
+ * @return The NUL-terminated contents, valid until the builder changes
+ */
+const char* sb_cstr(const StringBuilder* builder);
+
+/**
+ * Take the contents as a heap string and empty the builder
+ * 
+ * @param builder The builder
+ * @return The string, which the caller must free, or NULL if out of memory
+ */
+char* sb_detach(StringBuilder* builder);
+
+/**
+ * Free the builder's heap storage; a caller-supplied buffer is left alone
+ * 
+ * @param builder The builder to free
+ */
+void sb_free(StringBuilder* builder);
+
+#endif /* STRING_BUILDER_H */
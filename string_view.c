@@ -0,0 +1,59 @@
+/**
+ * NeuroChef - String Views Implementation
+ * 
+ * This file implements the string view helpers.
+ */
+
+#include "string_view.h"
+#include <ctype.h>
+#include <string.h>
+
+StringView sv_from_cstr(const char* str) {
+    StringView view = { str, str ? strlen(str) : 0 };
+    return view;
+}
+
+bool sv_equals(StringView a, StringView b) {
+    return a.length == b.length && (a.length == 0 || memcmp(a.data, b.data, a.length) == 0);
+}
+
+bool sv_equals_ignore_case(StringView a, StringView b) {
+    if (a.length != b.length) return false;
+    for (size_t i = 0; i < a.length; i++) {
+        if (tolower((unsigned char)a.data[i]) != tolower((unsigned char)b.data[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sv_contains_ignore_case(StringView haystack, StringView needle) {
+    if (needle.length == 0) return true;
+    if (needle.length > haystack.length) return false;
+
+    for (size_t i = 0; i + needle.length <= haystack.length; i++) {
+        StringView window = { haystack.data + i, needle.length };
+        if (sv_equals_ignore_case(window, needle)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t sv_hash(StringView view) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < view.length; i++) {
+        hash ^= (unsigned char)view.data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t sv_hash_ignore_case(StringView view) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < view.length; i++) {
+        hash ^= (unsigned char)tolower((unsigned char)view.data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
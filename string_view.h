@@ -0,0 +1,78 @@
+/**
+ * NeuroChef - String Views
+ * 
+ * This header declares a borrowed (pointer, length) string type and a few
+ * helpers for comparing and hashing it.
+ */
+
+#ifndef STRING_VIEW_H
+#define STRING_VIEW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A borrowed view of raw string contents. Views usually point into the mapped
+ * data file and are not NUL-terminated; print them with
+ * printf("%.*s", SV_ARG(view)).
+ */
+typedef struct {
+    const char* data;
+    size_t length;
+} StringView;
+
+#define SV_ARG(view) (int)(view).length, (view).data
+
+/**
+ * Make a view of a NUL-terminated string
+ * 
+ * @param str The string (may be NULL)
+ * @return A view of the string, or an empty view for NULL
+ */
+StringView sv_from_cstr(const char* str);
+
+/**
+ * Compare two views byte for byte
+ * 
+ * @param a The first view
+ * @param b The second view
+ * @return true if both views hold the same bytes
+ */
+bool sv_equals(StringView a, StringView b);
+
+/**
+ * Compare two views ignoring ASCII case
+ * 
+ * @param a The first view
+ * @param b The second view
+ * @return true if both views hold the same text apart from case
+ */
+bool sv_equals_ignore_case(StringView a, StringView b);
+
+/**
+ * Check whether a view contains another, ignoring ASCII case
+ * 
+ * @param haystack The view to search
+ * @param needle The view to look for
+ * @return true if needle occurs in haystack
+ */
+bool sv_contains_ignore_case(StringView haystack, StringView needle);
+
+/**
+ * Hash the bytes of a view (32-bit FNV-1a)
+ * 
+ * @param view The view to hash
+ * @return The hash value
+ */
+uint32_t sv_hash(StringView view);
+
+/**
+ * Hash a view as if it were lowercased, consistent with sv_equals_ignore_case
+ * 
+ * @param view The view to hash
+ * @return The hash value
+ */
+uint32_t sv_hash_ignore_case(StringView view);
+
+#endif /* STRING_VIEW_H */
@@ -0,0 +1,99 @@
+/**
+ * NeuroChef - Symbol Table Implementation
+ * 
+ * This file implements string interning with an open-addressing hash table.
+ */
+
+#include "symbol_table.h"
+#include <stdlib.h>
+
+#define SYMBOL_SLOT_EMPTY SYMBOL_NONE
+
+static int find_slot(const SymbolTable* table, StringView name) {
+    int mask = table->slot_capacity - 1;
+    int slot = (int)(sv_hash(name) & (uint32_t)mask);
+
+    while (table->slots[slot] != SYMBOL_SLOT_EMPTY) {
+        if (sv_equals(table->names[table->slots[slot]], name)) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static bool grow_slots(SymbolTable* table) {
+    int new_capacity = table->slot_capacity == 0 ? 64 : table->slot_capacity * 2;
+    SymbolId* new_slots = (SymbolId*)malloc(new_capacity * sizeof(SymbolId));
+    if (!new_slots) return false;
+
+    for (int i = 0; i < new_capacity; i++) {
+        new_slots[i] = SYMBOL_SLOT_EMPTY;
+    }
+
+    free(table->slots);
+    table->slots = new_slots;
+    table->slot_capacity = new_capacity;
+
+    for (int id = 0; id < table->count; id++) {
+        int slot = find_slot(table, table->names[id]);
+        table->slots[slot] = (SymbolId)id;
+    }
+    return true;
+}
+
+void symbol_table_init(SymbolTable* table) {
+    table->names = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    table->slots = NULL;
+    table->slot_capacity = 0;
+}
+
+SymbolId symbol_table_intern(SymbolTable* table, StringView name) {
+    if (table->slot_capacity > 0) {
+        int slot = find_slot(table, name);
+        if (table->slots[slot] != SYMBOL_SLOT_EMPTY) {
+            return table->slots[slot];
+        }
+    }
+
+    if (table->count >= SYMBOL_MAX_COUNT) return SYMBOL_NONE;
+
+    /* Keep the load factor at or below one half */
+    if ((table->count + 1) * 2 > table->slot_capacity) {
+        if (!grow_slots(table)) return SYMBOL_NONE;
+    }
+
+    if (table->count == table->capacity) {
+        int new_capacity = table->capacity == 0 ? 32 : table->capacity * 2;
+        StringView* new_names = (StringView*)realloc(table->names, new_capacity * sizeof(StringView));
+        if (!new_names) return SYMBOL_NONE;
+        table->names = new_names;
+        table->capacity = new_capacity;
+    }
+
+    SymbolId id = (SymbolId)table->count;
+    table->names[table->count++] = name;
+    table->slots[find_slot(table, name)] = id;
+    return id;
+}
+
+SymbolId symbol_table_find(const SymbolTable* table, StringView name) {
+    if (table->slot_capacity == 0) return SYMBOL_NONE;
+    return table->slots[find_slot(table, name)];
+}
+
+StringView symbol_table_name(const SymbolTable* table, SymbolId id) {
+    if (id >= table->count) {
+        StringView empty = { "", 0 };
+        return empty;
+    }
+    return table->names[id];
+}
+
+void symbol_table_free(SymbolTable* table) {
+    free(table->names);
+    free(table->slots);
+    symbol_table_init(table);
+}
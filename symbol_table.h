@@ -0,0 +1,71 @@
+/**
+ * NeuroChef - Symbol Table
+ * 
+ * This header declares an interning table that maps the small vocabulary of
+ * meal types and sensory attributes to compact 16-bit ids, so attribute
+ * matching is an integer compare.
+ */
+
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <stdint.h>
+#include "string_view.h"
+
+typedef uint16_t SymbolId;
+
+#define SYMBOL_NONE ((SymbolId)0xFFFF)
+#define SYMBOL_MAX_COUNT 0xFFFF
+
+typedef struct {
+    StringView* names;
+    int count;
+    int capacity;
+    SymbolId* slots;
+    int slot_capacity;
+} SymbolTable;
+
+/**
+ * Initialize an empty symbol table
+ * 
+ * @param table The table to initialize
+ */
+void symbol_table_init(SymbolTable* table);
+
+/**
+ * Intern a string, adding it to the table if it is new
+ * 
+ * The table stores the view itself, so its bytes must outlive the table.
+ * 
+ * @param table The symbol table
+ * @param name The string to intern
+ * @return The symbol id, or SYMBOL_NONE if the table is full or out of memory
+ */
+SymbolId symbol_table_intern(SymbolTable* table, StringView name);
+
+/**
+ * Look up a string without adding it
+ * 
+ * @param table The symbol table
+ * @param name The string to look up
+ * @return The symbol id, or SYMBOL_NONE if the string was never interned
+ */
+SymbolId symbol_table_find(const SymbolTable* table, StringView name);
+
+/**
+ * Get the string for a symbol id
+ * 
+ * @param table The symbol table
+ * @param id The symbol id
+ * @return The interned string, or an empty view for an unknown id
+ */
+StringView symbol_table_name(const SymbolTable* table, SymbolId id);
+
+/**
+ * Free the memory owned by a symbol table
+ * 
+ * @param table The table to free
+ */
+void symbol_table_free(SymbolTable* table);
+
+#endif /* SYMBOL_TABLE_H */
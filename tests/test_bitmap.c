@@ -0,0 +1,221 @@
+/**
+ * NeuroChef - Compressed Bitmap Tests
+ *
+ * Checks AND, OR and AND NOT against a plain membership table on bitmaps
+ * whose containers sit on either side of BITMAP_ARRAY_MAX, so every mix of
+ * array and bitset inputs is combined and results move between the two
+ * representations in both directions. Every result must hold exactly the
+ * expected values, store at most BITMAP_ARRAY_MAX values per array and more
+ * per bitset, and keep no empty containers.
+ *
+ *     ./test_bitmap
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../bitmap.h"
+#include "test_util.h"
+
+/* Values span this many containers */
+#define TEST_CONTAINERS 4
+#define TEST_RANGE ((uint32_t)TEST_CONTAINERS << 16)
+#define TEST_ROUNDS 40
+
+/* Container sizes on both sides of the array limit */
+static const int SIZES[] = { 0, 1, 100, 4000, 4095, 4096, 4097, 4200, 6000, 30000, 65536 };
+
+typedef struct {
+    Bitmap bitmap;
+    /* One byte per value in TEST_RANGE */
+    uint8_t* members;
+} TestSet;
+
+static uint32_t random_state = 2024;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+static void test_set_init(TestSet* set) {
+    bitmap_init(&set->bitmap);
+    set->members = (uint8_t*)calloc(TEST_RANGE, 1);
+    REQUIRE(set->members != NULL);
+}
+
+static void test_set_free(TestSet* set) {
+    bitmap_free(&set->bitmap);
+    free(set->members);
+}
+
+/* Build the bitmap from the membership table */
+static void test_set_build(TestSet* set) {
+    bitmap_free(&set->bitmap);
+    for (uint32_t value = 0; value < TEST_RANGE; value++) {
+        if (set->members[value]) REQUIRE(bitmap_append(&set->bitmap, value));
+    }
+}
+
+/* Fill one container with count distinct random values */
+static void fill_container(uint8_t* members, uint32_t key, int count) {
+    uint8_t* container = members + (key << 16);
+    bool invert = count > 32768;
+    int wanted = invert ? 65536 - count : count;
+
+    memset(container, invert ? 1 : 0, 65536);
+    for (int placed = 0; placed < wanted;) {
+        uint32_t low = next_random() & 0xFFFF;
+        if (container[low] == (invert ? 1 : 0)) {
+            container[low] = invert ? 0 : 1;
+            placed++;
+        }
+    }
+}
+
+static void random_set(TestSet* set) {
+    for (uint32_t key = 0; key < TEST_CONTAINERS; key++) {
+        fill_container(set->members, key, SIZES[next_random() % (sizeof(SIZES) / sizeof(SIZES[0]))]);
+    }
+    test_set_build(set);
+}
+
+/* A set that mostly overlaps another, so unions barely grow and
+   differences collapse from bitsets to arrays */
+static void nearby_set(TestSet* set, const TestSet* other) {
+    int keep_per_mille = 900 + (int)(next_random() % 101);
+    int add_per_million = (int)(next_random() % 2000);
+    for (uint32_t value = 0; value < TEST_RANGE; value++) {
+        set->members[value] = other->members[value]
+            ? (int)(next_random() % 1000) < keep_per_mille
+            : (int)(next_random() % 1000000) < add_per_million;
+    }
+    test_set_build(set);
+}
+
+/* Check a result against the expected membership table */
+static void check_result(const Bitmap* bitmap, const uint8_t* expected, const char* label, int round) {
+    uint32_t expected_count = 0;
+    for (uint32_t value = 0; value < TEST_RANGE; value++) {
+        expected_count += expected[value];
+    }
+    CHECK_MSG(bitmap_cardinality(bitmap) == expected_count, "%s, round %d: cardinality %u instead of %u",
+              label, round, bitmap_cardinality(bitmap), expected_count);
+
+    uint32_t* values = (uint32_t*)malloc((expected_count + 1) * sizeof(uint32_t));
+    REQUIRE(values != NULL);
+    uint32_t count = bitmap_to_array(bitmap, values, expected_count + 1);
+    bool same = count == expected_count;
+    for (uint32_t i = 0; same && i < count; i++) {
+        same = values[i] < TEST_RANGE && expected[values[i]] && (i == 0 || values[i] > values[i - 1]);
+    }
+    CHECK_MSG(same, "%s, round %d: values differ", label, round);
+    free(values);
+
+    for (int i = 0; i < bitmap->count; i++) {
+        const BitmapContainer* container = &bitmap->containers[i];
+        CHECK_MSG(container->cardinality > 0, "%s, round %d: empty container %d", label, round, container->key);
+        CHECK_MSG(i == 0 || container->key > bitmap->containers[i - 1].key,
+                  "%s, round %d: containers out of order", label, round);
+        CHECK_MSG(container->type == (container->cardinality > BITMAP_ARRAY_MAX ? BITMAP_CONTAINER_BITSET
+                                                                                : BITMAP_CONTAINER_ARRAY),
+                  "%s, round %d: container %d of %d values stored as %s", label, round, container->key,
+                  container->cardinality, container->type == BITMAP_CONTAINER_ARRAY ? "an array" : "a bitset");
+    }
+}
+
+static void check_operations(const TestSet* a, const TestSet* b, int round) {
+    uint8_t* expected = (uint8_t*)malloc(TEST_RANGE);
+    REQUIRE(expected != NULL);
+    Bitmap result;
+    bitmap_init(&result);
+
+    for (uint32_t value = 0; value < TEST_RANGE; value++) {
+        expected[value] = a->members[value] & b->members[value];
+    }
+    REQUIRE(bitmap_and(&result, &a->bitmap, &b->bitmap));
+    check_result(&result, expected, "AND", round);
+    CHECK(bitmap_and_cardinality(&a->bitmap, &b->bitmap) == bitmap_cardinality(&result));
+
+    for (uint32_t value = 0; value < TEST_RANGE; value++) {
+        expected[value] = a->members[value] | b->members[value];
+    }
+    REQUIRE(bitmap_or(&result, &a->bitmap, &b->bitmap));
+    check_result(&result, expected, "OR", round);
+
+    for (uint32_t value = 0; value < TEST_RANGE; value++) {
+        expected[value] = a->members[value] & !b->members[value];
+    }
+    REQUIRE(bitmap_andnot(&result, &a->bitmap, &b->bitmap));
+    check_result(&result, expected, "AND NOT", round);
+
+    bitmap_free(&result);
+    free(expected);
+}
+
+/* Hand-picked pairs for each container transition */
+static void test_transitions(void) {
+    TestSet a, b;
+    test_set_init(&a);
+    test_set_init(&b);
+
+    /* Two arrays whose union is a bitset */
+    for (uint32_t i = 0; i < 3000; i++) {
+        a.members[i * 2] = 1;
+        b.members[i * 2 + 1] = 1;
+    }
+    /* A bitset minus most of itself is an array */
+    for (uint32_t i = 0; i < 5000; i++) {
+        a.members[(1u << 16) + i] = 1;
+        b.members[(1u << 16) + i] = i >= 10;
+    }
+    /* A bitset minus an array, down to exactly the limit and one above */
+    for (uint32_t i = 0; i < BITMAP_ARRAY_MAX + 1; i++) {
+        a.members[(2u << 16) + i * 3] = 1;
+        a.members[(3u << 16) + i * 3] = 1;
+    }
+    a.members[(3u << 16) + 60000] = 1;
+    b.members[2u << 16] = 1;
+    b.members[(3u << 16) + 1] = 1;
+    test_set_build(&a);
+    test_set_build(&b);
+
+    CHECK(a.bitmap.containers[0].type == BITMAP_CONTAINER_ARRAY);
+    CHECK(a.bitmap.containers[1].type == BITMAP_CONTAINER_BITSET);
+    CHECK(b.bitmap.containers[1].type == BITMAP_CONTAINER_BITSET);
+    CHECK(b.bitmap.containers[2].type == BITMAP_CONTAINER_ARRAY);
+    check_operations(&a, &b, -1);
+    check_operations(&b, &a, -2);
+
+    /* Against an empty bitmap */
+    memset(b.members, 0, TEST_RANGE);
+    test_set_build(&b);
+    check_operations(&a, &b, -3);
+    check_operations(&b, &a, -4);
+
+    test_set_free(&a);
+    test_set_free(&b);
+}
+
+int main(void) {
+    test_transitions();
+
+    TestSet a, b;
+    test_set_init(&a);
+    test_set_init(&b);
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        random_set(&a);
+        if (round % 2 == 0) {
+            random_set(&b);
+        } else {
+            nearby_set(&b, &a);
+        }
+        check_operations(&a, &b, round);
+        check_operations(&b, &a, round);
+    }
+    test_set_free(&a);
+    test_set_free(&b);
+
+    return test_exit_code("test_bitmap");
+}
@@ -0,0 +1,288 @@
+/**
+ * NeuroChef - Fuzzy Name Index Tests
+ *
+ * Checks Myers' bit-parallel edit distance against the textbook dynamic
+ * program at pattern lengths on both sides of each 64-bit word (63, 64, 65
+ * and up), and checks the trigram index: its CSR arrays list exactly the
+ * trigrams of each name, in name order, and a name a few typos away from a
+ * query is always among the candidates.
+ *
+ *     ./test_fuzzy_index
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../fuzzy_index.h"
+#include "test_util.h"
+
+#define TEXT_MAX_LENGTH 320
+#define NAME_COUNT 400
+
+static const int PATTERN_LENGTHS[] = { 1, 2, 3, 31, 32, 33, 63, 64, 65, 100, 127, 128, 129, 192, 255, 256 };
+
+static uint32_t random_state = 77;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+static int min3(int a, int b, int c) {
+    int m = a < b ? a : b;
+    return m < c ? m : c;
+}
+
+/* The distance from the pattern to its best match anywhere in the text:
+   row 0 is all zeros because a match may start at any column */
+static int naive_edit_distance(const char* pattern, size_t pattern_length, const char* text, size_t text_length) {
+    int* previous = (int*)malloc((text_length + 1) * sizeof(int));
+    int* current = (int*)malloc((text_length + 1) * sizeof(int));
+    REQUIRE(previous != NULL && current != NULL);
+
+    for (size_t j = 0; j <= text_length; j++) previous[j] = 0;
+    for (size_t i = 1; i <= pattern_length; i++) {
+        current[0] = (int)i;
+        for (size_t j = 1; j <= text_length; j++) {
+            int substitution = previous[j - 1] + (pattern[i - 1] == text[j - 1] ? 0 : 1);
+            current[j] = min3(substitution, previous[j] + 1, current[j - 1] + 1);
+        }
+        int* swap = previous;
+        previous = current;
+        current = swap;
+    }
+
+    int best = previous[0];
+    for (size_t j = 1; j <= text_length; j++) {
+        if (previous[j] < best) best = previous[j];
+    }
+    free(previous);
+    free(current);
+    return best;
+}
+
+static void random_text(char* out, size_t length, const char* alphabet) {
+    size_t size = strlen(alphabet);
+    for (size_t i = 0; i < length; i++) {
+        out[i] = alphabet[next_random() % size];
+    }
+}
+
+/* Apply edits random substitutions, insertions and deletions */
+static size_t mutate(char* text, size_t length, size_t capacity, int edits, const char* alphabet) {
+    for (int e = 0; e < edits; e++) {
+        size_t at = length ? next_random() % length : 0;
+        switch (next_random() % 3) {
+            case 0:
+                if (length > 0) text[at] = alphabet[next_random() % strlen(alphabet)];
+                break;
+            case 1:
+                if (length < capacity) {
+                    memmove(text + at + 1, text + at, length - at);
+                    text[at] = alphabet[next_random() % strlen(alphabet)];
+                    length++;
+                }
+                break;
+            default:
+                if (length > 0) {
+                    memmove(text + at, text + at + 1, length - at - 1);
+                    length--;
+                }
+                break;
+        }
+    }
+    return length;
+}
+
+static void check_distance(const char* pattern, size_t pattern_length, const char* text, size_t text_length) {
+    int expected = naive_edit_distance(pattern, pattern_length, text, text_length);
+    int distance = fuzzy_edit_distance(pattern, pattern_length, text, text_length);
+    CHECK_MSG(distance == expected, "pattern of %zu, text of %zu: %d instead of %d",
+              pattern_length, text_length, distance, expected);
+}
+
+static void test_edit_distance(void) {
+    static const char* ALPHABETS[] = { "ab", "abc d", "abcdefghijklmnopqrstuvwxyz 0123456789" };
+    char pattern[FUZZY_MAX_NAME_LENGTH];
+    char text[TEXT_MAX_LENGTH + FUZZY_MAX_NAME_LENGTH];
+
+    for (size_t l = 0; l < sizeof(PATTERN_LENGTHS) / sizeof(PATTERN_LENGTHS[0]); l++) {
+        size_t pattern_length = (size_t)PATTERN_LENGTHS[l];
+        for (size_t a = 0; a < sizeof(ALPHABETS) / sizeof(ALPHABETS[0]); a++) {
+            for (int round = 0; round < 20; round++) {
+                random_text(pattern, pattern_length, ALPHABETS[a]);
+
+                /* Unrelated text */
+                size_t text_length = next_random() % TEXT_MAX_LENGTH;
+                random_text(text, text_length, ALPHABETS[a]);
+                check_distance(pattern, pattern_length, text, text_length);
+
+                /* The pattern with a few edits, inside other text */
+                size_t prefix = next_random() % 40;
+                random_text(text, prefix, ALPHABETS[a]);
+                memcpy(text + prefix, pattern, pattern_length);
+                size_t edited = mutate(text + prefix, pattern_length, sizeof(text) - prefix - 40,
+                                       (int)(next_random() % 6), ALPHABETS[a]);
+                size_t suffix = next_random() % 40;
+                random_text(text + prefix + edited, suffix, ALPHABETS[a]);
+                check_distance(pattern, pattern_length, text, prefix + edited + suffix);
+            }
+        }
+    }
+
+    /* Edge cases: empty text, the pattern itself, an edit in the last row */
+    memset(pattern, 'a', sizeof(pattern));
+    CHECK(fuzzy_edit_distance(pattern, 65, "", 0) == 65);
+    CHECK(fuzzy_edit_distance(pattern, 65, pattern, 65) == 0);
+    memcpy(text, pattern, 65);
+    text[64] = 'b';
+    CHECK(fuzzy_edit_distance(pattern, 65, text, 65) == 1);
+    CHECK(fuzzy_edit_distance(pattern, 64, text, 65) == 0);
+    CHECK(fuzzy_edit_distance("", 0, text, 65) == 0);
+
+    /* Patterns beyond FUZZY_MAX_NAME_LENGTH are cut to that length */
+    char long_pattern[FUZZY_MAX_NAME_LENGTH + 20];
+    random_text(long_pattern, sizeof(long_pattern), "abc");
+    random_text(text, 200, "abc");
+    CHECK(fuzzy_edit_distance(long_pattern, sizeof(long_pattern), text, 200) ==
+          naive_edit_distance(long_pattern, FUZZY_MAX_NAME_LENGTH, text, 200));
+}
+
+static void test_normalize(void) {
+    char out[FUZZY_MAX_NAME_LENGTH];
+    CHECK(fuzzy_normalize(sv_from_cstr("  Berry-Blast   SMOOTHIE!! "), out, sizeof(out)) == 20);
+    CHECK(strcmp(out, "berry blast smoothie") == 0);
+    CHECK(fuzzy_normalize(sv_from_cstr("Caf\xc3\xa9 No.2"), out, sizeof(out)) == 8);
+    CHECK(strcmp(out, "caf no 2") == 0);
+    CHECK(fuzzy_normalize(sv_from_cstr("?!"), out, sizeof(out)) == 0 && out[0] == '\0');
+
+    char small[8];
+    size_t length = fuzzy_normalize(sv_from_cstr("abc defghij"), small, sizeof(small));
+    CHECK(length < sizeof(small) && small[length] == '\0' && strncmp(small, "abc def", length) == 0);
+}
+
+static int trigram_code(const char* text) {
+    int code = 0;
+    for (int i = 0; i < 3; i++) {
+        char c = text[i];
+        int symbol = c >= 'a' && c <= 'z' ? c - 'a' + 1 : c >= '0' && c <= '9' ? c - '0' + 27 : 0;
+        code = code * FUZZY_TRIGRAM_ALPHABET + symbol;
+    }
+    return code;
+}
+
+static bool name_has_trigram(const char* name, size_t length, int code) {
+    for (size_t i = 0; i + 3 <= length; i++) {
+        if (trigram_code(name + i) == code) return true;
+    }
+    return false;
+}
+
+static bool posting_contains(const FuzzyIndex* index, int code, uint32_t name) {
+    for (uint32_t p = index->offsets[code]; p < index->offsets[code + 1]; p++) {
+        if (index->postings[p] == name) return true;
+    }
+    return false;
+}
+
+static int distinct_trigrams(const char* text, size_t length) {
+    int count = 0;
+    for (size_t i = 0; i + 3 <= length; i++) {
+        int code = trigram_code(text + i);
+        bool seen = false;
+        for (size_t j = 0; j < i && !seen; j++) {
+            seen = trigram_code(text + j) == code;
+        }
+        count += !seen;
+    }
+    return count;
+}
+
+static void test_trigram_index(void) {
+    static const char* WORDS[] = { "berry", "blast", "smoothie", "soft", "baked", "sweet", "potato", "mild",
+                                   "chicken", "salad", "creamy", "garlic", "mashed", "potatoes", "rice", "bowl" };
+    size_t word_count = sizeof(WORDS) / sizeof(WORDS[0]);
+    char names[NAME_COUNT][FUZZY_MAX_NAME_LENGTH];
+    size_t lengths[NAME_COUNT];
+    StringView views[NAME_COUNT];
+
+    for (int i = 0; i < NAME_COUNT; i++) {
+        int written = 0;
+        int parts = 1 + (int)(next_random() % 4);
+        for (int w = 0; w < parts; w++) {
+            written += snprintf(names[i] + written, sizeof(names[i]) - (size_t)written, "%s%s",
+                                w ? " " : "", WORDS[next_random() % word_count]);
+        }
+        snprintf(names[i] + written, sizeof(names[i]) - (size_t)written, " %d", i);
+        lengths[i] = strlen(names[i]);
+        views[i] = sv_from_cstr(names[i]);
+    }
+    /* Too short for any trigram */
+    snprintf(names[0], sizeof(names[0]), "ab");
+    lengths[0] = 2;
+    views[0] = sv_from_cstr(names[0]);
+
+    FuzzyIndex index;
+    REQUIRE(fuzzy_index_build(&index, views, NAME_COUNT));
+    CHECK(index.name_count == NAME_COUNT);
+
+    /* CSR shape: offsets never decrease and end at the posting count; each
+       list is in increasing name order and lists only names with that
+       trigram */
+    CHECK(index.offsets[0] == 0);
+    uint32_t total = 0;
+    for (int code = 0; code < FUZZY_TRIGRAM_COUNT; code++) {
+        CHECK_MSG(index.offsets[code] <= index.offsets[code + 1], "offsets decrease at trigram %d", code);
+        for (uint32_t p = index.offsets[code]; p < index.offsets[code + 1]; p++) {
+            uint32_t name = index.postings[p];
+            CHECK_MSG(name < NAME_COUNT && name_has_trigram(names[name], lengths[name], code),
+                      "trigram %d lists name %u", code, name);
+            CHECK_MSG(p == index.offsets[code] || index.postings[p - 1] < name,
+                      "trigram %d lists names out of order", code);
+        }
+    }
+
+    /* Every trigram of every name is listed */
+    for (int i = 0; i < NAME_COUNT; i++) {
+        for (size_t t = 0; t + 3 <= lengths[i]; t++) {
+            int code = trigram_code(names[i] + t);
+            CHECK_MSG(posting_contains(&index, code, (uint32_t)i), "\"%s\" missing from trigram %d", names[i], code);
+        }
+    }
+    for (int code = 0; code < FUZZY_TRIGRAM_COUNT; code++) {
+        total += index.offsets[code + 1] - index.offsets[code];
+    }
+    CHECK(index.offsets[FUZZY_TRIGRAM_COUNT] == total);
+
+    /* A name within max_edits of the query always passes the count filter */
+    for (int i = 1; i < NAME_COUNT; i++) {
+        char query[FUZZY_MAX_NAME_LENGTH];
+        int edits = 1 + (int)(next_random() % 2);
+        memcpy(query, names[i], lengths[i]);
+        size_t query_length = mutate(query, lengths[i], sizeof(query) - 1, edits, "abcdefghijklmnopqrstuvwxyz");
+        query[query_length] = '\0';
+
+        int32_t* candidates;
+        int count = fuzzy_index_candidates(&index, query, query_length, edits, NAME_COUNT, &candidates);
+        bool found = false;
+        for (int c = 0; c < count; c++) {
+            found = found || candidates[c] == i;
+        }
+        /* Each edit destroys at most three of the query's trigrams; with
+           none left to share, the filter promises nothing */
+        bool promised = distinct_trigrams(query, query_length) - 3 * edits >= 1;
+        CHECK_MSG(found || !promised, "\"%s\" (%d edits of \"%s\") missed", query, edits, names[i]);
+        free(candidates);
+    }
+
+    fuzzy_index_free(&index);
+    CHECK(index.offsets == NULL && index.postings == NULL);
+}
+
+int main(void) {
+    test_edit_distance();
+    test_normalize();
+    test_trigram_index();
+    return test_exit_code("test_fuzzy_index");
+}
@@ -0,0 +1,209 @@
+/**
+ * NeuroChef - JSON Scanning Kernel Tests
+ *
+ * Forces each scanning kernel the processor supports and checks that it
+ * finds exactly what the scalar kernel finds: on strings whose escapes and
+ * quotes straddle the 16, 32 and 64-byte blocks the vector kernels work
+ * in, on odd and even runs of backslashes, on UTF-8 text, on random input,
+ * and on input cut short at every byte and resumed from the saved state.
+ *
+ *     ./test_json_scan
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../json_scan.h"
+#include "../string_builder.h"
+#include "test_util.h"
+
+#define RANDOM_INPUTS 2000
+#define RANDOM_MAX_LENGTH 300
+
+typedef struct {
+    /* Offset of the result from the start of the input */
+    size_t offset;
+    JsonScanState state;
+} ContainerResult;
+
+static uint32_t random_state = 12345;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+/* Scan a container in one call, or cut at split and resume from the state */
+static ContainerResult scan_container(const char* text, size_t length, size_t split) {
+    JsonScanState state = { 0, false, false };
+    const char* end = text + length;
+    const char* found = json_scan_container(text, text + split, &state);
+    if (found == text + split && split < length) {
+        found = json_scan_container(text + split, end, &state);
+    }
+    ContainerResult result = { (size_t)(found - text), state };
+    return result;
+}
+
+static bool same_container_result(ContainerResult a, ContainerResult b) {
+    return a.offset == b.offset && a.state.depth == b.state.depth &&
+           a.state.in_string == b.state.in_string && a.state.escaped == b.state.escaped;
+}
+
+/* Compare one kernel with the scalar kernel on one input, from every start
+   offset and, for containers, with the input cut at every byte. The input
+   is copied to a buffer of exactly its length so no kernel can read past
+   it unnoticed under a sanitizer. */
+static void check_input(JsonScanKernel kernel, const char* input, size_t length, const char* label) {
+    char* text = (char*)malloc(length ? length : 1);
+    REQUIRE(text != NULL);
+    memcpy(text, input, length);
+    const char* end = text + length;
+
+    for (size_t start = 0; start <= length; start++) {
+        json_scan_set_kernel(JSON_SCAN_SCALAR);
+        const char* string_end = json_scan_string(text + start, end);
+        const char* space_end = json_scan_nonspace(text + start, end);
+        json_scan_set_kernel(kernel);
+        CHECK_MSG(json_scan_string(text + start, end) == string_end,
+                  "%s: %s string scan from %zu", json_scan_kernel_name(kernel), label, start);
+        CHECK_MSG(json_scan_nonspace(text + start, end) == space_end,
+                  "%s: %s whitespace scan from %zu", json_scan_kernel_name(kernel), label, start);
+    }
+
+    json_scan_set_kernel(JSON_SCAN_SCALAR);
+    ContainerResult expected = scan_container(text, length, length);
+    for (size_t split = 0; split <= length; split++) {
+        json_scan_set_kernel(JSON_SCAN_SCALAR);
+        ContainerResult scalar = scan_container(text, length, split);
+        json_scan_set_kernel(kernel);
+        ContainerResult result = scan_container(text, length, split);
+        CHECK_MSG(same_container_result(result, scalar),
+                  "%s: %s container scan cut at %zu stopped at %zu (depth %d) instead of %zu (depth %d)",
+                  json_scan_kernel_name(kernel), label, split, result.offset, result.state.depth,
+                  scalar.offset, scalar.state.depth);
+        /* Resuming must not change where the container ends */
+        CHECK_MSG(same_container_result(scalar, expected), "scalar: %s container scan cut at %zu", label, split);
+    }
+
+    free(text);
+}
+
+/* An object holding one string whose escape sits at a chosen offset, so
+   the escape and the quote after it land on either side of a block edge */
+static void check_escape_at(JsonScanKernel kernel, size_t offset, int backslashes, const char* tail) {
+    StringBuilder text;
+    sb_init(&text);
+    sb_append_cstr(&text, "{\"k\":\"");
+    while (text.length < offset) {
+        sb_append_cstr(&text, "a");
+    }
+    for (int i = 0; i < backslashes; i++) {
+        sb_append_cstr(&text, "\\");
+    }
+    sb_append_cstr(&text, tail);
+    REQUIRE(!text.failed);
+
+    char label[96];
+    snprintf(label, sizeof(label), "%d backslashes at %zu then '%s'", backslashes, offset, tail);
+    check_input(kernel, text.data, text.length, label);
+    sb_free(&text);
+}
+
+static void test_block_boundaries(JsonScanKernel kernel) {
+    /* An odd run escapes the quote after it, so the string goes on and the
+       brace that follows is inside it; an even run does not */
+    static const char* TAILS[] = { "\"}]", "\"x\"}", "n\"}", "\"\"}", "\"{[}\"}" };
+    static const size_t EDGES[] = { 16, 32, 64, 128 };
+
+    for (size_t e = 0; e < sizeof(EDGES) / sizeof(EDGES[0]); e++) {
+        for (size_t offset = EDGES[e] - 3; offset <= EDGES[e] + 2; offset++) {
+            for (int backslashes = 1; backslashes <= 6; backslashes++) {
+                for (size_t t = 0; t < sizeof(TAILS) / sizeof(TAILS[0]); t++) {
+                    check_escape_at(kernel, offset, backslashes, TAILS[t]);
+                }
+            }
+        }
+    }
+
+    /* Runs long enough to span whole blocks */
+    for (int backslashes = 63; backslashes <= 130; backslashes++) {
+        check_escape_at(kernel, 7, backslashes, "\"}");
+    }
+}
+
+static void test_fixed_inputs(JsonScanKernel kernel) {
+    static const char* INPUTS[] = {
+        "",
+        "{}",
+        "[[[[]]]]",
+        "{\"a\": [1, 2, {\"b\": \"}\"}], \"c\": \"]\"}",
+        "{\"caf\xc3\xa9\": \"cr\xc3\xa8me br\xc3\xbbl\xc3\xa9" "e\", \"t\": \"\xe6\x97\xa5\xe6\x9c\xac\"}",
+        "{\"emoji\": \"\xf0\x9f\x8d\xb2 \\\"soup\\\" \xf0\x9f\x8d\xb2\", \"n\": [\"\\u00e9\"]}",
+        "   \t\r\n   \n\n\t\t                                                        {",
+        "{\"unterminated\": \"string that runs to the end \\",
+        "{\"open\": [1, 2, [3",
+        "]}{\"closer first\"}",
+        "{\"k\":\"\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\"}\"}",
+    };
+
+    for (size_t i = 0; i < sizeof(INPUTS) / sizeof(INPUTS[0]); i++) {
+        char label[32];
+        snprintf(label, sizeof(label), "input %zu", i);
+        check_input(kernel, INPUTS[i], strlen(INPUTS[i]), label);
+    }
+
+    /* UTF-8 in the middle of every block position */
+    StringBuilder text;
+    sb_init(&text);
+    sb_append_cstr(&text, "[\"");
+    for (int i = 0; i < 40; i++) {
+        sb_append_cstr(&text, i % 3 == 0 ? "\xc3\xa9" : i % 3 == 1 ? "\xe2\x82\xac" : "\xf0\x9f\x8d\x9e");
+        if (i % 7 == 0) sb_append_cstr(&text, "\\\"");
+    }
+    sb_append_cstr(&text, "\", {\"x\": []}]");
+    REQUIRE(!text.failed);
+    check_input(kernel, text.data, text.length, "UTF-8 text");
+    sb_free(&text);
+}
+
+/* Random input over the bytes the kernels care about, plus UTF-8 */
+static void test_random_inputs(JsonScanKernel kernel) {
+    static const char ALPHABET[] = "\"\\{}[]  \n\ta,:\xc3\xa9";
+    char input[RANDOM_MAX_LENGTH];
+
+    random_state = 12345;
+    for (int i = 0; i < RANDOM_INPUTS; i++) {
+        size_t length = 1 + next_random() % (RANDOM_MAX_LENGTH - 1);
+        input[0] = next_random() % 2 ? '{' : '[';
+        for (size_t j = 1; j < length; j++) {
+            input[j] = ALPHABET[next_random() % (sizeof(ALPHABET) - 1)];
+        }
+
+        char label[32];
+        snprintf(label, sizeof(label), "random input %d", i);
+        check_input(kernel, input, length, label);
+    }
+}
+
+int main(void) {
+    JsonScanKernel kernels[] = { JSON_SCAN_SSE2, JSON_SCAN_AVX2 };
+    int tested = 0;
+
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (!json_scan_set_kernel(kernels[k])) {
+            printf("%s is not supported here; skipped\n", json_scan_kernel_name(kernels[k]));
+            continue;
+        }
+        test_fixed_inputs(kernels[k]);
+        test_block_boundaries(kernels[k]);
+        test_random_inputs(kernels[k]);
+        tested++;
+    }
+    /* The scalar kernel must at least agree with itself across cuts */
+    test_fixed_inputs(JSON_SCAN_SCALAR);
+
+    printf("compared %d vector kernel(s) with the scalar kernel\n", tested);
+    return test_exit_code("test_json_scan");
+}
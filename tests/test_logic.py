@@ -2,13 +2,14 @@
 Tests for the NeuroChef logic module.
 """
 
+import json
 import sys
 import os
 
 # Add the parent directory to the path so we can import the module
 sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '..')))
 
-from neurochef.logic import find_matches
+from neurochef.logic import find_matches, data_path, current_data
 
 # Mock data for testing
 mock_data = {
@@ -55,6 +56,16 @@ def test_quick_meal():
     assert "Smoothie" in response
     assert "5 minutes" in response
 
+def test_quick_meal_converts_units():
+    """Test that prep times in other units are compared in minutes."""
+    data = dict(mock_data, meals=[
+        dict(mock_data["meals"][0], name="Overnight Oats", prep_time={"duration": 1, "unit": "hours"}),
+        dict(mock_data["meals"][0], name="Toast", prep_time={"duration": 300, "unit": "seconds"})
+    ])
+    response = find_matches("I need a quick meal", data)
+    assert "Overnight Oats" not in response
+    assert "Toast (300 seconds)" in response
+
 def test_planning():
     """Test response for planning difficulty query."""
     response = find_matches("I have difficulty planning", mock_data)
@@ -64,3 +75,26 @@ def test_default_response():
     """Test default response for unrecognized query."""
     response = find_matches("hello", mock_data)
     assert "NeuroChef" in response
+
+def test_data_path_from_environment(monkeypatch, tmp_path):
+    """Test that the chatbot's data file, passed in NEUROCHEF_DATA, is used."""
+    json_path = tmp_path / "meals.json"
+    json_path.write_text(json.dumps(mock_data), encoding="utf-8")
+    monkeypatch.setenv("NEUROCHEF_DATA", str(json_path))
+    assert data_path() == str(json_path)
+    assert current_data()["meals"][0]["name"] == "Smoothie"
+
+def test_current_data_reloads(tmp_path):
+    """Test that changes to the file are loaded and broken files are ignored."""
+    json_path = tmp_path / "meals.json"
+    json_path.write_text(json.dumps(mock_data), encoding="utf-8")
+    assert current_data(str(json_path))["meals"][0]["name"] == "Smoothie"
+
+    changed = dict(mock_data, meals=[dict(mock_data["meals"][0], name="Soup")])
+    json_path.write_text(json.dumps(changed), encoding="utf-8")
+    os.utime(json_path, ns=(0, 10**18))
+    assert current_data(str(json_path))["meals"][0]["name"] == "Soup"
+
+    json_path.write_text("{\"meals\": [", encoding="utf-8")
+    os.utime(json_path, ns=(0, 2 * 10**18))
+    assert current_data(str(json_path))["meals"][0]["name"] == "Soup"
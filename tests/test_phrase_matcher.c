@@ -0,0 +1,169 @@
+/**
+ * NeuroChef - Phrase Matcher Tests
+ *
+ * Checks the Aho-Corasick automaton against a naive matcher that tries
+ * every phrase at every position: overlapping and nested phrases, phrases
+ * that are suffixes of others (reached through failure and output links),
+ * ASCII case, bytes that occur in no phrase, and random phrase sets over
+ * a two-letter alphabet, where failure links chain deepest.
+ *
+ *     ./test_phrase_matcher
+ */
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "../phrase_matcher.h"
+#include "test_util.h"
+
+#define MAX_MATCHES 4096
+#define RANDOM_ROUNDS 300
+
+static uint32_t random_state = 4242;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+static bool matches_at(const char* text, size_t end, const char* phrase) {
+    size_t length = strlen(phrase);
+    if (length > end) return false;
+    for (size_t i = 0; i < length; i++) {
+        if (tolower((unsigned char)text[end - length + i]) != tolower((unsigned char)phrase[i])) return false;
+    }
+    return true;
+}
+
+/* Every occurrence by end position, longest phrase first at each end, the
+   order the automaton reports them in */
+static int naive_scan(const char* const* phrases, int count, const char* text, size_t length,
+                      PhraseMatch* matches) {
+    int found = 0;
+    for (size_t end = 1; end <= length; end++) {
+        size_t longest = (size_t)-1;
+        for (;;) {
+            int best = -1;
+            for (int p = 0; p < count; p++) {
+                size_t phrase_length = strlen(phrases[p]);
+                if (phrase_length < longest && matches_at(text, end, phrases[p]) &&
+                    (best < 0 || phrase_length > strlen(phrases[best]))) {
+                    best = p;
+                }
+            }
+            if (best < 0) break;
+            longest = strlen(phrases[best]);
+            REQUIRE(found < MAX_MATCHES);
+            matches[found].phrase = best;
+            matches[found].start = end - longest;
+            found++;
+        }
+    }
+    return found;
+}
+
+static void check_scan(const char* const* phrases, int count, const char* text, const char* label) {
+    PhraseMatcher matcher;
+    REQUIRE(phrase_matcher_build(&matcher, phrases, count));
+
+    static PhraseMatch expected[MAX_MATCHES];
+    static PhraseMatch found[MAX_MATCHES];
+    size_t length = strlen(text);
+    int expected_count = naive_scan(phrases, count, text, length, expected);
+    int found_count = phrase_matcher_scan(&matcher, text, length, found, MAX_MATCHES);
+
+    bool same = found_count == expected_count;
+    for (int i = 0; same && i < found_count; i++) {
+        same = found[i].phrase == expected[i].phrase && found[i].start == expected[i].start;
+    }
+    CHECK_MSG(same, "%s: \"%s\" gave %d matches instead of %d", label, text, found_count, expected_count);
+
+    /* A short buffer still gets the first matches and the full count */
+    if (expected_count > 1) {
+        PhraseMatch first[1];
+        CHECK_MSG(phrase_matcher_scan(&matcher, text, length, first, 1) == expected_count &&
+                  first[0].phrase == expected[0].phrase && first[0].start == expected[0].start,
+                  "%s: \"%s\" with room for one match", label, text);
+    }
+
+    phrase_matcher_free(&matcher);
+}
+
+static void test_known_sets(void) {
+    /* The textbook set: "she" contains "he", which starts "hers" */
+    static const char* CLASSIC[] = { "he", "she", "his", "hers" };
+    check_scan(CLASSIC, 4, "ushers", "classic");
+    check_scan(CLASSIC, 4, "ahishers", "classic");
+    check_scan(CLASSIC, 4, "USHERS and His", "classic");
+
+    /* Nested phrases: every suffix is itself a phrase */
+    static const char* NESTED[] = { "a", "aa", "aaa" };
+    check_scan(NESTED, 3, "aaaa", "nested");
+    check_scan(NESTED, 3, "abaaba", "nested");
+
+    /* Overlapping phrases whose failure links cross from one to the next */
+    static const char* OVERLAP[] = { "abcd", "bcde", "cdef", "bc", "abab", "bab", "ab" };
+    check_scan(OVERLAP, 7, "abcdefg", "overlap");
+    check_scan(OVERLAP, 7, "ababcababab", "overlap");
+    check_scan(OVERLAP, 7, "xxabcdxbcdexcdefx", "overlap");
+
+    /* Phrases with spaces, as the query classifier uses */
+    static const char* QUERIES[] = { "what is in", "is in", "how do i make", "how long", "long does",
+                                     "what can i eat", "can i eat", "i eat" };
+    check_scan(QUERIES, 8, "What is in Berry Blast Smoothie?", "queries");
+    check_scan(QUERIES, 8, "how long does it take? what can I eat", "queries");
+    check_scan(QUERIES, 8, "\xc3\xa9what\tis in\xc3\xa9", "queries");
+
+    /* No phrases, and text with no phrase characters */
+    check_scan(QUERIES, 0, "what is in", "empty set");
+    check_scan(CLASSIC, 4, "", "empty text");
+    check_scan(CLASSIC, 4, "xyz 123 \xff\x80", "no phrase bytes");
+}
+
+/* Random distinct phrases over "ab", so most phrases overlap */
+static void test_random_sets(void) {
+    char storage[24][8];
+    const char* phrases[24];
+    char text[256];
+
+    for (int round = 0; round < RANDOM_ROUNDS; round++) {
+        int count = 0;
+        int wanted = 1 + (int)(next_random() % 24);
+        for (int attempt = 0; attempt < 200 && count < wanted; attempt++) {
+            size_t length = 1 + next_random() % 6;
+            for (size_t i = 0; i < length; i++) {
+                storage[count][i] = next_random() % 2 ? 'a' : 'B';
+            }
+            storage[count][length] = '\0';
+
+            bool duplicate = false;
+            for (int p = 0; p < count && !duplicate; p++) {
+                duplicate = strcasecmp(phrases[p], storage[count]) == 0;
+            }
+            if (!duplicate) {
+                phrases[count] = storage[count];
+                count++;
+            }
+        }
+
+        size_t length = next_random() % (sizeof(text) - 1);
+        for (size_t i = 0; i < length; i++) {
+            uint32_t r = next_random() % 10;
+            text[i] = r < 4 ? 'a' : r < 8 ? 'b' : r < 9 ? 'A' : 'c';
+        }
+        text[length] = '\0';
+
+        char label[32];
+        snprintf(label, sizeof(label), "random set %d", round);
+        check_scan(phrases, count, text, label);
+    }
+}
+
+int main(void) {
+    test_known_sets();
+    test_random_sets();
+    return test_exit_code("test_phrase_matcher");
+}
@@ -0,0 +1,134 @@
+/**
+ * NeuroChef - Query Context Tests
+ *
+ * Checks that the response cache cannot change an answer: inputs that
+ * normalize to the same text share a cache entry, so each must get the
+ * answer it gets from a fresh context whichever of them was asked first.
+ * Also checks that recipe names are cut from queries without surrounding
+ * space. Every query here is answered in C; none reaches the Python module.
+ *
+ *     ./test_query_context meal_data.json
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../query_context.h"
+#include "../recipe_store.h"
+#include "../recipe_utils.h"
+#include "test_util.h"
+
+#define TEST_CACHE_CAPACITY 16
+
+/* Inputs that differ only in case and whitespace */
+static const char* const EQUIVALENT_QUERIES[][2] = {
+    { "how  do i make berry blast smoothie", "how do i make berry blast smoothie" },
+    { "what is in Zorblax Thing?", "what is in zorblax thing?" },
+    { "What is in\tBerry Blast Smoothie?", "  what is in berry blast smoothie?  " },
+    { "HOW LONG DOES IT TAKE TO MAKE Soft Baked Sweet Potato", "how long does it take to make soft baked sweet potato" },
+    { "what's the texture of  mild chicken salad", "What's the TEXTURE of Mild Chicken Salad" },
+};
+
+#define PAIR_COUNT ((int)(sizeof(EQUIVALENT_QUERIES) / sizeof(EQUIVALENT_QUERIES[0])))
+
+typedef struct {
+    char* response;
+    ResponseInfo info;
+} Answer;
+
+static Answer ask(QueryContext* context, const char* query) {
+    Answer answer;
+    const char* response = query_context_respond(context, query, &answer.info);
+    REQUIRE(response != NULL);
+    answer.response = strdup(response);
+    REQUIRE(answer.response != NULL);
+    return answer;
+}
+
+/* Ask a context that has answered nothing yet */
+static Answer ask_fresh(RecipeStore* store, const char* query) {
+    QueryContext context;
+    REQUIRE(query_context_init(&context, store, TEST_CACHE_CAPACITY));
+    Answer answer = ask(&context, query);
+    query_context_release(&context);
+    query_context_free(&context);
+    return answer;
+}
+
+static bool same_answer(const Answer* a, const Answer* b) {
+    return strcmp(a->response, b->response) == 0 && a->info.type == b->info.type &&
+           a->info.recipe_index == b->info.recipe_index && a->info.success == b->info.success;
+}
+
+static void check_pair(RecipeStore* store, const char* first, const char* second) {
+    Answer fresh_first = ask_fresh(store, first);
+    Answer fresh_second = ask_fresh(store, second);
+    CHECK_MSG(same_answer(&fresh_first, &fresh_second), "\"%s\" and \"%s\" answered differently:\n%s\n%s",
+              first, second, fresh_first.response, fresh_second.response);
+
+    QueryContext context;
+    REQUIRE(query_context_init(&context, store, TEST_CACHE_CAPACITY));
+    Answer warm_first = ask(&context, first);
+    Answer warm_second = ask(&context, second);
+    CHECK_MSG(response_cache_get_stats(&context.cache).hits == 1, "\"%s\" missed the cache after \"%s\"",
+              second, first);
+    CHECK_MSG(same_answer(&warm_second, &fresh_second), "\"%s\" after \"%s\" answered\n%s\ninstead of\n%s",
+              second, first, warm_second.response, fresh_second.response);
+    query_context_release(&context);
+    query_context_free(&context);
+
+    free(fresh_first.response);
+    free(fresh_second.response);
+    free(warm_first.response);
+    free(warm_second.response);
+}
+
+/* Names are cut from the normalized text with no surrounding space, so
+   they hit the exact name index */
+static void test_name_spans(const RecipeDB* db) {
+    static const char* QUERIES[] = {
+        "what is in   berry blast smoothie",
+        "What is in\t\tBerry Blast Smoothie?",
+        "how do i make   berry blast smoothie ?!",
+        "   Berry   Blast Smoothie   ",
+    };
+
+    for (size_t i = 0; i < sizeof(QUERIES) / sizeof(QUERIES[0]); i++) {
+        ParsedQuery parsed;
+        REQUIRE(parse_query(QUERIES[i], &parsed));
+        CHECK_MSG(sv_equals(parsed.name, sv_from_cstr("berry blast smoothie")),
+                  "\"%s\": name \"%.*s\"", QUERIES[i], SV_ARG(parsed.name));
+        CHECK_MSG(parsed_query_is_recipe(&parsed), "\"%s\" is not a recipe query", QUERIES[i]);
+        free_parsed_query(&parsed);
+    }
+    CHECK(find_recipe_by_name(db, "berry blast smoothie") != NULL);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <meal_data.json>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    RecipeDB* db = init_recipe_db(argv[1]);
+    REQUIRE(db != NULL && get_recipe_db_error(db) == NULL);
+    db->verbose = false;
+
+    RecipeStore store;
+    REQUIRE(recipe_store_init(&store, db));
+
+    test_name_spans(db);
+    for (int i = 0; i < PAIR_COUNT; i++) {
+        check_pair(&store, EQUIVALENT_QUERIES[i][0], EQUIVALENT_QUERIES[i][1]);
+        check_pair(&store, EQUIVALENT_QUERIES[i][1], EQUIVALENT_QUERIES[i][0]);
+    }
+
+    /* The pair the cache used to confuse: a preparation question either way */
+    Answer answer = ask_fresh(&store, EQUIVALENT_QUERIES[0][0]);
+    CHECK_MSG(answer.info.type == QUERY_PREPARATION && answer.info.recipe_index >= 0,
+              "\"%s\" answered as %s", EQUIVALENT_QUERIES[0][0], query_type_name(answer.info.type));
+    free(answer.response);
+
+    recipe_store_free(&store);
+    return test_exit_code("test_query_context");
+}
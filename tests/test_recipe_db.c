@@ -0,0 +1,671 @@
+/**
+ * NeuroChef - Recipe Database Tests
+ *
+ * Checks that a snapshot is an exact image of the database it was compiled
+ * from: loaded at its preferred address or relocated elsewhere, every
+ * record, index and answer matches the database parsed from the JSON file.
+ * Damaged, truncated and stale snapshots must be rejected.
+ *
+ * The streaming loader must build the same database in chunks of any size,
+ * down to one byte, and reject input cut short. Given a catalog large
+ * enough to be parsed on several threads, also checks that the parallel
+ * loader builds the same database as the sequential one.
+ *
+ * Precomputed responses must be exactly the ones rendered on demand, for
+ * every recipe and query type.
+ *
+ *     ./test_recipe_db meal_data.json <scratch directory> [large catalog]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/time.h>
+#endif
+#include "../recipe_filter.h"
+#include "../recipe_utils.h"
+#include "../snapshot.h"
+#include "../string_builder.h"
+#include "../thread_pool.h"
+#include "test_util.h"
+
+#define TEST_PATH_SIZE 4096
+
+/* Queries asked of every recipe by name */
+static const char* RECIPE_QUERIES[] = {
+    "What is in %s?",
+    "How do I make %s?",
+    "How long does it take to make %s?",
+    "What's the texture of %s?",
+    "Tell me about %s",
+    "what is in %sx",
+};
+
+/* Guidance, suggestion and filter queries */
+static const char* GENERAL_QUERIES[] = {
+    "What can I eat for dinner?",
+    "What should I eat for dinner?",
+    "I have difficulty planning meals",
+    "What are some quick meals?",
+    "I need meals with smooth texture",
+    "warm, soft dinner under 20 minutes total",
+    "meals without crunchy",
+    "breakfast or lunch under 10 minutes prep page 2",
+    "snacks that are sweet and cold",
+    "snacks not too crunchy or spicy",
+    "meals with prep time between 5 and 10 minutes",
+    "dinner in under an hour",
+    "smooth meals with cook time over 30 minutes",
+    "prep under 10 minutes, cook under 20 minutes",
+};
+
+/* A catalog with escapes, skipped values and space around colons
+   throughout, so small stream chunks split each of them */
+static const char STREAM_CATALOG[] =
+    "{\n"
+    "  \"meta\" : {\"note\": \"braces } ] { [ and \\\"quotes\\\" \\\\\\\\\\\" in a skipped value\",\n"
+    "            \"list\": [1, [2, {\"x\": \"}\\\\\"}], -3.5e2, true, null, \"\xc3\xa9\xf0\x9f\x8d\xb2\"]},\n"
+    "  \"sensory_considerations\"\n"
+    "      :\n"
+    "  {\"avoidance_triggers\": {\"texture\": [\"slimy\", \"gritty \\\"bits\\\"\"], \"taste\": [\"bitter\\\\\\\\\"]},\n"
+    "   \"preferred_sensory_profiles\": {\"texture\": [\"smooth\"]},\n"
+    "   \"texture_mapping\": {\"crunchy\": [\"soft \\\\\\\"alternative\\\\\\\"\", \"pur\xc3\xa9" "e\"]}},\n"
+    "  \"meals\": [\n"
+    "    {\"id\": \"escape_01\", \"name\": \"Caf\xc3\xa9 \\\"Special\\\" Toast\",\n"
+    "     \"unknown\": {\"deep\": [[[[\"\\\\\\\\\", \"}]\"]]]], \"n\": 12345678901234567890},\n"
+    "     \"meal_type\": [\"breakfast\", \"snack\"],\n"
+    "     \"sensory_profile\": {\"texture\": [\"crunchy\"], \"temperature\": [\"warm\"], \"taste\": [\"savory\"], \"smell\": [\"toasty\"]},\n"
+    "     \"prep_time\": {\"duration\": 90, \"unit\": \"seconds\"},\n"
+    "     \"cook_time\" : {\"duration\" : 2 , \"unit\" : \"minutes\"},\n"
+    "     \"description\": \"Back\\\\\\\\slash \\\\\\\\\\\\\\\" runs, a tab\\t and a quote \\\" inside\",\n"
+    "     \"ingredients\": [{\"name\": \"Bread \\\\ crumbs\", \"notes\": \"\\\"fresh\\\"\", \"options\": [\"white\", \"brown\\\\\\\\\"]},\n"
+    "                     {\"name\": \"Butter\"}],\n"
+    "     \"preparation_steps\": [\"Toast \\\"lightly\\\".\", \"Spread \\\\ serve.\"],\n"
+    "     \"executive_function_support\": {\"difficulty_planning\": true, \"difficulty_initiating\": false},\n"
+    "     \"notes\": \"\"},\n"
+    "    {\"id\":\"escape_02\",\"name\":\"Quiet Soup\",\"meal_type\":[\"dinner\"],\"sensory_profile\":{\"texture\":[\"smooth\",\"liquid\"],\"temperature\":[\"hot\"]},\"prep_time\":{\"duration\":1,\"unit\":\"hr\"},\"cook_time\":{\"duration\":30,\"unit\":\"minutes\"},\"description\":\"\\\\\\\\\\\\\\\\\",\"ingredients\":[{\"name\":\"Stock\"}],\"preparation_steps\":[\"Simmer.\"],\"executive_function_support\":{\"difficulty_monitoring\":true}} ,\n"
+    "    {   \"id\"   :   \"escape_03\"   ,   \"name\"   :   \"Spaced   Salad\"   ,   \"extra\"   :   [ { } , [ ] , \"\" , 0 ]   ,\n"
+    "        \"meal_type\"   :   [   \"lunch\"   ]   ,   \"prep_time\"   :   {   \"duration\"   :   5   ,   \"unit\"   :   \"min\"   }   }\n"
+    "  ],\n"
+    "  \"executive_function_support_strategies\": {\"difficulty_planning\": [\"plan \\\"ahead\\\"\", \"lists\\\\\"]},\n"
+    "  \"customization_options\": {\"dietary_restrictions\": [\"vegan\"], \"allergy_information\": \"nuts \\\\ \\\"seeds\\\"\",\n"
+    "                            \"preferred_cuisines\": [], \"time_constraints\": [\"quick\"], \"available_equipment\": [\"oven\"]},\n"
+    "  \"skipped \\\"odd\\\" key \\\\\": \"a \\\\\\\" b \\\\\\\\ c \\\" d \\\\\",\n"
+    "  \"skipped_string\": \"\\\\\\\\\\\\\\\" still inside \\\" and \\\\ done\",\n"
+    "  \"additional_notes\": \"trailing value with a } brace, \\\"quoted\\\" \\\\\"\n"
+    "}\n";
+
+static char* read_file(const char* path, size_t* length) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+
+    char* data = NULL;
+    long size = -1;
+    if (fseek(fp, 0, SEEK_END) == 0) size = ftell(fp);
+    if (size >= 0 && fseek(fp, 0, SEEK_SET) == 0) {
+        data = (char*)malloc((size_t)size + 1);
+        if (data && fread(data, 1, (size_t)size, fp) != (size_t)size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(fp);
+    if (data) {
+        data[size] = '\0';
+        *length = (size_t)size;
+    }
+    return data;
+}
+
+static bool write_file(const char* path, const char* data, size_t length) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return false;
+    bool written = fwrite(data, 1, length, fp) == length;
+    return fclose(fp) == 0 && written;
+}
+
+/* Give a file a fixed modification time, so staleness checks do not depend
+   on the file system's timestamp resolution */
+static void set_modification_time(const char* path, long seconds) {
+#ifndef _WIN32
+    struct timeval times[2] = { { seconds, 0 }, { seconds, 0 } };
+    REQUIRE(utimes(path, times) == 0);
+#else
+    (void)path;
+    (void)seconds;
+#endif
+}
+
+static void join_path(char* out, const char* directory, const char* name) {
+    snprintf(out, TEST_PATH_SIZE, "%s/%s", directory, name);
+}
+
+static RecipeDB* load_json(const char* path) {
+    RecipeDB* db = init_recipe_db(path);
+    REQUIRE(db != NULL);
+    CHECK_MSG(get_recipe_db_error(db) == NULL, "%s: %s", path, get_recipe_db_error(db));
+    db->verbose = false;
+    return db;
+}
+
+static bool same_list(const StringList* a, const StringList* b) {
+    if (a->count != b->count) return false;
+    for (int i = 0; i < a->count; i++) {
+        if (!sv_equals(a->items[i], b->items[i])) return false;
+    }
+    return true;
+}
+
+static bool same_symbols(const SymbolId* a, int a_count, const SymbolId* b, int b_count) {
+    return a_count == b_count && (a_count == 0 || memcmp(a, b, (size_t)a_count * sizeof(SymbolId)) == 0);
+}
+
+static bool same_ints(const int32_t* a, const int32_t* b, int count) {
+    return count == 0 || memcmp(a, b, (size_t)count * sizeof(int32_t)) == 0;
+}
+
+static bool same_recipe(const Recipe* a, const Recipe* b) {
+    if (!sv_equals(a->id, b->id) || !sv_equals(a->name, b->name) ||
+        !sv_equals(a->description, b->description) || !sv_equals(a->notes, b->notes) ||
+        a->prep_time_duration != b->prep_time_duration || !sv_equals(a->prep_time_unit, b->prep_time_unit) ||
+        a->cook_time_duration != b->cook_time_duration || !sv_equals(a->cook_time_unit, b->cook_time_unit) ||
+        a->executive_function_support != b->executive_function_support) {
+        return false;
+    }
+    if (!same_symbols(a->meal_type, a->meal_type_count, b->meal_type, b->meal_type_count) ||
+        !same_symbols(a->sensory_texture, a->sensory_texture_count, b->sensory_texture, b->sensory_texture_count) ||
+        !same_symbols(a->sensory_temperature, a->sensory_temperature_count,
+                      b->sensory_temperature, b->sensory_temperature_count) ||
+        !same_symbols(a->sensory_taste, a->sensory_taste_count, b->sensory_taste, b->sensory_taste_count) ||
+        !same_symbols(a->sensory_smell, a->sensory_smell_count, b->sensory_smell, b->sensory_smell_count)) {
+        return false;
+    }
+
+    if (a->ingredients_count != b->ingredients_count ||
+        a->preparation_steps_count != b->preparation_steps_count) {
+        return false;
+    }
+    for (int i = 0; i < a->ingredients_count; i++) {
+        const Ingredient* x = &a->ingredients[i];
+        const Ingredient* y = &b->ingredients[i];
+        if (!sv_equals(x->name, y->name) || !sv_equals(x->notes, y->notes) || !same_list(&x->options, &y->options)) {
+            return false;
+        }
+    }
+    for (int i = 0; i < a->preparation_steps_count; i++) {
+        if (!sv_equals(a->preparation_steps[i], b->preparation_steps[i])) return false;
+    }
+    return true;
+}
+
+/* Compare every record, symbol, column and index of two databases */
+static void check_same_database(const RecipeDB* a, const RecipeDB* b, const char* label) {
+    REQUIRE(a->recipe_count == b->recipe_count);
+    for (int i = 0; i < a->recipe_count; i++) {
+        CHECK_MSG(same_recipe(&a->recipes[i], &b->recipes[i]), "%s: recipe %d", label, i);
+    }
+
+    int count = a->recipe_count;
+    CHECK_MSG(same_ints(a->columns.prep_minutes, b->columns.prep_minutes, count) &&
+              same_ints(a->columns.cook_minutes, b->columns.cook_minutes, count) &&
+              same_ints(a->columns.total_minutes, b->columns.total_minutes, count) &&
+              (count == 0 || memcmp(a->columns.executive_function_support, b->columns.executive_function_support,
+                                    (size_t)count * sizeof(uint32_t)) == 0),
+              "%s: columns", label);
+    for (int t = 0; t < RECIPE_TIME_FIELD_COUNT; t++) {
+        const TimeIndex* x = &a->time_index[t];
+        const TimeIndex* y = &b->time_index[t];
+        CHECK_MSG(x->count == y->count && same_ints(x->minutes, y->minutes, x->count) &&
+                  same_ints(x->recipes, y->recipes, x->count),
+                  "%s: time index %d", label, t);
+    }
+
+    REQUIRE(a->symbols.count == b->symbols.count);
+    for (int id = 0; id < a->symbols.count; id++) {
+        CHECK_MSG(sv_equals(get_symbol_name(a, (SymbolId)id), get_symbol_name(b, (SymbolId)id)),
+                  "%s: symbol %d", label, id);
+        for (int kind = 0; kind < ATTRIBUTE_KIND_COUNT; kind++) {
+            const Bitmap* x = &a->attribute_index[kind][id];
+            const Bitmap* y = &b->attribute_index[kind][id];
+            uint32_t cardinality = bitmap_cardinality(x);
+            CHECK_MSG(bitmap_cardinality(y) == cardinality && bitmap_and_cardinality(x, y) == cardinality,
+                      "%s: posting list of symbol %d, kind %d", label, id, kind);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        const Recipe* recipe = &a->recipes[i];
+        char key[TEST_PATH_SIZE];
+        snprintf(key, sizeof(key), "%.*s", (int)recipe->id.length, recipe->id.data);
+        Recipe* by_id = find_recipe_by_id(b, key);
+        CHECK_MSG(by_id && by_id - b->recipes == find_recipe_by_id(a, key) - a->recipes, "%s: id %s", label, key);
+        snprintf(key, sizeof(key), "%.*s", (int)recipe->name.length, recipe->name.data);
+        Recipe* by_name = find_recipe_by_name(b, key);
+        CHECK_MSG(by_name && by_name - b->recipes == find_recipe_by_name(a, key) - a->recipes,
+                  "%s: name %s", label, key);
+    }
+
+    const SensoryConsiderations* x = &a->sensory_considerations;
+    const SensoryConsiderations* y = &b->sensory_considerations;
+    for (int d = 0; d < SENSORY_DIMENSION_COUNT; d++) {
+        CHECK_MSG(same_list(&x->avoidance_triggers[d], &y->avoidance_triggers[d]) &&
+                  same_list(&x->preferred_profiles[d], &y->preferred_profiles[d]),
+                  "%s: sensory considerations %d", label, d);
+    }
+    REQUIRE(x->texture_mapping_count == y->texture_mapping_count);
+    for (int i = 0; i < x->texture_mapping_count; i++) {
+        CHECK_MSG(sv_equals(x->texture_mappings[i].trigger, y->texture_mappings[i].trigger) &&
+                  same_list(&x->texture_mappings[i].alternatives, &y->texture_mappings[i].alternatives),
+                  "%s: texture mapping %d", label, i);
+    }
+    for (int c = 0; c < EXECUTIVE_CHALLENGE_COUNT; c++) {
+        CHECK_MSG(same_list(&a->executive_strategies[c], &b->executive_strategies[c]),
+                  "%s: executive strategies %d", label, c);
+    }
+    CHECK_MSG(same_list(&a->customization.dietary_restrictions, &b->customization.dietary_restrictions) &&
+              sv_equals(a->customization.allergy_information, b->customization.allergy_information) &&
+              same_list(&a->customization.preferred_cuisines, &b->customization.preferred_cuisines) &&
+              same_list(&a->customization.time_constraints, &b->customization.time_constraints) &&
+              same_list(&a->customization.available_equipment, &b->customization.available_equipment),
+              "%s: customization options", label);
+}
+
+/* Answer a query the way a query context does, without the Python fallback */
+static void answer(const RecipeDB* db, const char* query, StringBuilder* out) {
+    sb_reset(out);
+    ParsedQuery parsed;
+    REQUIRE(parse_query(query, &parsed));
+
+    RecipeFilter filter;
+    if (parse_recipe_filter(db, &parsed, &filter)) {
+        answer_filter_query(db, &filter, out);
+    } else if (parsed_query_is_recipe(&parsed)) {
+        QueryResult result = render_parsed_query(db, &parsed, out);
+        if (result.response != out->data) {
+            sb_append(out, result.response, result.response_length);
+        }
+        sb_appendf(out, "\n[recipe %d]", result.recipe_index);
+        answer_guidance_query(db, &parsed, out);
+    } else {
+        answer_guidance_query(db, &parsed, out);
+    }
+    free_parsed_query(&parsed);
+}
+
+static void check_same_answer(const RecipeDB* a, const RecipeDB* b, const char* query, const char* label) {
+    StringBuilder x, y;
+    sb_init(&x);
+    sb_init(&y);
+    answer(a, query, &x);
+    answer(b, query, &y);
+    CHECK_MSG(!x.failed && !y.failed && strcmp(sb_cstr(&x), sb_cstr(&y)) == 0,
+              "%s: \"%s\" answered\n%s\ninstead of\n%s", label, query, sb_cstr(&y), sb_cstr(&x));
+    sb_free(&x);
+    sb_free(&y);
+}
+
+/* Ask both databases every query and compare the answers */
+static void check_same_answers(const RecipeDB* a, const RecipeDB* b, const char* label) {
+    char query[TEST_PATH_SIZE];
+    for (int i = 0; i < a->recipe_count; i++) {
+        StringView name = a->recipes[i].name;
+        char name_text[TEST_PATH_SIZE];
+        snprintf(name_text, sizeof(name_text), "%.*s", (int)name.length, name.data);
+
+        for (size_t q = 0; q < sizeof(RECIPE_QUERIES) / sizeof(RECIPE_QUERIES[0]); q++) {
+            snprintf(query, sizeof(query), RECIPE_QUERIES[q], name_text);
+            check_same_answer(a, b, query, label);
+        }
+
+        FuzzyMatch x[8], y[8];
+        int x_count = fuzzy_search_recipes(a, name_text + 1, x, 8);
+        int y_count = fuzzy_search_recipes(b, name_text + 1, y, 8);
+        bool same = x_count == y_count;
+        for (int m = 0; same && m < x_count; m++) {
+            same = x[m].recipe_index == y[m].recipe_index && x[m].distance == y[m].distance;
+        }
+        CHECK_MSG(same, "%s: fuzzy search for \"%s\"", label, name_text + 1);
+    }
+
+    for (size_t q = 0; q < sizeof(GENERAL_QUERIES) / sizeof(GENERAL_QUERIES[0]); q++) {
+        check_same_answer(a, b, GENERAL_QUERIES[q], label);
+    }
+}
+
+static void test_snapshot_round_trip(const RecipeDB* json_db, const char* json_path, const char* snapshot_path) {
+    SnapshotStatus status;
+    RecipeDB* db = load_recipe_snapshot(snapshot_path, json_path, &status);
+    CHECK(status == SNAPSHOT_LOADED);
+    REQUIRE(db != NULL);
+    db->verbose = false;
+    CHECK(db->from_snapshot);
+
+    check_same_database(json_db, db, "snapshot");
+    check_same_answers(json_db, db, "snapshot");
+    free_recipe_db(db);
+}
+
+/* Occupy the preferred address so the snapshot has to be relocated */
+static void test_snapshot_relocated(const RecipeDB* json_db, const char* json_path, const char* snapshot_path) {
+#ifndef _WIN32
+    size_t length = 1 << 20;
+    void* blocker = mmap((void*)SNAPSHOT_PREFERRED_BASE, length, PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    REQUIRE(blocker != MAP_FAILED);
+    CHECK(blocker == (void*)SNAPSHOT_PREFERRED_BASE);
+
+    SnapshotStatus status;
+    RecipeDB* db = load_recipe_snapshot(snapshot_path, json_path, &status);
+    CHECK(status == SNAPSHOT_LOADED);
+    REQUIRE(db != NULL);
+    db->verbose = false;
+    CHECK((uintptr_t)db->source.data != SNAPSHOT_PREFERRED_BASE);
+
+    check_same_database(json_db, db, "relocated snapshot");
+    check_same_answers(json_db, db, "relocated snapshot");
+    free_recipe_db(db);
+    munmap(blocker, length);
+#else
+    (void)json_db;
+    (void)json_path;
+    (void)snapshot_path;
+#endif
+}
+
+static void expect_rejected(const char* snapshot_path, const char* json_path, SnapshotStatus expected,
+                            const char* label) {
+    SnapshotStatus status;
+    RecipeDB* db = load_recipe_snapshot(snapshot_path, json_path, &status);
+    CHECK_MSG(db == NULL && status == expected, "%s: status %s", label, snapshot_status_name(status));
+    if (db) free_recipe_db(db);
+}
+
+/* Flip one byte at a time, in the header, the records, the relocation
+   table and the last byte, and cut the file short */
+static void test_snapshot_rejects_damage(const char* json_path, const char* snapshot_path, const char* work_dir) {
+    size_t length;
+    char* image = read_file(snapshot_path, &length);
+    REQUIRE(image != NULL && length > 64);
+
+    char damaged_path[TEST_PATH_SIZE];
+    join_path(damaged_path, work_dir, "damaged.ncdb");
+
+    size_t positions[] = { 0, 24, length / 3, length / 2, length - 9, length - 1 };
+    for (size_t i = 0; i < sizeof(positions) / sizeof(positions[0]); i++) {
+        image[positions[i]] ^= 0x5A;
+        REQUIRE(write_file(damaged_path, image, length));
+        image[positions[i]] ^= 0x5A;
+
+        char label[64];
+        snprintf(label, sizeof(label), "byte %zu of %zu flipped", positions[i], length);
+        expect_rejected(damaged_path, json_path, SNAPSHOT_INVALID, label);
+    }
+
+    REQUIRE(write_file(damaged_path, image, length / 2));
+    expect_rejected(damaged_path, json_path, SNAPSHOT_INVALID, "truncated");
+    REQUIRE(write_file(damaged_path, image, 16));
+    expect_rejected(damaged_path, json_path, SNAPSHOT_INVALID, "shorter than a header");
+
+    /* A damaged snapshot falls back to the JSON file */
+    image[length / 2] ^= 0x5A;
+    REQUIRE(write_file(damaged_path, image, length));
+    SnapshotStatus status;
+    RecipeDB* db = open_recipe_db(json_path, damaged_path, &status);
+    CHECK(status == SNAPSHOT_INVALID);
+    CHECK(db != NULL && !db->from_snapshot && db->recipe_count > 0);
+    if (db) free_recipe_db(db);
+
+    remove(damaged_path);
+    join_path(damaged_path, work_dir, "missing.ncdb");
+    expect_rejected(damaged_path, json_path, SNAPSHOT_MISSING, "missing");
+    free(image);
+}
+
+/* A snapshot is stale once its JSON file changes, but not when the file is
+   only touched */
+static void test_snapshot_rejects_stale(const char* json_path, const char* work_dir) {
+    size_t length;
+    char* source = read_file(json_path, &length);
+    REQUIRE(source != NULL);
+
+    char copy_path[TEST_PATH_SIZE], snapshot_path[TEST_PATH_SIZE];
+    join_path(copy_path, work_dir, "stale.json");
+    join_path(snapshot_path, work_dir, "stale.ncdb");
+    REQUIRE(write_file(copy_path, source, length));
+    set_modification_time(copy_path, 1000000000L);
+
+    RecipeDB* db = load_json(copy_path);
+    const char* error = write_recipe_snapshot(db, copy_path, snapshot_path);
+    CHECK_MSG(error == NULL, "%s", error);
+    free_recipe_db(db);
+
+    SnapshotStatus status;
+    db = load_recipe_snapshot(snapshot_path, copy_path, &status);
+    CHECK(db != NULL && status == SNAPSHOT_LOADED);
+    if (db) free_recipe_db(db);
+
+    /* Touched: same size and contents, another time */
+    set_modification_time(copy_path, 1000000100L);
+    db = load_recipe_snapshot(snapshot_path, copy_path, &status);
+    CHECK(db != NULL && status == SNAPSHOT_LOADED);
+    if (db) free_recipe_db(db);
+
+    /* Same size, one byte different */
+    char* space = strchr(source, ' ');
+    REQUIRE(space != NULL);
+    *space = '\t';
+    REQUIRE(write_file(copy_path, source, length));
+    set_modification_time(copy_path, 1000000200L);
+    expect_rejected(snapshot_path, copy_path, SNAPSHOT_STALE, "one byte changed");
+    *space = ' ';
+
+    /* Grown */
+    REQUIRE(write_file(copy_path, source, length));
+    FILE* fp = fopen(copy_path, "ab");
+    REQUIRE(fp != NULL);
+    fputc('\n', fp);
+    fclose(fp);
+    set_modification_time(copy_path, 1000000000L);
+    expect_rejected(snapshot_path, copy_path, SNAPSHOT_STALE, "grown");
+
+    remove(copy_path);
+    remove(snapshot_path);
+    free(source);
+}
+
+/* Snapshots serialize every record, string and index in a fixed order, so
+   two databases with the same contents compile to the same bytes */
+static void check_same_snapshot(const RecipeDB* a, const RecipeDB* b, const char* json_path,
+                                const char* work_dir, const char* label) {
+    char a_path[TEST_PATH_SIZE], b_path[TEST_PATH_SIZE];
+    join_path(a_path, work_dir, "loader_a.ncdb");
+    join_path(b_path, work_dir, "loader_b.ncdb");
+    REQUIRE(write_recipe_snapshot(a, json_path, a_path) == NULL);
+    REQUIRE(write_recipe_snapshot(b, json_path, b_path) == NULL);
+
+    size_t a_length, b_length;
+    char* a_image = read_file(a_path, &a_length);
+    char* b_image = read_file(b_path, &b_length);
+    REQUIRE(a_image != NULL && b_image != NULL);
+    CHECK_MSG(a_length == b_length && memcmp(a_image, b_image, a_length) == 0, "%s: snapshot bytes", label);
+
+    free(a_image);
+    free(b_image);
+    remove(a_path);
+    remove(b_path);
+}
+
+/* Parse the catalog on 1, 2 and several threads and compare the results:
+   symbol ids, recipe order and everything the arenas hold */
+static void test_parallel_loader(const char* catalog_path, const char* work_dir) {
+    size_t length;
+    char* catalog = read_file(catalog_path, &length);
+    REQUIRE(catalog != NULL);
+    free(catalog);
+    /* Smaller files are always parsed on one thread */
+    REQUIRE(length >= 1024 * 1024);
+
+    set_recipe_loader_threads(1);
+    RecipeDB* sequential = load_json(catalog_path);
+    REQUIRE(sequential->recipe_count > 0);
+
+    int default_threads = thread_pool_default_size();
+    int thread_counts[] = { 2, 7, default_threads > 2 ? default_threads : 3 };
+    for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++) {
+        set_recipe_loader_threads(thread_counts[i]);
+        RecipeDB* parallel = load_json(catalog_path);
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d loader threads", thread_counts[i]);
+        check_same_database(sequential, parallel, label);
+        check_same_answers(sequential, parallel, label);
+        check_same_snapshot(sequential, parallel, catalog_path, work_dir, label);
+        free_recipe_db(parallel);
+    }
+
+    set_recipe_loader_threads(0);
+    free_recipe_db(sequential);
+}
+
+static RecipeDB* load_streamed(const char* path, size_t chunk_size) {
+    set_recipe_stream_chunk_size(chunk_size);
+    RecipeDB* db = init_recipe_db_streaming(path);
+    set_recipe_stream_chunk_size(0);
+    REQUIRE(db != NULL);
+    db->verbose = false;
+    return db;
+}
+
+/* Stream a catalog in chunks of each size and compare with mapping it */
+static void check_streamed(const char* path, const char* work_dir, const size_t* chunk_sizes, size_t count) {
+    RecipeDB* mapped = load_json(path);
+    for (size_t i = 0; i < count; i++) {
+        RecipeDB* streamed = load_streamed(path, chunk_sizes[i]);
+
+        char label[TEST_PATH_SIZE];
+        snprintf(label, sizeof(label), "%s streamed in %zu-byte chunks", path, chunk_sizes[i]);
+        CHECK_MSG(get_recipe_db_error(streamed) == NULL, "%s: %s", label, get_recipe_db_error(streamed));
+        if (!get_recipe_db_error(streamed)) {
+            check_same_database(mapped, streamed, label);
+            check_same_answers(mapped, streamed, label);
+            check_same_snapshot(mapped, streamed, path, work_dir, label);
+        }
+        free_recipe_db(streamed);
+    }
+    free_recipe_db(mapped);
+}
+
+/* Streaming must build the database mapping builds, however the input is
+   cut into chunks, and must reject input cut short anywhere */
+static void test_streaming_loader(const char* json_path, const char* work_dir, const char* large_catalog) {
+    static const size_t CHUNK_SIZES[] = { 1, 7, 4096, 0 };
+    static const size_t LARGE_CHUNK_SIZES[] = { 7, 0 };
+    size_t chunk_count = sizeof(CHUNK_SIZES) / sizeof(CHUNK_SIZES[0]);
+
+    check_streamed(json_path, work_dir, CHUNK_SIZES, chunk_count);
+
+    char path[TEST_PATH_SIZE];
+    join_path(path, work_dir, "stream_catalog.json");
+    size_t length = sizeof(STREAM_CATALOG) - 1;
+    REQUIRE(write_file(path, STREAM_CATALOG, length));
+    check_streamed(path, work_dir, CHUNK_SIZES, chunk_count);
+
+    if (large_catalog) {
+        check_streamed(large_catalog, work_dir, LARGE_CHUNK_SIZES,
+                       sizeof(LARGE_CHUNK_SIZES) / sizeof(LARGE_CHUNK_SIZES[0]));
+    }
+
+    /* Every prefix that stops before the closing brace is malformed */
+    size_t closing = length;
+    while (closing > 0 && STREAM_CATALOG[closing - 1] != '}') closing--;
+    for (size_t cut = 0; cut + 1 < closing; cut++) {
+        REQUIRE(write_file(path, STREAM_CATALOG, cut));
+        for (size_t i = 0; i < 2; i++) {
+            RecipeDB* db = load_streamed(path, CHUNK_SIZES[i]);
+            CHECK_MSG(get_recipe_db_error(db) != NULL, "catalog cut at %zu, streamed in %zu-byte chunks, loaded",
+                      cut, CHUNK_SIZES[i]);
+            free_recipe_db(db);
+        }
+    }
+    remove(path);
+}
+
+/* Every recipe's response to every query type, precomputed and rendered */
+static void test_precomputed_responses(const char* path, const char* label) {
+    RecipeDB* rendered = load_json(path);
+    RecipeDB* precomputed = load_json(path);
+    REQUIRE(precompute_recipe_responses(precomputed));
+    REQUIRE(precomputed->response_blob != NULL);
+    CHECK(precompute_recipe_responses(precomputed));
+
+    StringBuilder x, y;
+    sb_init(&x);
+    sb_init(&y);
+    char query[TEST_PATH_SIZE];
+    for (int i = 0; i < rendered->recipe_count; i++) {
+        StringView name = rendered->recipes[i].name;
+        snprintf(query, sizeof(query), "tell me about %.*s", (int)name.length, name.data);
+        ParsedQuery parsed;
+        REQUIRE(parse_query(query, &parsed));
+        /* Look up the name as stored, whatever the parser would cut */
+        parsed.name = name;
+
+        /* Types past QUERY_GENERAL share its slot in the table */
+        for (int type = QUERY_INGREDIENTS; type <= QUERY_UNKNOWN; type++) {
+            parsed.type = (QueryType)type;
+            QueryResult a = render_parsed_query(rendered, &parsed, &x);
+            QueryResult b = render_parsed_query(precomputed, &parsed, &y);
+            CHECK_MSG(a.success && b.success && a.recipe_index == b.recipe_index && a.recipe_index >= 0 &&
+                      a.response_length == b.response_length &&
+                      memcmp(a.response, b.response, a.response_length) == 0,
+                      "%s: %s response for \"%.*s\" is\n%.*s\ninstead of\n%.*s", label,
+                      query_type_name((QueryType)type), (int)name.length, name.data, (int)b.response_length,
+                      b.response ? b.response : "", (int)a.response_length, a.response ? a.response : "");
+            CHECK_MSG(b.response >= precomputed->response_blob &&
+                      b.response < precomputed->response_blob + precomputed->response_blob_size,
+                      "%s: %s response for \"%.*s\" was not precomputed", label,
+                      query_type_name((QueryType)type), (int)name.length, name.data);
+        }
+        free_parsed_query(&parsed);
+    }
+
+    sb_free(&x);
+    sb_free(&y);
+    free_recipe_db(precomputed);
+    free_recipe_db(rendered);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3 && argc != 4) {
+        fprintf(stderr, "Usage: %s <meal_data.json> <scratch directory> [large catalog]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char* json_path = argv[1];
+    const char* work_dir = argv[2];
+
+    RecipeDB* json_db = load_json(json_path);
+    REQUIRE(json_db->recipe_count > 0);
+
+    char snapshot_path[TEST_PATH_SIZE];
+    join_path(snapshot_path, work_dir, "test_recipe_db.ncdb");
+    const char* error = write_recipe_snapshot(json_db, json_path, snapshot_path);
+    REQUIRE(error == NULL);
+
+    test_snapshot_round_trip(json_db, json_path, snapshot_path);
+    test_snapshot_relocated(json_db, json_path, snapshot_path);
+    test_snapshot_rejects_damage(json_path, snapshot_path, work_dir);
+    test_snapshot_rejects_stale(json_path, work_dir);
+    test_streaming_loader(json_path, work_dir, argc == 4 ? argv[3] : NULL);
+    test_precomputed_responses(json_path, "meal_data");
+    if (argc == 4) {
+        test_parallel_loader(argv[3], work_dir);
+        test_precomputed_responses(argv[3], "large catalog");
+    }
+
+    remove(snapshot_path);
+    free_recipe_db(json_db);
+    return test_exit_code("test_recipe_db");
+}
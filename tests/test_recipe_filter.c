@@ -0,0 +1,489 @@
+/**
+ * NeuroChef - Recipe Filter Tests
+ *
+ * Checks run_recipe_filter against a plain evaluation of the predicate tree
+ * over every recipe, reading each recipe's own attribute lists rather than
+ * the posting bitmaps. Filters are built by hand to drive the search from
+ * a posting bitmap, from a narrow time slice and by a full scan, and parsed
+ * from queries with OR groups, exclusions, unknown words and pages. Every
+ * filter is read back a page at a time at several page sizes, checking
+ * each page and its "more" flag. The catalog is generated with one value
+ * shared by two attribute kinds and no "chewy" recipe.
+ *
+ *     ./test_recipe_filter <scratch directory>
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../recipe_filter.h"
+#include "../string_builder.h"
+#include "test_util.h"
+
+#define TEST_PATH_SIZE 4096
+#define CATALOG_SIZE 600
+/* FILTER_TIME_DRIVER_DIVISOR in recipe_filter.c */
+#define TIME_DRIVER_DIVISOR 16
+
+static uint32_t random_state = 2024;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+static const char* MEAL_TYPES[] = { "breakfast", "lunch", "dinner", "snack" };
+static const char* TEXTURES[] = { "soft", "creamy", "crunchy", "smooth" };
+static const char* TEMPERATURES[] = { "warm", "cold" };
+/* "mild" is both a taste and a smell */
+static const char* TASTES[] = { "sweet", "savory", "spicy", "mild" };
+static const char* SMELLS[] = { "mild", "fruity", "smoky" };
+
+#define COUNT_OF(array) ((int)(sizeof(array) / sizeof((array)[0])))
+
+/* Each value with the given percent chance; snacks are rare, so their
+   posting is much smaller than the others */
+static void append_values(StringBuilder* json, const char* key, const char** values, int count) {
+    sb_appendf(json, "\"%s\": [", key);
+    bool first = true;
+    for (int i = 0; i < count; i++) {
+        uint32_t percent = strcmp(values[i], "snack") == 0 ? 4 : 40;
+        if (next_random() % 100 < percent) {
+            sb_appendf(json, "%s\"%s\"", first ? "" : ", ", values[i]);
+            first = false;
+        }
+    }
+    sb_append_cstr(json, "]");
+}
+
+/* A time in minutes, now and then in hours or an unknown unit */
+static void append_time(StringBuilder* json, const char* key, int max_minutes) {
+    uint32_t r = next_random() % 50;
+    if (r == 0) {
+        sb_appendf(json, "\"%s\": {\"duration\": 3, \"unit\": \"pinch\"}", key);
+    } else if (r < 5) {
+        sb_appendf(json, "\"%s\": {\"duration\": %d, \"unit\": \"hours\"}", key, 1 + (int)(next_random() % 2));
+    } else {
+        sb_appendf(json, "\"%s\": {\"duration\": %d, \"unit\": \"minutes\"}", key,
+                   (int)(next_random() % (uint32_t)(max_minutes + 1)));
+    }
+}
+
+static void write_catalog(const char* path) {
+    StringBuilder json;
+    sb_init(&json);
+    sb_append_cstr(&json, "{\"meals\": [\n");
+    for (int i = 0; i < CATALOG_SIZE; i++) {
+        sb_appendf(&json, "%s{\"id\": \"filter_%d\", \"name\": \"Filter Meal %d\", ", i > 0 ? "," : "", i, i);
+        append_values(&json, "meal_type", MEAL_TYPES, COUNT_OF(MEAL_TYPES));
+        sb_append_cstr(&json, ",\n \"sensory_profile\": {");
+        append_values(&json, "texture", TEXTURES, COUNT_OF(TEXTURES));
+        sb_append_cstr(&json, ", ");
+        append_values(&json, "temperature", TEMPERATURES, COUNT_OF(TEMPERATURES));
+        sb_append_cstr(&json, ", ");
+        append_values(&json, "taste", TASTES, COUNT_OF(TASTES));
+        sb_append_cstr(&json, ", ");
+        append_values(&json, "smell", SMELLS, COUNT_OF(SMELLS));
+        sb_append_cstr(&json, "},\n ");
+        append_time(&json, "prep_time", 120);
+        sb_append_cstr(&json, ", ");
+        append_time(&json, "cook_time", 90);
+        sb_append_cstr(&json, "}\n");
+    }
+    sb_append_cstr(&json, "]}\n");
+    REQUIRE(!json.failed);
+
+    FILE* file = fopen(path, "wb");
+    REQUIRE(file != NULL);
+    REQUIRE(fwrite(json.data, 1, json.length, file) == json.length);
+    fclose(file);
+    sb_free(&json);
+}
+
+/* ===== Reference evaluation ===== */
+
+static bool recipe_has(const Recipe* recipe, AttributeKind kind, SymbolId value) {
+    int count;
+    const SymbolId* ids = get_recipe_attributes(recipe, kind, &count);
+    for (int i = 0; i < count; i++) {
+        if (ids[i] == value) return true;
+    }
+    return false;
+}
+
+static bool reference_matches(const RecipeDB* db, const RecipeFilter* filter, int index, int recipe) {
+    const FilterNode* node = &filter->nodes[index];
+
+    switch (node->type) {
+        case FILTER_ATTRIBUTE:
+            for (int kind = 0; kind < ATTRIBUTE_KIND_COUNT; kind++) {
+                if ((node->kinds & (1u << kind)) && recipe_has(&db->recipes[recipe], (AttributeKind)kind, node->value)) {
+                    return true;
+                }
+            }
+            return false;
+        case FILTER_TIME: {
+            int32_t minutes = get_recipe_time_column(db, node->field)[recipe];
+            return minutes != RECIPE_MINUTES_UNKNOWN && minutes >= node->min_minutes &&
+                   minutes <= node->max_minutes;
+        }
+        case FILTER_UNKNOWN:
+            return false;
+        case FILTER_NOT:
+            return !reference_matches(db, filter, node->first_child, recipe);
+        case FILTER_OR:
+            for (int child = node->first_child; child >= 0; child = filter->nodes[child].next_sibling) {
+                if (reference_matches(db, filter, child, recipe)) return true;
+            }
+            return false;
+        default:
+            for (int child = node->first_child; child >= 0; child = filter->nodes[child].next_sibling) {
+                if (!reference_matches(db, filter, child, recipe)) return false;
+            }
+            return true;
+    }
+}
+
+/* Every match in recipe order; returns the count */
+static int reference_run(const RecipeDB* db, const RecipeFilter* filter, int* recipe_indices) {
+    int count = 0;
+    for (int recipe = 0; recipe < db->recipe_count; recipe++) {
+        if (reference_matches(db, filter, filter->root, recipe)) recipe_indices[count++] = recipe;
+    }
+    return count;
+}
+
+/* Read the filter back a page at a time, past the last match */
+static void check_pages(const RecipeDB* db, const RecipeFilter* filter, const int* expected, int total,
+                        int page_size, const char* label) {
+    int found[CATALOG_SIZE];
+    for (int offset = 0; offset <= total + page_size; offset += page_size) {
+        bool more = true;
+        int count = run_recipe_filter(db, filter, offset, found, page_size, &more);
+
+        int wanted = offset < total ? total - offset : 0;
+        if (wanted > page_size) wanted = page_size;
+        bool same = count == wanted;
+        for (int i = 0; same && i < count; i++) {
+            same = found[i] == expected[offset + i];
+        }
+        CHECK_MSG(same, "%s: %d matches at offset %d of %d, expected %d", label, count, offset, page_size,
+                  wanted);
+        CHECK_MSG(more == (offset + wanted < total), "%s: more is %d at offset %d of %d with %d matches",
+                  label, more, offset, page_size, total);
+    }
+}
+
+/* Returns the number of matches */
+static int check_filter(const RecipeDB* db, const RecipeFilter* filter, const char* label) {
+    static const int PAGE_SIZES[] = { 1, 3, RECIPE_FILTER_PAGE_SIZE, 64, CATALOG_SIZE };
+
+    int expected[CATALOG_SIZE];
+    int total = reference_run(db, filter, expected);
+    for (int i = 0; i < COUNT_OF(PAGE_SIZES); i++) {
+        /* One match per page over a big result costs a pass per match */
+        if (PAGE_SIZES[i] == 1 && total > 64) continue;
+        check_pages(db, filter, expected, total, PAGE_SIZES[i], label);
+    }
+    return total;
+}
+
+/* ===== Hand-built filters ===== */
+
+static void filter_init(RecipeFilter* filter) {
+    memset(filter, 0, sizeof(*filter));
+    filter->page = 1;
+    filter->root = 0;
+    filter->node_count = 1;
+    filter->nodes[0].type = FILTER_AND;
+    filter->nodes[0].first_child = -1;
+    filter->nodes[0].next_sibling = -1;
+}
+
+/* Add a node as the last child of parent */
+static int filter_add(RecipeFilter* filter, int parent, FilterNodeType type) {
+    REQUIRE(filter->node_count < RECIPE_FILTER_MAX_NODES);
+    int index = filter->node_count++;
+    FilterNode* node = &filter->nodes[index];
+    node->type = type;
+    node->first_child = -1;
+    node->next_sibling = -1;
+
+    int* link = &filter->nodes[parent].first_child;
+    while (*link >= 0) link = &filter->nodes[*link].next_sibling;
+    *link = index;
+    return index;
+}
+
+static int add_attribute(const RecipeDB* db, RecipeFilter* filter, int parent, const char* value,
+                         uint32_t kinds) {
+    int index = filter_add(filter, parent, FILTER_ATTRIBUTE);
+    filter->nodes[index].value = symbol_table_find(&db->symbols, sv_from_cstr(value));
+    REQUIRE(filter->nodes[index].value != SYMBOL_NONE);
+    filter->nodes[index].kinds = kinds;
+    return index;
+}
+
+static int add_time(RecipeFilter* filter, int parent, RecipeTimeField field, int32_t min_minutes,
+                    int32_t max_minutes) {
+    int index = filter_add(filter, parent, FILTER_TIME);
+    filter->nodes[index].field = field;
+    filter->nodes[index].min_minutes = min_minutes;
+    filter->nodes[index].max_minutes = max_minutes;
+    return index;
+}
+
+#define KIND(kind) (1u << (kind))
+
+static void test_drivers(const RecipeDB* db) {
+    RecipeFilter filter;
+    int total;
+
+    /* Posting bitmaps: one longer than a batch of candidates, one short */
+    filter_init(&filter);
+    add_attribute(db, &filter, 0, "dinner", KIND(ATTRIBUTE_MEAL_TYPE));
+    total = check_filter(db, &filter, "dinner");
+    CHECK_MSG(total > 256, "only %d dinners, fewer than a batch", total);
+
+    filter_init(&filter);
+    add_attribute(db, &filter, 0, "snack", KIND(ATTRIBUTE_MEAL_TYPE));
+    add_attribute(db, &filter, 0, "warm", KIND(ATTRIBUTE_TEMPERATURE));
+    int not_node = filter_add(&filter, 0, FILTER_NOT);
+    add_attribute(db, &filter, not_node, "spicy", KIND(ATTRIBUTE_TASTE));
+    total = check_filter(db, &filter, "warm snack without spicy");
+    CHECK(total > 0);
+
+    filter_init(&filter);
+    add_attribute(db, &filter, 0, "soft", KIND(ATTRIBUTE_TEXTURE));
+    int or_node = filter_add(&filter, 0, FILTER_OR);
+    add_attribute(db, &filter, or_node, "breakfast", KIND(ATTRIBUTE_MEAL_TYPE));
+    add_attribute(db, &filter, or_node, "lunch", KIND(ATTRIBUTE_MEAL_TYPE));
+    add_time(&filter, 0, RECIPE_TIME_TOTAL, 0, 90);
+    check_filter(db, &filter, "soft breakfast or lunch under 90 minutes");
+
+    /* A narrow time slice, alone and ahead of a wider attribute */
+    filter_init(&filter);
+    add_time(&filter, 0, RECIPE_TIME_PREP, 61, 64);
+    total = check_filter(db, &filter, "prep 61 to 64 minutes");
+    CHECK_MSG(total > 0 && total <= CATALOG_SIZE / TIME_DRIVER_DIVISOR,
+              "%d recipes with 61 to 64 minutes of prep, too many to drive", total);
+
+    filter_init(&filter);
+    add_attribute(db, &filter, 0, "creamy", KIND(ATTRIBUTE_TEXTURE));
+    add_time(&filter, 0, RECIPE_TIME_COOK, 30, 33);
+    not_node = filter_add(&filter, 0, FILTER_NOT);
+    add_attribute(db, &filter, not_node, "cold", KIND(ATTRIBUTE_TEMPERATURE));
+    check_filter(db, &filter, "creamy, cook 30 to 33 minutes, not cold");
+
+    /* Full scans: a value under two kinds, a wide time and exclusions only */
+    filter_init(&filter);
+    add_attribute(db, &filter, 0, "mild", KIND(ATTRIBUTE_TASTE) | KIND(ATTRIBUTE_SMELL));
+    add_time(&filter, 0, RECIPE_TIME_TOTAL, 20, INT32_MAX);
+    total = check_filter(db, &filter, "mild taste or smell over 20 minutes");
+    CHECK(total > 0);
+
+    filter_init(&filter);
+    not_node = filter_add(&filter, 0, FILTER_NOT);
+    add_attribute(db, &filter, not_node, "crunchy", KIND(ATTRIBUTE_TEXTURE));
+    not_node = filter_add(&filter, 0, FILTER_NOT);
+    or_node = filter_add(&filter, not_node, FILTER_OR);
+    add_attribute(db, &filter, or_node, "sweet", KIND(ATTRIBUTE_TASTE));
+    add_attribute(db, &filter, or_node, "smoky", KIND(ATTRIBUTE_SMELL));
+    check_filter(db, &filter, "not crunchy, not sweet or smoky");
+
+    filter_init(&filter);
+    check_filter(db, &filter, "no constraints");
+
+    /* An unknown word at the root matches nothing, whatever else there is */
+    filter_init(&filter);
+    add_time(&filter, 0, RECIPE_TIME_TOTAL, 0, INT32_MAX);
+    int unknown = filter_add(&filter, 0, FILTER_UNKNOWN);
+    filter.nodes[unknown].term = sv_from_cstr("chewy");
+    CHECK(check_filter(db, &filter, "chewy") == 0);
+
+    /* Under a NOT it excludes nothing */
+    filter_init(&filter);
+    add_attribute(db, &filter, 0, "dinner", KIND(ATTRIBUTE_MEAL_TYPE));
+    not_node = filter_add(&filter, 0, FILTER_NOT);
+    unknown = filter_add(&filter, not_node, FILTER_UNKNOWN);
+    filter.nodes[unknown].term = sv_from_cstr("chewy");
+    CHECK(check_filter(db, &filter, "dinner without chewy") > 0);
+}
+
+/* ===== Parsed filters ===== */
+
+static bool parse(const RecipeDB* db, const char* query, RecipeFilter* filter, ParsedQuery* parsed) {
+    REQUIRE(parse_query(query, parsed));
+    bool is_filter = parse_recipe_filter(db, parsed, filter);
+    CHECK_MSG(is_filter, "\"%s\" is not a filter", query);
+    return is_filter;
+}
+
+/* The root's children, which must be n */
+static bool root_children(const RecipeFilter* filter, const FilterNode** children, int n) {
+    int count = 0;
+    for (int child = filter->nodes[filter->root].first_child; child >= 0;
+         child = filter->nodes[child].next_sibling) {
+        if (count < n) children[count] = &filter->nodes[child];
+        count++;
+    }
+    return count == n;
+}
+
+static bool is_time(const FilterNode* node, RecipeTimeField field, int32_t min_minutes, int32_t max_minutes) {
+    return node->type == FILTER_TIME && node->field == field && node->min_minutes == min_minutes &&
+           node->max_minutes == max_minutes;
+}
+
+static bool excludes(const RecipeDB* db, const RecipeFilter* filter, const FilterNode* node, const char* value) {
+    if (node->type != FILTER_NOT) return false;
+    const FilterNode* child = &filter->nodes[node->first_child];
+    return child->type == FILTER_ATTRIBUTE && child->next_sibling < 0 &&
+           sv_equals(get_symbol_name(db, child->value), sv_from_cstr(value));
+}
+
+static void test_parsed_trees(const RecipeDB* db) {
+    RecipeFilter filter;
+    ParsedQuery parsed;
+    const FilterNode* children[3];
+
+    /* The first number takes the second's unit; the field defaults to total */
+    if (parse(db, "between 10 and 20 minutes", &filter, &parsed)) {
+        CHECK_MSG(root_children(&filter, children, 1) && is_time(children[0], RECIPE_TIME_TOTAL, 10, 20),
+                  "\"between 10 and 20 minutes\"");
+        check_filter(db, &filter, "between 10 and 20 minutes");
+    }
+    free_parsed_query(&parsed);
+
+    /* The field word may follow the duration */
+    if (parse(db, "no more than 1 hour prep", &filter, &parsed)) {
+        CHECK_MSG(root_children(&filter, children, 1) && is_time(children[0], RECIPE_TIME_PREP, 0, 60),
+                  "\"no more than 1 hour prep\"");
+        check_filter(db, &filter, "no more than 1 hour prep");
+    }
+    free_parsed_query(&parsed);
+
+    /* The exclusion carries across "too" and "or" to both attributes */
+    if (parse(db, "not too crunchy or spicy", &filter, &parsed)) {
+        CHECK_MSG(root_children(&filter, children, 2) && excludes(db, &filter, children[0], "crunchy") &&
+                  excludes(db, &filter, children[1], "spicy"),
+                  "\"not too crunchy or spicy\"");
+        check_filter(db, &filter, "not too crunchy or spicy");
+    }
+    free_parsed_query(&parsed);
+
+    /* "or" between attributes groups them */
+    if (parse(db, "warm breakfast or lunch meals", &filter, &parsed)) {
+        bool grouped = root_children(&filter, children, 2) && children[0]->type == FILTER_ATTRIBUTE &&
+                       children[1]->type == FILTER_OR;
+        CHECK_MSG(grouped, "\"warm breakfast or lunch meals\"");
+        check_filter(db, &filter, "warm breakfast or lunch meals");
+    }
+    free_parsed_query(&parsed);
+
+    /* A sensory word no recipe has */
+    if (parse(db, "chewy dinners under 30 minutes", &filter, &parsed)) {
+        CHECK_MSG(root_children(&filter, children, 3) && children[0]->type == FILTER_UNKNOWN &&
+                  sv_equals(children[0]->term, sv_from_cstr("chewy")),
+                  "\"chewy dinners under 30 minutes\"");
+        CHECK(check_filter(db, &filter, "chewy dinners under 30 minutes") == 0);
+    }
+    free_parsed_query(&parsed);
+}
+
+/* Queries checked against the reference, and each asked for a later page */
+static const char* FILTER_QUERIES[] = {
+    "warm soft dinners",
+    "snacks without spicy",
+    "breakfast or lunch under 30 minutes prep",
+    "warm dinners or lunches without crunchy",
+    "meals with prep time between 61 and 64 minutes",
+    "prep between 10 and 20 minutes and cook under 15 minutes",
+    "mild meals under 100 minutes total",
+    "meals without crunchy",
+    "meals over 1 hour cook",
+    "sweet or savory snacks",
+    "creamy smooth meals, not cold or smoky, under 2 hours total",
+    "dinners with no more than 45 minutes prep and at least 30 minutes cook",
+};
+
+/* Page N of the response lists matches (N - 1) * page size onwards */
+static void check_response_page(const RecipeDB* db, const char* query, int page, const int* expected,
+                                int total) {
+    char paged[256];
+    snprintf(paged, sizeof(paged), "%s page %d", query, page);
+
+    RecipeFilter filter;
+    ParsedQuery parsed;
+    if (!parse(db, paged, &filter, &parsed)) {
+        free_parsed_query(&parsed);
+        return;
+    }
+    CHECK_MSG(filter.page == page, "\"%s\" asks for page %d", paged, filter.page);
+
+    StringBuilder out;
+    sb_init(&out);
+    REQUIRE(answer_filter_query(db, &filter, &out));
+
+    int first = (page - 1) * RECIPE_FILTER_PAGE_SIZE;
+    for (int i = first; i < total && i < first + RECIPE_FILTER_PAGE_SIZE; i++) {
+        char line[64];
+        snprintf(line, sizeof(line), "- Filter Meal %d", expected[i]);
+        const char* at = strstr(sb_cstr(&out), line);
+        CHECK_MSG(at && (at[strlen(line)] == '\n' || at[strlen(line)] == ' '), "\"%s\" does not list %s:\n%s",
+                  paged, line, sb_cstr(&out));
+    }
+    bool more = first + RECIPE_FILTER_PAGE_SIZE < total;
+    char next[32];
+    snprintf(next, sizeof(next), "Ask for page %d", page + 1);
+    CHECK_MSG((strstr(sb_cstr(&out), next) != NULL) == more, "\"%s\" with %d matches:\n%s", paged, total,
+              sb_cstr(&out));
+
+    sb_free(&out);
+    free_parsed_query(&parsed);
+}
+
+static void test_parsed_queries(const RecipeDB* db) {
+    for (int i = 0; i < COUNT_OF(FILTER_QUERIES); i++) {
+        RecipeFilter filter;
+        ParsedQuery parsed;
+        if (parse(db, FILTER_QUERIES[i], &filter, &parsed)) {
+            int expected[CATALOG_SIZE];
+            int total = check_filter(db, &filter, FILTER_QUERIES[i]);
+            CHECK_MSG(total > 0, "\"%s\" matches nothing", FILTER_QUERIES[i]);
+            REQUIRE(reference_run(db, &filter, expected) == total);
+
+            int last_page = total / RECIPE_FILTER_PAGE_SIZE + 1;
+            check_response_page(db, FILTER_QUERIES[i], 2, expected, total);
+            check_response_page(db, FILTER_QUERIES[i], last_page, expected, total);
+            check_response_page(db, FILTER_QUERIES[i], last_page + 1, expected, total);
+        }
+        free_parsed_query(&parsed);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <scratch directory>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char path[TEST_PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/test_recipe_filter.json", argv[1]);
+    write_catalog(path);
+
+    RecipeDB* db = init_recipe_db(path);
+    REQUIRE(db != NULL);
+    REQUIRE(get_recipe_db_error(db) == NULL);
+    db->verbose = false;
+    REQUIRE(db->recipe_count == CATALOG_SIZE);
+
+    test_drivers(db);
+    test_parsed_trees(db);
+    test_parsed_queries(db);
+
+    free_recipe_db(db);
+    remove(path);
+    return test_exit_code("test_recipe_filter");
+}
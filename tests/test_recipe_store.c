@@ -0,0 +1,237 @@
+/**
+ * NeuroChef - Recipe Store Tests
+ *
+ * Checks hazard-pointer reclamation in the recipe store. First, step by
+ * step on one thread: a replaced database is kept exactly as long as some
+ * reader holds it. Then reader threads acquire, check and release the
+ * database while the main thread keeps publishing new ones and reclaiming
+ * the old. Each catalog names its recipes differently, and the names point
+ * into the file mapping that freeing a database unmaps, so a reader whose
+ * database was freed under it sees other names or faults. Once the readers
+ * stop, every replaced database must have been freed.
+ *
+ *     ./test_recipe_store <scratch directory>
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../recipe_store.h"
+#include "test_util.h"
+
+#define TEST_PATH_SIZE 4096
+#define CATALOG_COUNT 6
+#define CATALOG_RECIPES 20
+#define READER_COUNT 4
+#define PUBLISH_COUNT 200
+/* Wait for every reader to make progress after this many publishes */
+#define PUBLISHES_PER_SYNC 5
+/* Times a reader checks the database it holds before releasing it */
+#define CHECKS_PER_HOLD 3
+
+static char catalog_paths[CATALOG_COUNT][TEST_PATH_SIZE];
+
+static void write_catalog(int catalog) {
+    FILE* file = fopen(catalog_paths[catalog], "wb");
+    REQUIRE(file != NULL);
+    fputs("{\"meals\": [\n", file);
+    for (int i = 0; i < CATALOG_RECIPES; i++) {
+        fprintf(file, "%s{\"id\": \"store_%d_%d\", \"name\": \"Store %d Meal %d\", \"meal_type\": [\"lunch\"]}\n",
+                i > 0 ? "," : "", catalog, i, catalog, i);
+    }
+    fputs("]}\n", file);
+    REQUIRE(fclose(file) == 0);
+}
+
+static RecipeDB* load_catalog(int catalog) {
+    RecipeDB* db = init_recipe_db(catalog_paths[catalog]);
+    REQUIRE(db != NULL && get_recipe_db_error(db) == NULL);
+    db->verbose = false;
+    return db;
+}
+
+/* Whether a database still holds the catalog it was loaded from; returns
+   the catalog, or -1 */
+static int catalog_of(const RecipeDB* db) {
+    if (db->recipe_count != CATALOG_RECIPES) return -1;
+
+    int catalog = -1;
+    for (int i = 0; i < db->recipe_count; i++) {
+        char expected[64];
+        StringView name = db->recipes[i].name;
+        if (catalog < 0) {
+            if (name.length < 7 || memcmp(name.data, "Store ", 6) != 0) return -1;
+            catalog = name.data[6] - '0';
+            if (catalog < 0 || catalog >= CATALOG_COUNT) return -1;
+        }
+        snprintf(expected, sizeof(expected), "Store %d Meal %d", catalog, i);
+        if (!sv_equals(name, sv_from_cstr(expected))) return -1;
+    }
+    return catalog;
+}
+
+static void test_hold_and_release(void) {
+    RecipeStore store;
+    REQUIRE(recipe_store_init(&store, load_catalog(0)));
+    RecipeStoreReader* first = recipe_store_register(&store);
+    RecipeStoreReader* second = recipe_store_register(&store);
+    REQUIRE(first != NULL && second != NULL && first != second);
+
+    /* A database nobody holds is freed as soon as it is replaced */
+    recipe_store_publish(&store, load_catalog(1));
+    CHECK(recipe_store_reclaim(&store) == 0);
+
+    /* One held across two publishes, a second held across one */
+    const RecipeDB* db1 = recipe_store_acquire(&store, first);
+    CHECK(db1 && catalog_of(db1) == 1);
+    recipe_store_publish(&store, load_catalog(2));
+    CHECK(recipe_store_reclaim(&store) == 1);
+
+    const RecipeDB* db2 = recipe_store_acquire(&store, second);
+    CHECK(db2 && catalog_of(db2) == 2);
+    recipe_store_publish(&store, load_catalog(3));
+    CHECK(recipe_store_reclaim(&store) == 2);
+    CHECK(catalog_of(db1) == 1 && catalog_of(db2) == 2);
+
+    /* Released databases go at the next reclaim, held ones stay */
+    recipe_store_release(first);
+    CHECK(recipe_store_reclaim(&store) == 1);
+    CHECK(catalog_of(db2) == 2);
+
+    /* Unregistering releases too, and the slot is reused */
+    recipe_store_unregister(&store, second);
+    CHECK(recipe_store_reclaim(&store) == 0);
+    RecipeStoreReader* reused = recipe_store_register(&store);
+    CHECK(reused == second);
+
+    /* Reacquiring moves a reader on to the current database */
+    const RecipeDB* db3 = recipe_store_acquire(&store, first);
+    CHECK(db3 && catalog_of(db3) == 3);
+    recipe_store_publish(&store, load_catalog(4));
+    CHECK(recipe_store_reclaim(&store) == 1);
+    CHECK(catalog_of(recipe_store_acquire(&store, first)) == 4);
+    CHECK(recipe_store_reclaim(&store) == 0);
+
+    recipe_store_release(first);
+    recipe_store_unregister(&store, first);
+    recipe_store_unregister(&store, reused);
+    recipe_store_free(&store);
+}
+
+typedef struct {
+    RecipeStore* store;
+    int stop;
+    /* Per reader: databases acquired, and ones found changed while held */
+    int acquired[READER_COUNT];
+    int broken[READER_COUNT];
+} ReaderState;
+
+typedef struct {
+    ReaderState* state;
+    int index;
+} ReaderArgs;
+
+static void* run_reader(void* argument) {
+    ReaderArgs* args = (ReaderArgs*)argument;
+    ReaderState* state = args->state;
+    RecipeStoreReader* reader = recipe_store_register(state->store);
+    if (!reader) {
+        __atomic_fetch_add(&state->broken[args->index], 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    while (!__atomic_load_n(&state->stop, __ATOMIC_ACQUIRE)) {
+        const RecipeDB* db = recipe_store_acquire(state->store, reader);
+        uint32_t version = db ? db->version : 0;
+        int catalog = db ? catalog_of(db) : -1;
+        for (int check = 0; check < CHECKS_PER_HOLD; check++) {
+            /* Give the publisher a chance to replace it while it is held */
+            sched_yield();
+            if (!db || db->version != version || catalog_of(db) != catalog || catalog < 0) {
+                __atomic_fetch_add(&state->broken[args->index], 1, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+        recipe_store_release(reader);
+        __atomic_fetch_add(&state->acquired[args->index], 1, __ATOMIC_RELEASE);
+    }
+
+    recipe_store_unregister(state->store, reader);
+    return NULL;
+}
+
+static void test_concurrent_publish(void) {
+    RecipeStore store;
+    REQUIRE(recipe_store_init(&store, load_catalog(0)));
+
+    static ReaderState state;
+    memset(&state, 0, sizeof(state));
+    state.store = &store;
+
+    pthread_t threads[READER_COUNT];
+    ReaderArgs args[READER_COUNT];
+    for (int i = 0; i < READER_COUNT; i++) {
+        args[i].state = &state;
+        args[i].index = i;
+        REQUIRE(pthread_create(&threads[i], NULL, run_reader, &args[i]) == 0);
+    }
+
+    for (int publish = 1; publish <= PUBLISH_COUNT; publish++) {
+        recipe_store_publish(&store, load_catalog(publish % CATALOG_COUNT));
+        int held = recipe_store_reclaim(&store);
+
+        /* Each reader holds at most one database, so at most that many wait */
+        CHECK_MSG(held <= READER_COUNT, "publish %d: %d replaced databases still held", publish, held);
+
+        if (publish % PUBLISHES_PER_SYNC == 0) {
+            for (int i = 0; i < READER_COUNT; i++) {
+                int seen = __atomic_load_n(&state.acquired[i], __ATOMIC_ACQUIRE);
+                while (__atomic_load_n(&state.acquired[i], __ATOMIC_ACQUIRE) == seen &&
+                       __atomic_load_n(&state.broken[i], __ATOMIC_RELAXED) == 0) {
+                    sched_yield();
+                }
+            }
+        }
+    }
+
+    __atomic_store_n(&state.stop, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < READER_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (int i = 0; i < READER_COUNT; i++) {
+        CHECK_MSG(state.broken[i] == 0, "reader %d found its database changed %d times", i, state.broken[i]);
+        CHECK_MSG(state.acquired[i] >= PUBLISH_COUNT / PUBLISHES_PER_SYNC, "reader %d acquired only %d times",
+                  i, state.acquired[i]);
+    }
+
+    /* With every reader gone, every replaced database is freed */
+    CHECK(recipe_store_reclaim(&store) == 0);
+    CHECK(store.retired_count == 0);
+    const RecipeDB* current = store.current;
+    CHECK(current && catalog_of(current) == PUBLISH_COUNT % CATALOG_COUNT);
+
+    recipe_store_free(&store);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <scratch directory>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < CATALOG_COUNT; i++) {
+        snprintf(catalog_paths[i], sizeof(catalog_paths[i]), "%s/test_recipe_store_%d.json", argv[1], i);
+        write_catalog(i);
+    }
+
+    test_hold_and_release();
+    test_concurrent_publish();
+
+    for (int i = 0; i < CATALOG_COUNT; i++) {
+        remove(catalog_paths[i]);
+    }
+    return test_exit_code("test_recipe_store");
+}
@@ -0,0 +1,162 @@
+/**
+ * NeuroChef - Recipe Time Tests
+ *
+ * Checks the conversion of recipe times to minutes: every unit spelling,
+ * seconds rounded up, and negative, unrecognized or overflowing times
+ * reported as unknown. Then loads a small catalog whose recipes mix units
+ * and checks the total time columns and the totals in time answers, which
+ * must only add times once they are in the same unit.
+ *
+ *     ./test_recipe_time <scratch directory>
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../recipe_utils.h"
+#include "../string_builder.h"
+#include "test_util.h"
+
+#define TEST_PATH_SIZE 4096
+
+typedef struct {
+    const char* name;
+    int prep;
+    const char* prep_unit;
+    int cook;
+    const char* cook_unit;
+    /* Expected total in minutes, or RECIPE_MINUTES_UNKNOWN */
+    int32_t total_minutes;
+    /* Expected total line of the time answer */
+    const char* total_line;
+} TimeCase;
+
+static const TimeCase CASES[] = {
+    { "Hour Stew", 1, "hr", 30, "minutes", 90, "Total time: 90 minutes" },
+    { "Same Unit Soup", 10, "minutes", 20, "minutes", 30, "Total time: 30 minutes" },
+    { "Slow Braise", 2, "hours", 3, "hours", 300, "Total time: 5 hours" },
+    { "Mixed Case Roast", 2, "Hours", 15, "mins", 135, "Total time: 135 minutes" },
+    { "Overnight Oats", 1, "day", 5, "min", 1445, "Total time: 1445 minutes" },
+    { "Seconds Toast", 90, "seconds", 2, "minutes", 4, "Total time: 4 minutes" },
+    { "Pinch Salad", 5, "pinch", 10, "minutes", RECIPE_MINUTES_UNKNOWN, "Total time: unknown" },
+    { "Negative Dish", -5, "minutes", 10, "minutes", RECIPE_MINUTES_UNKNOWN, "Total time: unknown" },
+    { "Endless Hours", 999999999, "hours", 999999999, "hours", RECIPE_MINUTES_UNKNOWN,
+      "Total time: 1999999998 hours" },
+    { "Endless Mix", 35791394, "hours", 100, "minutes", RECIPE_MINUTES_UNKNOWN, "Total time: unknown" },
+};
+
+#define CASE_COUNT ((int)(sizeof(CASES) / sizeof(CASES[0])))
+
+static int32_t minutes(int duration, const char* unit) {
+    return recipe_time_in_minutes(duration, sv_from_cstr(unit));
+}
+
+static void test_conversion(void) {
+    CHECK(minutes(0, "minutes") == 0);
+    CHECK(minutes(45, "minute") == 45);
+    CHECK(minutes(45, "mins") == 45);
+    CHECK(minutes(45, "MIN") == 45);
+    CHECK(minutes(2, "hours") == 120);
+    CHECK(minutes(2, "Hour") == 120);
+    CHECK(minutes(2, "hrs") == 120);
+    CHECK(minutes(1, "hr") == 60);
+    CHECK(minutes(2, "days") == 2880);
+    CHECK(minutes(1, "day") == 1440);
+
+    /* Seconds round up to whole minutes */
+    CHECK(minutes(0, "seconds") == 0);
+    CHECK(minutes(1, "second") == 1);
+    CHECK(minutes(60, "secs") == 1);
+    CHECK(minutes(61, "sec") == 2);
+    CHECK(minutes(INT_MAX, "seconds") == INT_MAX / 60 + 1);
+
+    CHECK(minutes(-1, "minutes") == RECIPE_MINUTES_UNKNOWN);
+    CHECK(minutes(-1, "seconds") == RECIPE_MINUTES_UNKNOWN);
+    CHECK(minutes(INT_MIN, "hours") == RECIPE_MINUTES_UNKNOWN);
+    CHECK(minutes(5, "pinch") == RECIPE_MINUTES_UNKNOWN);
+    CHECK(minutes(5, "") == RECIPE_MINUTES_UNKNOWN);
+    CHECK(minutes(5, "minutesx") == RECIPE_MINUTES_UNKNOWN);
+    CHECK(minutes(5, "h") == RECIPE_MINUTES_UNKNOWN);
+
+    /* The largest durations that fit, and one more */
+    CHECK(minutes(INT_MAX, "minutes") == INT_MAX);
+    CHECK(minutes(INT32_MAX / 60, "hours") == INT32_MAX / 60 * 60);
+    CHECK(minutes(INT32_MAX / 60 + 1, "hours") == RECIPE_MINUTES_UNKNOWN);
+    CHECK(minutes(INT32_MAX / 1440, "days") == INT32_MAX / 1440 * 1440);
+    CHECK(minutes(INT32_MAX / 1440 + 1, "days") == RECIPE_MINUTES_UNKNOWN);
+}
+
+static void write_catalog(const char* path) {
+    StringBuilder json;
+    sb_init(&json);
+    sb_append_cstr(&json, "{\"meals\": [\n");
+    for (int i = 0; i < CASE_COUNT; i++) {
+        const TimeCase* c = &CASES[i];
+        sb_appendf(&json,
+                   "%s{\"id\": \"time_%d\", \"name\": \"%s\", \"meal_type\": [\"dinner\"],\n"
+                   " \"prep_time\": {\"duration\": %d, \"unit\": \"%s\"},\n"
+                   " \"cook_time\": {\"duration\": %d, \"unit\": \"%s\"}}\n",
+                   i > 0 ? "," : "", i, c->name, c->prep, c->prep_unit, c->cook, c->cook_unit);
+    }
+    sb_append_cstr(&json, "]}\n");
+    REQUIRE(!json.failed);
+
+    FILE* file = fopen(path, "wb");
+    REQUIRE(file != NULL);
+    REQUIRE(fwrite(json.data, 1, json.length, file) == json.length);
+    fclose(file);
+    sb_free(&json);
+}
+
+static void test_catalog_totals(const char* work_dir) {
+    char path[TEST_PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/test_recipe_time.json", work_dir);
+    write_catalog(path);
+
+    RecipeDB* db = init_recipe_db(path);
+    REQUIRE(db != NULL);
+    REQUIRE(get_recipe_db_error(db) == NULL);
+    db->verbose = false;
+    REQUIRE(db->recipe_count == CASE_COUNT);
+
+    const int32_t* prep = get_recipe_time_column(db, RECIPE_TIME_PREP);
+    const int32_t* cook = get_recipe_time_column(db, RECIPE_TIME_COOK);
+    const int32_t* total = get_recipe_time_column(db, RECIPE_TIME_TOTAL);
+
+    for (int i = 0; i < CASE_COUNT; i++) {
+        const TimeCase* c = &CASES[i];
+        CHECK_MSG(prep[i] == minutes(c->prep, c->prep_unit) && cook[i] == minutes(c->cook, c->cook_unit),
+                  "%s: columns hold %d and %d minutes", c->name, prep[i], cook[i]);
+        CHECK_MSG(total[i] == c->total_minutes, "%s: total of %d minutes instead of %d",
+                  c->name, total[i], c->total_minutes);
+
+        char query[128];
+        snprintf(query, sizeof(query), "How long does it take to make %s?", c->name);
+        QueryResult result = process_recipe_query(db, query);
+        CHECK_MSG(result.success && result.recipe_index == i, "%s: matched recipe %d", c->name,
+                  result.recipe_index);
+
+        char line[96];
+        snprintf(line, sizeof(line), "%s\n", c->total_line);
+        CHECK_MSG(result.response && strstr(result.response, line) != NULL,
+                  "%s: expected \"%s\" in\n%s", c->name, c->total_line,
+                  result.response ? result.response : "(no response)");
+        free_query_result(&result);
+    }
+
+    free_recipe_db(db);
+    remove(path);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <scratch directory>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    test_conversion();
+    test_catalog_totals(argv[1]);
+    return test_exit_code("test_recipe_time");
+}
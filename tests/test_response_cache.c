@@ -0,0 +1,253 @@
+/**
+ * NeuroChef - Response Cache Tests
+ *
+ * Checks the LRU response cache: hit and miss counters, which entry is
+ * evicted at capacity, lookups refreshing recency, puts that replace an
+ * entry in place, and a dataset version bump making every older entry miss.
+ * Then runs random gets and puts against a plain list kept in recency
+ * order, over capacities from one entry to more than the bucket count.
+ *
+ *     ./test_response_cache
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../response_cache.h"
+#include "test_util.h"
+
+#define MODEL_CAPACITY 128
+#define RANDOM_OPERATIONS 20000
+
+static uint32_t random_state = 31337;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+static const ResponseCacheEntry* get(ResponseCache* cache, const char* key, uint32_t version) {
+    return response_cache_get(cache, key, strlen(key), version);
+}
+
+static void put(ResponseCache* cache, const char* key, uint32_t version, const char* response) {
+    REQUIRE(response_cache_put(cache, key, strlen(key), QUERY_GENERAL, version, response, -1, true));
+}
+
+static bool holds(ResponseCache* cache, const char* key, uint32_t version, const char* response) {
+    const ResponseCacheEntry* entry = get(cache, key, version);
+    return entry && strcmp(entry->response, response) == 0;
+}
+
+static bool stats_are(const ResponseCache* cache, uint64_t hits, uint64_t misses, uint64_t evictions,
+                      int entry_count) {
+    ResponseCacheStats stats = response_cache_get_stats(cache);
+    return stats.hits == hits && stats.misses == misses && stats.evictions == evictions &&
+           stats.entry_count == entry_count;
+}
+
+static void test_counters(void) {
+    ResponseCache cache;
+    REQUIRE(response_cache_init(&cache, 4));
+    CHECK(stats_are(&cache, 0, 0, 0, 0) && response_cache_get_stats(&cache).capacity == 4);
+
+    CHECK(get(&cache, "what is in soup", 1) == NULL);
+    CHECK(stats_are(&cache, 0, 1, 0, 0));
+
+    REQUIRE(response_cache_put(&cache, "what is in soup", 15, QUERY_INGREDIENTS, 1, "Soup has broth.", 3,
+                               false));
+    const ResponseCacheEntry* entry = get(&cache, "what is in soup", 1);
+    CHECK(entry && strcmp(entry->response, "Soup has broth.") == 0 && entry->type == QUERY_INGREDIENTS &&
+          entry->recipe_index == 3 && !entry->success);
+    CHECK(stats_are(&cache, 1, 1, 0, 1));
+
+    /* The key is the bytes given, so a prefix or extension is another key */
+    CHECK(response_cache_get(&cache, "what is in soup", 14, 1) == NULL);
+    CHECK(get(&cache, "what is in soup?", 1) == NULL);
+    CHECK(stats_are(&cache, 1, 3, 0, 1));
+
+    /* A put of the same key replaces the entry without evicting */
+    put(&cache, "what is in soup", 1, "Soup has stock.");
+    CHECK(holds(&cache, "what is in soup", 1, "Soup has stock."));
+    CHECK(stats_are(&cache, 2, 3, 0, 1));
+
+    /* Clearing drops the entries but keeps the counters */
+    response_cache_clear(&cache);
+    CHECK(get(&cache, "what is in soup", 1) == NULL);
+    CHECK(stats_are(&cache, 2, 4, 0, 0));
+    put(&cache, "what is in soup", 1, "Soup again.");
+    CHECK(holds(&cache, "what is in soup", 1, "Soup again."));
+
+    response_cache_free(&cache);
+}
+
+static void test_eviction_order(void) {
+    ResponseCache cache;
+    REQUIRE(response_cache_init(&cache, 3));
+
+    put(&cache, "a", 1, "A");
+    put(&cache, "b", 1, "B");
+    put(&cache, "c", 1, "C");
+    CHECK(stats_are(&cache, 0, 0, 0, 3));
+
+    /* "a" is the oldest until a hit makes it the newest; then "b" goes */
+    CHECK(holds(&cache, "a", 1, "A"));
+    put(&cache, "d", 1, "D");
+    CHECK(stats_are(&cache, 1, 0, 1, 3));
+    CHECK(get(&cache, "b", 1) == NULL);
+    CHECK(holds(&cache, "c", 1, "C") && holds(&cache, "a", 1, "A") && holds(&cache, "d", 1, "D"));
+
+    /* Recency is now c, a, d from oldest; replacing "c" refreshes it */
+    put(&cache, "c", 1, "C2");
+    put(&cache, "e", 1, "E");
+    CHECK(get(&cache, "a", 1) == NULL);
+    CHECK(holds(&cache, "d", 1, "D") && holds(&cache, "c", 1, "C2") && holds(&cache, "e", 1, "E"));
+    CHECK(response_cache_get_stats(&cache).evictions == 2);
+
+    /* A miss does not refresh anything: "d" is still the oldest */
+    CHECK(get(&cache, "zzz", 1) == NULL);
+    put(&cache, "f", 1, "F");
+    CHECK(get(&cache, "d", 1) == NULL);
+
+    response_cache_free(&cache);
+
+    /* One entry: every new key evicts the last */
+    REQUIRE(response_cache_init(&cache, 1));
+    put(&cache, "a", 1, "A");
+    put(&cache, "b", 1, "B");
+    CHECK(get(&cache, "a", 1) == NULL && holds(&cache, "b", 1, "B"));
+    CHECK(stats_are(&cache, 1, 1, 1, 1));
+    response_cache_free(&cache);
+}
+
+static void test_version_bump(void) {
+    ResponseCache cache;
+    REQUIRE(response_cache_init(&cache, 8));
+
+    put(&cache, "how do i make toast", 1, "Old toast.");
+    put(&cache, "what is in toast", 1, "Old bread.");
+
+    /* After a reload every old entry misses under the new version */
+    CHECK(get(&cache, "how do i make toast", 2) == NULL);
+    CHECK(get(&cache, "what is in toast", 2) == NULL);
+    CHECK(stats_are(&cache, 0, 2, 0, 2));
+
+    /* The new answer is stored beside the old one, which it never returns */
+    put(&cache, "how do i make toast", 2, "New toast.");
+    CHECK(holds(&cache, "how do i make toast", 2, "New toast."));
+    CHECK(holds(&cache, "how do i make toast", 1, "Old toast."));
+    CHECK(get(&cache, "how do i make toast", 3) == NULL);
+    CHECK(stats_are(&cache, 2, 3, 0, 3));
+
+    response_cache_free(&cache);
+}
+
+/* ===== Random operations against a model ===== */
+
+typedef struct {
+    int key;
+    uint32_t version;
+    int response;
+} ModelEntry;
+
+/* Entries most recently used first */
+typedef struct {
+    ModelEntry entries[MODEL_CAPACITY];
+    int count;
+    int capacity;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} Model;
+
+static int model_find(const Model* model, int key, uint32_t version) {
+    for (int i = 0; i < model->count; i++) {
+        if (model->entries[i].key == key && model->entries[i].version == version) return i;
+    }
+    return -1;
+}
+
+static void model_to_front(Model* model, int i, ModelEntry entry) {
+    memmove(&model->entries[1], &model->entries[0], (size_t)i * sizeof(ModelEntry));
+    model->entries[0] = entry;
+}
+
+static void key_text(int key, char* text, size_t size) {
+    /* Keys share long prefixes, and some are prefixes of others */
+    snprintf(text, size, "what can i eat %d%s", key / 2, key % 2 ? " please" : "");
+}
+
+static void check_random(int capacity, int key_space) {
+    ResponseCache cache;
+    REQUIRE(response_cache_init(&cache, capacity));
+    Model model;
+    memset(&model, 0, sizeof(model));
+    model.capacity = capacity;
+
+    for (int op = 0; op < RANDOM_OPERATIONS; op++) {
+        int key = (int)(next_random() % (uint32_t)key_space);
+        uint32_t version = 1 + next_random() % 3;
+        char text[64];
+        key_text(key, text, sizeof(text));
+        int i = model_find(&model, key, version);
+
+        if (next_random() % 2 == 0) {
+            const ResponseCacheEntry* entry = get(&cache, text, version);
+            if (i >= 0) {
+                ModelEntry found = model.entries[i];
+                model_to_front(&model, i, found);
+                model.hits++;
+                CHECK_MSG(entry && entry->recipe_index == found.response && entry->version == version,
+                          "capacity %d, op %d: \"%s\" v%u should hit", capacity, op, text, version);
+            } else {
+                model.misses++;
+                CHECK_MSG(entry == NULL, "capacity %d, op %d: \"%s\" v%u should miss", capacity, op, text,
+                          version);
+            }
+        } else {
+            ModelEntry entry = { key, version, op };
+            char response[32];
+            snprintf(response, sizeof(response), "response %d", op);
+            REQUIRE(response_cache_put(&cache, text, strlen(text), QUERY_GENERAL, version, response, op,
+                                       true));
+            if (i >= 0) {
+                model_to_front(&model, i, entry);
+            } else if (model.count < model.capacity) {
+                model_to_front(&model, model.count++, entry);
+            } else {
+                model.evictions++;
+                model_to_front(&model, model.count - 1, entry);
+            }
+        }
+
+        CHECK_MSG(stats_are(&cache, model.hits, model.misses, model.evictions, model.count),
+                  "capacity %d, op %d: counters differ", capacity, op);
+        if (test_failure_count > 0) break;
+    }
+
+    /* Every entry the model keeps is there with its response */
+    for (int i = 0; i < model.count; i++) {
+        char text[64];
+        char response[32];
+        key_text(model.entries[i].key, text, sizeof(text));
+        snprintf(response, sizeof(response), "response %d", model.entries[i].response);
+        const ResponseCacheEntry* entry = response_cache_get(&cache, text, strlen(text), model.entries[i].version);
+        CHECK_MSG(entry && strcmp(entry->response, response) == 0, "capacity %d: \"%s\" lost", capacity, text);
+    }
+
+    response_cache_free(&cache);
+}
+
+int main(void) {
+    test_counters();
+    test_eviction_order();
+    test_version_bump();
+
+    check_random(1, 4);
+    check_random(2, 6);
+    check_random(5, 12);
+    check_random(64, 100);
+    check_random(MODEL_CAPACITY, 400);
+    return test_exit_code("test_response_cache");
+}
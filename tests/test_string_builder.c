@@ -0,0 +1,234 @@
+/**
+ * NeuroChef - String Builder Tests
+ *
+ * Checks that formatted appends grow a builder correctly from nothing and
+ * from a small caller-supplied buffer: text that just fits stays in the
+ * buffer, text one byte longer moves to the heap, and random sequences of
+ * appends across the initial capacity match the same text built with
+ * snprintf, without writing past the caller's buffer. Then checks the
+ * failed flag: a request too large to allocate leaves the text as it was,
+ * makes every later append fail until a reset, and makes detach return
+ * NULL.
+ *
+ *     ./test_string_builder
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../string_builder.h"
+#include "test_util.h"
+
+#define BUFFER_SIZE 16
+#define GUARD_SIZE 16
+#define GUARD_BYTE 0x5A
+#define REFERENCE_SIZE 8192
+#define RANDOM_ROUNDS 200
+
+static uint32_t random_state = 99;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+/* A caller buffer followed by bytes the builder must never touch */
+typedef struct {
+    char buffer[BUFFER_SIZE];
+    unsigned char guard[GUARD_SIZE];
+} GuardedBuffer;
+
+static void init_guarded(StringBuilder* builder, GuardedBuffer* storage) {
+    memset(storage->guard, GUARD_BYTE, sizeof(storage->guard));
+    sb_init_buffer(builder, storage->buffer, sizeof(storage->buffer));
+}
+
+static bool guard_intact(const GuardedBuffer* storage) {
+    for (size_t i = 0; i < sizeof(storage->guard); i++) {
+        if (storage->guard[i] != GUARD_BYTE) return false;
+    }
+    return true;
+}
+
+static bool holds(const StringBuilder* builder, const char* expected) {
+    size_t length = strlen(expected);
+    return builder->length == length && builder->capacity > length &&
+           memcmp(sb_cstr(builder), expected, length + 1) == 0;
+}
+
+static void test_buffer_boundary(void) {
+    GuardedBuffer storage;
+    StringBuilder builder;
+    init_guarded(&builder, &storage);
+    CHECK(holds(&builder, "") && !builder.owns_data);
+
+    /* Fifteen characters and the terminator fill the buffer exactly */
+    CHECK(sb_appendf(&builder, "%s%d", "abcdefghij", 12345));
+    CHECK(holds(&builder, "abcdefghij12345") && !builder.owns_data && builder.data == storage.buffer);
+
+    /* One more moves the text to the heap */
+    CHECK(sb_appendf(&builder, "%c", 'x'));
+    CHECK(holds(&builder, "abcdefghij12345x") && builder.owns_data && builder.data != storage.buffer);
+    CHECK(guard_intact(&storage));
+
+    /* The same from a partly used buffer, crossing in one append */
+    sb_free(&builder);
+    init_guarded(&builder, &storage);
+    CHECK(sb_append_cstr(&builder, "0123456789"));
+    CHECK(sb_appendf(&builder, "[%05d]", 42));
+    CHECK(holds(&builder, "0123456789[00042]") && builder.owns_data);
+    CHECK(guard_intact(&storage));
+    sb_free(&builder);
+
+    /* An empty format on a builder with no storage yet */
+    sb_init(&builder);
+    CHECK(sb_appendf(&builder, "%s", ""));
+    CHECK(holds(&builder, ""));
+    CHECK(sb_appendf(&builder, "%d-%s", 7, "up"));
+    CHECK(holds(&builder, "7-up"));
+    sb_free(&builder);
+
+    /* Detaching from the caller's buffer copies the text to the heap */
+    init_guarded(&builder, &storage);
+    CHECK(sb_append_cstr(&builder, "short"));
+    char* detached = sb_detach(&builder);
+    CHECK(detached && strcmp(detached, "short") == 0 && detached != storage.buffer);
+    CHECK(holds(&builder, ""));
+    free(detached);
+    sb_free(&builder);
+}
+
+/* Append random formatted pieces and compare with snprintf into one array */
+static void check_random_appends(StringBuilder* builder, const GuardedBuffer* storage, const char* label) {
+    static char reference[REFERENCE_SIZE];
+    static char piece[REFERENCE_SIZE];
+    size_t length = 0;
+    reference[0] = '\0';
+
+    for (;;) {
+        size_t piece_length = next_random() % 300;
+        for (size_t i = 0; i < piece_length; i++) {
+            piece[i] = (char)('a' + next_random() % 26);
+        }
+        piece[piece_length] = '\0';
+        int number = (int)(next_random() % 100000) - 50000;
+
+        int written = snprintf(reference + length, sizeof(reference) - length, "%s<%d>", piece, number);
+        if (written < 0 || length + (size_t)written >= sizeof(reference)) break;
+        length += (size_t)written;
+
+        size_t before = builder->length;
+        CHECK_MSG(sb_appendf(builder, "%s<%d>", piece, number), "%s: append at %zu failed", label, before);
+        if (!holds(builder, reference)) {
+            CHECK_MSG(false, "%s: text differs after appending %d bytes at %zu", label, written, before);
+            break;
+        }
+        if (storage) {
+            CHECK_MSG(guard_intact(storage), "%s: wrote past the caller's buffer", label);
+        }
+    }
+}
+
+static void test_random_growth(void) {
+    for (int round = 0; round < RANDOM_ROUNDS; round++) {
+        StringBuilder builder;
+        if (round % 2 == 0) {
+            sb_init(&builder);
+            check_random_appends(&builder, NULL, "heap");
+            sb_free(&builder);
+        } else {
+            GuardedBuffer storage;
+            init_guarded(&builder, &storage);
+            check_random_appends(&builder, &storage, "caller buffer");
+            sb_free(&builder);
+            CHECK(guard_intact(&storage));
+        }
+    }
+
+    /* Reset keeps the storage; growing again from there still works */
+    StringBuilder builder;
+    sb_init(&builder);
+    check_random_appends(&builder, NULL, "before reset");
+    size_t capacity = builder.capacity;
+    sb_reset(&builder);
+    CHECK(holds(&builder, "") && builder.capacity == capacity);
+    check_random_appends(&builder, NULL, "after reset");
+    sb_free(&builder);
+}
+
+static void check_failed(StringBuilder* builder, const char* text) {
+    CHECK(builder->failed);
+    CHECK(holds(builder, text));
+    CHECK(!sb_append_cstr(builder, "more"));
+    CHECK(!sb_appendf(builder, "%d", 1));
+    CHECK(!sb_append_json_string(builder, "x", 1));
+    CHECK(!sb_reserve(builder, 1));
+    CHECK(holds(builder, text));
+}
+
+static void test_failed_flag(void) {
+    StringBuilder builder;
+    sb_init(&builder);
+    CHECK(sb_append_cstr(&builder, "kept"));
+    CHECK(!builder.failed);
+
+    /* More than the address space: the text stays and every append fails */
+    CHECK(!sb_reserve(&builder, SIZE_MAX));
+    check_failed(&builder, "kept");
+
+    /* Detaching a failed builder gives nothing and starts over */
+    CHECK(sb_detach(&builder) == NULL);
+    CHECK(!builder.failed && holds(&builder, ""));
+    CHECK(sb_appendf(&builder, "%s", "again"));
+    CHECK(holds(&builder, "again"));
+
+    /* A request that would overflow the doubled capacity */
+    CHECK(!sb_reserve(&builder, SIZE_MAX / 2));
+    check_failed(&builder, "again");
+
+    /* A reset clears the flag and the builder works again */
+    sb_reset(&builder);
+    CHECK(!builder.failed && holds(&builder, ""));
+    CHECK(sb_appendf(&builder, "%d %s", 3, "ok"));
+    CHECK(holds(&builder, "3 ok"));
+    sb_free(&builder);
+
+    /* On a caller's buffer, the buffer keeps the text */
+    GuardedBuffer storage;
+    init_guarded(&builder, &storage);
+    CHECK(sb_append_cstr(&builder, "stack"));
+    CHECK(!sb_reserve(&builder, SIZE_MAX - 3));
+    check_failed(&builder, "stack");
+    CHECK(builder.data == storage.buffer && guard_intact(&storage));
+    sb_free(&builder);
+}
+
+static void test_edits(void) {
+    StringBuilder builder;
+    sb_init(&builder);
+
+    CHECK(sb_append_json_string(&builder, "a\"b\\c\n\t\x01", 8));
+    CHECK(holds(&builder, "\"a\\\"b\\\\c\\n\\t\\u0001\""));
+
+    sb_reset(&builder);
+    CHECK(sb_append_cstr(&builder, "error: retry"));
+    sb_drop_prefix(&builder, 7);
+    CHECK(holds(&builder, "retry"));
+    sb_truncate(&builder, 3);
+    CHECK(holds(&builder, "ret"));
+    sb_truncate(&builder, 10);
+    CHECK(holds(&builder, "ret"));
+    sb_drop_prefix(&builder, 10);
+    CHECK(holds(&builder, ""));
+
+    sb_free(&builder);
+}
+
+int main(void) {
+    test_buffer_boundary();
+    test_random_growth();
+    test_failed_flag();
+    test_edits();
+    return test_exit_code("test_string_builder");
+}
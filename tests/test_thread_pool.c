@@ -0,0 +1,192 @@
+/**
+ * NeuroChef - Thread Pool Tests
+ *
+ * Checks that every run of the work-stealing pool calls the task function
+ * exactly once for each index, on a worker below the thread count, and
+ * that all of them have finished when the run returns. Covers one thread,
+ * fewer tasks than threads, empty runs and many runs on one pool, with
+ * uneven task costs. Also checks that idle workers take over the tasks of
+ * a worker stalled on its first one.
+ *
+ *     ./test_thread_pool
+ */
+
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../thread_pool.h"
+#include "test_util.h"
+
+#define MAX_TASKS 5000
+#define RUNS_PER_POOL 40
+/* How long worker 0 waits for its tasks to be stolen */
+#define STEAL_TIMEOUT_SECONDS 10
+
+static uint32_t random_state = 777;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+typedef struct {
+    int thread_count;
+    int calls[MAX_TASKS];
+    /* Tasks run by a worker outside the range first dealt to it */
+    int stolen;
+    int bad_workers;
+    size_t task_count;
+    /* Spin this many rounds in tasks whose index is a multiple of 7 */
+    int slow_rounds;
+} RunState;
+
+/* The worker thread_pool_run deals a task to before any stealing */
+static int dealt_worker(size_t task_count, int thread_count, size_t task) {
+    size_t share = task_count / (size_t)thread_count;
+    size_t extra = task_count % (size_t)thread_count;
+    size_t start = 0;
+    for (int i = 0; i < thread_count; i++) {
+        start += share + ((size_t)i < extra ? 1 : 0);
+        if (task < start) return i;
+    }
+    return -1;
+}
+
+static void count_task(void* context, int worker, size_t task) {
+    RunState* state = (RunState*)context;
+    if (worker < 0 || worker >= state->thread_count || task >= MAX_TASKS) {
+        __atomic_fetch_add(&state->bad_workers, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (worker != dealt_worker(state->task_count, state->thread_count, task)) {
+        __atomic_fetch_add(&state->stolen, 1, __ATOMIC_RELAXED);
+    }
+
+    if (task % 7 == 0) {
+        volatile uint32_t sink = 0;
+        for (int i = 0; i < state->slow_rounds; i++) sink += (uint32_t)i;
+    }
+    __atomic_fetch_add(&state->calls[task], 1, __ATOMIC_RELAXED);
+}
+
+/* Returns the number of tasks that ran on a worker they were not dealt to */
+static int check_run(ThreadPool* pool, RunState* state, size_t task_count, int slow_rounds) {
+    memset(state->calls, 0, sizeof(state->calls));
+    state->thread_count = pool->thread_count;
+    state->stolen = 0;
+    state->bad_workers = 0;
+    state->task_count = task_count;
+    state->slow_rounds = slow_rounds;
+
+    thread_pool_run(pool, task_count, count_task, state);
+
+    /* Read after the run returns: every call must already have happened */
+    int wrong = 0;
+    for (size_t task = 0; task < MAX_TASKS; task++) {
+        int expected = task < task_count ? 1 : 0;
+        int calls = __atomic_load_n(&state->calls[task], __ATOMIC_RELAXED);
+        if (calls != expected && wrong++ < 3) {
+            CHECK_MSG(calls == expected, "%d threads, %zu tasks: task %zu ran %d times", pool->thread_count,
+                      task_count, task, calls);
+        }
+    }
+    CHECK_MSG(state->bad_workers == 0, "%d threads: %d calls from a worker out of range", pool->thread_count,
+              state->bad_workers);
+    return state->stolen;
+}
+
+static void check_pool(int thread_count) {
+    static RunState state;
+    ThreadPool pool;
+    REQUIRE(thread_pool_init(&pool, thread_count));
+    CHECK(pool.thread_count == thread_count);
+
+    /* Fewer tasks than threads, one per thread and a few more */
+    static const size_t SMALL_COUNTS[] = { 1, 2, 3, 5, 7, 8, 9, 17 };
+    for (size_t i = 0; i < sizeof(SMALL_COUNTS) / sizeof(SMALL_COUNTS[0]); i++) {
+        check_run(&pool, &state, SMALL_COUNTS[i], 0);
+    }
+
+    /* An empty run calls nothing and leaves the pool usable */
+    thread_pool_run(&pool, 0, count_task, &state);
+    check_run(&pool, &state, 4, 0);
+
+    /* Many runs, each a new generation, with uneven task costs */
+    int stolen = 0;
+    for (int run = 0; run < RUNS_PER_POOL; run++) {
+        size_t task_count = 1 + next_random() % MAX_TASKS;
+        stolen += check_run(&pool, &state, task_count, (int)(next_random() % 20000));
+    }
+    if (thread_count == 1) {
+        CHECK_MSG(stolen == 0, "one thread: %d tasks ran on another worker", stolen);
+    }
+
+    check_run(&pool, &state, MAX_TASKS, 5000);
+    thread_pool_free(&pool);
+}
+
+/* Worker 0 stalls on its first task until another worker has stolen one
+   of its tasks, which can only happen by stealing */
+typedef struct {
+    int calls[MAX_TASKS];
+    int by_worker[64];
+    size_t dealt_to_first;
+    int stolen;
+} StealState;
+
+static void stall_task(void* context, int worker, size_t task) {
+    StealState* state = (StealState*)context;
+    if (worker != 0 && task < state->dealt_to_first) {
+        __atomic_store_n(&state->stolen, 1, __ATOMIC_RELEASE);
+    }
+    if (worker == 0 && task == 0) {
+        time_t deadline = time(NULL) + STEAL_TIMEOUT_SECONDS;
+        while (!__atomic_load_n(&state->stolen, __ATOMIC_ACQUIRE) && time(NULL) < deadline) {
+            sched_yield();
+        }
+    }
+    __atomic_fetch_add(&state->calls[task], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&state->by_worker[worker], 1, __ATOMIC_RELAXED);
+}
+
+static void test_stealing(void) {
+    static StealState state;
+    ThreadPool pool;
+    REQUIRE(thread_pool_init(&pool, 4));
+
+    memset(&state, 0, sizeof(state));
+    state.dealt_to_first = 100;
+    thread_pool_run(&pool, 400, stall_task, &state);
+
+    bool once = true;
+    for (int task = 0; task < 400; task++) {
+        once = once && state.calls[task] == 1;
+    }
+    CHECK(once);
+    CHECK_MSG(state.stolen && state.by_worker[0] < 100, "worker 0 ran %d of its 100 tasks; nothing was stolen",
+              state.by_worker[0]);
+
+    thread_pool_free(&pool);
+}
+
+int main(void) {
+    static const int THREAD_COUNTS[] = { 1, 2, 3, 4, 8 };
+    for (size_t i = 0; i < sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0]); i++) {
+        check_pool(THREAD_COUNTS[i]);
+    }
+    CHECK(thread_pool_default_size() >= 1);
+
+    /* A count below one still gives a working pool of one */
+    ThreadPool pool;
+    static RunState state;
+    REQUIRE(thread_pool_init(&pool, 0));
+    CHECK(pool.thread_count == 1);
+    check_run(&pool, &state, 10, 0);
+    thread_pool_free(&pool);
+
+    test_stealing();
+    return test_exit_code("test_thread_pool");
+}
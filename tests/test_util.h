@@ -0,0 +1,55 @@
+/**
+ * NeuroChef - C Test Helpers
+ *
+ * Checks shared by the C test programs under tests/. A failed check prints
+ * where it failed and the test carries on, so one run reports every
+ * failure; each program's main returns test_exit_code().
+ */
+
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int test_failure_count = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            test_failure_count++; \
+        } \
+    } while (0)
+
+/* Like CHECK, with a printf-style note of what was being checked */
+#define CHECK_MSG(condition, ...) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #condition); \
+            fprintf(stderr, __VA_ARGS__); \
+            fputc('\n', stderr); \
+            test_failure_count++; \
+        } \
+    } while (0)
+
+/* Stops the test when continuing would only crash */
+#define REQUIRE(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: required: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+static int test_exit_code(const char* name) {
+    if (test_failure_count > 0) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, test_failure_count);
+        return EXIT_FAILURE;
+    }
+    printf("%s: all checks passed\n", name);
+    return EXIT_SUCCESS;
+}
+
+#endif /* TEST_UTIL_H */
@@ -0,0 +1,210 @@
+/**
+ * NeuroChef - Thread Pool Implementation
+ * 
+ * This file implements the work-stealing pool. Each queue is a contiguous
+ * range of task indices guarded by its own mutex; no thread ever holds two
+ * queue locks at once.
+ */
+
+#include "thread_pool.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define CACHE_LINE_SIZE 64
+
+struct ThreadPoolQueue {
+    pthread_mutex_t lock;
+    size_t next;
+    size_t end;
+    ThreadPool* pool;
+    int worker;
+    /* Keep neighbouring queues off each other's cache lines */
+    char padding[CACHE_LINE_SIZE];
+};
+
+int thread_pool_default_size(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
+static bool pop_task(ThreadPoolQueue* queue, size_t* task) {
+    bool found = false;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->next < queue->end) {
+        *task = queue->next++;
+        found = true;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+/* Move the back half of the first non-empty queue into the worker's own */
+static bool steal_tasks(ThreadPool* pool, int worker) {
+    for (int i = 1; i < pool->thread_count; i++) {
+        ThreadPoolQueue* victim = &pool->queues[(worker + i) % pool->thread_count];
+
+        pthread_mutex_lock(&victim->lock);
+        size_t remaining = victim->end - victim->next;
+        size_t taken = (remaining + 1) / 2;
+        victim->end -= taken;
+        size_t end = victim->end + taken;
+        pthread_mutex_unlock(&victim->lock);
+
+        if (taken > 0) {
+            ThreadPoolQueue* own = &pool->queues[worker];
+            pthread_mutex_lock(&own->lock);
+            own->next = end - taken;
+            own->end = end;
+            pthread_mutex_unlock(&own->lock);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void run_worker(ThreadPool* pool, int worker) {
+    ThreadPoolQueue* own = &pool->queues[worker];
+    size_t task;
+
+    for (;;) {
+        if (pop_task(own, &task)) {
+            pool->task(pool->context, worker, task);
+        } else if (!steal_tasks(pool, worker)) {
+            break;
+        }
+    }
+}
+
+static void* worker_main(void* argument) {
+    ThreadPoolQueue* queue = (ThreadPoolQueue*)argument;
+    ThreadPool* pool = queue->pool;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stopping && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->stopping) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_worker(pool, queue->worker);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy_workers == 0) {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+bool thread_pool_init(ThreadPool* pool, int thread_count) {
+    if (thread_count < 1) thread_count = 1;
+
+    pool->thread_count = 0;
+    pool->generation = 0;
+    pool->busy_workers = 0;
+    pool->stopping = false;
+    pool->task = NULL;
+    pool->context = NULL;
+    pool->threads = (pthread_t*)malloc((size_t)thread_count * sizeof(pthread_t));
+    pool->queues = (ThreadPoolQueue*)calloc((size_t)thread_count, sizeof(ThreadPoolQueue));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    if (!pool->threads || !pool->queues) {
+        thread_pool_free(pool);
+        return false;
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+        pool->queues[i].pool = pool;
+        pool->queues[i].worker = i;
+    }
+    /* thread_count tracks the workers actually running, so free can join them */
+    pool->thread_count = thread_count;
+
+    /* Worker 0 is whichever thread calls thread_pool_run */
+    for (int i = 1; i < thread_count; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->queues[i]) != 0) {
+            pool->thread_count = i;
+            thread_pool_free(pool);
+            return false;
+        }
+    }
+    return true;
+}
+
+void thread_pool_run(ThreadPool* pool, size_t task_count, ThreadPoolTask task, void* context) {
+    if (task_count == 0) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+
+    /* Deal the tasks out as contiguous ranges of near-equal size */
+    size_t share = task_count / (size_t)pool->thread_count;
+    size_t extra = task_count % (size_t)pool->thread_count;
+    size_t start = 0;
+    for (int i = 0; i < pool->thread_count; i++) {
+        size_t length = share + ((size_t)i < extra ? 1 : 0);
+        pool->queues[i].next = start;
+        pool->queues[i].end = start + length;
+        start += length;
+    }
+
+    pool->busy_workers = pool->thread_count - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_worker(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy_workers > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_free(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (pool->threads) {
+        for (int i = 1; i < pool->thread_count; i++) {
+            pthread_join(pool->threads[i], NULL);
+        }
+    }
+    if (pool->queues) {
+        for (int i = 0; i < pool->thread_count; i++) {
+            pthread_mutex_destroy(&pool->queues[i].lock);
+        }
+    }
+
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->queues);
+    free(pool->threads);
+    pool->queues = NULL;
+    pool->threads = NULL;
+    pool->thread_count = 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * NeuroChef - Thread Pool
+ * 
+ * This header declares a fixed pool of worker threads that runs batches of
+ * independent, numbered tasks. Each run splits the task range evenly over
+ * the workers' queues; a worker takes tasks from the front of its own queue
+ * and, once that is empty, steals the back half of another worker's queue,
+ * so uneven task costs still keep every core busy. The thread that starts a
+ * run takes part as worker 0.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A task function; it is called once for every task index in a run
+ * 
+ * @param context The context passed to thread_pool_run
+ * @param worker Index of the calling worker, below the pool's thread count
+ * @param task The task index
+ */
+typedef void (*ThreadPoolTask)(void* context, int worker, size_t task);
+
+typedef struct ThreadPoolQueue ThreadPoolQueue;
+
+typedef struct {
+    int thread_count;
+    pthread_t* threads;
+    ThreadPoolQueue* queues;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    /* Incremented to start each run */
+    uint64_t generation;
+    int busy_workers;
+    bool stopping;
+    ThreadPoolTask task;
+    void* context;
+} ThreadPool;
+
+/**
+ * Get the number of processors available to this process
+ * 
+ * @return The processor count, at least 1
+ */
+int thread_pool_default_size(void);
+
+/**
+ * Start a pool of workers
+ * 
+ * @param pool The pool to initialize
+ * @param thread_count Number of workers including the calling thread
+ * @return true on success, false if threads could not be created
+ */
+bool thread_pool_init(ThreadPool* pool, int thread_count);
+
+/**
+ * Run tasks 0 to task_count - 1 and wait until all of them have finished
+ * 
+ * Tasks may run in any order and on any worker. Runs must not overlap.
+ * 
+ * @param pool The pool
+ * @param task_count Number of tasks
+ * @param task The function that runs one task
+ * @param context Passed to every call of the task function
+ */
+void thread_pool_run(ThreadPool* pool, size_t task_count, ThreadPoolTask task, void* context);
+
+/**
+ * Stop the workers and free the memory owned by a pool
+ * 
+ * @param pool The pool to free
+ */
+void thread_pool_free(ThreadPool* pool);
+
+#endif /* THREAD_POOL_H */